@@ -0,0 +1,53 @@
+#ifndef LUADIO_BENCH_UTILITY_HPP
+#define LUADIO_BENCH_UTILITY_HPP
+
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <algorithm>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace luadio
+{
+	// Runs fn repeatedly and returns the fastest run in nanoseconds.
+	// The minimum is the most repeatable figure on a machine that is also doing other work.
+	template<typename F>
+	double bench_measure(F &&fn, uint32_t runs = 20, uint32_t iterations = 100)
+	{
+		double best = 1e30;
+
+		// One untimed run so caches and lazily built tables are warm
+		fn();
+
+		for(uint32_t r = 0; r < runs; r++)
+		{
+			auto start = std::chrono::steady_clock::now();
+
+			for(uint32_t i = 0; i < iterations; i++)
+				fn();
+
+			auto end = std::chrono::steady_clock::now();
+			double elapsed = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+			best = std::min(best, elapsed);
+		}
+
+		return best;
+	}
+
+	// Keeps the compiler from optimizing away a result that is never used
+	template<typename T>
+	inline void bench_keep(const T &value)
+	{
+#if defined(_MSC_VER)
+		static const void *volatile pSink;
+		pSink = &value;
+		_ReadWriteBarrier();
+#else
+		asm volatile("" : : "g"(&value) : "memory");
+#endif
+	}
+}
+
+#endif
@@ -0,0 +1,92 @@
+#include "bench_utility.hpp"
+#include "../include/system/convolution_engine.hpp"
+#include <vector>
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <cstdio>
+#include <cmath>
+#include <thread>
+
+using namespace luadio;
+
+// Audio thread cost of convolution_engine with several stereo 5 second reverbs at 64 frame blocks.
+// Every block is timed on its own, the worst blocks show whether the larger partitions cause spikes.
+// The tail segment runs on its own thread per engine and is not part of the figures. Blocks are
+// paced in real time, so those threads get their time between blocks like they would in the app.
+int main()
+{
+	const uint32_t sampleRate = 48000;
+	const uint32_t blockSize = 64;
+	const uint32_t channels = 2;
+	const size_t irFrames = static_cast<size_t>(sampleRate) * 5;
+	const size_t blockCount = static_cast<size_t>(sampleRate) * 10 / blockSize;
+	const double budget = 1e9 * blockSize / sampleRate;
+
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+
+	// Decaying noise, a rough stand-in for a hall
+	std::vector<float> impulse(irFrames * channels);
+
+	for(size_t i = 0; i < irFrames; i++)
+	{
+		for(uint32_t c = 0; c < channels; c++)
+			impulse[i * channels + c] = noise(rng) * std::exp(-6.9f * i / irFrames);
+	}
+
+	std::vector<float> input(blockSize * channels);
+	std::vector<float> output(blockSize * channels);
+
+	for(auto &sample : input)
+		sample = noise(rng);
+
+	for(uint32_t engineCount : { 1u, 4u, 8u })
+	{
+		std::vector<std::unique_ptr<convolution_engine>> engines;
+
+		for(uint32_t i = 0; i < engineCount; i++)
+		{
+			engines.push_back(std::make_unique<convolution_engine>(channels, blockSize));
+			engines.back()->load(impulse.data(), irFrames, channels);
+		}
+
+		std::vector<double> times(blockCount);
+		auto deadline = std::chrono::steady_clock::now();
+
+		for(size_t b = 0; b < blockCount; b++)
+		{
+			deadline += std::chrono::nanoseconds(static_cast<int64_t>(budget));
+			std::this_thread::sleep_until(deadline);
+
+			auto start = std::chrono::steady_clock::now();
+
+			for(auto &engine : engines)
+				engine->process(input.data(), output.data(), blockSize, channels);
+
+			auto end = std::chrono::steady_clock::now();
+			times[b] = std::chrono::duration<double, std::nano>(end - start).count();
+			bench_keep(output);
+		}
+
+		double mean = 0.0;
+
+		for(double t : times)
+			mean += t;
+
+		mean /= blockCount;
+		std::sort(times.begin(), times.end());
+		const double p999 = times[blockCount * 999 / 1000];
+		const double worst = times.back();
+
+		uint64_t lateBlocks = 0;
+
+		for(auto &engine : engines)
+			lateBlocks += engine->get_late_blocks();
+
+		std::printf("%u x stereo 5 s IR  mean %7.2f us (%5.1f%%)  99.9%% %7.2f us  worst %7.2f us (%5.1f%% of a %u frame block)  late tail blocks %llu\n",
+			engineCount, mean / 1e3, 100.0 * mean / budget, p999 / 1e3, worst / 1e3, 100.0 * worst / budget, blockSize, static_cast<unsigned long long>(lateBlocks));
+	}
+
+	return 0;
+}
@@ -0,0 +1,43 @@
+#include "bench_utility.hpp"
+#include "../include/system/fft.hpp"
+#include "../include/system/fft_plan.hpp"
+#include <vector>
+#include <complex>
+#include <cstdio>
+#include <cmath>
+
+using namespace luadio;
+
+// Real forward transforms of fft_plan against the complex double fft::perform the FFT panel used before
+int main()
+{
+	for(size_t size = 256; size <= 8192; size *= 2)
+	{
+		std::vector<float> input(size);
+
+		for(size_t i = 0; i < size; i++)
+			input[i] = std::sin(0.05f * i) + 0.25f * std::sin(0.73f * i);
+
+		// The panel filled the complex buffer from the samples before every transform
+		std::vector<std::complex<double>> buffer(size);
+
+		const double reference = bench_measure([&] () {
+			for(size_t i = 0; i < size; i++)
+				buffer[i] = std::complex<double>(input[i], 0.0);
+			fft::perform(buffer, size);
+			bench_keep(buffer);
+		});
+
+		auto plan = fft_plan::get(size);
+		std::vector<std::complex<float>> bins(plan->get_bin_count());
+
+		const double planned = bench_measure([&] () {
+			plan->forward(input.data(), bins.data());
+			bench_keep(bins);
+		});
+
+		std::printf("N = %5zu  fft::perform %9.2f us  fft_plan %8.2f us  %5.1fx\n", size, reference / 1e3, planned / 1e3, reference / planned);
+	}
+
+	return 0;
+}
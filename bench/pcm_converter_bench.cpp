@@ -0,0 +1,50 @@
+#include "bench_utility.hpp"
+#include "../include/system/pcm_converter.hpp"
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+
+using namespace luadio;
+
+// Float to integer PCM throughput of pcm_converter against the scalar loop the recorder used before
+int main()
+{
+	const size_t count = 1 << 16;
+	std::vector<float> input(count);
+	std::vector<uint8_t> output(count * 4);
+
+	for(size_t i = 0; i < count; i++)
+		input[i] = static_cast<float>(i % 2001) / 1000.0f - 1.0f;
+
+	auto report = [count] (const char *name, double nanoseconds) {
+		std::printf("%-28s %8.3f ns/sample %9.1f Msamples/s\n", name, nanoseconds / count, count * 1e3 / nanoseconds);
+	};
+
+	report("scalar s16 (old recorder)", bench_measure([&] () {
+		int16_t *pDst = reinterpret_cast<int16_t*>(output.data());
+		for(size_t i = 0; i < count; i++)
+			pDst[i] = static_cast<int16_t>(input[i] * 32767);
+		bench_keep(output);
+	}));
+
+	pcm_converter converter;
+	const char *names[] = { "s16", "s24", "s32" };
+
+	for(int dither = 0; dither < 2; dither++)
+	{
+		converter.set_dither(dither != 0);
+
+		for(int format = pcm_format_s16; format <= pcm_format_s32; format++)
+		{
+			char name[64];
+			std::snprintf(name, sizeof(name), "pcm_converter %s%s", names[format], dither ? " dither" : "");
+
+			report(name, bench_measure([&] () {
+				converter.convert(input.data(), output.data(), count, static_cast<pcm_format>(format));
+				bench_keep(output);
+			}));
+		}
+	}
+
+	return 0;
+}
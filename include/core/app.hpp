@@ -2,30 +2,42 @@
 #include "compiler.hpp"
 #include "queue_item.hpp"
 #include "texture_2d.hpp"
+#include "audio_settings.hpp"
 #include "../external/imgui/TextEditor.h"
 #include "../external/imgui/imgui_logbox.hpp"
 #include "../system/concurrent_queue.hpp"
 #include "../system/tokenizer.hpp"
-#include "../system/concurrent_buffer.hpp"
 #include "../system/timer.hpp"
-#include "../system/fft.hpp"
 #include "../system/audio_recorder.hpp"
+#include "../system/audio_history.hpp"
+#include "../system/analysis_worker.hpp"
+#include "../system/transport.hpp"
+#include "../system/event_scheduler.hpp"
+#include "../system/sample_bank.hpp"
+#include "../system/sample_player.hpp"
+#include "../system/latency_monitor.hpp"
+#include "../system/planar_buffer.hpp"
 #include "../../libs/miniaudioex/include/miniaudioex.h"
 #include <string>
 #include <vector>
 #include <mutex>
+#include <atomic>
 
 namespace luadio
 {
 	enum plot_mode
 	{
 		plot_mode_waveform,
-		plot_mode_fft
+		plot_mode_fft,
+		plot_mode_spectrogram,
+		plot_mode_scope
 	};
 
 	enum menu_state
 	{
 		menu_state_settings_visuals,
+		menu_state_settings_recording,
+		menu_state_settings_audio,
 		menu_state_none
 	};
 
@@ -40,6 +52,7 @@ namespace luadio
 	class app : public application
 	{
 	public:
+		app(const audio_settings &settings);
 		void on_load() override ;
 		void on_destroy() override; 
 		void on_update() override;
@@ -48,36 +61,70 @@ namespace luadio
 	private:
 		TextEditor editor;
 		std::vector<lua_field*> fields;
-		std::vector<float> outputData;
 		concurrent_queue<queue_item> eventQueue;
 		concurrent_queue<lua_field_info> fieldQueue;
 		tokenizer codeTokenizer;
-		concurrent_buffer concurrentBuffer;
-		std::vector<std::complex<double>> fftBuffer;
 		ma_ex_context *pContext;
 		ma_ex_audio_source *pSource;
 		ma_effect_node effectNode;
 		ma_sound_group soundGroup;
+		audio_settings audioSettings;
+		audio_settings pendingSettings;
+		latency_monitor latency;
+		std::atomic<buffer_layout> bufferLayout;
+		std::atomic<bool> effectDefined;
+		std::atomic<bool> effectBypass;
+		planar_buffer planarRead;
+		planar_buffer planarEffectInput;
+		planar_buffer planarEffectOutput;
+		std::vector<float> subBlock;
+		// Input of the effect stage as it was before the effect ran, for the dry stem
+		std::vector<float> dryBuffer;
+		uint32_t subBlockFrames;
+		uint32_t subBlockPosition;
+		// Transport frame and layout of the buffer the running script callback works on
+		uint64_t scriptFrame;
+		bool scriptPlanar;
 		texture_2d knobTexture;
 		timer updateTimer;		
 		audio_recorder recorder;
+		audio_history history;
+		float historySeconds;
+		analysis_worker analysis;
+		transport transportClock;
+		event_scheduler scheduler;
+		sample_bank samples;
+		sample_player samplePlayer;
+		texture_2d spectrogramTexture;
+		uint64_t spectrogramColumnsUploaded;
+		std::vector<uint8_t> spectrogramPixels;
 		imgui_logbox logBox;
 		wave_form_settings waveformSettings;
 		menu_state menuState;
 		std::mutex luaMutex;
+		void open_audio();
+		void close_audio();
+		void restart_audio();
 		void show_menu();
 		void show_panel();
 		void show_editor();
 		void show_log();
 		void show_inspector();
+		void show_meters();
+		void update_spectrogram_texture();
 		void clear_fields();
 		void push_field_to_queue(lua_field *field);
 		void on_script_start();
 		void on_script_stop();
 		void on_script_update();
+		void reset_transport();
+		void dispatch_events(lua_State *L, uint64_t frame, uint64_t startFrame);
 		void update_fields();
 		void on_log_message(const std::string &message);
 		void on_queue_audio(const std::string &filepath);
+		uint64_t get_output_frame(uint32_t frameCount) const;
+		void render_block(lua_State *L, float *pOutput, uint32_t frameCount, uint32_t channels, bool planar);
+		bool process_planar_effect(lua_State *L, const float *pInput, float *pOutput, uint32_t frameCount, uint32_t channels);
 		static void on_audio_read(void *pUserData, void *pFramesOut, ma_uint64 frameCount, ma_uint32 channels);
 		static void on_audio_effect(ma_node *pNode, const float **ppFramesIn, ma_uint32 *pFrameCountIn, float **ppFramesOut, ma_uint32 *pFrameCountOut);
 	};
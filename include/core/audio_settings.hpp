@@ -0,0 +1,33 @@
+#ifndef LUADIO_AUDIO_SETTINGS_HPP
+#define LUADIO_AUDIO_SETTINGS_HPP
+
+#include <string>
+#include <cstdint>
+
+namespace luadio
+{
+	// Format the engine runs at, chosen on the command line or in the audio settings window
+	struct audio_settings
+	{
+		static constexpr uint32_t minSampleRate = 8000;
+		static constexpr uint32_t maxSampleRate = 192000;
+		static constexpr uint32_t minPeriodSize = 16;
+		static constexpr uint32_t maxPeriodSize = 8192;
+		static constexpr uint32_t maxChannels = 16;
+		static constexpr uint32_t lowLatencyPeriodSize = 128;
+		static constexpr uint32_t maxSubBlockSize = 1024;
+		uint32_t sampleRate;
+		uint32_t channels;
+		uint32_t periodSize;
+		// Fixed length on_audio_read is called with whatever the device asks for, 0 passes device periods on as they come
+		uint32_t subBlockSize;
+		audio_settings();
+		bool is_valid() const;
+		double get_period_milliseconds() const;
+		std::string to_string() const;
+		// Reads --sample-rate, --channels, --period, --sub-block and --low-latency, returns false if the program should exit
+		static bool parse(int argc, char **argv, audio_settings &settings);
+	};
+}
+
+#endif
@@ -18,6 +18,7 @@ namespace luadio
 		texture_2d &operator=(texture_2d &&other) noexcept;
 		void generate(const image *img);
 		void generate(const uint8_t *data, size_t size, uint32_t width, uint32_t height, uint32_t channels);
+		void update(const uint8_t *data, uint32_t x, uint32_t y, uint32_t width, uint32_t height);
 		void destroy();
 		void bind(uint32_t unit);
 		void unbind();
@@ -0,0 +1,24 @@
+#ifndef LUADIO_CONVOLUTION_MODULE_HPP
+#define LUADIO_CONVOLUTION_MODULE_HPP
+
+#include "lua_module.hpp"
+#include <cstdint>
+
+namespace luadio
+{
+	// Partitioned FFT convolution with impulse responses loaded from disk, available to scripts as luadio.convolution
+	class convolution_module : public lua_module
+	{
+	public:
+		void load(lua_State *L) override;
+	private:
+		static void *luadio_convolution_create(const char *filePath, uint32_t channels, uint32_t blockSize, uint32_t sampleRate);
+		static void luadio_convolution_destroy(void *pEngine);
+		static int32_t luadio_convolution_get_status(void *pEngine);
+		static void luadio_convolution_process(void *pEngine, const float *pInput, float *pOutput, uint32_t frameCount, uint32_t channels);
+		static uint32_t luadio_convolution_get_latency(void *pEngine);
+		static uint64_t luadio_convolution_get_late_blocks(void *pEngine);
+	};
+}
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef LUADIO_DSP_MODULE_HPP
+#define LUADIO_DSP_MODULE_HPP
+
+#include "lua_module.hpp"
+#include <cstdint>
+
+namespace luadio
+{
+	// Vectorized buffer operations called once per block, available to scripts as luadio.dsp
+	class dsp_module : public lua_module
+	{
+	public:
+		void load(lua_State *L) override;
+	private:
+		static void luadio_dsp_clear(float *pDst, uint32_t count);
+		static void luadio_dsp_copy(float *pDst, const float *pSrc, uint32_t count);
+		static void luadio_dsp_gain(float *pDst, const float *pSrc, float gain, uint32_t count);
+		static void luadio_dsp_gain_ramp(float *pDst, const float *pSrc, float startGain, float endGain, uint32_t count);
+		static void luadio_dsp_accumulate(float *pDst, const float *pSrc, float gain, uint32_t count);
+		static void luadio_dsp_mix(float *pDst, const float *pA, float gainA, const float *pB, float gainB, uint32_t count);
+		static void luadio_dsp_clip(float *pDst, const float *pSrc, float minimum, float maximum, uint32_t count);
+		static void luadio_dsp_pan(float *pDst, const float *pSrc, float pan, uint32_t frameCount);
+		static void luadio_dsp_balance(float *pDst, const float *pSrc, float pan, uint32_t frameCount);
+		static void luadio_dsp_interleave(float *pDst, const float *pSrc, uint32_t frameCount, uint32_t channels);
+		static void luadio_dsp_deinterleave(float *pDst, const float *pSrc, uint32_t frameCount, uint32_t channels);
+		static float luadio_dsp_get_peak(const float *pSrc, uint32_t count);
+	};
+}
+
+#endif
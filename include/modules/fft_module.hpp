@@ -0,0 +1,32 @@
+#ifndef LUADIO_FFT_MODULE_HPP
+#define LUADIO_FFT_MODULE_HPP
+
+#include "lua_module.hpp"
+#include <cstdint>
+
+namespace luadio
+{
+	// Native real FFT, windows, spectral helpers and an STFT processor, available to scripts as luadio.fft
+	class fft_module : public lua_module
+	{
+	public:
+		void load(lua_State *L) override;
+	private:
+		static const void *luadio_fft_get_plan(uint32_t size);
+		static void luadio_fft_forward(const void *pPlan, const float *pInput, float *pBins);
+		static void luadio_fft_inverse(const void *pPlan, const float *pBins, float *pOutput);
+		static void luadio_fft_generate_window(int32_t type, float *pWindow, uint32_t length);
+		static void luadio_fft_apply_window(const float *pInput, const float *pWindow, float *pOutput, uint32_t length);
+		static void luadio_fft_multiply(float *pBins, const float *pOther, uint32_t binCount);
+		static void luadio_fft_scale(float *pBins, const float *pGains, uint32_t binCount);
+		static void luadio_fft_get_magnitudes(const float *pBins, float *pMagnitudes, uint32_t binCount);
+		static void luadio_fft_overlap_add(float *pAccumulator, const float *pFrame, uint32_t frameSize, float *pOutput, uint32_t hopSize);
+		static void *luadio_stft_create(uint32_t size, uint32_t overlap, int32_t window);
+		static void luadio_stft_destroy(void *pStft);
+		static uint32_t luadio_stft_process(void *pStft, const float *pInput, float *pOutput, uint32_t frameCount, uint32_t stride);
+		static int32_t luadio_stft_is_ready(void *pStft);
+		static float *luadio_stft_get_bins(void *pStft);
+	};
+}
+
+#endif
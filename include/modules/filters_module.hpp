@@ -0,0 +1,35 @@
+#ifndef LUADIO_FILTERS_MODULE_HPP
+#define LUADIO_FILTERS_MODULE_HPP
+
+#include "lua_module.hpp"
+#include "../system/biquad.hpp"
+#include "../system/state_variable_filter.hpp"
+#include "../system/one_pole.hpp"
+#include "../system/delay_line.hpp"
+#include <cstdint>
+
+namespace luadio
+{
+	// Biquads, state variable filters, one poles and delay lines with block processing, available to scripts as luadio.filters
+	class filters_module : public lua_module
+	{
+	public:
+		void load(lua_State *L) override;
+	private:
+		static void luadio_biquad_set(biquad *pFilter, int32_t type, float frequency, float q, float gainDecibels, float sampleRate);
+		static void luadio_biquad_process(biquad *pFilter, const float *pInput, float *pOutput, uint32_t frameCount, uint32_t channels);
+		static void luadio_biquad_process_cascade(biquad *pStages, uint32_t stageCount, const float *pInput, float *pOutput, uint32_t frameCount, uint32_t channels);
+		static void luadio_svf_set(state_variable_filter *pFilter, int32_t type, float frequency, float q, float gainDecibels, float sampleRate);
+		static void luadio_svf_process(state_variable_filter *pFilter, const float *pInput, float *pOutput, uint32_t frameCount, uint32_t channels);
+		static void luadio_one_pole_set(one_pole *pFilter, int32_t type, float frequency, float sampleRate);
+		static void luadio_one_pole_set_time(one_pole *pFilter, float seconds, float sampleRate);
+		static void luadio_one_pole_process(one_pole *pFilter, const float *pInput, float *pOutput, uint32_t frameCount, uint32_t channels);
+		static delay_line *luadio_delay_line_create(uint32_t maxDelayFrames, uint32_t channels);
+		static void luadio_delay_line_destroy(delay_line *pDelay);
+		static void luadio_delay_line_reset(delay_line *pDelay);
+		static void luadio_delay_line_process(delay_line *pDelay, const float *pInput, float *pOutput, uint32_t frameCount, float delayFrames, float feedback, int32_t interpolation);
+		static void luadio_delay_line_process_modulated(delay_line *pDelay, const float *pInput, float *pOutput, const float *pDelayFrames, uint32_t frameCount, float feedback, int32_t interpolation);
+	};
+}
+
+#endif
@@ -4,23 +4,42 @@
 #include "lua_module.hpp"
 #include <functional>
 #include <string>
+#include <cstdint>
 
 namespace luadio
 {
 	using luadio_log_func = std::function<void(const std::string&)>;
 	using luadio_queue_audio_func = std::function<void(const std::string&)>;
+	using luadio_record_func = std::function<void(double,double)>;
+	using luadio_record_bus_func = std::function<void(const char*,const void*,uint32_t,uint32_t)>;
+	using luadio_get_frame_position_func = std::function<double()>;
+	using luadio_get_sample_rate_func = std::function<double()>;
+	using luadio_set_buffer_layout_func = std::function<void(int32_t)>;
+	using luadio_set_effect_bypass_func = std::function<void(bool)>;
 
 	class luadio_module : public lua_module
 	{
 	public:
 		static luadio_log_func onLog;
 		static luadio_queue_audio_func onQueueAudio;
+		static luadio_record_func onRecord;
+		static luadio_record_bus_func onRecordBus;
+		static luadio_get_frame_position_func onGetFramePosition;
+		static luadio_get_sample_rate_func onGetSampleRate;
+		static luadio_set_buffer_layout_func onSetBufferLayout;
+		static luadio_set_effect_bypass_func onSetEffectBypass;
 		void load(lua_State *L) override;
 	private:
 		static int luadio_find_function_pointer(lua_State *L);
 		static void luadio_print(const char *message);
 		static void luadio_play();
 		static void luadio_play_from_file(const char *filePath);
+		static void luadio_record(double startFrame, double stopFrame);
+		static void luadio_record_bus(const char *name, const void *pFrames, uint32_t frameCount, uint32_t channels);
+		static double luadio_get_frame_position();
+		static double luadio_get_sample_rate();
+		static void luadio_set_buffer_layout(int32_t layout);
+		static void luadio_set_effect_bypass(int32_t bypass);
 	};
 }
 
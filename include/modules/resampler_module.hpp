@@ -0,0 +1,26 @@
+#ifndef LUADIO_RESAMPLER_MODULE_HPP
+#define LUADIO_RESAMPLER_MODULE_HPP
+
+#include "lua_module.hpp"
+#include "../system/polyphase_resampler.hpp"
+#include <cstdint>
+
+namespace luadio
+{
+	// Polyphase sample rate conversion with fixed and varying ratios, available to scripts as luadio.resampler
+	class resampler_module : public lua_module
+	{
+	public:
+		void load(lua_State *L) override;
+	private:
+		static void *luadio_resampler_create(uint32_t channels, int32_t quality, double ratio, double maxRatio);
+		static void luadio_resampler_destroy(void *pResampler);
+		static void luadio_resampler_set_ratio(void *pResampler, double ratio);
+		static void luadio_resampler_reset(void *pResampler);
+		static uint32_t luadio_resampler_get_latency(void *pResampler);
+		static uint32_t luadio_resampler_process(void *pResampler, const float *pInput, uint32_t inputFrames, float *pOutput, uint32_t outputFrames, uint32_t *pInputUsed);
+		static uint32_t luadio_resampler_process_varying(void *pResampler, const float *pInput, uint32_t inputFrames, const float *pRatios, float *pOutput, uint32_t outputFrames, uint32_t *pInputUsed);
+	};
+}
+
+#endif
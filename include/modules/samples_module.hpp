@@ -0,0 +1,29 @@
+#ifndef LUADIO_SAMPLES_MODULE_HPP
+#define LUADIO_SAMPLES_MODULE_HPP
+
+#include "lua_module.hpp"
+#include "../system/sample_bank.hpp"
+#include "../system/sample_player.hpp"
+#include <cstdint>
+
+namespace luadio
+{
+	// Asynchronously loaded, shared sample buffers and one shot playback, available to scripts as luadio.samples
+	class samples_module : public lua_module
+	{
+	public:
+		// Owned by the app so samples outlive the scripts that load them
+		static sample_bank *pBank;
+		static sample_player *pPlayer;
+		void load(lua_State *L) override;
+	private:
+		static sample_data *luadio_samples_load(const char *filePath, uint32_t sampleRate);
+		static int32_t luadio_samples_get_status(sample_data *pSample);
+		static uint32_t luadio_samples_get_pending_count();
+		static int32_t luadio_samples_trigger(sample_data *pSample, float gain, float pan, double frame);
+		static void luadio_samples_stop_all();
+		static uint32_t luadio_samples_get_active_count();
+	};
+}
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef LUADIO_SEQUENCER_MODULE_HPP
+#define LUADIO_SEQUENCER_MODULE_HPP
+
+#include "lua_module.hpp"
+#include "../system/step_sequencer.hpp"
+#include "../system/arpeggiator.hpp"
+#include <cstdint>
+
+namespace luadio
+{
+	// Step sequencer and arpeggiator running on the transport clock, available to scripts as luadio.sequencer
+	class sequencer_module : public lua_module
+	{
+	public:
+		void load(lua_State *L) override;
+	private:
+		static void *luadio_sequencer_create(uint32_t length);
+		static void luadio_sequencer_destroy(void *pSequencer);
+		static sequencer_step *luadio_sequencer_get_steps(void *pSequencer);
+		static float *luadio_sequencer_get_parameters(void *pSequencer);
+		static float *luadio_sequencer_get_defaults(void *pSequencer);
+		static const note_event *luadio_sequencer_get_events(void *pSequencer);
+		static void luadio_sequencer_set_length(void *pSequencer, uint32_t length);
+		static void luadio_sequencer_set_rate(void *pSequencer, double stepsPerBeat);
+		static void luadio_sequencer_set_swing(void *pSequencer, double swing);
+		static void luadio_sequencer_set_seed(void *pSequencer, uint32_t seed);
+		static uint32_t luadio_sequencer_process(void *pSequencer, uint32_t frameCount);
+		static void luadio_sequencer_release_all(void *pSequencer);
+		static void *luadio_arpeggiator_create();
+		static void luadio_arpeggiator_destroy(void *pArpeggiator);
+		static const note_event *luadio_arpeggiator_get_events(void *pArpeggiator);
+		static void luadio_arpeggiator_note_on(void *pArpeggiator, int32_t note, float velocity);
+		static void luadio_arpeggiator_note_off(void *pArpeggiator, int32_t note);
+		static void luadio_arpeggiator_clear(void *pArpeggiator);
+		static void luadio_arpeggiator_set_mode(void *pArpeggiator, int32_t mode);
+		static void luadio_arpeggiator_set_octaves(void *pArpeggiator, uint32_t octaves);
+		static void luadio_arpeggiator_set_gate(void *pArpeggiator, float gate);
+		static void luadio_arpeggiator_set_rate(void *pArpeggiator, double stepsPerBeat);
+		static void luadio_arpeggiator_set_swing(void *pArpeggiator, double swing);
+		static uint32_t luadio_arpeggiator_process(void *pArpeggiator, uint32_t frameCount);
+		static void luadio_arpeggiator_release_all(void *pArpeggiator);
+	};
+}
+
+#endif
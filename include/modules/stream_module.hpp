@@ -0,0 +1,30 @@
+#ifndef LUADIO_STREAM_MODULE_HPP
+#define LUADIO_STREAM_MODULE_HPP
+
+#include "lua_module.hpp"
+#include "../system/file_stream.hpp"
+#include <cstdint>
+
+namespace luadio
+{
+	// Disk streaming of long audio files with read ahead, available to scripts as luadio.stream
+	class stream_module : public lua_module
+	{
+	public:
+		void load(lua_State *L) override;
+	private:
+		static void *luadio_stream_open(const char *filePath, uint32_t sampleRate);
+		static void luadio_stream_close(void *pStream);
+		static void luadio_stream_read(void *pStream, float *pOutput, uint32_t frameCount, uint32_t channels);
+		static void luadio_stream_seek(void *pStream, double frame);
+		static void luadio_stream_set_loop(void *pStream, int32_t loop);
+		static int32_t luadio_stream_get_status(void *pStream);
+		static double luadio_stream_get_position(void *pStream);
+		static double luadio_stream_get_length(void *pStream);
+		static uint32_t luadio_stream_get_channels(void *pStream);
+		static double luadio_stream_get_underruns(void *pStream);
+		static double luadio_stream_get_underrun_frames(void *pStream);
+	};
+}
+
+#endif
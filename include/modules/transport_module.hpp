@@ -0,0 +1,31 @@
+#ifndef LUADIO_TRANSPORT_MODULE_HPP
+#define LUADIO_TRANSPORT_MODULE_HPP
+
+#include "lua_module.hpp"
+#include "../system/transport.hpp"
+#include "../system/event_scheduler.hpp"
+#include <cstdint>
+
+namespace luadio
+{
+	// Audio driven transport clock and sample accurate event scheduling, available to scripts as luadio.transport
+	class transport_module : public lua_module
+	{
+	public:
+		// Owned by the app, which advances the clock and dispatches events while rendering
+		static transport *pTransport;
+		static event_scheduler *pScheduler;
+		void load(lua_State *L) override;
+	private:
+		static const transport_state *luadio_transport_get_state();
+		static void luadio_transport_set_tempo(double beatsPerMinute);
+		static void luadio_transport_set_beats_per_bar(uint32_t beatsPerBar);
+		static double luadio_transport_get_frame_of_beat(double beat);
+		static int32_t luadio_scheduler_schedule(double frame, int32_t id);
+		static int32_t luadio_scheduler_pop_due(double frame, double *pEventFrame);
+		static uint32_t luadio_scheduler_get_count();
+		static void luadio_scheduler_clear();
+	};
+}
+
+#endif
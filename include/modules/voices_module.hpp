@@ -0,0 +1,30 @@
+#ifndef LUADIO_VOICES_MODULE_HPP
+#define LUADIO_VOICES_MODULE_HPP
+
+#include "lua_module.hpp"
+#include "../system/voice_allocator.hpp"
+#include <cstdint>
+
+namespace luadio
+{
+	// Native polyphony with voice stealing and per voice rendering, available to scripts as luadio.voices
+	class voices_module : public lua_module
+	{
+	public:
+		void load(lua_State *L) override;
+	private:
+		static void *luadio_voices_create(uint32_t voiceCount, uint32_t sampleRate);
+		static void luadio_voices_destroy(void *pVoices);
+		static voice_data *luadio_voices_get_data(void *pVoices);
+		static void luadio_voices_set_envelope(void *pVoices, float attackSeconds, float decaySeconds, float sustainLevel, float releaseSeconds);
+		static void luadio_voices_set_steal_policy(void *pVoices, int32_t policy);
+		static int32_t luadio_voices_note_on(void *pVoices, int32_t note, float velocity);
+		static void luadio_voices_note_off(void *pVoices, int32_t note);
+		static void luadio_voices_all_notes_off(void *pVoices);
+		static void luadio_voices_reset(void *pVoices);
+		static void luadio_voices_render(void *pVoices, float *pOutput, uint32_t frameCount, uint32_t channels);
+		static void luadio_voices_render_events(void *pVoices, float *pOutput, uint32_t frameCount, uint32_t channels, const void *pEvents, uint32_t eventCount);
+	};
+}
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef LUADIO_ANALYSIS_WORKER_HPP
+#define LUADIO_ANALYSIS_WORKER_HPP
+
+#include "spsc_queue.hpp"
+#include "triple_buffer.hpp"
+#include "spectrogram.hpp"
+#include "waveform_pyramid.hpp"
+#include "triggered_scope.hpp"
+#include "loudness_meter.hpp"
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <memory>
+#include <cstdint>
+#include <cstdlib>
+
+namespace luadio
+{
+	// Display ready results of one analysis pass, small enough to copy around freely.
+	// Waveforms, scope and levels cover the first maxChannels channels of the output, the spectrum all of them.
+	struct analysis_frame
+	{
+		static constexpr uint32_t maxChannels = 2;
+		static constexpr uint32_t waveformColumns = 128;
+		static constexpr uint32_t spectrumBands = 64;
+		static constexpr float minDecibels = -90.0f;
+		uint32_t channels;
+		// Per channel minimum and maximum sample of each column, oldest column first.
+		// The columns span the waveform length set on the worker.
+		float waveformMin[maxChannels][waveformColumns];
+		float waveformMax[maxChannels][waveformColumns];
+		// Same layout for the triggered scope view, which starts at the trigger when scopeTriggered is set
+		float scopeMin[maxChannels][waveformColumns];
+		float scopeMax[maxChannels][waveformColumns];
+		bool scopeTriggered;
+		// Log frequency bands from 20 Hz to Nyquist, in dB relative to full scale
+		float spectrum[spectrumBands];
+		// Per channel levels of the most recent audio, in dB relative to full scale
+		float peakDecibels[maxChannels];
+		float rmsDecibels[maxChannels];
+	};
+
+	// Runs all visual analysis of the output on its own thread.
+	// The audio thread only copies blocks into a lock free tap, so the cost of the analysis
+	// never shows up on the audio thread or in the UI frame time. Results are handed to the UI
+	// through a triple buffer, the UI only draws them.
+	class analysis_worker
+	{
+	public:
+		static constexpr uint32_t scopeFrames = 1024;
+		static constexpr float maxWaveformSeconds = 10.0f;
+		analysis_worker();
+		~analysis_worker();
+		void start(uint32_t sampleRate, uint32_t channels);
+		void stop();
+		void write(const float *pFrames, uint32_t frameCount, uint32_t channels);
+		void set_spectrogram_settings(const spectrogram_settings &settings);
+		spectrogram_settings get_spectrogram_settings() const;
+		const spectrogram &get_spectrogram() const;
+		// Length of audio shown by the waveform columns, up to maxWaveformSeconds
+		void set_waveform_seconds(float seconds);
+		float get_waveform_seconds() const;
+		void set_scope_settings(const scope_settings &settings);
+		scope_settings get_scope_settings() const;
+		// Results are published through atomics and can be read at any time
+		loudness_meter &get_loudness();
+		// Only call from the UI thread, returns the most recently published frame
+		const analysis_frame &get_frame();
+	private:
+		spsc_queue<float> tap;
+		std::thread thread;
+		std::atomic<bool> running;
+		std::atomic<bool> settingsChanged;
+		std::atomic<bool> scopeSettingsChanged;
+		std::atomic<float> waveformSeconds;
+		mutable std::mutex settingsMutex;
+		spectrogram_settings settings;
+		scope_settings triggerSettings;
+		spectrogram spectrum;
+		std::unique_ptr<triple_buffer<analysis_frame>> frames;
+		uint32_t sampleRate;
+		uint32_t channels;
+		std::vector<float> readBuffer;
+		std::vector<float> monoBuffer;
+		std::vector<float> scope;
+		size_t scopePosition;
+		waveform_pyramid pyramid;
+		triggered_scope oscilloscope;
+		loudness_meter loudness;
+		std::shared_ptr<const fft_plan> plan;
+		std::vector<float> window;
+		std::vector<float> fftInput;
+		std::vector<std::complex<float>> fftOutput;
+		spectrum_band bands[analysis_frame::spectrumBands];
+		float spectrumScale;
+		void run();
+		void write_scope(const float *pFrames, size_t frameCount);
+		void publish_frame(const float *pNewFrames, size_t frameCount);
+		void compute_waveform(analysis_frame &frame);
+		void compute_scope(analysis_frame &frame);
+		void compute_spectrum(analysis_frame &frame);
+		void compute_levels(analysis_frame &frame, const float *pNewFrames, size_t frameCount);
+	};
+}
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef LUADIO_ARPEGGIATOR_HPP
+#define LUADIO_ARPEGGIATOR_HPP
+
+#include "pattern_clock.hpp"
+#include <cstdint>
+#include <cstdlib>
+
+namespace luadio
+{
+	enum arp_mode
+	{
+		arp_mode_up,
+		arp_mode_down,
+		arp_mode_up_down,
+		arp_mode_played,
+		arp_mode_random
+	};
+
+	// Plays the held notes one step at a time on the transport grid.
+	// The note order is rebuilt only when notes or settings change. The pattern restarts from
+	// the beginning whenever a note is pressed while nothing was held.
+	class arpeggiator
+	{
+	public:
+		static constexpr uint32_t maxNotes = 16;
+		static constexpr uint32_t maxOctaves = 4;
+		arpeggiator();
+		void note_on(int32_t note, float velocity);
+		void note_off(int32_t note);
+		void clear();
+		void set_mode(arp_mode mode);
+		void set_octaves(uint32_t octaves);
+		void set_gate(float gate);
+		void set_rate(double stepsPerBeat);
+		void set_swing(double swing);
+		uint32_t process(const transport_state &state, uint32_t frameCount);
+		const note_event *get_events() const;
+		void release_all();
+	private:
+		pattern_clock clock;
+		int32_t heldNotes[maxNotes];
+		float heldVelocities[maxNotes];
+		uint32_t heldCount;
+		int32_t pattern[maxNotes * maxOctaves * 2];
+		float patternVelocities[maxNotes * maxOctaves * 2];
+		uint32_t patternLength;
+		uint64_t position;
+		arp_mode mode;
+		uint32_t octaves;
+		float gate;
+		void build_pattern();
+	};
+}
+
+#endif
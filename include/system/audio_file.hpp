@@ -0,0 +1,18 @@
+#ifndef LUADIO_AUDIO_FILE_HPP
+#define LUADIO_AUDIO_FILE_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace luadio
+{
+	class audio_file
+	{
+	public:
+		// Decodes a whole file into interleaved floats, converted to sampleRate. The channel count of the file is kept.
+		static bool read(const std::string &filePath, uint32_t sampleRate, std::vector<float> &frames, uint32_t &channels);
+	};
+}
+
+#endif
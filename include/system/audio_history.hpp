@@ -0,0 +1,40 @@
+#ifndef LUADIO_AUDIO_HISTORY_HPP
+#define LUADIO_AUDIO_HISTORY_HPP
+
+#include "pcm_converter.hpp"
+#include <vector>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <cstdint>
+#include <cstdlib>
+
+namespace luadio
+{
+	// Always-on ring holding the most recent output so a take can be saved after it happened.
+	// The audio thread only copies each block into the ring and publishes the new write position,
+	// the wave file is written on a background thread.
+	class audio_history
+	{
+	public:
+		audio_history();
+		~audio_history();
+		void initialize(uint32_t maxSeconds, uint32_t sampleRate, uint32_t channels);
+		void write(const float *pFrames, uint32_t frameCount, uint32_t channels);
+		bool save(float seconds, pcm_format format, bool dither);
+		bool is_saving() const;
+		float get_max_seconds() const;
+		float get_available_seconds() const;
+	private:
+		std::vector<float> buffer;
+		uint64_t capacity;
+		uint32_t sampleRate;
+		uint32_t channels;
+		std::atomic<uint64_t> writePosition;
+		std::atomic<bool> saving;
+		std::thread saveThread;
+		void save_to_file(std::string filePath, uint64_t frameCount, pcm_format format, bool dither);
+	};
+}
+
+#endif
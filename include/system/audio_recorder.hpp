@@ -1,48 +1,145 @@
 #ifndef LUADIO_AUDIO_RECORDER_HPP
 #define LUADIO_AUDIO_RECORDER_HPP
 
-#include <vector>
+#include "wav_writer.hpp"
+#include "spsc_queue.hpp"
 #include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <thread>
 #include <cstdint>
 #include <cstdlib>
-#include <fstream>
-#include <mutex>
 
 namespace luadio
 {
+	// Records the output to wave files between two absolute frame positions.
+	// Positions are frames of the transport as they reach the output, passed in by the audio thread,
+	// so boundaries land on the exact frame regardless of when the request was made. All shared state
+	// is published through atomics.
+	// Besides the final mix, the dry signal and any bus a script writes are recorded as separate stems.
+	// The audio thread only copies frames into lock free rings, one background thread does all file I/O.
 	class audio_recorder
 	{
 	public:
+		static constexpr uint64_t endless = UINT64_MAX;
+		static constexpr uint32_t maxStems = 16;
 		audio_recorder();
 		~audio_recorder();
 		void start();
 		void stop();
-		void on_process(const float* pFrames, uint32_t frameCount, uint32_t channels);
+		void start_at(uint64_t frame, uint64_t stopFrame = endless);
+		void stop_at(uint64_t frame);
+		// frame is the transport frame of the first frame of the block
+		void on_process(const float *pDry, const float *pMix, uint32_t frameCount, uint32_t channels, uint64_t frame);
+		void on_idle();
+		// Only call while no audio is processed, when the transport is reset
+		void set_frame_position(uint64_t frame);
+		// frame is the transport frame of the first frame written, writes to the same frames of a bus are mixed
+		void write_bus(const char *name, const float *pFrames, uint32_t frameCount, uint32_t channels, uint64_t frame);
+		void write_bus(const char *name, const float *const *ppChannels, uint32_t frameCount, uint32_t channels, uint64_t frame);
+		// Frees all bus slots once no session uses them, the next script claims them again with its own names
+		void release_buses();
 		bool is_recording() const;
+		uint64_t get_frame_position() const;
+		uint64_t get_dropped_blocks() const;
+		// Bus writes refused because all slots were taken or the channel count did not match
+		uint64_t get_dropped_bus_writes() const;
+		void set_format(pcm_format format);
+		pcm_format get_format() const;
+		void set_dither(bool enabled);
+		bool get_dither() const;
+		void set_record_dry(bool enabled);
+		bool get_record_dry() const;
+		void set_record_buses(bool enabled);
+		bool get_record_buses() const;
+		// Rate written to the file header of the next session
+		void set_sample_rate(uint32_t sampleRate);
+		uint32_t get_sample_rate() const;
 	private:
         enum recorder_state
         {
             recorder_state_idle,
-            recorder_state_write_header,
-            recorder_state_write_data
+            recorder_state_armed,
+            recorder_state_recording
         };
 
-        std::string currentFileName;
-        std::vector<uint8_t> outputBuffer;
-        uint64_t bytesWritten;
-        std::ofstream stream;
-        recorder_state state;
-        mutable std::mutex mutex;
-
-		recorder_state get_state() const;
-		void set_state(recorder_state newState);
-		void write_header(uint32_t channels);
-		void write_data(const float* pFrames, uint32_t frameCount, uint32_t channels);
-		void close_file();
-		void write_int16(int16_t value, uint8_t *buffer, int32_t offset);
-		void write_int32(int32_t value, uint8_t *buffer, int32_t offset);
-		void write_float(float value, uint8_t *buffer, int32_t offset);
+		enum stem_index
+		{
+			stem_index_mix,
+			stem_index_dry,
+			stem_index_first_bus
+		};
+
+		enum io_command_type
+		{
+			io_command_type_open,
+			io_command_type_data,
+			io_command_type_close
+		};
+
+		struct io_command
+		{
+			io_command_type type;
+			uint32_t stemMask;
+			uint32_t frameCount;
+			pcm_format format;
+			bool dither;
+		};
+
+		struct stem
+		{
+			char name[32];
+			std::atomic<bool> active;
+			uint32_t channels;
+			// Set once the bus was written for a recorded frame, it stays in the session from then on
+			bool inSession;
+			// Bus frames wait here until the output reaches them, each slot keeps the frame it holds
+			std::vector<float> staging;
+			std::vector<uint64_t> stagedFrames;
+			spsc_queue<float> ring;
+			wav_writer writer;
+			uint64_t framesWritten;
+		};
+
+        std::vector<std::unique_ptr<stem>> stems;
+        spsc_queue<io_command> commands;
+        std::thread ioThread;
+        std::atomic<bool> running;
+        std::atomic<pcm_format> format;
+        std::atomic<bool> dither;
+        std::atomic<bool> recordDry;
+        std::atomic<bool> recordBuses;
+        std::atomic<uint32_t> sampleRate;
+        std::atomic<recorder_state> state;
+        std::atomic<uint64_t> startFrame;
+        std::atomic<uint64_t> stopFrame;
+        std::atomic<uint64_t> framePosition;
+        uint64_t stagingPosition;
+        std::atomic<uint64_t> droppedBlocks;
+        std::atomic<uint64_t> droppedBusWrites;
+        std::atomic<bool> releaseRequested;
+        // Sessions the audio thread opened and the I/O thread closed, bus slots are only freed while equal
+        std::atomic<uint64_t> sessionsOpened;
+        std::atomic<uint64_t> sessionsClosed;
+        std::string sessionName;
+        pcm_format sessionFormat;
+        bool sessionDither;
+        uint64_t sessionFrames;
+        std::vector<float> ioBuffer;
+        std::vector<float> busBuffer;
+
+		void check_stop(uint64_t blockEnd);
+		bool push_frames(const float *pDry, const float *pMix, uint32_t offset, uint32_t frameCount, uint32_t channels, uint64_t frame);
+		stem *find_bus(const char *name, uint32_t channels);
+		void sync_staging();
+		bool has_staged_frames(const stem &s, uint64_t frame, uint32_t frameCount) const;
+		uint32_t get_staging_capacity(uint32_t channels) const;
+		void io_loop();
+		void io_write(const io_command &command);
+		void io_close();
+		std::string get_stem_file_name(const stem &s) const;
 	};
 }
 
-#endif
\ No newline at end of file
+#endif
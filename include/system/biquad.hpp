@@ -0,0 +1,32 @@
+#ifndef LUADIO_BIQUAD_HPP
+#define LUADIO_BIQUAD_HPP
+
+#include "filter_type.hpp"
+#include <type_traits>
+#include <cstdint>
+#include <cstdlib>
+
+namespace luadio
+{
+	// Second order IIR filter with coefficients from the RBJ audio EQ cookbook, run as transposed direct form II.
+	// Plain data so scripts can allocate it through FFI, the layout is mirrored in luadio.filters.
+	// Interleaved channels are processed four at a time in one vector.
+	struct biquad
+	{
+		static constexpr uint32_t maxChannels = 16;
+		float b0, b1, b2, a1, a2;
+		float z1[maxChannels];
+		float z2[maxChannels];
+		// gainDecibels is only used by peak and shelf filters
+		void set(filter_type type, float frequency, float q, float gainDecibels, float sampleRate);
+		void reset();
+		// Input and output may be the same buffer
+		void process(const float *pInput, float *pOutput, size_t frameCount, uint32_t channels);
+		// Runs the block through every stage in order, for slopes steeper than 12 dB per octave
+		static void process_cascade(biquad *pStages, uint32_t stageCount, const float *pInput, float *pOutput, size_t frameCount, uint32_t channels);
+	};
+
+	static_assert(std::is_standard_layout_v<biquad> && std::is_trivially_copyable_v<biquad>);
+}
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef LUADIO_BUFFER_OPS_HPP
+#define LUADIO_BUFFER_OPS_HPP
+
+#include <cstdlib>
+#include <cstdint>
+
+namespace luadio
+{
+	// Vectorized kernels for the per block work scripts do on sample buffers.
+	// Counts are in samples unless named frameCount. Destination comes first, and unless noted
+	// the destination may be the same buffer as a source, so every operation also works in place.
+	class buffer_ops
+	{
+	public:
+		static void clear(float *pDst, size_t count);
+		static void copy(float *pDst, const float *pSrc, size_t count);
+		// dst = src * gain
+		static void gain(float *pDst, const float *pSrc, float gain, size_t count);
+		// dst = src * gain where gain moves linearly from startGain towards endGain, avoids zipper noise
+		static void gain_ramp(float *pDst, const float *pSrc, float startGain, float endGain, size_t count);
+		// dst += src * gain
+		static void accumulate(float *pDst, const float *pSrc, float gain, size_t count);
+		// dst = a * gainA + b * gainB
+		static void mix(float *pDst, const float *pA, float gainA, const float *pB, float gainB, size_t count);
+		// Hard clips into [minimum, maximum]
+		static void clip(float *pDst, const float *pSrc, float minimum, float maximum, size_t count);
+		// Equal power pan of a mono buffer into interleaved stereo, pan goes from -1 (left) to 1 (right).
+		// pDst holds frameCount * 2 samples and must not overlap pSrc.
+		static void pan(float *pDst, const float *pSrc, float pan, size_t frameCount);
+		// Equal power balance of interleaved stereo
+		static void balance(float *pDst, const float *pSrc, float pan, size_t frameCount);
+		// Planar (all frames of channel 0, then channel 1, ...) to interleaved and back, buffers must not overlap
+		static void interleave(float *pDst, const float *pSrc, size_t frameCount, uint32_t channels);
+		static void deinterleave(float *pDst, const float *pSrc, size_t frameCount, uint32_t channels);
+		// Same with every channel in its own buffer
+		static void interleave(float *pDst, const float *const *ppSrc, size_t frameCount, uint32_t channels);
+		static void deinterleave(float *const *ppDst, const float *pSrc, size_t frameCount, uint32_t channels);
+		// Largest absolute sample value
+		static float get_peak(const float *pSrc, size_t count);
+	private:
+		static void get_pan_gains(float pan, float &left, float &right);
+	};
+}
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef LUADIO_CONVOLUTION_ENGINE_HPP
+#define LUADIO_CONVOLUTION_ENGINE_HPP
+
+#include "uniform_convolver.hpp"
+#include "spsc_queue.hpp"
+#include <vector>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <cstdint>
+#include <cstdlib>
+
+namespace luadio
+{
+	enum convolution_status
+	{
+		convolution_status_loading,
+		convolution_status_ready,
+		convolution_status_failed
+	};
+
+	// Low latency convolution with long impulse responses such as reverbs.
+	// The impulse response is split into segments of growing partition size. The head uses the
+	// block size so latency stays at one block, the middle runs with a larger partition on the
+	// audio thread, and the tail runs with the largest partition on its own thread. The middle and
+	// the tail start two of their partitions into the impulse response, so each has a whole partition
+	// of time to deliver before its output is due. The middle spreads its transforms evenly over the
+	// blocks of that partition instead of doing them all in one block. Loading, decoding and
+	// transforming the impulse response happen on a loader thread, the engine outputs silence until it is ready.
+	class convolution_engine
+	{
+	public:
+		// blockSize is rounded up to a power of two
+		convolution_engine(uint32_t channels, uint32_t blockSize);
+		~convolution_engine();
+		// Starts loading the impulse response in the background, only call once
+		void load(const std::string &filePath, uint32_t sampleRate);
+		// Same as load but with samples already in memory, interleaved with irChannels channels
+		void load(const float *pImpulse, size_t frameCount, uint32_t irChannels);
+		// Writes only the wet signal, input and output are interleaved with the given number of channels
+		void process(const float *pInput, float *pOutput, uint32_t frameCount, uint32_t channels);
+		convolution_status get_status() const;
+		// Delay of the wet signal in frames
+		uint32_t get_latency() const;
+		// Number of blocks in which the tail thread did not deliver in time
+		uint64_t get_late_blocks() const;
+	private:
+		struct segment
+		{
+			uint32_t offset;
+			uint32_t partitionSize;
+			bool threaded;
+			std::vector<std::unique_ptr<uniform_convolver>> convolvers;
+			// Inline segments collect input here until a partition is full, and work on the
+			// pending partition in steps while the next one fills
+			std::vector<std::vector<float>> inputChunks;
+			std::vector<std::vector<float>> pendingChunks;
+			uint32_t inputPosition;
+			uint32_t blockIndex;
+			uint32_t step;
+			uint32_t stepsPerChannel;
+			uint32_t stepCount;
+			std::vector<float> outputChunk;
+			// Per channel input to the thread and output of any segment
+			std::vector<std::unique_ptr<spsc_queue<float>>> inputQueues;
+			std::vector<std::unique_ptr<spsc_queue<float>>> outputQueues;
+			// Samples owed by the thread after a late block, dropped as soon as they arrive
+			std::vector<size_t> outputDebt;
+		};
+
+		uint32_t channels;
+		uint32_t blockSize;
+		uint32_t blockPosition;
+		std::vector<float> inputBlock;
+		std::vector<float> outputBlock;
+		std::vector<float> scratch;
+		std::vector<std::unique_ptr<segment>> segments;
+		std::atomic<convolution_status> status;
+		std::atomic<bool> running;
+		std::atomic<uint64_t> lateBlocks;
+		std::thread loader;
+		std::thread worker;
+		void prepare(const float *pImpulse, size_t frameCount, uint32_t irChannels);
+		void add_segment(uint32_t offset, uint32_t partitionSize, size_t length, const float *pImpulse, uint32_t irChannels, bool threaded);
+		void process_block();
+		void run_step(segment &s, uint32_t step);
+		void run();
+	};
+}
+
+#endif
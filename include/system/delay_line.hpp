@@ -0,0 +1,46 @@
+#ifndef LUADIO_DELAY_LINE_HPP
+#define LUADIO_DELAY_LINE_HPP
+
+#include <type_traits>
+#include <cstdint>
+#include <cstdlib>
+
+namespace luadio
+{
+	enum interpolation_type
+	{
+		interpolation_type_none,
+		interpolation_type_linear,
+		interpolation_type_cubic
+	};
+
+	// Interleaved multichannel delay line with fractional delay times and feedback.
+	// The buffer is a power of two so positions wrap with a mask. The fields are mirrored in
+	// luadio.filters so scripts can read them, the buffer is owned by the delay line.
+	struct delay_line
+	{
+		float *pBuffer;
+		uint32_t length;
+		uint32_t mask;
+		uint32_t writePosition;
+		uint32_t channels;
+		// Holds at least maxDelayFrames of history
+		delay_line(uint32_t maxDelayFrames, uint32_t channels);
+		~delay_line();
+		delay_line(const delay_line&) = delete;
+		delay_line &operator=(const delay_line&) = delete;
+		void reset();
+		uint32_t get_max_delay() const;
+		// Writes the delayed signal to pOutput and input plus feedback times the delayed signal into the line.
+		// Input and output may be the same buffer.
+		void process(const float *pInput, float *pOutput, size_t frameCount, float delayFrames, float feedback, interpolation_type interpolation);
+		// Same but with one delay time per frame, for chorus, flanger and vibrato
+		void process_modulated(const float *pInput, float *pOutput, const float *pDelayFrames, size_t frameCount, float feedback, interpolation_type interpolation);
+	private:
+		float read(uint32_t channel, float delayFrames, interpolation_type interpolation) const;
+	};
+
+	static_assert(std::is_standard_layout_v<delay_line>);
+}
+
+#endif
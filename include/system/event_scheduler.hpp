@@ -0,0 +1,40 @@
+#ifndef LUADIO_EVENT_SCHEDULER_HPP
+#define LUADIO_EVENT_SCHEDULER_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+
+namespace luadio
+{
+	// Time ordered queue of event ids, keyed by absolute transport frame.
+	// A binary heap in storage reserved up front, so scheduling and dispatching never allocate
+	// or lock. Events on the same frame come out in the order they were scheduled.
+	// Not thread safe, the app only touches it while holding the script lock.
+	class event_scheduler
+	{
+	public:
+		static constexpr uint32_t capacity = 4096;
+		event_scheduler();
+		// Returns false when the queue is full
+		bool schedule(uint64_t frame, int32_t id);
+		// Takes the earliest event at or before frame and the frame it was scheduled for, returns false if there is none
+		bool pop_due(uint64_t frame, int32_t &id, uint64_t &eventFrame);
+		// Frame of the earliest event, UINT64_MAX when empty
+		uint64_t get_next_frame() const;
+		uint32_t get_count() const;
+		void clear();
+	private:
+		struct event
+		{
+			uint64_t frame;
+			uint64_t sequence;
+			int32_t id;
+		};
+		std::vector<event> heap;
+		uint64_t sequence;
+		static bool is_before(const event &a, const event &b);
+	};
+}
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef LUADIO_FFT_PLAN_HPP
+#define LUADIO_FFT_PLAN_HPP
+
+#include <cstdlib>
+#include <cstdint>
+#include <vector>
+#include <complex>
+#include <memory>
+
+namespace luadio
+{
+	// Precomputed real-input FFT of a fixed power of two size.
+	// A real transform of size N runs as a complex transform of size N/2 followed by a split step.
+	// The complex transform uses fused radix-2^2 passes with twiddles computed once in double precision.
+	// A plan is immutable after construction, so one plan can be used from several threads at once.
+	class fft_plan
+	{
+	public:
+		fft_plan(size_t size);
+		size_t get_size() const;
+		size_t get_bin_count() const;
+		// pOutput receives size / 2 + 1 bins, pInput holds size samples
+		void forward(const float *pInput, std::complex<float> *pOutput) const;
+		// pInput holds size / 2 + 1 bins, pOutput receives size samples, scaled so inverse(forward(x)) == x
+		void inverse(const std::complex<float> *pInput, float *pOutput) const;
+		// Returns a shared plan for the given size, plans are created once and cached
+		static std::shared_ptr<const fft_plan> get(size_t size);
+	private:
+		struct pass
+		{
+			size_t half;
+			size_t twiddleOffset;
+		};
+		size_t size;
+		size_t complexSize;
+		bool radix2Pass;
+		std::vector<pass> passes;
+		std::vector<uint32_t> bitReverse;
+		std::vector<float> twiddles;
+		std::vector<std::complex<float>> splitTwiddles;
+		void transform(std::complex<float> *pData) const;
+		void fused_pass(std::complex<float> *pData, const pass &p) const;
+	};
+}
+
+#endif
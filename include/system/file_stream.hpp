@@ -0,0 +1,87 @@
+#ifndef LUADIO_FILE_STREAM_HPP
+#define LUADIO_FILE_STREAM_HPP
+
+#include "spsc_queue.hpp"
+#include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <cstdint>
+#include <cstdlib>
+
+namespace luadio
+{
+	enum stream_status
+	{
+		// Opening, or refilling after a seek
+		stream_status_buffering,
+		stream_status_playing,
+		stream_status_ended,
+		stream_status_failed
+	};
+
+	// Plays a file of any length from disk with constant memory.
+	// An I/O thread decodes ahead into a fixed ring of chunks and hands them to the audio thread
+	// through lock free queues, the audio thread only copies frames and returns used chunks.
+	// A seek tags the chunks that follow with a new generation, the reader drops anything older,
+	// so the first frame after a seek is exactly the requested one. Frames the reader needed while
+	// the ring was empty are output as silence and counted as underruns.
+	class file_stream
+	{
+	public:
+		static constexpr uint32_t chunkFrames = 4096;
+		static constexpr uint32_t chunkCount = 16;
+		file_stream(const std::string &filePath, uint32_t sampleRate);
+		~file_stream();
+		file_stream(const file_stream&) = delete;
+		file_stream &operator=(const file_stream&) = delete;
+		// Audio thread, overwrites frameCount frames of pOutput mapped to the given channel count
+		void read(float *pOutput, uint32_t frameCount, uint32_t channels);
+		// Any thread, the stream continues at frame once it has been prefetched
+		void seek(uint64_t frame);
+		void set_loop(bool loop);
+		stream_status get_status() const;
+		// Frame of the file the next read starts at
+		uint64_t get_position() const;
+		// Length in frames, 0 until the file is open or if the format does not report it
+		uint64_t get_length() const;
+		uint32_t get_channels() const;
+		// Number of reads that ran out of buffered frames, and the frames of silence they produced
+		uint64_t get_underruns() const;
+		uint64_t get_underrun_frames() const;
+	private:
+		struct chunk
+		{
+			std::vector<float> frames;
+			uint64_t startFrame;
+			uint32_t frameCount;
+			uint32_t generation;
+		};
+		std::string filePath;
+		uint32_t sampleRate;
+		chunk chunks[chunkCount];
+		spsc_queue<uint32_t> filledChunks;
+		spsc_queue<uint32_t> freeChunks;
+		std::thread thread;
+		std::atomic<bool> running;
+		std::atomic<bool> loop;
+		std::atomic<stream_status> status;
+		std::atomic<uint32_t> generation;
+		// Generation the I/O thread is decoding, and the one whose decoding reached the end of the file
+		std::atomic<uint32_t> activeGeneration;
+		std::atomic<uint32_t> finishedGeneration;
+		std::atomic<uint64_t> seekFrame;
+		std::atomic<uint64_t> position;
+		std::atomic<uint64_t> length;
+		std::atomic<uint32_t> channels;
+		std::atomic<uint64_t> underruns;
+		std::atomic<uint64_t> underrunFrames;
+		// Reader state, only touched by the audio thread
+		int32_t currentChunk;
+		uint32_t chunkOffset;
+		uint32_t readerGeneration;
+		void run();
+	};
+}
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef LUADIO_FILTER_TYPE_HPP
+#define LUADIO_FILTER_TYPE_HPP
+
+namespace luadio
+{
+	enum filter_type
+	{
+		filter_type_lowpass,
+		filter_type_highpass,
+		filter_type_bandpass,
+		filter_type_notch,
+		filter_type_allpass,
+		filter_type_peak,
+		filter_type_lowshelf,
+		filter_type_highshelf
+	};
+}
+
+#endif
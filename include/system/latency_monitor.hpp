@@ -0,0 +1,53 @@
+#ifndef LUADIO_LATENCY_MONITOR_HPP
+#define LUADIO_LATENCY_MONITOR_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+
+namespace luadio
+{
+	// Measures how the device actually drives the engine.
+	// The audio thread stamps every callback with the time it spent working and closes a period
+	// once the last callback of it ran. Block size, callback interval and load are published
+	// through atomics, so the UI can show what a chosen period size really costs.
+	class latency_monitor
+	{
+	public:
+		latency_monitor();
+		void reset(uint32_t sampleRate);
+		// Nanoseconds on a monotonic clock, taken at the start of a callback
+		static uint64_t now();
+		// Adds the time since start to the work of the current period
+		void add_work(uint64_t start);
+		// Adds the time since start and publishes the period, start is also used to measure the interval
+		void end_period(uint64_t start, uint32_t frameCount);
+		uint32_t get_block_size() const;
+		uint32_t get_max_block_size() const;
+		// Milliseconds between the starts of two periods
+		float get_average_interval() const;
+		float get_max_interval() const;
+		// Work time relative to the duration of the audio it produced
+		float get_average_load() const;
+		float get_peak_load() const;
+		// Periods that started later than 1.5 times their duration, each one risks a dropout
+		uint64_t get_late_periods() const;
+	private:
+		std::atomic<uint32_t> sampleRate;
+		uint64_t lastStart;
+		uint64_t work;
+		float averageIntervalState;
+		float averageLoadState;
+		std::atomic<bool> resetRequested;
+		std::atomic<uint32_t> blockSize;
+		std::atomic<uint32_t> maxBlockSize;
+		std::atomic<float> averageInterval;
+		std::atomic<float> maxInterval;
+		std::atomic<float> averageLoad;
+		std::atomic<float> peakLoad;
+		std::atomic<uint64_t> latePeriods;
+		void clear();
+	};
+}
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef LUADIO_LOUDNESS_METER_HPP
+#define LUADIO_LOUDNESS_METER_HPP
+
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+
+namespace luadio
+{
+	// Loudness and level metering as described in ITU-R BS.1770-4 and EBU R128.
+	// Audio is K-weighted and summed in 100 ms blocks. Momentary (400 ms) and short term (3 s)
+	// loudness are taken from the most recent blocks, integrated loudness from a histogram of
+	// gated 400 ms blocks, so memory stays constant no matter how long a session runs.
+	// True peak is measured on a 4x oversampled signal. process() runs on one worker thread,
+	// every result is published through atomics and can be read from any thread.
+	class loudness_meter
+	{
+	public:
+		static constexpr uint32_t maxChannels = 16;
+		loudness_meter();
+		void initialize(uint32_t sampleRate, uint32_t channels);
+		void process(const float *pFrames, size_t frameCount);
+		// Clears integrated loudness and the maximum true peak, takes effect on the next process call
+		void reset();
+		uint32_t get_channels() const;
+		// Loudness in LUFS, negative infinity while there is nothing to measure
+		float get_momentary() const;
+		float get_short_term() const;
+		float get_integrated() const;
+		// Levels in dB relative to full scale
+		float get_true_peak(uint32_t channel) const;
+		float get_rms(uint32_t channel) const;
+		float get_peak_hold(uint32_t channel) const;
+	private:
+		struct biquad
+		{
+			double b0, b1, b2, a1, a2;
+		};
+
+		struct channel_state
+		{
+			double shelfZ1, shelfZ2;
+			double highPassZ1, highPassZ2;
+			double weightedSum;
+			double squareSum;
+			float samplePeak;
+			float truePeak;
+			float peakHold;
+			uint32_t holdBlocks;
+			uint32_t historyPosition;
+			float history[2 * 12];
+		};
+
+		static constexpr uint32_t shortTermBlocks = 30;
+		static constexpr uint32_t momentaryBlocks = 4;
+		static constexpr uint32_t rmsBlocks = 3;
+		static constexpr uint32_t oversampling = 4;
+		static constexpr uint32_t tapsPerPhase = 12;
+		static constexpr uint32_t histogramBins = 1000;
+
+		uint32_t sampleRate;
+		uint32_t channels;
+		uint32_t blockFrames;
+		uint32_t framesInBlock;
+		uint64_t blockCount;
+		biquad shelf;
+		biquad highPass;
+		float channelWeights[maxChannels];
+		float truePeakFilter[oversampling][tapsPerPhase];
+		channel_state states[maxChannels];
+		double weightedBlocks[shortTermBlocks];
+		double squareBlocks[rmsBlocks][maxChannels];
+		std::vector<uint32_t> histogramCounts;
+		std::vector<double> histogramEnergy;
+		std::atomic<bool> resetRequested;
+		std::atomic<float> momentary;
+		std::atomic<float> shortTerm;
+		std::atomic<float> integrated;
+		std::atomic<float> truePeaks[maxChannels];
+		std::atomic<float> rmsLevels[maxChannels];
+		std::atomic<float> peakHolds[maxChannels];
+
+		void clear();
+		void end_block();
+		float measure_true_peak(channel_state &state, float sample) const;
+		float compute_integrated() const;
+	};
+}
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef LUADIO_MEMORY_MAPPED_FILE_HPP
+#define LUADIO_MEMORY_MAPPED_FILE_HPP
+
+#include <string>
+#include <cstdint>
+#include <cstdlib>
+
+namespace luadio
+{
+	// Read only view of a whole file through the virtual memory system.
+	// Pages are read on first access, nothing is copied into user buffers.
+	class memory_mapped_file
+	{
+	public:
+		memory_mapped_file();
+		~memory_mapped_file();
+		memory_mapped_file(const memory_mapped_file&) = delete;
+		memory_mapped_file &operator=(const memory_mapped_file&) = delete;
+		bool open(const std::string &filePath);
+		void close();
+		const uint8_t *get_data() const;
+		size_t get_size() const;
+	private:
+		const uint8_t *pData;
+		size_t size;
+#ifdef _WIN32
+		void *fileHandle;
+		void *mappingHandle;
+#else
+		int fileDescriptor;
+#endif
+	};
+}
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef LUADIO_NOTE_EVENT_HPP
+#define LUADIO_NOTE_EVENT_HPP
+
+#include <type_traits>
+#include <cstdint>
+
+namespace luadio
+{
+	enum note_event_type
+	{
+		note_event_type_note_off,
+		note_event_type_parameter,
+		note_event_type_note_on
+	};
+
+	// Event at a frame offset within the current block, produced by pattern generators and consumed
+	// by the voice allocator. For parameter events note holds the parameter index and value the new value.
+	// Plain data so scripts can read event lists through FFI, the layout is mirrored in luadio.sequencer.
+	struct note_event
+	{
+		uint32_t offset;
+		int32_t type;
+		int32_t note;
+		float value;
+	};
+
+	static_assert(std::is_standard_layout_v<note_event> && std::is_trivially_copyable_v<note_event>);
+}
+
+#endif
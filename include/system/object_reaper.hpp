@@ -0,0 +1,43 @@
+#ifndef LUADIO_OBJECT_REAPER_HPP
+#define LUADIO_OBJECT_REAPER_HPP
+
+#include "spsc_queue.hpp"
+#include <atomic>
+#include <thread>
+
+namespace luadio
+{
+	// Deletes objects on a background thread.
+	// Objects owning threads join them when destroyed, which blocks for as long as those threads are busy.
+	// Scripts release such objects from the garbage collector, which may run on the audio thread, so
+	// they are handed over here instead of being deleted in place.
+	class object_reaper
+	{
+	public:
+		using delete_function = void (*)(void *pObject);
+		~object_reaper();
+		static object_reaper &get();
+		// Callers must be serialized, scripts do so through the Lua mutex. Deletes in place if the queue is full
+		void dispose(void *pObject, delete_function pDelete);
+
+		template <typename T>
+		void dispose(T *pObject)
+		{
+			dispose(pObject, [] (void *p) { delete static_cast<T*>(p); });
+		}
+	private:
+		struct item
+		{
+			void *pObject;
+			delete_function pDelete;
+		};
+
+		spsc_queue<item> items;
+		std::thread thread;
+		std::atomic<bool> running;
+		object_reaper();
+		void run();
+	};
+}
+
+#endif
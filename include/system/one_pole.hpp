@@ -0,0 +1,31 @@
+#ifndef LUADIO_ONE_POLE_HPP
+#define LUADIO_ONE_POLE_HPP
+
+#include "filter_type.hpp"
+#include <type_traits>
+#include <cstdint>
+#include <cstdlib>
+
+namespace luadio
+{
+	// First order low or high pass, also useful to smooth parameters.
+	// Plain data so scripts can allocate it through FFI, the layout is mirrored in luadio.filters.
+	struct one_pole
+	{
+		static constexpr uint32_t maxChannels = 16;
+		float coefficient;
+		int32_t highpass;
+		float z[maxChannels];
+		// Only filter_type_lowpass and filter_type_highpass are supported, anything else is treated as low pass
+		void set(filter_type type, float frequency, float sampleRate);
+		// Low pass that reaches about 63% of a step after seconds
+		void set_time(float seconds, float sampleRate);
+		void reset();
+		// Input and output may be the same buffer
+		void process(const float *pInput, float *pOutput, size_t frameCount, uint32_t channels);
+	};
+
+	static_assert(std::is_standard_layout_v<one_pole> && std::is_trivially_copyable_v<one_pole>);
+}
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef LUADIO_PATTERN_CLOCK_HPP
+#define LUADIO_PATTERN_CLOCK_HPP
+
+#include "note_event.hpp"
+#include "transport.hpp"
+#include <cstdint>
+#include <cstdlib>
+
+namespace luadio
+{
+	// Shared timing of the step sequencer and the arpeggiator.
+	// Steps are placed on the transport beat grid, so patterns follow tempo changes and stay in
+	// sync with each other. Every odd step is pushed back by the swing amount. Note offs that fall
+	// beyond the current block are kept until their block comes. Events of a block are collected
+	// in fixed storage and sorted, note offs first, so a retriggered note is never cut by its own release.
+	class pattern_clock
+	{
+	public:
+		static constexpr uint32_t maxEvents = 256;
+		static constexpr uint32_t maxNoteOffs = 128;
+		pattern_clock();
+		void set_rate(double stepsPerBeat);
+		// Fraction of a step odd steps are delayed by, from 0 to 0.75
+		void set_swing(double swing);
+		double get_step_length() const;
+		// Start beat of a step including swing
+		double get_step_beat(int64_t step) const;
+		// Starts a block, emits note offs that became due, and returns the range of steps that may start in it
+		void begin(const transport_state &state, uint32_t frameCount, int64_t &firstStep, int64_t &lastStep);
+		bool contains(double beat) const;
+		void add_note(double beat, double length, int32_t note, float velocity);
+		void add_parameter(double beat, uint32_t index, float value);
+		// Sorts the events of the block, returns how many there are
+		uint32_t end();
+		// Releases every sounding note at the start of the next block
+		void release_all();
+		const note_event *get_events() const;
+		uint32_t get_event_count() const;
+		// Deterministic random number in [0, 1) for a step, the same step always gets the same number
+		static double get_random(int64_t step, uint64_t seed);
+	private:
+		struct note_off
+		{
+			double beat;
+			int32_t note;
+		};
+		double stepsPerBeat;
+		double swing;
+		double blockStart;
+		double blockEnd;
+		double framesPerBeat;
+		uint32_t frameCount;
+		note_event events[maxEvents];
+		uint32_t eventCount;
+		note_off noteOffs[maxNoteOffs];
+		uint32_t noteOffCount;
+		bool releaseRequested;
+		double to_frame(double beat) const;
+		uint32_t to_offset(double beat) const;
+		void add_event(uint32_t offset, note_event_type type, int32_t note, float value);
+	};
+}
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef LUADIO_PCM_CONVERTER_HPP
+#define LUADIO_PCM_CONVERTER_HPP
+
+#include <cstdint>
+#include <cstdlib>
+
+namespace luadio
+{
+	enum pcm_format
+	{
+		pcm_format_s16,
+		pcm_format_s24,
+		pcm_format_s32
+	};
+
+	// Converts normalized float samples to little endian integer PCM and back.
+	// Out of range input is saturated rather than wrapped. When dither is enabled,
+	// triangular (TPDF) noise of +/- 1 LSB is added before quantization.
+	class pcm_converter
+	{
+	public:
+		pcm_converter();
+		void set_dither(bool enabled);
+		bool get_dither() const;
+		void convert(const float *pSrc, void *pDst, size_t count, pcm_format format);
+		static uint32_t get_bits_per_sample(pcm_format format);
+		static uint32_t get_bytes_per_sample(pcm_format format);
+		static void float_to_s16(const float *pSrc, int16_t *pDst, size_t count);
+		static void float_to_s24(const float *pSrc, uint8_t *pDst, size_t count);
+		static void float_to_s32(const float *pSrc, int32_t *pDst, size_t count);
+		// Little endian integer PCM to normalized floats, the source does not need to be aligned
+		static void s16_to_float(const uint8_t *pSrc, float *pDst, size_t count);
+		static void s24_to_float(const uint8_t *pSrc, float *pDst, size_t count);
+		static void s32_to_float(const uint8_t *pSrc, float *pDst, size_t count);
+	private:
+		static constexpr size_t chunkSize = 256;
+		uint32_t seeds[8];
+		bool dither;
+		void add_dither(const float *pSrc, float *pDst, size_t count, float lsb);
+	};
+}
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef LUADIO_PLANAR_BUFFER_HPP
+#define LUADIO_PLANAR_BUFFER_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+
+namespace luadio
+{
+	enum buffer_layout
+	{
+		buffer_layout_interleaved,
+		buffer_layout_planar
+	};
+
+	// One block of audio with every channel in its own contiguous buffer.
+	// Each channel starts on a 64 byte boundary and holds a multiple of 16 floats, so
+	// per channel loops vectorize without a scalar head. Scripts get the channel pointer array,
+	// conversion from and to the interleaved device format happens here, once per block.
+	class planar_buffer
+	{
+	public:
+		planar_buffer();
+		// Allocates, only call while the audio thread does not use the buffer
+		void resize(uint32_t channels, uint32_t capacity);
+		void clear(uint32_t frameCount);
+		void copy(const planar_buffer &source, uint32_t frameCount);
+		void read_interleaved(const float *pSrc, uint32_t frameCount);
+		void write_interleaved(float *pDst, uint32_t frameCount) const;
+		float **get_channels();
+		uint32_t get_channel_count() const;
+		uint32_t get_capacity() const;
+	private:
+		std::vector<float> storage;
+		std::vector<float*> channelPointers;
+		uint32_t channels;
+		uint32_t capacity;
+		uint32_t stride;
+	};
+}
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef LUADIO_POLYPHASE_FILTER_HPP
+#define LUADIO_POLYPHASE_FILTER_HPP
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstdlib>
+
+namespace luadio
+{
+	enum resampler_quality
+	{
+		resampler_quality_low,
+		resampler_quality_medium,
+		resampler_quality_high
+	};
+
+	// Kaiser windowed sinc lowpass sampled at phaseCount fractional offsets.
+	// Each phase is a row of taps, normalized to unity gain at DC. Row phaseCount is included so
+	// readers can interpolate between a row and the next one without wrapping.
+	// A filter is immutable after construction, so one filter can be used from several threads at once.
+	class polyphase_filter
+	{
+	public:
+		static constexpr uint32_t phaseCount = 256;
+		// cutoff is relative to the input Nyquist frequency, 1 when upsampling and target / source when downsampling
+		polyphase_filter(resampler_quality quality, double cutoff);
+		uint32_t get_tap_count() const;
+		const float *get_phase(uint32_t phase) const;
+		// Returns a shared filter, cutoffs are rounded to a few digits so close ratios share one filter
+		static std::shared_ptr<const polyphase_filter> get(resampler_quality quality, double cutoff);
+	private:
+		uint32_t tapCount;
+		std::vector<float> coefficients;
+		static double bessel_i0(double x);
+	};
+}
+
+#endif
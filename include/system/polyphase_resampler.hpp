@@ -0,0 +1,55 @@
+#ifndef LUADIO_POLYPHASE_RESAMPLER_HPP
+#define LUADIO_POLYPHASE_RESAMPLER_HPP
+
+#include "polyphase_filter.hpp"
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstdlib>
+
+namespace luadio
+{
+	// Streaming sample rate conversion of interleaved audio with a shared polyphase filter.
+	// The ratio is the number of input frames per output frame, so 2 plays an octave up or halves the rate.
+	// Each output frame interpolates between the two nearest filter phases, which allows any ratio
+	// and smooth ratio changes. The filter cutoff is fixed at construction from maxRatio, so pitching
+	// up to maxRatio never aliases. Input is copied into planar history, only complete output frames are
+	// produced, and whatever cannot be used yet stays buffered for the next call.
+	class polyphase_resampler
+	{
+	public:
+		static constexpr uint32_t maxChannels = 16;
+		static constexpr double maxRatioLimit = 64.0;
+		polyphase_resampler(uint32_t channels, resampler_quality quality, double ratio, double maxRatio);
+		// Clamped to maxRatio
+		void set_ratio(double ratio);
+		double get_ratio() const;
+		// Reads up to inputFrames and writes up to outputFrames, reports how many of each were used
+		void process(const float *pInput, uint32_t inputFrames, float *pOutput, uint32_t outputFrames, uint32_t &inputUsed, uint32_t &outputWritten);
+		// Same as process with the ratio of every output frame taken from pRatios
+		void process_varying(const float *pInput, uint32_t inputFrames, const float *pRatios, float *pOutput, uint32_t outputFrames, uint32_t &inputUsed, uint32_t &outputWritten);
+		void reset();
+		// Input frames held back before they can be output, feed this many frames of silence to flush
+		uint32_t get_latency() const;
+		uint32_t get_channels() const;
+		// Output frames a whole signal of inputFrames becomes at a fixed ratio
+		static uint64_t get_output_frames(uint64_t inputFrames, double ratio);
+	private:
+		static constexpr uint32_t chunkFrames = 1024;
+		std::shared_ptr<const polyphase_filter> filter;
+		std::vector<float> history;
+		std::vector<float> kernel;
+		uint32_t channels;
+		uint32_t tapCount;
+		uint32_t capacity;
+		uint32_t filled;
+		double position;
+		double ratio;
+		double maxRatio;
+		void run(const float *pInput, uint32_t inputFrames, const float *pRatios, float *pOutput, uint32_t outputFrames, uint32_t &inputUsed, uint32_t &outputWritten);
+		static void interpolate(const float *pA, const float *pB, float t, float *pDst, uint32_t count);
+		static float dot(const float *pA, const float *pB, uint32_t count);
+	};
+}
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef LUADIO_SAMPLE_BANK_HPP
+#define LUADIO_SAMPLE_BANK_HPP
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+
+namespace luadio
+{
+	enum sample_status
+	{
+		sample_status_loading,
+		sample_status_ready,
+		sample_status_failed
+	};
+
+	// A sample in the bank, shared with scripts. The other fields are only valid once status is ready.
+	// The layout is mirrored in luadio.samples.
+	struct sample_data
+	{
+		// Interleaved frames aligned to sample_bank::alignment, followed by paddingFrames of silence
+		// so interpolating readers may look a few frames past the end
+		float *pFrames;
+		uint64_t frameCount;
+		uint32_t channels;
+		uint32_t sampleRate;
+		std::atomic<int32_t> status;
+		uint32_t id;
+	};
+
+	// Loads samples on a worker thread so neither the audio thread nor the UI ever waits on a file.
+	// Uncompressed WAV files are read through a memory mapping and converted straight into the final
+	// buffer, or through the high quality polyphase resampler when their rate differs from the requested
+	// one. Everything else is decoded once with miniaudio. Requests for
+	// a path already in the bank return the same sample, and files with identical content share one
+	// buffer. Samples stay valid as long as the bank.
+	class sample_bank
+	{
+	public:
+		static constexpr size_t alignment = 64;
+		static constexpr uint32_t paddingFrames = 8;
+		sample_bank();
+		~sample_bank();
+		// Returns immediately, the sample reports its status while it loads
+		sample_data *load(const std::string &filePath, uint32_t sampleRate);
+		sample_data *get(uint32_t id);
+		uint32_t get_count() const;
+		uint32_t get_pending_count() const;
+	private:
+		struct entry
+		{
+			sample_data data;
+			std::string filePath;
+			std::shared_ptr<float> buffer;
+			uint64_t hash;
+		};
+		std::vector<std::unique_ptr<entry>> entries;
+		std::deque<entry*> queue;
+		mutable std::mutex mutex;
+		std::condition_variable condition;
+		std::atomic<uint32_t> pendingCount;
+		std::thread loader;
+		bool running;
+		void run();
+		bool read(entry &sample);
+		bool read_wav(entry &sample);
+		void share_duplicate(entry &sample);
+		static void resample_frames(const float *pInput, uint64_t inputFrames, uint32_t channels, double ratio, float *pOutput, uint64_t outputFrames);
+		static std::shared_ptr<float> allocate(size_t count);
+		static uint64_t compute_hash(const float *pSamples, size_t count);
+	};
+}
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef LUADIO_SAMPLE_PLAYER_HPP
+#define LUADIO_SAMPLE_PLAYER_HPP
+
+#include "sample_bank.hpp"
+#include "spsc_queue.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+
+namespace luadio
+{
+	struct sample_trigger
+	{
+		// Null stops every voice and drops triggers that have not started yet
+		const sample_data *pSample;
+		// Transport frame the sample starts at, frames in the past start at once
+		uint64_t frame;
+		float gain;
+		float pan;
+	};
+
+	// Fixed pool of one shot voices playing samples from the bank.
+	// Triggers go through a lock free queue and wait in a small list until the block that contains
+	// their frame, where they start at the exact frame. When every voice is busy the oldest one is
+	// taken over. Samples that are not loaded yet when their frame comes are skipped.
+	class sample_player
+	{
+	public:
+		static constexpr uint32_t maxVoices = 64;
+		static constexpr uint32_t maxPending = 256;
+		sample_player();
+		// Producer side, one thread at a time. Returns false when the queue is full.
+		bool trigger(const sample_data *pSample, uint64_t frame, float gain, float pan);
+		bool stop_all();
+		// Adds the playing voices to pOutput, frame is the transport frame of its first frame
+		void render(float *pOutput, uint32_t frameCount, uint32_t channels, uint64_t frame);
+		uint32_t get_active_count() const;
+		// Not thread safe, only call while nothing renders
+		void reset();
+	private:
+		struct voice
+		{
+			const sample_data *pSample;
+			uint64_t position;
+			uint32_t delay;
+			float left;
+			float right;
+			float gain;
+		};
+		spsc_queue<sample_trigger> triggers;
+		sample_trigger pending[maxPending];
+		uint32_t pendingCount;
+		voice voices[maxVoices];
+		uint32_t voiceCount;
+		std::atomic<uint32_t> activeCount;
+		void start(const sample_trigger &trigger, uint32_t delay);
+		static bool render_voice(voice &v, float *pOutput, uint32_t frameCount, uint32_t channels);
+	};
+}
+
+#endif
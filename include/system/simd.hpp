@@ -0,0 +1,61 @@
+#ifndef LUADIO_SIMD_HPP
+#define LUADIO_SIMD_HPP
+
+#include <cstdint>
+
+// Selects the widest instruction set the compiler was allowed to target.
+// Kernels test these macros and always provide a scalar fallback.
+
+#if defined(__AVX2__)
+	#define LUADIO_SIMD_AVX2 1
+	#define LUADIO_SIMD_SSE2 1
+	#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define LUADIO_SIMD_SSE2 1
+	#include <emmintrin.h>
+#endif
+
+#if defined(LUADIO_SIMD_SSE2)
+namespace luadio
+{
+	// Loads the first lanes floats of p into a vector, the remaining lanes are zero.
+	// Used to process up to four interleaved channels of one frame at once.
+	inline __m128 simd_load_lanes(const float *p, uint32_t lanes)
+	{
+		switch(lanes)
+		{
+			case 1:
+				return _mm_load_ss(p);
+			case 2:
+				return _mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double*>(p)));
+			case 3:
+				return _mm_setr_ps(p[0], p[1], p[2], 0.0f);
+			default:
+				return _mm_loadu_ps(p);
+		}
+	}
+
+	// Stores the first lanes floats of v to p
+	inline void simd_store_lanes(float *p, __m128 v, uint32_t lanes)
+	{
+		switch(lanes)
+		{
+			case 1:
+				_mm_store_ss(p, v);
+				break;
+			case 2:
+				_mm_store_sd(reinterpret_cast<double*>(p), _mm_castps_pd(v));
+				break;
+			case 3:
+				_mm_store_sd(reinterpret_cast<double*>(p), _mm_castps_pd(v));
+				_mm_store_ss(p + 2, _mm_movehl_ps(v, v));
+				break;
+			default:
+				_mm_storeu_ps(p, v);
+				break;
+		}
+	}
+}
+#endif
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef LUADIO_SPECTROGRAM_HPP
+#define LUADIO_SPECTROGRAM_HPP
+
+#include "fft_plan.hpp"
+#include "window_function.hpp"
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <cstdlib>
+
+namespace luadio
+{
+	struct spectrogram_settings
+	{
+		uint32_t fftSize;
+		uint32_t overlap;
+		window_type window;
+		float minDecibels;
+	};
+
+	// Range of FFT bins, inclusive, that is drawn as one row or bar
+	struct spectrum_band
+	{
+		uint32_t firstBin;
+		uint32_t lastBin;
+	};
+
+	// Short time Fourier transform producing one column of log frequency intensities per hop.
+	// process() is called by a single worker thread. Finished columns go into a fixed ring
+	// and are published with an atomic counter, so the UI can read them without locking.
+	class spectrogram
+	{
+	public:
+		static constexpr uint32_t rows = 128;
+		static constexpr uint32_t capacity = 512;
+		spectrogram();
+		void configure(const spectrogram_settings &settings, uint32_t sampleRate);
+		void process(const float *pSamples, size_t count);
+		uint64_t get_column_count() const;
+		const uint8_t *get_column(uint64_t index) const;
+		// Spaces count bands logarithmically between 20 Hz and Nyquist
+		static void compute_bands(uint32_t fftSize, uint32_t sampleRate, spectrum_band *pBands, uint32_t count);
+	private:
+		spectrogram_settings settings;
+		std::shared_ptr<const fft_plan> plan;
+		std::vector<float> window;
+		std::vector<float> fifo;
+		std::vector<float> frame;
+		std::vector<std::complex<float>> bins;
+		std::vector<spectrum_band> rowBands;
+		std::vector<uint8_t> columns;
+		std::atomic<uint64_t> columnCount;
+		size_t fifoCount;
+		size_t hopSize;
+		float scale;
+		void compute_column();
+	};
+}
+
+#endif
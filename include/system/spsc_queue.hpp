@@ -0,0 +1,117 @@
+#ifndef LUADIO_SPSC_QUEUE_HPP
+#define LUADIO_SPSC_QUEUE_HPP
+
+#include <vector>
+#include <atomic>
+#include <cstdlib>
+#include <algorithm>
+#include <stdexcept>
+
+namespace luadio
+{
+	// Lock free queue for exactly one producer thread and one consumer thread.
+	// Neither side ever blocks or allocates, which makes it safe to use on the audio thread.
+	template <typename T>
+	class spsc_queue
+	{
+	public:
+		spsc_queue() : spsc_queue(1024) {}
+
+		spsc_queue(size_t capacityPowerOfTwo)
+		{
+			resize(capacityPowerOfTwo);
+		}
+
+		// Not thread safe, only call while neither side is active
+		void resize(size_t capacityPowerOfTwo)
+		{
+			if (capacityPowerOfTwo == 0 || (capacityPowerOfTwo & (capacityPowerOfTwo - 1)) != 0)
+				throw std::invalid_argument("capacityPowerOfTwo must be power of two");
+			items.resize(capacityPowerOfTwo);
+			mask = capacityPowerOfTwo - 1;
+			head.store(0);
+			tail.store(0);
+		}
+
+		bool try_enqueue(const T &item)
+		{
+			const size_t t = tail.load(std::memory_order_relaxed);
+
+			if (t - head.load(std::memory_order_acquire) > mask)
+				return false;
+
+			items[t & mask] = item;
+			tail.store(t + 1, std::memory_order_release);
+			return true;
+		}
+
+		bool try_dequeue(T &item)
+		{
+			const size_t h = head.load(std::memory_order_relaxed);
+
+			if (h == tail.load(std::memory_order_acquire))
+				return false;
+
+			item = items[h & mask];
+			head.store(h + 1, std::memory_order_release);
+			return true;
+		}
+
+		// Producer side, writes up to count items and returns how many were written
+		size_t write(const T *pItems, size_t count)
+		{
+			const size_t t = tail.load(std::memory_order_relaxed);
+			const size_t n = std::min(count, get_capacity() - (t - head.load(std::memory_order_acquire)));
+
+			for (size_t i = 0; i < n; i++)
+				items[(t + i) & mask] = pItems[i];
+
+			tail.store(t + n, std::memory_order_release);
+			return n;
+		}
+
+		// Consumer side, reads up to count items and returns how many were read
+		size_t read(T *pItems, size_t count)
+		{
+			const size_t h = head.load(std::memory_order_relaxed);
+			const size_t n = std::min(count, tail.load(std::memory_order_acquire) - h);
+
+			for (size_t i = 0; i < n; i++)
+				pItems[i] = items[(h + i) & mask];
+
+			head.store(h + n, std::memory_order_release);
+			return n;
+		}
+
+		// Consumer side, drops up to count items without copying them
+		size_t skip(size_t count)
+		{
+			const size_t h = head.load(std::memory_order_relaxed);
+			const size_t n = std::min(count, tail.load(std::memory_order_acquire) - h);
+			head.store(h + n, std::memory_order_release);
+			return n;
+		}
+
+		size_t size() const
+		{
+			return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+		}
+
+		size_t get_free_space() const
+		{
+			return get_capacity() - size();
+		}
+
+		size_t get_capacity() const
+		{
+			return mask + 1;
+		}
+	private:
+		std::vector<T> items;
+		size_t mask;
+		alignas(64) std::atomic<size_t> head;
+		alignas(64) std::atomic<size_t> tail;
+	};
+}
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef LUADIO_STATE_VARIABLE_FILTER_HPP
+#define LUADIO_STATE_VARIABLE_FILTER_HPP
+
+#include "filter_type.hpp"
+#include <type_traits>
+#include <cstdint>
+#include <cstdlib>
+
+namespace luadio
+{
+	// Topology preserving transform state variable filter (trapezoidal integration, after Zavalishin and Simper).
+	// Unlike a biquad it stays stable and free of artifacts while the cutoff is modulated quickly.
+	// The output is a mix of input, band and low pass, so every type shares the same state update.
+	// Plain data so scripts can allocate it through FFI, the layout is mirrored in luadio.filters.
+	struct state_variable_filter
+	{
+		static constexpr uint32_t maxChannels = 16;
+		float a1, a2, a3;
+		float m0, m1, m2;
+		float ic1eq[maxChannels];
+		float ic2eq[maxChannels];
+		// gainDecibels is only used by peak and shelf filters
+		void set(filter_type type, float frequency, float q, float gainDecibels, float sampleRate);
+		void reset();
+		// Input and output may be the same buffer
+		void process(const float *pInput, float *pOutput, size_t frameCount, uint32_t channels);
+	};
+
+	static_assert(std::is_standard_layout_v<state_variable_filter> && std::is_trivially_copyable_v<state_variable_filter>);
+}
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef LUADIO_STEP_SEQUENCER_HPP
+#define LUADIO_STEP_SEQUENCER_HPP
+
+#include "pattern_clock.hpp"
+#include <type_traits>
+#include <cstdint>
+#include <cstdlib>
+
+namespace luadio
+{
+	// One step of a pattern. Plain data so scripts can edit steps in place through FFI,
+	// the layout is mirrored in luadio.sequencer.
+	struct sequencer_step
+	{
+		static constexpr uint32_t maxParameters = 8;
+		// MIDI note, negative for a rest
+		int32_t note;
+		float velocity;
+		// Fraction of the step (or of one ratchet) the note is held
+		float gate;
+		// Chance from 0 to 1 that the note plays
+		float probability;
+		// Number of evenly spaced repeats within the step
+		uint32_t ratchets;
+		// Bit i set locks parameter i to locks[i] while the step plays
+		uint32_t lockMask;
+		float locks[maxParameters];
+	};
+
+	static_assert(std::is_standard_layout_v<sequencer_step> && std::is_trivially_copyable_v<sequencer_step>);
+
+	// Step sequencer with per step parameter locks, probability, swing and ratchets.
+	// Every step sets each parameter either to its lock or back to the default, and changes
+	// are reported as parameter events at the exact frame next to the note events.
+	class step_sequencer
+	{
+	public:
+		static constexpr uint32_t maxSteps = 64;
+		static constexpr uint32_t maxRatchets = 16;
+		step_sequencer(uint32_t length);
+		void set_length(uint32_t length);
+		void set_rate(double stepsPerBeat);
+		void set_swing(double swing);
+		// Changes the random choices of probability steps
+		void set_seed(uint64_t seed);
+		sequencer_step *get_steps();
+		// Current parameter values and the values used by steps without a lock
+		float *get_parameters();
+		float *get_defaults();
+		// Generates the events of the next frameCount frames, returns how many there are
+		uint32_t process(const transport_state &state, uint32_t frameCount);
+		const note_event *get_events() const;
+		// Releases sounding notes in the next block
+		void release_all();
+	private:
+		pattern_clock clock;
+		sequencer_step steps[maxSteps];
+		float parameters[sequencer_step::maxParameters];
+		float defaults[sequencer_step::maxParameters];
+		uint32_t length;
+		uint64_t seed;
+	};
+}
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef LUADIO_STFT_PROCESSOR_HPP
+#define LUADIO_STFT_PROCESSOR_HPP
+
+#include "fft_plan.hpp"
+#include "window_function.hpp"
+#include <vector>
+#include <complex>
+#include <memory>
+#include <cstdint>
+#include <cstdlib>
+
+namespace luadio
+{
+	// Windowed analysis, user modification and overlap-add resynthesis of one channel.
+	// process() runs sample by sample until a hop completes, then stops with the spectrum of the
+	// newest frame ready to be modified in place. The next call resynthesizes it before going on,
+	// so a caller loops until all frames are consumed and edits the bins whenever is_ready is set.
+	// The output is delayed by size samples. Nothing allocates after construction.
+	class stft_processor
+	{
+	public:
+		stft_processor(uint32_t size, uint32_t overlap, window_type window);
+		// Returns the number of frames consumed, input and output are read and written with the given stride
+		uint32_t process(const float *pInput, float *pOutput, uint32_t frameCount, uint32_t stride);
+		bool is_ready() const;
+		std::complex<float> *get_bins();
+		uint32_t get_bin_count() const;
+		uint32_t get_size() const;
+		uint32_t get_hop_size() const;
+	private:
+		std::shared_ptr<const fft_plan> plan;
+		std::vector<float> window;
+		std::vector<float> input;
+		std::vector<float> output;
+		std::vector<float> frame;
+		std::vector<std::complex<float>> bins;
+		uint32_t size;
+		uint32_t hopSize;
+		uint32_t hopPosition;
+		float synthesisScale;
+		bool ready;
+		void analyze();
+		void synthesize();
+	};
+}
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef LUADIO_TRANSPORT_HPP
+#define LUADIO_TRANSPORT_HPP
+
+#include <type_traits>
+#include <atomic>
+#include <cstdint>
+
+namespace luadio
+{
+	// Snapshot of the clock at the start of the block being processed.
+	// Plain data so scripts can read it through FFI, the layout is mirrored in luadio.transport.
+	// Positions are doubles so scripts get plain numbers, they stay exact up to 2^53 frames.
+	struct transport_state
+	{
+		double frame;
+		double beat;
+		double tempo;
+		double sampleRate;
+		uint32_t beatsPerBar;
+		uint32_t reserved;
+	};
+
+	static_assert(std::is_standard_layout_v<transport_state> && std::is_trivially_copyable_v<transport_state>);
+
+	// Musical clock driven by the audio thread. It only moves when audio is processed, so
+	// anything timed from it is exact to the sample and independent of the UI frame rate.
+	// Tempo changes are latched: the block in progress keeps the tempo it started with, so its beats
+	// match what was rendered, and the new tempo takes over after advance. Beats keep counting from where they were.
+	class transport
+	{
+	public:
+		transport();
+		void reset(uint32_t sampleRate);
+		void advance(uint64_t frameCount);
+		void set_tempo(double beatsPerMinute);
+		void set_beats_per_bar(uint32_t beatsPerBar);
+		const transport_state *get_state() const;
+		// Can be read from any thread
+		uint64_t get_frame_position() const;
+		// Frame at which the given beat is reached if the tempo does not change until then,
+		// a tempo set during the block counts as if it applied from the start of the block
+		double get_frame_of_beat(double beat) const;
+	private:
+		transport_state state;
+		double pendingTempo;
+		uint64_t framePosition;
+		std::atomic<uint64_t> publishedFrame;
+	};
+}
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef LUADIO_TRIGGERED_SCOPE_HPP
+#define LUADIO_TRIGGERED_SCOPE_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+
+namespace luadio
+{
+	enum trigger_mode
+	{
+		trigger_mode_free,
+		trigger_mode_zero_crossing,
+		trigger_mode_level
+	};
+
+	struct scope_settings
+	{
+		trigger_mode mode;
+		float level;
+		float holdoffSeconds;
+		float windowSeconds;
+		uint32_t channel;
+	};
+
+	// Oscilloscope view that locks onto a rising edge so periodic signals stand still.
+	// Incoming frames go into a mirrored history ring, every span of it can be read as one
+	// contiguous array. Like a hardware scope it re-arms hold-off after each trigger and takes
+	// the first edge after that, so complex waveforms keep locking onto the same edge.
+	// When nothing triggers for a while the view runs free.
+	class triggered_scope
+	{
+	public:
+		static constexpr uint32_t historyFrames = 1 << 15;
+		static constexpr uint32_t maxWindowFrames = historyFrames / 4;
+		triggered_scope();
+		void initialize(uint32_t sampleRate, uint32_t channels);
+		void configure(const scope_settings &settings);
+		void push(const float *pFrames, size_t frameCount);
+		// Looks for a new trigger and moves the view, returns true if the view is triggered
+		bool update();
+		// Fills columns minimum/maximum pairs for one channel of the current view
+		void get_columns(uint32_t columns, uint32_t channel, float *pMin, float *pMax) const;
+		// Index of the first rising edge through threshold, pSamples[i - 1] < threshold <= pSamples[i], or count if none
+		static size_t find_rising_edge(const float *pSamples, size_t count, float threshold);
+	private:
+		std::vector<float> history;
+		scope_settings settings;
+		uint32_t sampleRate;
+		uint32_t channels;
+		uint64_t framesWritten;
+		uint64_t armedFrame;
+		uint64_t lastTrigger;
+		uint64_t windowStart;
+		uint64_t windowFrames;
+		bool hasTriggered;
+		const float *get_channel(uint32_t channel, uint64_t frame) const;
+	};
+}
+
+#endif
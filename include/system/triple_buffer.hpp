@@ -0,0 +1,61 @@
+#ifndef LUADIO_TRIPLE_BUFFER_HPP
+#define LUADIO_TRIPLE_BUFFER_HPP
+
+#include <atomic>
+#include <cstdint>
+
+namespace luadio
+{
+	// Hands the latest value from one writer thread to one reader thread without locking.
+	// The writer fills its own slot and swaps it with the shared middle slot on publish,
+	// the reader swaps the middle slot with its own slot when something new was published.
+	// Neither side ever waits, intermediate values are simply skipped when the reader is slow.
+	template <typename T>
+	class triple_buffer
+	{
+	public:
+		triple_buffer()
+		{
+			writeIndex = 0;
+			middle.store(1);
+			readIndex = 2;
+		}
+
+		// Writer side, the slot to fill before calling publish
+		T &get_write_buffer()
+		{
+			return slots[writeIndex];
+		}
+
+		// Writer side
+		void publish()
+		{
+			writeIndex = middle.exchange(writeIndex | dirtyFlag, std::memory_order_acq_rel) & indexMask;
+		}
+
+		// Reader side, returns true if a newer value became readable
+		bool update()
+		{
+			if((middle.load(std::memory_order_relaxed) & dirtyFlag) == 0)
+				return false;
+
+			readIndex = middle.exchange(readIndex, std::memory_order_acq_rel) & indexMask;
+			return true;
+		}
+
+		// Reader side, the most recent value seen by update
+		const T &get_read_buffer() const
+		{
+			return slots[readIndex];
+		}
+	private:
+		static constexpr uint32_t indexMask = 3;
+		static constexpr uint32_t dirtyFlag = 4;
+		T slots[3] {};
+		uint32_t writeIndex;
+		alignas(64) std::atomic<uint32_t> middle;
+		alignas(64) uint32_t readIndex;
+	};
+}
+
+#endif
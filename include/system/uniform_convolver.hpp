@@ -0,0 +1,48 @@
+#ifndef LUADIO_UNIFORM_CONVOLVER_HPP
+#define LUADIO_UNIFORM_CONVOLVER_HPP
+
+#include "fft_plan.hpp"
+#include <vector>
+#include <complex>
+#include <memory>
+#include <cstdint>
+#include <cstdlib>
+
+namespace luadio
+{
+	// Uniformly partitioned overlap-save convolution with a frequency domain delay line.
+	// The impulse response is cut into partitions of partitionSize samples that are transformed once.
+	// Every block of input is transformed once as well and kept in the delay line, so a block costs
+	// two transforms plus one complex multiply-accumulate per partition, independent of the IR length.
+	class uniform_convolver
+	{
+	public:
+		// Reads impulseLength samples from pImpulse, stride apart so one channel of an interleaved IR can be used
+		uniform_convolver(uint32_t partitionSize, const float *pImpulse, size_t impulseLength, size_t stride);
+		// Processes exactly partitionSize samples, pOutput is overwritten
+		void process(const float *pInput, float *pOutput);
+		// The steps of process, so the work of one partition can be spread over several calls.
+		// begin takes the input, accumulate adds partitions first to first + count - 1 of the filter
+		// and finish writes the output. Every partition has to be accumulated once in between.
+		void begin(const float *pInput);
+		void accumulate(uint32_t first, uint32_t count);
+		void finish(float *pOutput);
+		uint32_t get_partition_size() const;
+		uint32_t get_partition_count() const;
+		// acc[i] += a[i] * b[i] for count complex values
+		static void multiply_accumulate(const std::complex<float> *pA, const std::complex<float> *pB, std::complex<float> *pAccumulator, size_t count);
+	private:
+		std::shared_ptr<const fft_plan> plan;
+		uint32_t partitionSize;
+		uint32_t binCount;
+		uint32_t partitionCount;
+		uint32_t delayLinePosition;
+		std::vector<std::complex<float>> filters;
+		std::vector<std::complex<float>> delayLine;
+		std::vector<std::complex<float>> accumulator;
+		std::vector<float> inputBuffer;
+		std::vector<float> outputBuffer;
+	};
+}
+
+#endif
@@ -0,0 +1,110 @@
+#ifndef LUADIO_VOICE_ALLOCATOR_HPP
+#define LUADIO_VOICE_ALLOCATOR_HPP
+
+#include "note_event.hpp"
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+
+namespace luadio
+{
+	enum voice_state
+	{
+		voice_state_idle,
+		voice_state_attack,
+		voice_state_decay,
+		voice_state_sustain,
+		voice_state_release
+	};
+
+	enum steal_policy
+	{
+		// Refuse new notes when every voice is busy
+		steal_policy_none,
+		steal_policy_oldest,
+		steal_policy_quietest
+	};
+
+	enum voice_waveform
+	{
+		voice_waveform_sine,
+		voice_waveform_saw,
+		voice_waveform_square,
+		voice_waveform_triangle
+	};
+
+	// Per voice arrays, shared with scripts so they can read voice state and write per voice parameters
+	// without a call per voice. The layout is mirrored in luadio.voices.
+	struct voice_data
+	{
+		uint32_t voiceCount;
+		uint32_t activeCount;
+		// Indices of the voices that are sounding, only the first activeCount entries are valid
+		uint32_t *pActive;
+		int32_t *pNotes;
+		float *pVelocities;
+		// Written by note_on, scripts may change them any time (pitch bend, detune, panning)
+		float *pFrequencies;
+		float *pGains;
+		float *pPans;
+		int32_t *pWaveforms;
+		// Envelope level of each voice, read only
+		float *pLevels;
+	};
+
+	// Polyphonic voice management with a built in oscillator and ADSR per voice.
+	// Voice state is kept as structure of arrays and rendering only touches the compact list of
+	// sounding voices, so cost scales with the notes that play rather than with the voice count.
+	// A new note takes an idle voice, then the quietest releasing voice, and only then steals an
+	// active voice according to the policy. Stolen voices keep their phase and envelope level so
+	// stealing does not click. Not thread safe, note events and rendering belong on the audio thread.
+	class voice_allocator
+	{
+	public:
+		static constexpr uint32_t maxVoices = 128;
+		voice_allocator(uint32_t voiceCount, uint32_t sampleRate);
+		void set_envelope(float attackSeconds, float decaySeconds, float sustainLevel, float releaseSeconds);
+		void set_steal_policy(steal_policy policy);
+		// Returns the index of the voice playing the note, or -1 if the note was dropped
+		int32_t note_on(int32_t note, float velocity);
+		// Releases every voice playing the note
+		void note_off(int32_t note);
+		void all_notes_off();
+		// Stops every voice immediately
+		void reset();
+		// Overwrites pOutput with the mix of all sounding voices, voices are panned across the first two channels
+		void render(float *pOutput, uint32_t frameCount, uint32_t channels);
+		// Same as render, note events are applied at their frame offsets. Events must be sorted by offset,
+		// parameter events are ignored
+		void render_events(float *pOutput, uint32_t frameCount, uint32_t channels, const note_event *pEvents, uint32_t eventCount);
+		voice_data *get_data();
+	private:
+		static constexpr uint32_t chunkFrames = 256;
+		uint32_t sampleRate;
+		steal_policy policy;
+		float attackStep;
+		float decayStep;
+		float sustainLevel;
+		float releaseFrames;
+		uint64_t noteCounter;
+		voice_data data;
+		std::vector<uint32_t> active;
+		std::vector<int32_t> notes;
+		std::vector<float> velocities;
+		std::vector<float> frequencies;
+		std::vector<float> gains;
+		std::vector<float> pans;
+		std::vector<int32_t> waveforms;
+		std::vector<float> levels;
+		std::vector<float> phases;
+		std::vector<float> releaseSteps;
+		std::vector<voice_state> states;
+		std::vector<uint64_t> startOrder;
+		std::vector<float> scratch;
+		int32_t find_voice(int32_t note) const;
+		void update_active();
+		void render_voice(uint32_t voice, float *pOutput, uint32_t frameCount);
+	};
+}
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef LUADIO_WAV_WRITER_HPP
+#define LUADIO_WAV_WRITER_HPP
+
+#include "pcm_converter.hpp"
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+
+namespace luadio
+{
+	// Writes interleaved float frames to a PCM wave file.
+	// The header sizes are patched in when the file is closed.
+	class wav_writer
+	{
+	public:
+		wav_writer();
+		~wav_writer();
+		bool open(const std::string &filePath, uint32_t sampleRate, uint32_t channels, pcm_format format, bool dither);
+		void write(const float *pFrames, uint32_t frameCount);
+		void close();
+		bool is_open() const;
+		uint32_t get_channels() const;
+		static std::string create_file_name(const std::string &suffix);
+	private:
+		std::ofstream stream;
+		std::vector<uint8_t> outputBuffer;
+		pcm_converter converter;
+		pcm_format format;
+		uint32_t channels;
+		uint64_t bytesWritten;
+		void write_int16(int16_t value, uint8_t *buffer, int32_t offset);
+		void write_int32(int32_t value, uint8_t *buffer, int32_t offset);
+	};
+}
+
+#endif
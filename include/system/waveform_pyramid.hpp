@@ -0,0 +1,48 @@
+#ifndef LUADIO_WAVEFORM_PYRAMID_HPP
+#define LUADIO_WAVEFORM_PYRAMID_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+
+namespace luadio
+{
+	// Min/max decimation pyramid over the most recent seconds of audio.
+	// Level 0 holds the minimum and maximum of every baseFrames frames, each level above
+	// halves the resolution of the one below. The pyramid is built incrementally as frames
+	// arrive, and any span of history is drawn from the coarsest level that still gives every
+	// column at least one entry. Drawing seconds of audio costs the same as drawing one block.
+	// Not thread safe, push and get_columns are meant to be called by the same thread.
+	class waveform_pyramid
+	{
+	public:
+		static constexpr uint32_t baseFrames = 4;
+		waveform_pyramid();
+		void initialize(uint64_t maxFrames, uint32_t maxColumns, uint32_t channels);
+		void push(const float *pFrames, size_t frameCount);
+		// Fills columns minimum/maximum pairs covering the last frameCount frames of one channel, oldest first
+		void get_columns(uint64_t frameCount, uint32_t columns, uint32_t channel, float *pMin, float *pMax) const;
+		uint64_t get_max_frames() const;
+		uint32_t get_channels() const;
+	private:
+		struct level
+		{
+			uint64_t framesPerEntry;
+			uint64_t capacity;
+			uint64_t count;
+			std::vector<float> minimums;
+			std::vector<float> maximums;
+			std::vector<float> pendingMin;
+			std::vector<float> pendingMax;
+		};
+		std::vector<level> levels;
+		std::vector<float> accumulatorMin;
+		std::vector<float> accumulatorMax;
+		uint32_t accumulated;
+		uint64_t maxFrames;
+		uint32_t channels;
+		void push_entry(size_t levelIndex, const float *pMin, const float *pMax);
+	};
+}
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef LUADIO_WINDOW_FUNCTION_HPP
+#define LUADIO_WINDOW_FUNCTION_HPP
+
+#include <cstdlib>
+
+namespace luadio
+{
+	enum window_type
+	{
+		window_type_rectangular,
+		window_type_hann,
+		window_type_hamming,
+		window_type_blackman_harris
+	};
+
+	class window_function
+	{
+	public:
+		// Fills pDst with a periodic window of length n, which is what overlapping frames need
+		static void generate(window_type type, float *pDst, size_t n);
+		// Sum of the window, used to normalize magnitudes
+		static float get_gain(const float *pWindow, size_t n);
+	};
+}
+
+#endif
@@ -5,6 +5,16 @@
 #include "../modules/luadio_module.hpp"
 #include "../modules/oscillator_module.hpp"
 #include "../modules/wavetable_module.hpp"
+#include "../modules/fft_module.hpp"
+#include "../modules/convolution_module.hpp"
+#include "../modules/dsp_module.hpp"
+#include "../modules/filters_module.hpp"
+#include "../modules/voices_module.hpp"
+#include "../modules/transport_module.hpp"
+#include "../modules/sequencer_module.hpp"
+#include "../modules/samples_module.hpp"
+#include "../modules/resampler_module.hpp"
+#include "../modules/stream_module.hpp"
 #include "../modules/script_template.hpp"
 #include "../embedded/knobs.hpp"
 #include "image.hpp"
@@ -13,25 +23,31 @@
 
 namespace luadio
 {
-	void app::on_load() 
+	// Frames of one planar block, longer device periods are handed to scripts in several blocks
+	static constexpr uint32_t planarFrames = 4096;
+	// Memory of the output history, two minutes of stereo at 48 kHz
+	static constexpr size_t historyBytes = static_cast<size_t>(120) * 48000 * 2 * sizeof(float);
+	// Frames of the dry copy made before an effect runs, the recorder does not stage longer periods either
+	static constexpr uint32_t dryFrames = 1 << 14;
+
+	app::app(const audio_settings &settings)
 	{
-		ma_ex_context_config contextConfig = ma_ex_context_config_init(44100, 2, 1024, NULL);
-		pContext = ma_ex_context_init(&contextConfig);
-		pSource = ma_ex_audio_source_init(pContext);
-
-		std::memset(&soundGroup, 0, sizeof(ma_sound_group));
-		std::memset(&effectNode, 0, sizeof(ma_effect_node));
-
-		ma_sound_group_init(&pContext->engine, 0, nullptr, &soundGroup);
-		ma_ex_audio_source_set_group(pSource, &soundGroup);
-
-		ma_effect_node_config effectNodeConfig = ma_effect_node_config_init(2, 44100, on_audio_effect, this);
+		audioSettings = settings;
+		pendingSettings = settings;
+		pContext = nullptr;
+		pSource = nullptr;
+		bufferLayout.store(buffer_layout_interleaved);
+		effectDefined.store(false);
+		effectBypass.store(false);
+		subBlockFrames = 0;
+		subBlockPosition = 0;
+		scriptFrame = 0;
+		scriptPlanar = false;
+	}
 
-		if (ma_effect_node_init(ma_engine_get_node_graph(&pContext->engine), &effectNodeConfig, nullptr, &effectNode) == MA_SUCCESS)
-		{
-			ma_node_attach_output_bus(&effectNode, 0, ma_engine_get_endpoint(&pContext->engine), 0);
-			ma_node_attach_output_bus(&soundGroup, 0, &effectNode, 0);
-		}
+	void app::on_load() 
+	{
+		open_audio();
 
 		editor.SetShowHorizontalScrollbar(false);
 		auto palette = editor.GetDarkPalette();
@@ -47,10 +63,35 @@ namespace luadio
 			luadio_module luadioModule;
 			oscillator_module oscillatorModule;
 			wavetable_module wavetableModule;
+			fft_module fftModule;
+			convolution_module convolutionModule;
+			dsp_module dspModule;
+			filters_module filtersModule;
+			voices_module voicesModule;
+			transport_module transportModule;
+			sequencer_module sequencerModule;
+			samples_module samplesModule;
+			resampler_module resamplerModule;
+			stream_module streamModule;
 
 			luadioModule.load(compiler::get_lua_state());
 			oscillatorModule.load(compiler::get_lua_state());
 			wavetableModule.load(compiler::get_lua_state());
+			fftModule.load(compiler::get_lua_state());
+			convolutionModule.load(compiler::get_lua_state());
+			dspModule.load(compiler::get_lua_state());
+			filtersModule.load(compiler::get_lua_state());
+			voicesModule.load(compiler::get_lua_state());
+			transportModule.load(compiler::get_lua_state());
+			sequencerModule.load(compiler::get_lua_state());
+			samplesModule.load(compiler::get_lua_state());
+			resamplerModule.load(compiler::get_lua_state());
+			streamModule.load(compiler::get_lua_state());
+
+			transport_module::pTransport = &transportClock;
+			transport_module::pScheduler = &scheduler;
+			samples_module::pBank = &samples;
+			samples_module::pPlayer = &samplePlayer;
 
 			luadio_module::onLog = [this] (const std::string &message) {
 				on_log_message(message);
@@ -59,6 +100,36 @@ namespace luadio
 			luadio_module::onQueueAudio = [this] (const std::string &filePath) {
 				on_queue_audio(filePath);
 			};
+
+			luadio_module::onRecord = [this] (double startFrame, double stopFrame) {
+				uint64_t start = startFrame > 0.0 ? static_cast<uint64_t>(startFrame) : 0;
+				uint64_t stop = stopFrame >= 0.0 ? static_cast<uint64_t>(stopFrame) : audio_recorder::endless;
+				recorder.start_at(start, stop);
+			};
+
+			luadio_module::onRecordBus = [this] (const char *name, const void *pFrames, uint32_t frameCount, uint32_t channels) {
+				// Bus frames are placed at the frames of the callback that writes them
+				if(scriptPlanar)
+					recorder.write_bus(name, reinterpret_cast<const float *const *>(pFrames), frameCount, channels, scriptFrame);
+				else
+					recorder.write_bus(name, reinterpret_cast<const float*>(pFrames), frameCount, channels, scriptFrame);
+			};
+
+			luadio_module::onGetFramePosition = [this] () -> double {
+				return static_cast<double>(recorder.get_frame_position());
+			};
+
+			luadio_module::onGetSampleRate = [this] () -> double {
+				return static_cast<double>(audioSettings.sampleRate);
+			};
+
+			luadio_module::onSetBufferLayout = [this] (int32_t layout) {
+				bufferLayout.store(layout == buffer_layout_planar ? buffer_layout_planar : buffer_layout_interleaved);
+			};
+
+			luadio_module::onSetEffectBypass = [this] (bool bypass) {
+				effectBypass.store(bypass);
+			};
 		}
 
 		image img(knobs::get_data(), knobs::get_size());
@@ -68,9 +139,6 @@ namespace luadio
 			knobTexture.generate(&img);
 		}
 
-		outputData.resize(1024);
-		std::memset(outputData.data(), 0, outputData.size() * sizeof(float));
-
 		constexpr auto getColorFromRGBA = [] (int r, int g, int b, int a) -> ImVec4 {
 			return ImVec4((float)r / 255, (float)g / 255, (float)b / 255, (float)a / 255);
 		};
@@ -81,6 +149,12 @@ namespace luadio
 		waveformSettings.selectedMode = 0;
 		menuState = menu_state_none;
 
+		historySeconds = 30.0f;
+
+		spectrogramPixels.resize(spectrogram::capacity * spectrogram::rows * 4, 0);
+		spectrogramTexture.generate(spectrogramPixels.data(), spectrogramPixels.size(), spectrogram::capacity, spectrogram::rows, 4);
+		spectrogramColumnsUploaded = 0;
+
 		std::filesystem::path dirPath = "recordings";
 		
 		if(!std::filesystem::exists(dirPath))
@@ -95,6 +169,52 @@ namespace luadio
 
 		clear_fields();
 
+		close_audio();
+
+		spectrogramTexture.destroy();
+	}
+
+	void app::open_audio()
+	{
+		ma_ex_context_config contextConfig = ma_ex_context_config_init(audioSettings.sampleRate, audioSettings.channels, audioSettings.periodSize, NULL);
+		pContext = ma_ex_context_init(&contextConfig);
+		pSource = ma_ex_audio_source_init(pContext);
+
+		std::memset(&soundGroup, 0, sizeof(ma_sound_group));
+		std::memset(&effectNode, 0, sizeof(ma_effect_node));
+
+		ma_sound_group_init(&pContext->engine, 0, nullptr, &soundGroup);
+		ma_ex_audio_source_set_group(pSource, &soundGroup);
+
+		ma_effect_node_config effectNodeConfig = ma_effect_node_config_init(audioSettings.channels, audioSettings.sampleRate, on_audio_effect, this);
+
+		if (ma_effect_node_init(ma_engine_get_node_graph(&pContext->engine), &effectNodeConfig, nullptr, &effectNode) == MA_SUCCESS)
+		{
+			ma_node_attach_output_bus(&effectNode, 0, ma_engine_get_endpoint(&pContext->engine), 0);
+			ma_node_attach_output_bus(&soundGroup, 0, &effectNode, 0);
+		}
+
+		// Everything that depends on the format is set up again before audio flows.
+		// The history keeps to a fixed memory budget, so higher rates and wide layouts hold less time.
+		const size_t bytesPerSecond = static_cast<size_t>(audioSettings.sampleRate) * audioSettings.channels * sizeof(float);
+		history.initialize(static_cast<uint32_t>(std::max<size_t>(1, historyBytes / bytesPerSecond)), audioSettings.sampleRate, audioSettings.channels);
+		historySeconds = std::min(historySeconds, history.get_max_seconds());
+		planarRead.resize(audioSettings.channels, planarFrames);
+		planarEffectInput.resize(audioSettings.channels, planarFrames);
+		planarEffectOutput.resize(audioSettings.channels, planarFrames);
+		subBlockFrames = audioSettings.subBlockSize;
+		subBlockPosition = subBlockFrames;
+		subBlock.assign(static_cast<size_t>(subBlockFrames) * audioSettings.channels, 0.0f);
+		dryBuffer.assign(static_cast<size_t>(dryFrames) * audioSettings.channels, 0.0f);
+		analysis.start(audioSettings.sampleRate, audioSettings.channels);
+		recorder.set_sample_rate(audioSettings.sampleRate);
+		latency.reset(audioSettings.sampleRate);
+
+		on_log_message("Audio: " + audioSettings.to_string());
+	}
+
+	void app::close_audio()
+	{
 		ma_ex_audio_source_stop(pSource);
 
 		ma_effect_node_uninit(&effectNode, nullptr);
@@ -103,9 +223,24 @@ namespace luadio
 		ma_ex_audio_source_uninit(pSource);
 		pSource = nullptr;
 
+		analysis.stop();
+
 		ma_ex_context_uninit(pContext);
 		pContext = nullptr;
 	}
+
+	void app::restart_audio()
+	{
+		if(ma_ex_audio_source_get_is_playing(pSource) == MA_TRUE)
+		{
+			on_script_stop();
+			ma_ex_audio_source_stop(pSource);
+		}
+
+		close_audio();
+		audioSettings = pendingSettings;
+		open_audio();
+	}
 	
 	void app::on_update() 
 	{
@@ -151,6 +286,7 @@ namespace luadio
 		show_editor();
 		show_log();
 		show_inspector();
+		show_meters();
 	}
 
     void app::show_menu()
@@ -186,6 +322,17 @@ namespace luadio
 					menuState = menu_state_settings_visuals;
 				}
 
+				if (ImGui::MenuItem("Recording")) 
+				{
+					menuState = menu_state_settings_recording;
+				}
+
+				if (ImGui::MenuItem("Audio")) 
+				{
+					pendingSettings = audioSettings;
+					menuState = menu_state_settings_audio;
+				}
+
 				ImGui::EndMenu();
 			}
 
@@ -204,7 +351,7 @@ namespace luadio
 				ImGui::ColorEdit4("Foreground", &waveformSettings.foregroundColor.x);
 				ImGui::ColorEdit4("Background", &waveformSettings.backgroundColor.x);
 				
-				const char* items[] = { "Wave", "FFT" };
+				const char* items[] = { "Wave", "FFT", "Spectrogram", "Scope" };
 
 				if (ImGui::BeginCombo("Mode", items[waveformSettings.selectedMode])) 
 				{
@@ -223,8 +370,123 @@ namespace luadio
 					ImGui::EndCombo();
 				}
 
+				if(waveformSettings.plotMode == plot_mode_waveform)
+				{
+					float milliseconds = analysis.get_waveform_seconds() * 1000.0f;
+
+					if(ImGui::SliderFloat("Time (ms)", &milliseconds, 5.0f, analysis_worker::maxWaveformSeconds * 1000.0f, "%.0f", ImGuiSliderFlags_Logarithmic))
+					{
+						analysis.set_waveform_seconds(milliseconds / 1000.0f);
+					}
+				}
+				else if(waveformSettings.plotMode == plot_mode_scope)
+				{
+					scope_settings settings = analysis.get_scope_settings();
+					bool changed = false;
+
+					const char* triggerItems[] = { "Free running", "Zero crossing", "Level" };
+					int selectedTrigger = static_cast<int>(settings.mode);
+
+					if(ImGui::Combo("Trigger", &selectedTrigger, triggerItems, IM_ARRAYSIZE(triggerItems)))
+					{
+						settings.mode = (trigger_mode)selectedTrigger;
+						changed = true;
+					}
+
+					if(settings.mode == trigger_mode_level)
+					{
+						changed |= ImGui::SliderFloat("Level", &settings.level, -1.0f, 1.0f);
+					}
+
+					// The trigger works on any output channel, the view shows the first analysis_frame::maxChannels
+					const char* stereoItems[] = { "Left", "Right" };
+					const uint32_t selectedChannel = std::min<uint32_t>(settings.channel, audioSettings.channels - 1);
+					auto get_channel_name = [&stereoItems] (uint32_t channel, uint32_t channels) {
+						return channels == 2 ? std::string(stereoItems[channel]) : "Channel " + std::to_string(channel + 1);
+					};
+
+					if(ImGui::BeginCombo("Channel", get_channel_name(selectedChannel, audioSettings.channels).c_str()))
+					{
+						for(uint32_t c = 0; c < audioSettings.channels; c++)
+						{
+							if(ImGui::Selectable(get_channel_name(c, audioSettings.channels).c_str(), c == selectedChannel))
+							{
+								settings.channel = c;
+								changed = true;
+							}
+						}
 
+						ImGui::EndCombo();
+					}
+
+					float windowMilliseconds = settings.windowSeconds * 1000.0f;
+					float holdoffMilliseconds = settings.holdoffSeconds * 1000.0f;
+
+					if(ImGui::SliderFloat("Time (ms)", &windowMilliseconds, 1.0f, 150.0f, "%.1f", ImGuiSliderFlags_Logarithmic))
+					{
+						settings.windowSeconds = windowMilliseconds / 1000.0f;
+						changed = true;
+					}
 
+					if(ImGui::SliderFloat("Hold-off (ms)", &holdoffMilliseconds, 0.0f, 100.0f, "%.1f"))
+					{
+						settings.holdoffSeconds = holdoffMilliseconds / 1000.0f;
+						changed = true;
+					}
+
+					if(changed)
+					{
+						analysis.set_scope_settings(settings);
+					}
+				}
+				else if(waveformSettings.plotMode == plot_mode_spectrogram)
+				{
+					spectrogram_settings settings = analysis.get_spectrogram_settings();
+					bool changed = false;
+
+					const char* sizeItems[] = { "512", "1024", "2048", "4096", "8192" };
+					int selectedSize = 0;
+
+					while(selectedSize < IM_ARRAYSIZE(sizeItems) - 1 && (512u << selectedSize) < settings.fftSize)
+						selectedSize++;
+
+					if(ImGui::Combo("FFT size", &selectedSize, sizeItems, IM_ARRAYSIZE(sizeItems)))
+					{
+						settings.fftSize = 512u << selectedSize;
+						changed = true;
+					}
+
+					const char* overlapItems[] = { "None", "50%", "75%", "87.5%" };
+					int selectedOverlap = 0;
+
+					while(selectedOverlap < IM_ARRAYSIZE(overlapItems) - 1 && (1u << selectedOverlap) < settings.overlap)
+						selectedOverlap++;
+
+					if(ImGui::Combo("Overlap", &selectedOverlap, overlapItems, IM_ARRAYSIZE(overlapItems)))
+					{
+						settings.overlap = 1u << selectedOverlap;
+						changed = true;
+					}
+
+					const char* windowItems[] = { "Rectangular", "Hann", "Hamming", "Blackman-Harris" };
+					int selectedWindow = static_cast<int>(settings.window);
+
+					if(ImGui::Combo("Window", &selectedWindow, windowItems, IM_ARRAYSIZE(windowItems)))
+					{
+						settings.window = (window_type)selectedWindow;
+						changed = true;
+					}
+
+					if(ImGui::SliderFloat("Floor (dB)", &settings.minDecibels, -140.0f, -30.0f, "%.0f"))
+					{
+						changed = true;
+					}
+
+					if(changed)
+					{
+						analysis.set_spectrogram_settings(settings);
+					}
+				}
 			}
 			ImGui::End();
 
@@ -236,66 +498,204 @@ namespace luadio
 				menuState = menu_state_none;
 			}
 		}
-	}
+		else if(menuState == menu_state_settings_recording)
+		{
+			bool show = true;
 
-    void app::show_panel()
-	{
-		ImGui::Begin("Panel");
+			ImGui::PushStyleVar(ImGuiStyleVar_WindowBorderSize, 1);
+			ImGui::PushStyleColor(ImGuiCol_Border, ImVec4(0.200f, 0.220f, 0.240f, 1.000f));
+
+			if(ImGui::Begin("Recording settings", &show))
+			{
+				const char* items[] = { "16 bit", "24 bit", "32 bit" };
+				int selectedFormat = static_cast<int>(recorder.get_format());
 
-		size_t bufferSize = concurrentBuffer.read(outputData);
+				if (ImGui::BeginCombo("Bit depth", items[selectedFormat])) 
+				{
+					for (int i = 0; i < IM_ARRAYSIZE(items); i++) {
+						bool isSelected = (selectedFormat == i);
+						if (ImGui::Selectable(items[i], isSelected)) 
+						{
+							recorder.set_format((pcm_format)i);
+						}
+						if (isSelected) 
+						{
+							ImGui::SetItemDefaultFocus();
+						}
+					}
+					ImGui::EndCombo();
+				}
 
-		if(bufferSize > 0)
+				bool dither = recorder.get_dither();
+
+				if(ImGui::Checkbox("Dither", &dither))
+				{
+					recorder.set_dither(dither);
+				}
+
+				bool recordDry = recorder.get_record_dry();
+
+				if(ImGui::Checkbox("Record dry stem", &recordDry))
+				{
+					recorder.set_record_dry(recordDry);
+				}
+
+				bool recordBuses = recorder.get_record_buses();
+
+				if(ImGui::Checkbox("Record script buses", &recordBuses))
+				{
+					recorder.set_record_buses(recordBuses);
+				}
+
+				ImGui::Text("Dropped blocks     %llu", static_cast<unsigned long long>(recorder.get_dropped_blocks()));
+				ImGui::Text("Dropped bus writes %llu", static_cast<unsigned long long>(recorder.get_dropped_bus_writes()));
+
+				ImGui::SliderFloat("History (seconds)", &historySeconds, 1.0f, history.get_max_seconds(), "%.0f");
+			}
+			ImGui::End();
+
+			ImGui::PopStyleVar(1);
+			ImGui::PopStyleColor(1);
+
+			if(!show)
+			{
+				menuState = menu_state_none;
+			}
+		}
+		else if(menuState == menu_state_settings_audio)
 		{
-			auto isPowerOfTwo = [] (size_t n) -> bool {
-				return n > 0 && (n & (n - 1)) == 0;
-			};
+			bool show = true;
 
-			auto nextPowerOfTwo = [] (size_t n) -> size_t {
-				size_t p = 1;
-				while (p < n) 
-					p <<= 1;
-				return p;
-			};
+			ImGui::PushStyleVar(ImGuiStyleVar_WindowBorderSize, 1);
+			ImGui::PushStyleColor(ImGuiCol_Border, ImVec4(0.200f, 0.220f, 0.240f, 1.000f));
 
-			if(waveformSettings.plotMode == plot_mode_fft)
+			if(ImGui::Begin("Audio settings", &show))
 			{
-				if(!isPowerOfTwo(outputData.size()))
+				// Values given on the command line may not be in the lists, the preview always shows the actual value
+				auto showCombo = [] (const char *label, const uint32_t *pValues, int count, uint32_t &value) {
+					std::string preview = std::to_string(value);
+
+					if (ImGui::BeginCombo(label, preview.c_str())) 
+					{
+						for (int i = 0; i < count; i++) {
+							std::string item = std::to_string(pValues[i]);
+							bool isSelected = (value == pValues[i]);
+							if (ImGui::Selectable(item.c_str(), isSelected)) 
+							{
+								value = pValues[i];
+							}
+							if (isSelected) 
+							{
+								ImGui::SetItemDefaultFocus();
+							}
+						}
+						ImGui::EndCombo();
+					}
+				};
+
+				const uint32_t sampleRates[] = { 22050, 32000, 44100, 48000, 88200, 96000 };
+				const uint32_t periodSizes[] = { 64, 128, 256, 512, 1024, 2048 };
+				const uint32_t channelCounts[] = { 1, 2, 4, 6, 8, 16 };
+				const uint32_t subBlockSizes[] = { 0, 16, 32, 64, 128, 256 };
+
+				showCombo("Sample rate", sampleRates, IM_ARRAYSIZE(sampleRates), pendingSettings.sampleRate);
+				showCombo("Period (frames)", periodSizes, IM_ARRAYSIZE(periodSizes), pendingSettings.periodSize);
+				showCombo("Channels", channelCounts, IM_ARRAYSIZE(channelCounts), pendingSettings.channels);
+				showCombo("Sub-block (0 = off)", subBlockSizes, IM_ARRAYSIZE(subBlockSizes), pendingSettings.subBlockSize);
+
+				if(pendingSettings.channels > analysis_frame::maxChannels)
 				{
-					size_t n = nextPowerOfTwo(outputData.size()) / 2;
-					fftBuffer.resize(n);
+					// Scripts, filters, meters and recordings get every channel, the plots only have room for two
+					ImGui::TextDisabled("Wave and scope plots show channels 1 and 2 of %u", pendingSettings.channels);
 				}
-				else
+
+				if(ImGui::Button("Low latency"))
 				{
-					size_t n = outputData.size() / 2;
-					if(fftBuffer.size() != n)
-						fftBuffer.resize(n);
+					pendingSettings.periodSize = audio_settings::lowLatencyPeriodSize;
 				}
 
-				size_t numFrames = outputData.size() / 2;
+				ImGui::SameLine();
+
+				// Restarting the device would cut a take or a history save short
+				ImGui::BeginDisabled(recorder.is_recording() || history.is_saving());
 
-				for (size_t i = 0; i < numFrames; ++i) 
+				if(ImGui::Button("Apply"))
 				{
-					float left  = outputData[2 * i];
-					float right = outputData[2 * i + 1];
-					float mono = 0.5f * (left + right); // Average the channels
-					fftBuffer[i] = std::complex<double>(static_cast<double>(mono), 0.0);
+					restart_audio();
 				}
 
-				fft::perform(fftBuffer, fftBuffer.size());
+				ImGui::EndDisabled();
+
+				ImGui::Separator();
+				ImGui::Text("Running at %s", audioSettings.to_string().c_str());
 
-				ImGuiEx::DrawHistogram(fftBuffer.data(), fftBuffer.size(), ImVec2(128, 64), waveformSettings.foregroundColor, waveformSettings.backgroundColor);
+				// There is no capture path to measure against, a duplex round trip takes at least one input and one output period
+				const float blockMilliseconds = 1000.0f * latency.get_max_block_size() / audioSettings.sampleRate;
+
+				ImGui::Text("Block        %u frames, largest %u", latency.get_block_size(), latency.get_max_block_size());
+				ImGui::Text("Interval     %.2f ms average, %.2f ms worst", latency.get_average_interval(), latency.get_max_interval());
+				ImGui::Text("Load         %.1f%% average, %.1f%% peak", latency.get_average_load() * 100.0f, latency.get_peak_load() * 100.0f);
+				ImGui::Text("Late periods %llu", static_cast<unsigned long long>(latency.get_late_periods()));
+				ImGui::Text("Round trip   ~%.1f ms (estimate, not measured)", 2.0f * blockMilliseconds);
+
+				if(ImGui::IsItemHovered())
+				{
+					ImGui::SetTooltip("One input and one output period of the largest block seen.\nThe device and driver buffers add to this.");
+				}
+
+				if(ImGuiEx::Button("Reset"))
+				{
+					latency.reset(audioSettings.sampleRate);
+				}
 			}
-			else
+			ImGui::End();
+
+			ImGui::PopStyleVar(1);
+			ImGui::PopStyleColor(1);
+
+			if(!show)
 			{
-				ImGuiEx::DrawWaveform(outputData.data(), bufferSize / 2, 2, ImVec2(128, 64), waveformSettings.foregroundColor, waveformSettings.backgroundColor);
+				menuState = menu_state_none;
 			}
 		}
+	}
+
+    void app::show_panel()
+	{
+		ImGui::Begin("Panel");
+
+		const analysis_frame &frame = analysis.get_frame();
+		const ImVec2 plotSize(128, 64);
+		ImVec2 plotPosition = ImGui::GetCursorScreenPos();
+
+		if(waveformSettings.plotMode == plot_mode_spectrogram)
+		{
+			update_spectrogram_texture();
+			float scroll = static_cast<float>(spectrogramColumnsUploaded % spectrogram::capacity) / spectrogram::capacity;
+			ImGuiEx::DrawSpectrogram(ImTextureID(spectrogramTexture.get_id()), scroll, plotSize, waveformSettings.backgroundColor);
+		}
+		else if(waveformSettings.plotMode == plot_mode_fft)
+		{
+			ImGuiEx::DrawSpectrum(frame.spectrum, analysis_frame::spectrumBands, analysis_frame::minDecibels, plotSize, waveformSettings.foregroundColor, waveformSettings.backgroundColor);
+		}
+		else if(waveformSettings.plotMode == plot_mode_scope)
+		{
+			ImGuiEx::DrawWaveformColumns(&frame.scopeMin[0][0], &frame.scopeMax[0][0], analysis_frame::waveformColumns, frame.channels, plotSize, waveformSettings.foregroundColor, waveformSettings.backgroundColor);
+		}
 		else
 		{
-			ImGuiEx::DrawWaveform(outputData.data(), outputData.size() / 2, 2, ImVec2(128, 64), waveformSettings.foregroundColor, waveformSettings.backgroundColor);
+			ImGuiEx::DrawWaveformColumns(&frame.waveformMin[0][0], &frame.waveformMax[0][0], analysis_frame::waveformColumns, frame.channels, plotSize, waveformSettings.foregroundColor, waveformSettings.backgroundColor);
+		}
+
+		// One thin meter per channel to the right of the plot
+		for(uint32_t c = 0; c < frame.channels; c++)
+		{
+			ImGui::SetCursorScreenPos(ImVec2(plotPosition.x + plotSize.x + 2 + c * 6, plotPosition.y));
+			ImGuiEx::DrawMeter(frame.peakDecibels[c], frame.rmsDecibels[c], analysis_frame::minDecibels, ImVec2(4, plotSize.y), waveformSettings.foregroundColor, ImVec4(0.1f, 0.1f, 0.1f, 1.0f));
 		}
-		
-		ImGui::SetCursorPosX(ImGui::GetCursorPosX() + 132);
+
+		ImGui::SetCursorScreenPos(plotPosition);
+		ImGui::SetCursorPosX(ImGui::GetCursorPosX() + plotSize.x + 16);
 
 		if(ImGuiEx::Button("Play/Stop"))
 		{
@@ -311,6 +711,13 @@ namespace luadio
 
 				lua_State *L = compiler::get_lua_state();
 
+				// Before running the script, so events it schedules while loading are kept
+				reset_transport();
+
+				// Every script starts out interleaved and opts in to planar buffers itself
+				bufferLayout.store(buffer_layout_interleaved);
+				effectBypass.store(false);
+
 				if (luaL_dostring(L, code.c_str()) == LUA_OK) 
 				{
 					on_script_start();
@@ -363,6 +770,28 @@ namespace luadio
 			ImGui::PopStyleColor(2);
 		}
 
+		ImGui::SameLine();
+
+		std::string saveLabel = "Save Last " + std::to_string(static_cast<int>(historySeconds)) + "s";
+
+		ImGui::BeginDisabled(history.is_saving() || history.get_available_seconds() <= 0.0f);
+
+		if(ImGui::Button(saveLabel.c_str()))
+		{
+			history.save(historySeconds, recorder.get_format(), recorder.get_dither());
+		}
+
+		ImGui::EndDisabled();
+
+		ImGui::SameLine();
+
+		bool bypass = effectBypass.load();
+
+		if(ImGui::Checkbox("Bypass effect", &bypass))
+		{
+			effectBypass.store(bypass);
+		}
+
 		ImGui::End();
 	}
 
@@ -481,6 +910,90 @@ namespace luadio
 		}
 	}
 
+    void app::show_meters()
+	{
+		if(ImGui::Begin("Meters"))
+		{
+			loudness_meter &loudness = analysis.get_loudness();
+
+			ImGui::Text("Momentary   %6.1f LUFS", loudness.get_momentary());
+			ImGui::Text("Short term  %6.1f LUFS", loudness.get_short_term());
+			ImGui::Text("Integrated  %6.1f LUFS", loudness.get_integrated());
+
+			for(uint32_t c = 0; c < loudness.get_channels(); c++)
+			{
+				ImGui::Text("Channel %u  TP %6.1f dBTP  RMS %6.1f dB  Peak %6.1f dB", c + 1, loudness.get_true_peak(c), loudness.get_rms(c), loudness.get_peak_hold(c));
+			}
+
+			ImVec2 position = ImGui::GetCursorScreenPos();
+
+			// The bar shows RMS, the line the held peak
+			for(uint32_t c = 0; c < loudness.get_channels(); c++)
+			{
+				ImGui::SetCursorScreenPos(ImVec2(position.x + c * 12, position.y));
+				ImGuiEx::DrawMeter(loudness.get_peak_hold(c), loudness.get_rms(c), analysis_frame::minDecibels, ImVec2(8, 64), waveformSettings.foregroundColor, ImVec4(0.1f, 0.1f, 0.1f, 1.0f));
+			}
+
+			ImGui::SetCursorScreenPos(position);
+			ImGui::Dummy(ImVec2(loudness.get_channels() * 12.0f, 68));
+
+			if(ImGuiEx::Button("Reset"))
+			{
+				loudness.reset();
+			}
+		}
+		ImGui::End();
+	}
+
+	void app::update_spectrogram_texture()
+	{
+		const spectrogram &spectrum = analysis.get_spectrogram();
+		const uint64_t columnCount = spectrum.get_column_count();
+
+		if(columnCount == spectrogramColumnsUploaded)
+			return;
+
+		// The worker may be writing the oldest slot of the ring right now, so it is never uploaded
+		uint64_t first = spectrogramColumnsUploaded;
+
+		if(columnCount - first > spectrogram::capacity - 1)
+			first = columnCount - (spectrogram::capacity - 1);
+
+		// Intensity scales the foreground color, the alpha lets the dot matrix show through quiet bins
+		uint8_t colorMap[256][4];
+		const ImVec4 &color = waveformSettings.foregroundColor;
+
+		for(int i = 0; i < 256; i++)
+		{
+			colorMap[i][0] = static_cast<uint8_t>(color.x * i);
+			colorMap[i][1] = static_cast<uint8_t>(color.y * i);
+			colorMap[i][2] = static_cast<uint8_t>(color.z * i);
+			colorMap[i][3] = static_cast<uint8_t>(color.w * i);
+		}
+
+		// Columns are uploaded in contiguous runs, a run ends where the ring wraps around
+		for(uint64_t index = first; index < columnCount; )
+		{
+			const uint32_t x = static_cast<uint32_t>(index % spectrogram::capacity);
+			const uint32_t width = static_cast<uint32_t>(std::min<uint64_t>(columnCount - index, spectrogram::capacity - x));
+
+			for(uint32_t c = 0; c < width; c++)
+			{
+				const uint8_t *pColumn = spectrum.get_column(index + c);
+
+				for(uint32_t row = 0; row < spectrogram::rows; row++)
+				{
+					std::memcpy(&spectrogramPixels[(row * width + c) * 4], colorMap[pColumn[row]], 4);
+				}
+			}
+
+			spectrogramTexture.update(spectrogramPixels.data(), x, 0, width, spectrogram::rows);
+			index += width;
+		}
+
+		spectrogramColumnsUploaded = columnCount;
+	}
+
 	void app::clear_fields()
 	{
 		if(fields.size() > 0)
@@ -542,7 +1055,19 @@ namespace luadio
 		lua_getglobal(L, "on_start");
 
 		if(lua_isfunction(L, -1))
-			lua_pcall(L, 0, 0, 0);
+		{
+			lua_pushinteger(L, audioSettings.sampleRate);
+			lua_pushinteger(L, audioSettings.channels);
+			lua_pushinteger(L, audioSettings.periodSize);
+			lua_pushinteger(L, audioSettings.subBlockSize);
+			lua_pcall(L, 4, 0, 0);
+		}
+
+		lua_settop(L, 0);
+
+		// Looked up once, a script without an effect costs the effect stage nothing
+		lua_getglobal(L, "on_audio_effect");
+		effectDefined.store(lua_isfunction(L, -1));
 
 		int top = lua_gettop(L);
 
@@ -592,6 +1117,61 @@ namespace luadio
 			lua_pop(L, top);
 	}
 
+	void app::reset_transport()
+	{
+		std::lock_guard<std::mutex> lock(luaMutex);
+
+		lua_State *L = compiler::get_lua_state();
+
+		transportClock.reset(audioSettings.sampleRate);
+		scheduler.clear();
+		samplePlayer.reset();
+		subBlockPosition = subBlockFrames;
+		recorder.set_frame_position(0);
+		recorder.release_buses();
+
+		// The Lua side keeps the items of pending events, only clear it if a script loaded the module
+		lua_getglobal(L, "package");
+		lua_getfield(L, -1, "loaded");
+		lua_getfield(L, -1, "luadio.transport");
+
+		if(lua_istable(L, -1))
+		{
+			lua_getfield(L, -1, "reset");
+
+			if(lua_isfunction(L, -1))
+				lua_pcall(L, 0, 0, 0);
+		}
+
+		int top = lua_gettop(L);
+
+		if(top > 0)
+			lua_pop(L, top);
+	}
+
+	void app::dispatch_events(lua_State *L, uint64_t frame, uint64_t startFrame)
+	{
+		const int top = lua_gettop(L);
+
+		lua_getglobal(L, "package");
+		lua_getfield(L, -1, "loaded");
+		lua_getfield(L, -1, "luadio.transport");
+
+		if(lua_istable(L, -1))
+		{
+			lua_getfield(L, -1, "dispatch");
+
+			if(lua_isfunction(L, -1))
+			{
+				lua_pushnumber(L, static_cast<double>(frame));
+				lua_pushnumber(L, static_cast<double>(startFrame));
+				lua_pcall(L, 2, 0, 0);
+			}
+		}
+
+		lua_settop(L, top);
+	}
+
 	void app::update_fields()
 	{
 		if(fieldQueue.size() == 0)
@@ -642,6 +1222,7 @@ namespace luadio
 	void app::on_audio_read(void *pUserData, void *pFramesOut, ma_uint64 frameCount, ma_uint32 channels)
 	{
 		app *pApp = reinterpret_cast<app*>(pUserData);
+		const uint64_t start = latency_monitor::now();
 
 		std::lock_guard<std::mutex> lock(pApp->luaMutex);
 
@@ -652,60 +1233,229 @@ namespace luadio
 		if(L == nullptr)
 			return;
 
+		float *pFrames = reinterpret_cast<float*>(pFramesOut);
+		ma_uint64 framesDone = 0;
+		const bool planar = pApp->bufferLayout.load(std::memory_order_relaxed) == buffer_layout_planar && channels == pApp->planarRead.get_channel_count();
+		const uint32_t blockFrames = pApp->subBlockFrames;
+
+		if(blockFrames > 0 && pApp->subBlock.size() == static_cast<size_t>(blockFrames) * channels)
+		{
+			// Whole sub-blocks are rendered into a one block FIFO and handed out from there, so scripts
+			// always see the same length whatever the device asks for. Leftover frames wait for the next period.
+			while(framesDone < frameCount)
+			{
+				if(pApp->subBlockPosition == blockFrames)
+				{
+					const uint64_t now = pApp->transportClock.get_frame_position();
+
+					// Events due anywhere in the sub-block run right before it, each is told its own frame
+					if(pApp->scheduler.get_next_frame() < now + blockFrames)
+						pApp->dispatch_events(L, now + blockFrames - 1, now);
+
+					std::fill(pApp->subBlock.begin(), pApp->subBlock.end(), 0.0f);
+					pApp->render_block(L, pApp->subBlock.data(), blockFrames, channels, planar);
+					pApp->subBlockPosition = 0;
+				}
+
+				const uint32_t count = static_cast<uint32_t>(std::min<ma_uint64>(blockFrames - pApp->subBlockPosition, frameCount - framesDone));
+				std::memcpy(pFrames + framesDone * channels, &pApp->subBlock[static_cast<size_t>(pApp->subBlockPosition) * channels], count * channels * sizeof(float));
+				pApp->subBlockPosition += count;
+				framesDone += count;
+			}
+
+			pApp->latency.add_work(start);
+			return;
+		}
+
+		// The block is split at scheduled events, so each one runs right before the frame it was scheduled for
+		while(framesDone < frameCount)
+		{
+			const uint64_t now = pApp->transportClock.get_frame_position();
+
+			if(pApp->scheduler.get_next_frame() <= now)
+				pApp->dispatch_events(L, now, now);
+
+			const uint64_t next = pApp->scheduler.get_next_frame();
+			ma_uint64 count = frameCount - framesDone;
+
+			if(next > now && next - now < count)
+				count = next - now;
+
+			if(planar && count > planarFrames)
+				count = planarFrames;
+
+			pApp->render_block(L, pFrames + framesDone * channels, static_cast<uint32_t>(count), channels, planar);
+			framesDone += count;
+		}
+
+		pApp->latency.add_work(start);
+	}
+
+	void app::render_block(lua_State *L, float *pOutput, uint32_t frameCount, uint32_t channels, bool planar)
+	{
+		const uint64_t now = transportClock.get_frame_position();
+
+		scriptFrame = now;
+		scriptPlanar = planar;
+
 		lua_getglobal(L, "on_audio_read");
 
 		if(lua_isfunction(L, -1))
 		{
-			lua_pushlightuserdata(L, pFramesOut);
-			lua_pushinteger(L, (frameCount * channels));
-			lua_pushinteger(L, channels);
-			lua_pcall(L, 3, 0, 0);
+			if(planar)
+			{
+				// Planar scripts get the channel pointers and a length in frames
+				planarRead.clear(frameCount);
+				lua_pushlightuserdata(L, planarRead.get_channels());
+				lua_pushinteger(L, frameCount);
+				lua_pushinteger(L, channels);
+				lua_pcall(L, 3, 0, 0);
+				planarRead.write_interleaved(pOutput, frameCount);
+			}
+			else
+			{
+				lua_pushlightuserdata(L, pOutput);
+				lua_pushinteger(L, (frameCount * channels));
+				lua_pushinteger(L, channels);
+				lua_pcall(L, 3, 0, 0);
+			}
 		}
 
 		int top = lua_gettop(L);
 
 		if(top > 0)
 			lua_pop(L, top);
+
+		// After the script so triggers sent from this callback still start in this block
+		samplePlayer.render(pOutput, frameCount, channels, now);
+
+		transportClock.advance(frameCount);
 	}
 
 	void app::on_audio_effect(ma_node *pNode, const float **ppFramesIn, ma_uint32 *pFrameCountIn, float **ppFramesOut, ma_uint32 *pFrameCountOut)
 	{
 		ma_effect_node *pEffectNode = reinterpret_cast<ma_effect_node*>(pNode);
 		app *pApp = reinterpret_cast<app*>(pEffectNode->config.pUserData);		
-		std::lock_guard<std::mutex> lock(pApp->luaMutex);
-		lua_State *L = compiler::get_lua_state();
-
-		if(L == nullptr)
-			return;
+		const uint64_t start = latency_monitor::now();
 
 		if(ma_ex_audio_source_get_is_playing(pApp->pSource) == MA_FALSE)
+		{
+			pApp->recorder.on_idle();
+			pApp->latency.end_period(start, *pFrameCountIn);
 			return;
+		}
 
-		const size_t sizeInBytes = *pFrameCountIn * pEffectNode->config.channels * sizeof(float);
+		const uint32_t channels = pEffectNode->config.channels;
+		const size_t sizeInBytes = *pFrameCountIn * channels * sizeof(float);
+		const float *pDry = ppFramesIn[0];
+		bool copied = false;
 
-		std::memcpy(ppFramesOut[0], ppFramesIn[0], sizeInBytes);
+		// Without an effect to run the stage never takes the Lua lock, it only passes the input on
+		if(pApp->effectDefined.load(std::memory_order_relaxed) && !pApp->effectBypass.load(std::memory_order_relaxed))
+		{
+			// The effect may run in place or write to its input, the dry stem is taken before it runs
+			if(pApp->recorder.is_recording() && pApp->recorder.get_record_dry())
+			{
+				// Only a period longer than dryFrames allocates here
+				if(pApp->dryBuffer.size() < static_cast<size_t>(*pFrameCountIn) * channels)
+					pApp->dryBuffer.resize(static_cast<size_t>(*pFrameCountIn) * channels);
 
-		lua_getglobal(L, "on_audio_effect");
+				std::memcpy(pApp->dryBuffer.data(), ppFramesIn[0], sizeInBytes);
+				pDry = pApp->dryBuffer.data();
+			}
 
-		if(lua_isfunction(L, -1))
-		{
-			lua_pushlightuserdata(L, (void*)ppFramesIn[0]);
-			lua_pushlightuserdata(L, (void*)pFrameCountIn);
-			lua_pushlightuserdata(L, (void*)ppFramesOut[0]);
-			lua_pushlightuserdata(L, (void*)pFrameCountOut);
-			lua_pushinteger(L, pEffectNode->config.channels);
+			std::lock_guard<std::mutex> lock(pApp->luaMutex);
+			lua_State *L = compiler::get_lua_state();
 
-			if(lua_pcall(L, 5, 0, 0) == 0)
+			if(L != nullptr)
 			{
-				pApp->concurrentBuffer.write(ppFramesOut[0], *pFrameCountOut * pEffectNode->config.channels);
-				if(pApp->recorder.is_recording())
-					pApp->recorder.on_process(ppFramesOut[0], *pFrameCountOut, pEffectNode->config.channels);
+				pApp->scriptFrame = pApp->get_output_frame(*pFrameCountIn);
+
+				if(pApp->bufferLayout.load(std::memory_order_relaxed) == buffer_layout_planar && channels == pApp->planarEffectInput.get_channel_count())
+				{
+					pApp->scriptPlanar = true;
+					pApp->process_planar_effect(L, ppFramesIn[0], ppFramesOut[0], *pFrameCountIn, channels);
+				}
+				else
+				{
+					pApp->scriptPlanar = false;
+
+					// Interleaved scripts expect the output to start as a copy of the input
+					if(ppFramesOut[0] != ppFramesIn[0])
+						std::memcpy(ppFramesOut[0], ppFramesIn[0], sizeInBytes);
+
+					lua_getglobal(L, "on_audio_effect");
+					lua_pushlightuserdata(L, (void*)ppFramesIn[0]);
+					lua_pushlightuserdata(L, (void*)pFrameCountIn);
+					lua_pushlightuserdata(L, (void*)ppFramesOut[0]);
+					lua_pushlightuserdata(L, (void*)pFrameCountOut);
+					lua_pushinteger(L, channels);
+					lua_pcall(L, 5, 0, 0);
+				}
+
+				copied = true;
+
+				int top = lua_gettop(L);
+
+				if(top > 0)
+					lua_pop(L, top);
 			}
 		}
 
-		int top = lua_gettop(L);
+		if(!copied && ppFramesOut[0] != ppFramesIn[0])
+			std::memcpy(ppFramesOut[0], ppFramesIn[0], sizeInBytes);
 
-		if(top > 0)
-			lua_pop(L, top);
+		// The output always reaches the taps, also when there is no effect or it failed
+		pApp->history.write(ppFramesOut[0], *pFrameCountOut, channels);
+		pApp->analysis.write(ppFramesOut[0], *pFrameCountOut, channels);
+		pApp->recorder.on_process(pDry, ppFramesOut[0], *pFrameCountOut, channels, pApp->get_output_frame(*pFrameCountOut));
+
+		pApp->latency.end_period(start, *pFrameCountOut);
+	}
+
+	uint64_t app::get_output_frame(uint32_t frameCount) const
+	{
+		// The read callback of this period already ran, and in sub-block mode the transport
+		// is further ahead by the frames still waiting in the FIFO
+		const uint64_t lead = static_cast<uint64_t>(subBlockFrames - subBlockPosition) + frameCount;
+		const uint64_t position = transportClock.get_frame_position();
+		return position > lead ? position - lead : 0;
+	}
+
+	bool app::process_planar_effect(lua_State *L, const float *pInput, float *pOutput, uint32_t frameCount, uint32_t channels)
+	{
+		// The output starts as a copy of the input, like the interleaved path does.
+		// Every frame of pOutput is written, so the caller does not copy beforehand.
+		const uint64_t frame = scriptFrame;
+
+		for(uint32_t framesDone = 0; framesDone < frameCount; )
+		{
+			const uint32_t count = std::min(frameCount - framesDone, planarFrames);
+			ma_uint32 countIn = count;
+			ma_uint32 countOut = count;
+
+			planarEffectInput.read_interleaved(pInput + static_cast<size_t>(framesDone) * channels, count);
+			planarEffectOutput.copy(planarEffectInput, count);
+			scriptFrame = frame + framesDone;
+
+			lua_getglobal(L, "on_audio_effect");
+			lua_pushlightuserdata(L, planarEffectInput.get_channels());
+			lua_pushlightuserdata(L, &countIn);
+			lua_pushlightuserdata(L, planarEffectOutput.get_channels());
+			lua_pushlightuserdata(L, &countOut);
+			lua_pushinteger(L, channels);
+
+			if(lua_pcall(L, 5, 0, 0) != 0)
+			{
+				// The rest of the block passes through unprocessed
+				std::memcpy(pOutput + static_cast<size_t>(framesDone) * channels, pInput + static_cast<size_t>(framesDone) * channels, static_cast<size_t>(frameCount - framesDone) * channels * sizeof(float));
+				return false;
+			}
+
+			planarEffectOutput.write_interleaved(pOutput + static_cast<size_t>(framesDone) * channels, count);
+			framesDone += count;
+		}
+
+		return true;
 	}
 }
\ No newline at end of file
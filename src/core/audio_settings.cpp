@@ -0,0 +1,117 @@
+#include "audio_settings.hpp"
+#include <iostream>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+namespace luadio
+{
+	static void print_usage(const char *program)
+	{
+		std::cout << "Usage: " << program << " [options]\n"
+			<< "  --sample-rate <hz>   Engine sample rate, default 44100\n"
+			<< "  --channels <count>   Output channels, default 2\n"
+			<< "  --period <frames>    Frames processed per device callback, default 1024\n"
+			<< "  --sub-block <frames> Run scripts in blocks of this fixed size, default 0 (off)\n"
+			<< "  --low-latency        Same as --period " << audio_settings::lowLatencyPeriodSize << "\n"
+			<< "  --help               Show this message\n";
+	}
+
+	static bool parse_value(const char *text, uint32_t minimum, uint32_t maximum, uint32_t &value)
+	{
+		char *pEnd = nullptr;
+		const unsigned long result = std::strtoul(text, &pEnd, 10);
+
+		if(pEnd == text || *pEnd != '\0' || result < minimum || result > maximum)
+			return false;
+
+		value = static_cast<uint32_t>(result);
+		return true;
+	}
+
+	audio_settings::audio_settings()
+	{
+		sampleRate = 44100;
+		channels = 2;
+		periodSize = 1024;
+		subBlockSize = 0;
+	}
+
+	bool audio_settings::is_valid() const
+	{
+		return sampleRate >= minSampleRate && sampleRate <= maxSampleRate &&
+			channels >= 1 && channels <= maxChannels &&
+			periodSize >= minPeriodSize && periodSize <= maxPeriodSize &&
+			subBlockSize <= maxSubBlockSize;
+	}
+
+	double audio_settings::get_period_milliseconds() const
+	{
+		return 1000.0 * periodSize / sampleRate;
+	}
+
+	std::string audio_settings::to_string() const
+	{
+		char text[160];
+		int length = std::snprintf(text, sizeof(text), "%u Hz, %u channels, %u frames per period (%.1f ms)", sampleRate, channels, periodSize, get_period_milliseconds());
+
+		if(subBlockSize > 0 && length > 0)
+			std::snprintf(text + length, sizeof(text) - length, ", sub-blocks of %u frames", subBlockSize);
+
+		return text;
+	}
+
+	bool audio_settings::parse(int argc, char **argv, audio_settings &settings)
+	{
+		for(int i = 1; i < argc; i++)
+		{
+			const char *pArgument = argv[i];
+			const char *pValue = (i + 1 < argc) ? argv[i + 1] : nullptr;
+			bool valid = true;
+
+			if(std::strcmp(pArgument, "--help") == 0)
+			{
+				print_usage(argv[0]);
+				return false;
+			}
+			else if(std::strcmp(pArgument, "--low-latency") == 0)
+			{
+				settings.periodSize = lowLatencyPeriodSize;
+				continue;
+			}
+			else if(std::strcmp(pArgument, "--sample-rate") == 0)
+			{
+				valid = pValue != nullptr && parse_value(pValue, minSampleRate, maxSampleRate, settings.sampleRate);
+			}
+			else if(std::strcmp(pArgument, "--channels") == 0)
+			{
+				valid = pValue != nullptr && parse_value(pValue, 1, maxChannels, settings.channels);
+			}
+			else if(std::strcmp(pArgument, "--period") == 0)
+			{
+				valid = pValue != nullptr && parse_value(pValue, minPeriodSize, maxPeriodSize, settings.periodSize);
+			}
+			else if(std::strcmp(pArgument, "--sub-block") == 0)
+			{
+				valid = pValue != nullptr && parse_value(pValue, 0, maxSubBlockSize, settings.subBlockSize);
+			}
+			else
+			{
+				std::cerr << "Unknown option " << pArgument << "\n";
+				print_usage(argv[0]);
+				return false;
+			}
+
+			if(!valid)
+			{
+				std::cerr << "Invalid value for " << pArgument << "\n";
+				print_usage(argv[0]);
+				return false;
+			}
+
+			i++;
+		}
+
+		return true;
+	}
+}
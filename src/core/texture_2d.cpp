@@ -113,6 +113,19 @@ namespace luadio
 		}
 	}
 
+	// Replaces a region of RGBA pixels, the texture must already be generated
+	void texture_2d::update(const uint8_t *data, uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+	{
+		if(!id || data == nullptr)
+			return;
+
+		glBindTexture(GL_TEXTURE_2D, id);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, data);
+		glGenerateMipmap(GL_TEXTURE_2D);
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+
 	void texture_2d::destroy()
 	{
 		if(id)
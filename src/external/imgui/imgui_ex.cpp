@@ -164,6 +164,66 @@ namespace ImGuiEx
 		return clicked;
 	}
 
+	// Draws precomputed min/max columns, one vertical span per column.
+	// Channel c reads its columns from minimums + c * columns and maximums + c * columns.
+	bool DrawWaveformColumns(const float *minimums, const float *maximums, int columns, int channels, const ImVec2 &size, const ImVec4 &foregroundColor, const ImVec4 &backgroundColor)
+	{
+		if (minimums == nullptr || maximums == nullptr || columns <= 0 || channels <= 0 || size.x <= 0 || size.y <= 0)
+			return false;
+
+		float channelHeight = size.y / channels;
+
+		auto drawList = ImGui::GetWindowDrawList();
+		ImVec2 windowPos = ImGui::GetCursorScreenPos();
+
+		ImVec2 topLeft = windowPos;
+		ImVec2 bottomRight = ImVec2(windowPos.x + size.x, windowPos.y + size.y);
+
+		create_dot_matrix_texture();
+
+		drawList->AddImage(ImTextureID(dotMatrixTexture.get_id()), topLeft, bottomRight, ImVec2(0, 0), ImVec2(1, 1), ImGui::GetColorU32(backgroundColor));
+
+		const ImU32 color = ImGui::GetColorU32(foregroundColor);
+		const float columnWidth = size.x / columns;
+		const float yScale = channelHeight / 2;
+
+		for (int channel = 0; channel < channels; channel++)
+		{
+			const float *pMin = minimums + channel * columns;
+			const float *pMax = maximums + channel * columns;
+			const float center = windowPos.y + channel * channelHeight + yScale;
+
+			for (int i = 0; i < columns; i++)
+			{
+				// Widen each span up to the previous column so steep edges stay connected
+				float low = pMin[i];
+				float high = pMax[i];
+
+				if (i > 0)
+				{
+					low = std::min(low, pMax[i - 1]);
+					high = std::max(high, pMin[i - 1]);
+				}
+
+				low = std::clamp(low, -1.0f, 1.0f);
+				high = std::clamp(high, -1.0f, 1.0f);
+
+				float x = windowPos.x + i * columnWidth;
+				float y0 = center - high * yScale;
+				float y1 = center - low * yScale;
+
+				drawList->AddRectFilled(ImVec2(x, y0), ImVec2(x + std::max(columnWidth, 1.0f), y1 + 1.0f), color);
+			}
+		}
+
+		// Mouse hit test
+		ImVec2 mouse = ImGui::GetIO().MousePos;
+		bool hovered = mouse.x >= topLeft.x && mouse.x < bottomRight.x &&
+					mouse.y >= topLeft.y && mouse.y < bottomRight.y;
+		bool clicked = hovered && ImGui::IsMouseClicked(ImGuiMouseButton_Left);
+		return clicked;
+	}
+
 	bool DrawHistogram(const std::complex<double> *samples, int count, const ImVec2 &size, const ImVec4 &foregroundColor, const ImVec4 &backgroundColor)
 	{
 		if (samples == nullptr || count <= 0 || size.x <= 0 || size.y <= 0)
@@ -227,6 +287,99 @@ namespace ImGuiEx
 		return clicked;
 	}
 
+	// Draws one bar per band, decibels at or below minDecibels draw nothing
+	bool DrawSpectrum(const float *decibels, int count, float minDecibels, const ImVec2 &size, const ImVec4 &foregroundColor, const ImVec4 &backgroundColor)
+	{
+		if (decibels == nullptr || count <= 0 || minDecibels >= 0 || size.x <= 0 || size.y <= 0)
+			return false;
+
+		auto drawList = ImGui::GetWindowDrawList();
+		ImVec2 windowPos = ImGui::GetCursorScreenPos();
+
+		ImVec2 topLeft = windowPos;
+		ImVec2 bottomRight = ImVec2(windowPos.x + size.x, windowPos.y + size.y);
+
+		create_dot_matrix_texture();
+
+		drawList->AddImage(ImTextureID(dotMatrixTexture.get_id()), topLeft, bottomRight, ImVec2(0, 0), ImVec2(1, 1), ImGui::GetColorU32(backgroundColor));
+
+		const ImU32 color = ImGui::GetColorU32(foregroundColor);
+		const float barWidth = size.x / count;
+
+		for (int i = 0; i < count; i++)
+		{
+			float t = std::clamp(1.0f - decibels[i] / minDecibels, 0.0f, 1.0f);
+
+			if (t <= 0.0f)
+				continue;
+
+			float x0 = windowPos.x + i * barWidth;
+			float y1 = bottomRight.y;
+			float y0 = y1 - t * size.y;
+
+			drawList->AddRectFilled(ImVec2(x0, y0), ImVec2(x0 + barWidth, y1), color);
+		}
+
+		// Mouse hit test
+		ImVec2 mouse = ImGui::GetIO().MousePos;
+		bool hovered = mouse.x >= topLeft.x && mouse.x < bottomRight.x &&
+					mouse.y >= topLeft.y && mouse.y < bottomRight.y;
+		bool clicked = hovered && ImGui::IsMouseClicked(ImGuiMouseButton_Left);
+		return clicked;
+	}
+
+	// Vertical level meter, the bar shows the RMS level and a line marks the peak
+	void DrawMeter(float peakDecibels, float rmsDecibels, float minDecibels, const ImVec2 &size, const ImVec4 &foregroundColor, const ImVec4 &backgroundColor)
+	{
+		if (minDecibels >= 0 || size.x <= 0 || size.y <= 0)
+			return;
+
+		auto drawList = ImGui::GetWindowDrawList();
+		ImVec2 windowPos = ImGui::GetCursorScreenPos();
+		ImVec2 bottomRight = ImVec2(windowPos.x + size.x, windowPos.y + size.y);
+
+		drawList->AddRectFilled(windowPos, bottomRight, ImGui::GetColorU32(backgroundColor));
+
+		auto toHeight = [&] (float decibels) -> float {
+			return std::clamp(1.0f - decibels / minDecibels, 0.0f, 1.0f) * size.y;
+		};
+
+		const ImU32 color = ImGui::GetColorU32(foregroundColor);
+		const float rmsY = bottomRight.y - toHeight(rmsDecibels);
+		const float peakY = bottomRight.y - toHeight(peakDecibels);
+
+		drawList->AddRectFilled(ImVec2(windowPos.x, rmsY), bottomRight, color);
+		drawList->AddLine(ImVec2(windowPos.x, peakY), ImVec2(bottomRight.x, peakY), color);
+	}
+
+	// Draws a ring texture of columns, scroll is the texture coordinate of the oldest column
+	bool DrawSpectrogram(ImTextureID textureId, float scroll, const ImVec2 &size, const ImVec4 &backgroundColor)
+	{
+		if (size.x <= 0 || size.y <= 0)
+			return false;
+
+		auto drawList = ImGui::GetWindowDrawList();
+		ImVec2 windowPos = ImGui::GetCursorScreenPos();
+
+		ImVec2 topLeft = windowPos;
+		ImVec2 bottomRight = ImVec2(windowPos.x + size.x, windowPos.y + size.y);
+
+		create_dot_matrix_texture();
+
+		drawList->AddImage(ImTextureID(dotMatrixTexture.get_id()), topLeft, bottomRight, ImVec2(0, 0), ImVec2(1, 1), ImGui::GetColorU32(backgroundColor));
+
+		// The texture repeats horizontally, so one quad covers the wrap around of the ring.
+		// Row 0 holds the lowest frequency and is flipped to the bottom.
+		drawList->AddImage(textureId, topLeft, bottomRight, ImVec2(scroll, 1), ImVec2(scroll + 1, 0));
+
+		// Mouse hit test
+		ImVec2 mouse = ImGui::GetIO().MousePos;
+		bool hovered = mouse.x >= topLeft.x && mouse.x < bottomRight.x &&
+					mouse.y >= topLeft.y && mouse.y < bottomRight.y;
+		bool clicked = hovered && ImGui::IsMouseClicked(ImGuiMouseButton_Left);
+		return clicked;
+	}
+
 	static const char ColorMarkerStart = '{';
 	static const char ColorMarkerEnd = '}';
 
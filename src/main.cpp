@@ -4,7 +4,12 @@ using namespace luadio;
 
 int main(int argc, char **argv)
 {
-	app application;
+	audio_settings settings;
+
+	if(!audio_settings::parse(argc, argv, settings))
+		return 1;
+
+	app application(settings);
 	application.run();
 	return 0;
 }
\ No newline at end of file
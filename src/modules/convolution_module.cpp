@@ -0,0 +1,132 @@
+#include "convolution_module.hpp"
+#include "../system/convolution_engine.hpp"
+#include "../system/object_reaper.hpp"
+#include <stdexcept>
+
+namespace luadio
+{
+	static std::string gSource = R"(local ffi = require('ffi')
+local luadio = require('luadio')
+local convolution = {}
+
+local luadio_convolution_create = luadio.findMethod('luadio_convolution_create', 'void* (__cdecl*)(const char*, uint32_t, uint32_t, uint32_t)')
+local luadio_convolution_destroy = luadio.findMethod('luadio_convolution_destroy', 'void (__cdecl*)(void*)')
+local luadio_convolution_get_status = luadio.findMethod('luadio_convolution_get_status', 'int32_t (__cdecl*)(void*)')
+local luadio_convolution_process = luadio.findMethod('luadio_convolution_process', 'void (__cdecl*)(void*, const float*, float*, uint32_t, uint32_t)')
+local luadio_convolution_get_latency = luadio.findMethod('luadio_convolution_get_latency', 'uint32_t (__cdecl*)(void*)')
+local luadio_convolution_get_late_blocks = luadio.findMethod('luadio_convolution_get_late_blocks', 'uint64_t (__cdecl*)(void*)')
+
+-- status Enum
+convolution.status = {}
+convolution.status.loading = 0
+convolution.status.ready = 1
+convolution.status.failed = 2
+
+local engine = {}
+engine.__index = engine
+
+-- Loads an impulse response file in the background, resampled to sampleRate or else the engine rate
+-- Output channels beyond the channels of the file reuse its last channel
+-- blockSize sets the latency in frames and is rounded up to a power of two
+function convolution.new(filePath, channels, blockSize, sampleRate)
+    local handle = luadio_convolution_create(filePath, channels or 2, blockSize or 256, sampleRate or luadio.get_sample_rate())
+    if handle == nil then
+        error('Failed to create convolution engine')
+    end
+    local self = setmetatable({}, engine)
+    self.handle = ffi.gc(handle, luadio_convolution_destroy)
+    self.latency = luadio_convolution_get_latency(handle)
+    return self
+end
+
+function engine:get_status()
+    return luadio_convolution_get_status(self.handle)
+end
+
+function engine:is_ready()
+    return self:get_status() == convolution.status.ready
+end
+
+function engine:failed()
+    return self:get_status() == convolution.status.failed
+end
+
+-- Number of blocks in which the reverb tail arrived too late and was replaced by silence
+function engine:get_late_blocks()
+    return tonumber(luadio_convolution_get_late_blocks(self.handle))
+end
+
+-- Convolves frameCount interleaved frames and writes only the wet signal, delayed by self.latency frames
+-- Writes silence until the impulse response is ready, input and output may be the same buffer
+function engine:process(input, output, frameCount, channels)
+    luadio_convolution_process(self.handle, ffi.cast('const float*', input), ffi.cast('float*', output), frameCount, channels or 2)
+end
+
+return convolution)";
+
+	void convolution_module::load(lua_State *L)
+	{
+		// Start the reaper here, the first engine may be released on the audio thread
+		object_reaper::get();
+
+		register_external_method(L, "luadio_convolution_create", reinterpret_cast<void*>(luadio_convolution_create));
+		register_external_method(L, "luadio_convolution_destroy", reinterpret_cast<void*>(luadio_convolution_destroy));
+		register_external_method(L, "luadio_convolution_get_status", reinterpret_cast<void*>(luadio_convolution_get_status));
+		register_external_method(L, "luadio_convolution_process", reinterpret_cast<void*>(luadio_convolution_process));
+		register_external_method(L, "luadio_convolution_get_latency", reinterpret_cast<void*>(luadio_convolution_get_latency));
+		register_external_method(L, "luadio_convolution_get_late_blocks", reinterpret_cast<void*>(luadio_convolution_get_late_blocks));
+
+		register_source(L, gSource, "luadio.convolution");
+	}
+
+	void *convolution_module::luadio_convolution_create(const char *filePath, uint32_t channels, uint32_t blockSize, uint32_t sampleRate)
+	{
+		if(filePath == nullptr || sampleRate == 0)
+			return nullptr;
+
+		try
+		{
+			convolution_engine *pEngine = new convolution_engine(channels, blockSize);
+			pEngine->load(filePath, sampleRate);
+			return pEngine;
+		}
+		catch(const std::invalid_argument &)
+		{
+			return nullptr;
+		}
+	}
+
+	void convolution_module::luadio_convolution_destroy(void *pEngine)
+	{
+		// The destructor joins the loader and worker threads, the collector may run on the audio thread
+		object_reaper::get().dispose(reinterpret_cast<convolution_engine*>(pEngine));
+	}
+
+	int32_t convolution_module::luadio_convolution_get_status(void *pEngine)
+	{
+		if(pEngine == nullptr)
+			return convolution_status_failed;
+		return reinterpret_cast<convolution_engine*>(pEngine)->get_status();
+	}
+
+	void convolution_module::luadio_convolution_process(void *pEngine, const float *pInput, float *pOutput, uint32_t frameCount, uint32_t channels)
+	{
+		if(pEngine == nullptr || pInput == nullptr || pOutput == nullptr || channels == 0)
+			return;
+		reinterpret_cast<convolution_engine*>(pEngine)->process(pInput, pOutput, frameCount, channels);
+	}
+
+	uint32_t convolution_module::luadio_convolution_get_latency(void *pEngine)
+	{
+		if(pEngine == nullptr)
+			return 0;
+		return reinterpret_cast<convolution_engine*>(pEngine)->get_latency();
+	}
+
+	uint64_t convolution_module::luadio_convolution_get_late_blocks(void *pEngine)
+	{
+		if(pEngine == nullptr)
+			return 0;
+		return reinterpret_cast<convolution_engine*>(pEngine)->get_late_blocks();
+	}
+}
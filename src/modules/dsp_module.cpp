@@ -0,0 +1,193 @@
+#include "dsp_module.hpp"
+#include "../system/buffer_ops.hpp"
+
+namespace luadio
+{
+	static std::string gSource = R"(local ffi = require('ffi')
+local luadio = require('luadio')
+local dsp = {}
+
+local luadio_dsp_clear = luadio.findMethod('luadio_dsp_clear', 'void (__cdecl*)(float*, uint32_t)')
+local luadio_dsp_copy = luadio.findMethod('luadio_dsp_copy', 'void (__cdecl*)(float*, const float*, uint32_t)')
+local luadio_dsp_gain = luadio.findMethod('luadio_dsp_gain', 'void (__cdecl*)(float*, const float*, float, uint32_t)')
+local luadio_dsp_gain_ramp = luadio.findMethod('luadio_dsp_gain_ramp', 'void (__cdecl*)(float*, const float*, float, float, uint32_t)')
+local luadio_dsp_accumulate = luadio.findMethod('luadio_dsp_accumulate', 'void (__cdecl*)(float*, const float*, float, uint32_t)')
+local luadio_dsp_mix = luadio.findMethod('luadio_dsp_mix', 'void (__cdecl*)(float*, const float*, float, const float*, float, uint32_t)')
+local luadio_dsp_clip = luadio.findMethod('luadio_dsp_clip', 'void (__cdecl*)(float*, const float*, float, float, uint32_t)')
+local luadio_dsp_pan = luadio.findMethod('luadio_dsp_pan', 'void (__cdecl*)(float*, const float*, float, uint32_t)')
+local luadio_dsp_balance = luadio.findMethod('luadio_dsp_balance', 'void (__cdecl*)(float*, const float*, float, uint32_t)')
+local luadio_dsp_interleave = luadio.findMethod('luadio_dsp_interleave', 'void (__cdecl*)(float*, const float*, uint32_t, uint32_t)')
+local luadio_dsp_deinterleave = luadio.findMethod('luadio_dsp_deinterleave', 'void (__cdecl*)(float*, const float*, uint32_t, uint32_t)')
+local luadio_dsp_get_peak = luadio.findMethod('luadio_dsp_get_peak', 'float (__cdecl*)(const float*, uint32_t)')
+
+-- Buffers are float pointers or float arrays, the destination always comes first
+-- Counts are in samples, except for functions that take frameCount
+-- Unless noted, the destination may be one of the sources
+
+function dsp.new_buffer(count)
+    return ffi.new('float[?]', count)
+end
+
+function dsp.clear(dst, count)
+    luadio_dsp_clear(ffi.cast('float*', dst), count)
+end
+
+function dsp.copy(dst, src, count)
+    luadio_dsp_copy(ffi.cast('float*', dst), ffi.cast('const float*', src), count)
+end
+
+-- dst = src * gain
+function dsp.gain(dst, src, gain, count)
+    luadio_dsp_gain(ffi.cast('float*', dst), ffi.cast('const float*', src), gain, count)
+end
+
+-- dst = src * gain with the gain moving linearly from startGain towards endGain, use it when a gain changes to avoid clicks
+function dsp.gain_ramp(dst, src, startGain, endGain, count)
+    luadio_dsp_gain_ramp(ffi.cast('float*', dst), ffi.cast('const float*', src), startGain, endGain, count)
+end
+
+-- dst = dst + src * gain
+function dsp.accumulate(dst, src, gain, count)
+    luadio_dsp_accumulate(ffi.cast('float*', dst), ffi.cast('const float*', src), gain, count)
+end
+
+-- dst = a * gainA + b * gainB
+function dsp.mix(dst, a, gainA, b, gainB, count)
+    luadio_dsp_mix(ffi.cast('float*', dst), ffi.cast('const float*', a), gainA, ffi.cast('const float*', b), gainB, count)
+end
+
+-- Hard clips into [minimum, maximum]
+function dsp.clip(dst, src, minimum, maximum, count)
+    luadio_dsp_clip(ffi.cast('float*', dst), ffi.cast('const float*', src), minimum, maximum, count)
+end
+
+-- Equal power pan of a mono buffer into interleaved stereo, pan goes from -1 (left) to 1 (right)
+-- dst holds frameCount * 2 samples and must not overlap src
+function dsp.pan(dst, src, pan, frameCount)
+    luadio_dsp_pan(ffi.cast('float*', dst), ffi.cast('const float*', src), pan, frameCount)
+end
+
+-- Equal power balance of interleaved stereo, 0 leaves the signal untouched
+function dsp.balance(dst, src, pan, frameCount)
+    luadio_dsp_balance(ffi.cast('float*', dst), ffi.cast('const float*', src), pan, frameCount)
+end
+
+-- Planar buffers hold all frames of channel 0, then all frames of channel 1 and so on
+-- Source and destination must not overlap
+function dsp.interleave(dst, src, frameCount, channels)
+    luadio_dsp_interleave(ffi.cast('float*', dst), ffi.cast('const float*', src), frameCount, channels)
+end
+
+function dsp.deinterleave(dst, src, frameCount, channels)
+    luadio_dsp_deinterleave(ffi.cast('float*', dst), ffi.cast('const float*', src), frameCount, channels)
+end
+
+-- Largest absolute sample value
+function dsp.peak(src, count)
+    return luadio_dsp_get_peak(ffi.cast('const float*', src), count)
+end
+
+return dsp)";
+
+	void dsp_module::load(lua_State *L)
+	{
+		register_external_method(L, "luadio_dsp_clear", reinterpret_cast<void*>(luadio_dsp_clear));
+		register_external_method(L, "luadio_dsp_copy", reinterpret_cast<void*>(luadio_dsp_copy));
+		register_external_method(L, "luadio_dsp_gain", reinterpret_cast<void*>(luadio_dsp_gain));
+		register_external_method(L, "luadio_dsp_gain_ramp", reinterpret_cast<void*>(luadio_dsp_gain_ramp));
+		register_external_method(L, "luadio_dsp_accumulate", reinterpret_cast<void*>(luadio_dsp_accumulate));
+		register_external_method(L, "luadio_dsp_mix", reinterpret_cast<void*>(luadio_dsp_mix));
+		register_external_method(L, "luadio_dsp_clip", reinterpret_cast<void*>(luadio_dsp_clip));
+		register_external_method(L, "luadio_dsp_pan", reinterpret_cast<void*>(luadio_dsp_pan));
+		register_external_method(L, "luadio_dsp_balance", reinterpret_cast<void*>(luadio_dsp_balance));
+		register_external_method(L, "luadio_dsp_interleave", reinterpret_cast<void*>(luadio_dsp_interleave));
+		register_external_method(L, "luadio_dsp_deinterleave", reinterpret_cast<void*>(luadio_dsp_deinterleave));
+		register_external_method(L, "luadio_dsp_get_peak", reinterpret_cast<void*>(luadio_dsp_get_peak));
+
+		register_source(L, gSource, "luadio.dsp");
+	}
+
+	void dsp_module::luadio_dsp_clear(float *pDst, uint32_t count)
+	{
+		if(pDst == nullptr)
+			return;
+		buffer_ops::clear(pDst, count);
+	}
+
+	void dsp_module::luadio_dsp_copy(float *pDst, const float *pSrc, uint32_t count)
+	{
+		if(pDst == nullptr || pSrc == nullptr)
+			return;
+		buffer_ops::copy(pDst, pSrc, count);
+	}
+
+	void dsp_module::luadio_dsp_gain(float *pDst, const float *pSrc, float gain, uint32_t count)
+	{
+		if(pDst == nullptr || pSrc == nullptr)
+			return;
+		buffer_ops::gain(pDst, pSrc, gain, count);
+	}
+
+	void dsp_module::luadio_dsp_gain_ramp(float *pDst, const float *pSrc, float startGain, float endGain, uint32_t count)
+	{
+		if(pDst == nullptr || pSrc == nullptr)
+			return;
+		buffer_ops::gain_ramp(pDst, pSrc, startGain, endGain, count);
+	}
+
+	void dsp_module::luadio_dsp_accumulate(float *pDst, const float *pSrc, float gain, uint32_t count)
+	{
+		if(pDst == nullptr || pSrc == nullptr)
+			return;
+		buffer_ops::accumulate(pDst, pSrc, gain, count);
+	}
+
+	void dsp_module::luadio_dsp_mix(float *pDst, const float *pA, float gainA, const float *pB, float gainB, uint32_t count)
+	{
+		if(pDst == nullptr || pA == nullptr || pB == nullptr)
+			return;
+		buffer_ops::mix(pDst, pA, gainA, pB, gainB, count);
+	}
+
+	void dsp_module::luadio_dsp_clip(float *pDst, const float *pSrc, float minimum, float maximum, uint32_t count)
+	{
+		if(pDst == nullptr || pSrc == nullptr)
+			return;
+		buffer_ops::clip(pDst, pSrc, minimum, maximum, count);
+	}
+
+	void dsp_module::luadio_dsp_pan(float *pDst, const float *pSrc, float pan, uint32_t frameCount)
+	{
+		if(pDst == nullptr || pSrc == nullptr)
+			return;
+		buffer_ops::pan(pDst, pSrc, pan, frameCount);
+	}
+
+	void dsp_module::luadio_dsp_balance(float *pDst, const float *pSrc, float pan, uint32_t frameCount)
+	{
+		if(pDst == nullptr || pSrc == nullptr)
+			return;
+		buffer_ops::balance(pDst, pSrc, pan, frameCount);
+	}
+
+	void dsp_module::luadio_dsp_interleave(float *pDst, const float *pSrc, uint32_t frameCount, uint32_t channels)
+	{
+		if(pDst == nullptr || pSrc == nullptr || channels == 0)
+			return;
+		buffer_ops::interleave(pDst, pSrc, frameCount, channels);
+	}
+
+	void dsp_module::luadio_dsp_deinterleave(float *pDst, const float *pSrc, uint32_t frameCount, uint32_t channels)
+	{
+		if(pDst == nullptr || pSrc == nullptr || channels == 0)
+			return;
+		buffer_ops::deinterleave(pDst, pSrc, frameCount, channels);
+	}
+
+	float dsp_module::luadio_dsp_get_peak(const float *pSrc, uint32_t count)
+	{
+		if(pSrc == nullptr)
+			return 0.0f;
+		return buffer_ops::get_peak(pSrc, count);
+	}
+}
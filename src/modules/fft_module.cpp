@@ -0,0 +1,292 @@
+#include "fft_module.hpp"
+#include "../system/fft_plan.hpp"
+#include "../system/stft_processor.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+#include <cmath>
+
+namespace luadio
+{
+	static std::string gSource = R"(local ffi = require('ffi')
+local luadio = require('luadio')
+local fft = {}
+
+local luadio_fft_get_plan = luadio.findMethod('luadio_fft_get_plan', 'const void* (__cdecl*)(uint32_t)')
+local luadio_fft_forward = luadio.findMethod('luadio_fft_forward', 'void (__cdecl*)(const void*, const float*, float*)')
+local luadio_fft_inverse = luadio.findMethod('luadio_fft_inverse', 'void (__cdecl*)(const void*, const float*, float*)')
+local luadio_fft_generate_window = luadio.findMethod('luadio_fft_generate_window', 'void (__cdecl*)(int32_t, float*, uint32_t)')
+local luadio_fft_apply_window = luadio.findMethod('luadio_fft_apply_window', 'void (__cdecl*)(const float*, const float*, float*, uint32_t)')
+local luadio_fft_multiply = luadio.findMethod('luadio_fft_multiply', 'void (__cdecl*)(float*, const float*, uint32_t)')
+local luadio_fft_scale = luadio.findMethod('luadio_fft_scale', 'void (__cdecl*)(float*, const float*, uint32_t)')
+local luadio_fft_get_magnitudes = luadio.findMethod('luadio_fft_get_magnitudes', 'void (__cdecl*)(const float*, float*, uint32_t)')
+local luadio_fft_overlap_add = luadio.findMethod('luadio_fft_overlap_add', 'void (__cdecl*)(float*, const float*, uint32_t, float*, uint32_t)')
+local luadio_stft_create = luadio.findMethod('luadio_stft_create', 'void* (__cdecl*)(uint32_t, uint32_t, int32_t)')
+local luadio_stft_destroy = luadio.findMethod('luadio_stft_destroy', 'void (__cdecl*)(void*)')
+local luadio_stft_process = luadio.findMethod('luadio_stft_process', 'uint32_t (__cdecl*)(void*, const float*, float*, uint32_t, uint32_t)')
+local luadio_stft_is_ready = luadio.findMethod('luadio_stft_is_ready', 'int32_t (__cdecl*)(void*)')
+local luadio_stft_get_bins = luadio.findMethod('luadio_stft_get_bins', 'float* (__cdecl*)(void*)')
+
+-- window Enum
+fft.window = {}
+fft.window.rectangular = 0
+fft.window.hann = 1
+fft.window.hamming = 2
+fft.window.blackman_harris = 3
+
+-- Spectra are float arrays of binCount interleaved real and imaginary pairs, binCount is size / 2 + 1
+
+local plan = {}
+plan.__index = plan
+
+-- Returns a plan for a real transform of size samples, size must be a power of two of at least 4
+-- Plans are cached natively, asking for the same size twice is cheap
+function fft.plan(size)
+    local handle = luadio_fft_get_plan(size)
+    if handle == nil then
+        error('FFT size must be a power of two of at least 4')
+    end
+    local self = setmetatable({}, plan)
+    self.handle = handle
+    self.size = size
+    self.binCount = size / 2 + 1
+    return self
+end
+
+-- Transforms size samples of input into binCount bins
+function plan:forward(input, bins)
+    luadio_fft_forward(self.handle, ffi.cast('const float*', input), ffi.cast('float*', bins))
+end
+
+-- Transforms binCount bins back into size samples, inverse(forward(x)) returns x
+function plan:inverse(bins, output)
+    luadio_fft_inverse(self.handle, ffi.cast('const float*', bins), ffi.cast('float*', output))
+end
+
+function plan:new_buffer()
+    return ffi.new('float[?]', self.size)
+end
+
+function plan:new_bins()
+    return ffi.new('float[?]', self.binCount * 2)
+end
+
+-- Allocates and fills a periodic window of the given type
+function fft.new_window(type, length)
+    local window = ffi.new('float[?]', length)
+    luadio_fft_generate_window(type, window, length)
+    return window
+end
+
+-- output[i] = input[i] * window[i], output may be the same buffer as input
+function fft.apply_window(input, window, output, length)
+    luadio_fft_apply_window(ffi.cast('const float*', input), window, ffi.cast('float*', output), length)
+end
+
+-- Complex multiplication of every bin with the matching bin of other, for example a filter response
+function fft.multiply(bins, other, binCount)
+    luadio_fft_multiply(ffi.cast('float*', bins), ffi.cast('const float*', other), binCount)
+end
+
+-- Scales every bin by a real gain, gains holds binCount floats
+function fft.scale(bins, gains, binCount)
+    luadio_fft_scale(ffi.cast('float*', bins), ffi.cast('const float*', gains), binCount)
+end
+
+function fft.magnitudes(bins, magnitudes, binCount)
+    luadio_fft_get_magnitudes(ffi.cast('const float*', bins), ffi.cast('float*', magnitudes), binCount)
+end
+
+-- Adds frameSize samples of frame to accumulator, moves the first hopSize finished samples to output
+-- and shifts the accumulator by hopSize
+function fft.overlap_add(accumulator, frame, frameSize, output, hopSize)
+    luadio_fft_overlap_add(ffi.cast('float*', accumulator), ffi.cast('const float*', frame), frameSize, ffi.cast('float*', output), hopSize)
+end
+
+local stft = {}
+stft.__index = stft
+
+-- Short time transform of one channel with windowed overlap-add resynthesis
+-- The output is delayed by size frames
+function fft.stft(size, overlap, window)
+    local handle = luadio_stft_create(size, overlap or 4, window or fft.window.hann)
+    if handle == nil then
+        error('FFT size must be a power of two of at least 4 and overlap between 1 and size')
+    end
+    local self = setmetatable({}, stft)
+    self.handle = ffi.gc(handle, luadio_stft_destroy)
+    self.size = size
+    self.binCount = size / 2 + 1
+    return self
+end
+
+-- Runs frameCount frames through the transform, reading and writing every stride-th float
+-- fn(bins, binCount) is called once per hop and may change the bins in place
+-- Example for the left channel of an interleaved block: stft:process(pFramesIn, pFramesOut, frameCount, 2, fn)
+function stft:process(input, output, frameCount, stride, fn)
+    input = ffi.cast('const float*', input)
+    output = ffi.cast('float*', output)
+    stride = stride or 1
+    local done = 0
+    while done < frameCount do
+        done = done + luadio_stft_process(self.handle, input + done * stride, output + done * stride, frameCount - done, stride)
+        if luadio_stft_is_ready(self.handle) ~= 0 then
+            fn(luadio_stft_get_bins(self.handle), self.binCount)
+        end
+    end
+end
+
+return fft)";
+
+	void fft_module::load(lua_State *L)
+	{
+		register_external_method(L, "luadio_fft_get_plan", reinterpret_cast<void*>(luadio_fft_get_plan));
+		register_external_method(L, "luadio_fft_forward", reinterpret_cast<void*>(luadio_fft_forward));
+		register_external_method(L, "luadio_fft_inverse", reinterpret_cast<void*>(luadio_fft_inverse));
+		register_external_method(L, "luadio_fft_generate_window", reinterpret_cast<void*>(luadio_fft_generate_window));
+		register_external_method(L, "luadio_fft_apply_window", reinterpret_cast<void*>(luadio_fft_apply_window));
+		register_external_method(L, "luadio_fft_multiply", reinterpret_cast<void*>(luadio_fft_multiply));
+		register_external_method(L, "luadio_fft_scale", reinterpret_cast<void*>(luadio_fft_scale));
+		register_external_method(L, "luadio_fft_get_magnitudes", reinterpret_cast<void*>(luadio_fft_get_magnitudes));
+		register_external_method(L, "luadio_fft_overlap_add", reinterpret_cast<void*>(luadio_fft_overlap_add));
+		register_external_method(L, "luadio_stft_create", reinterpret_cast<void*>(luadio_stft_create));
+		register_external_method(L, "luadio_stft_destroy", reinterpret_cast<void*>(luadio_stft_destroy));
+		register_external_method(L, "luadio_stft_process", reinterpret_cast<void*>(luadio_stft_process));
+		register_external_method(L, "luadio_stft_is_ready", reinterpret_cast<void*>(luadio_stft_is_ready));
+		register_external_method(L, "luadio_stft_get_bins", reinterpret_cast<void*>(luadio_stft_get_bins));
+
+		register_source(L, gSource, "luadio.fft");
+	}
+
+	const void *fft_module::luadio_fft_get_plan(uint32_t size)
+	{
+		// Cached plans live as long as the application, so handing out the raw pointer is safe
+		try
+		{
+			return fft_plan::get(size).get();
+		}
+		catch(const std::invalid_argument &)
+		{
+			return nullptr;
+		}
+	}
+
+	void fft_module::luadio_fft_forward(const void *pPlan, const float *pInput, float *pBins)
+	{
+		if(pPlan == nullptr || pInput == nullptr || pBins == nullptr)
+			return;
+		reinterpret_cast<const fft_plan*>(pPlan)->forward(pInput, reinterpret_cast<std::complex<float>*>(pBins));
+	}
+
+	void fft_module::luadio_fft_inverse(const void *pPlan, const float *pBins, float *pOutput)
+	{
+		if(pPlan == nullptr || pBins == nullptr || pOutput == nullptr)
+			return;
+		reinterpret_cast<const fft_plan*>(pPlan)->inverse(reinterpret_cast<const std::complex<float>*>(pBins), pOutput);
+	}
+
+	void fft_module::luadio_fft_generate_window(int32_t type, float *pWindow, uint32_t length)
+	{
+		if(type < window_type_rectangular || type > window_type_blackman_harris)
+			type = window_type_rectangular;
+		window_function::generate(static_cast<window_type>(type), pWindow, length);
+	}
+
+	void fft_module::luadio_fft_apply_window(const float *pInput, const float *pWindow, float *pOutput, uint32_t length)
+	{
+		if(pInput == nullptr || pWindow == nullptr || pOutput == nullptr)
+			return;
+
+		for(uint32_t i = 0; i < length; i++)
+			pOutput[i] = pInput[i] * pWindow[i];
+	}
+
+	void fft_module::luadio_fft_multiply(float *pBins, const float *pOther, uint32_t binCount)
+	{
+		if(pBins == nullptr || pOther == nullptr)
+			return;
+
+		for(uint32_t i = 0; i < binCount; i++)
+		{
+			const float re = pBins[i * 2] * pOther[i * 2] - pBins[i * 2 + 1] * pOther[i * 2 + 1];
+			const float im = pBins[i * 2] * pOther[i * 2 + 1] + pBins[i * 2 + 1] * pOther[i * 2];
+			pBins[i * 2] = re;
+			pBins[i * 2 + 1] = im;
+		}
+	}
+
+	void fft_module::luadio_fft_scale(float *pBins, const float *pGains, uint32_t binCount)
+	{
+		if(pBins == nullptr || pGains == nullptr)
+			return;
+
+		for(uint32_t i = 0; i < binCount; i++)
+		{
+			pBins[i * 2] *= pGains[i];
+			pBins[i * 2 + 1] *= pGains[i];
+		}
+	}
+
+	void fft_module::luadio_fft_get_magnitudes(const float *pBins, float *pMagnitudes, uint32_t binCount)
+	{
+		if(pBins == nullptr || pMagnitudes == nullptr)
+			return;
+
+		for(uint32_t i = 0; i < binCount; i++)
+			pMagnitudes[i] = std::sqrt(pBins[i * 2] * pBins[i * 2] + pBins[i * 2 + 1] * pBins[i * 2 + 1]);
+	}
+
+	void fft_module::luadio_fft_overlap_add(float *pAccumulator, const float *pFrame, uint32_t frameSize, float *pOutput, uint32_t hopSize)
+	{
+		if(pAccumulator == nullptr || pFrame == nullptr || pOutput == nullptr || hopSize > frameSize)
+			return;
+
+		for(uint32_t i = 0; i < frameSize; i++)
+			pAccumulator[i] += pFrame[i];
+
+		std::memcpy(pOutput, pAccumulator, hopSize * sizeof(float));
+		std::memmove(pAccumulator, pAccumulator + hopSize, (frameSize - hopSize) * sizeof(float));
+		std::fill(pAccumulator + frameSize - hopSize, pAccumulator + frameSize, 0.0f);
+	}
+
+	void *fft_module::luadio_stft_create(uint32_t size, uint32_t overlap, int32_t window)
+	{
+		if(window < window_type_rectangular || window > window_type_blackman_harris)
+			window = window_type_hann;
+
+		try
+		{
+			return new stft_processor(size, overlap, static_cast<window_type>(window));
+		}
+		catch(const std::invalid_argument &)
+		{
+			return nullptr;
+		}
+	}
+
+	void fft_module::luadio_stft_destroy(void *pStft)
+	{
+		delete reinterpret_cast<stft_processor*>(pStft);
+	}
+
+	uint32_t fft_module::luadio_stft_process(void *pStft, const float *pInput, float *pOutput, uint32_t frameCount, uint32_t stride)
+	{
+		if(pStft == nullptr || pInput == nullptr || pOutput == nullptr)
+			return frameCount;
+		return reinterpret_cast<stft_processor*>(pStft)->process(pInput, pOutput, frameCount, std::max<uint32_t>(1, stride));
+	}
+
+	int32_t fft_module::luadio_stft_is_ready(void *pStft)
+	{
+		if(pStft == nullptr)
+			return 0;
+		return reinterpret_cast<stft_processor*>(pStft)->is_ready() ? 1 : 0;
+	}
+
+	float *fft_module::luadio_stft_get_bins(void *pStft)
+	{
+		if(pStft == nullptr)
+			return nullptr;
+		return reinterpret_cast<float*>(reinterpret_cast<stft_processor*>(pStft)->get_bins());
+	}
+}
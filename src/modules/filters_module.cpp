@@ -0,0 +1,294 @@
+#include "filters_module.hpp"
+#include <algorithm>
+#include <cstddef>
+
+namespace luadio
+{
+	// The cdef below has to match these layouts
+	static_assert(sizeof(biquad) == sizeof(float) * (5 + 2 * biquad::maxChannels));
+	static_assert(sizeof(state_variable_filter) == sizeof(float) * (6 + 2 * state_variable_filter::maxChannels));
+	static_assert(sizeof(one_pole) == sizeof(float) * (2 + one_pole::maxChannels));
+	static_assert(offsetof(delay_line, channels) == sizeof(float*) + 3 * sizeof(uint32_t));
+
+	static std::string gSource = R"(local ffi = require('ffi')
+local luadio = require('luadio')
+local filters = {}
+
+ffi.cdef[[
+typedef struct { float b0, b1, b2, a1, a2; float z1[16]; float z2[16]; } luadio_biquad;
+typedef struct { float a1, a2, a3; float m0, m1, m2; float ic1eq[16]; float ic2eq[16]; } luadio_svf;
+typedef struct { float coefficient; int32_t highpass; float z[16]; } luadio_one_pole;
+typedef struct { float *pBuffer; uint32_t length; uint32_t mask; uint32_t writePosition; uint32_t channels; } luadio_delay_line;
+]]
+
+local luadio_biquad_set = luadio.findMethod('luadio_biquad_set', 'void (__cdecl*)(luadio_biquad*, int32_t, float, float, float, float)')
+local luadio_biquad_process = luadio.findMethod('luadio_biquad_process', 'void (__cdecl*)(luadio_biquad*, const float*, float*, uint32_t, uint32_t)')
+local luadio_biquad_process_cascade = luadio.findMethod('luadio_biquad_process_cascade', 'void (__cdecl*)(luadio_biquad*, uint32_t, const float*, float*, uint32_t, uint32_t)')
+local luadio_svf_set = luadio.findMethod('luadio_svf_set', 'void (__cdecl*)(luadio_svf*, int32_t, float, float, float, float)')
+local luadio_svf_process = luadio.findMethod('luadio_svf_process', 'void (__cdecl*)(luadio_svf*, const float*, float*, uint32_t, uint32_t)')
+local luadio_one_pole_set = luadio.findMethod('luadio_one_pole_set', 'void (__cdecl*)(luadio_one_pole*, int32_t, float, float)')
+local luadio_one_pole_set_time = luadio.findMethod('luadio_one_pole_set_time', 'void (__cdecl*)(luadio_one_pole*, float, float)')
+local luadio_one_pole_process = luadio.findMethod('luadio_one_pole_process', 'void (__cdecl*)(luadio_one_pole*, const float*, float*, uint32_t, uint32_t)')
+local luadio_delay_line_create = luadio.findMethod('luadio_delay_line_create', 'luadio_delay_line* (__cdecl*)(uint32_t, uint32_t)')
+local luadio_delay_line_destroy = luadio.findMethod('luadio_delay_line_destroy', 'void (__cdecl*)(luadio_delay_line*)')
+local luadio_delay_line_reset = luadio.findMethod('luadio_delay_line_reset', 'void (__cdecl*)(luadio_delay_line*)')
+local luadio_delay_line_process = luadio.findMethod('luadio_delay_line_process', 'void (__cdecl*)(luadio_delay_line*, const float*, float*, uint32_t, float, float, int32_t)')
+local luadio_delay_line_process_modulated = luadio.findMethod('luadio_delay_line_process_modulated', 'void (__cdecl*)(luadio_delay_line*, const float*, float*, const float*, uint32_t, float, int32_t)')
+
+-- type Enum
+filters.type = {}
+filters.type.lowpass = 0
+filters.type.highpass = 1
+filters.type.bandpass = 2
+filters.type.notch = 3
+filters.type.allpass = 4
+filters.type.peak = 5
+filters.type.lowshelf = 6
+filters.type.highshelf = 7
+
+-- interpolation Enum
+filters.interpolation = {}
+filters.interpolation.none = 0
+filters.interpolation.linear = 1
+filters.interpolation.cubic = 2
+
+-- Filters are plain FFI structs with their state inside, they hold up to 16 interleaved channels, as many as the engine outputs
+-- Input and output are interleaved and may be the same buffer
+-- gainDecibels is only used by peak and shelf filters, sampleRate defaults to the engine rate
+
+local biquad = {}
+biquad.__index = biquad
+
+function biquad:set(type, frequency, q, gainDecibels, sampleRate)
+    luadio_biquad_set(self, type, frequency, q or 0.7071, gainDecibels or 0, sampleRate or luadio.get_sample_rate())
+end
+
+function biquad:reset()
+    ffi.fill(self.z1, ffi.sizeof(self.z1))
+    ffi.fill(self.z2, ffi.sizeof(self.z2))
+end
+
+function biquad:process(input, output, frameCount, channels)
+    luadio_biquad_process(self, ffi.cast('const float*', input), ffi.cast('float*', output), frameCount, channels or 2)
+end
+
+ffi.metatype('luadio_biquad', biquad)
+
+-- RBJ cookbook biquad
+function filters.biquad(type, frequency, q, gainDecibels, sampleRate)
+    local filter = ffi.new('luadio_biquad')
+    filter:set(type, frequency, q, gainDecibels, sampleRate)
+    return filter
+end
+
+-- Array of stageCount biquads, set each one with stages[i]:set(...) where i starts at 0
+function filters.new_cascade(stageCount)
+    return ffi.new('luadio_biquad[?]', stageCount)
+end
+
+-- Runs the block through all stages in order
+function filters.process_cascade(stages, stageCount, input, output, frameCount, channels)
+    luadio_biquad_process_cascade(stages, stageCount, ffi.cast('const float*', input), ffi.cast('float*', output), frameCount, channels or 2)
+end
+
+local svf = {}
+svf.__index = svf
+
+function svf:set(type, frequency, q, gainDecibels, sampleRate)
+    luadio_svf_set(self, type, frequency, q or 0.7071, gainDecibels or 0, sampleRate or luadio.get_sample_rate())
+end
+
+function svf:reset()
+    ffi.fill(self.ic1eq, ffi.sizeof(self.ic1eq))
+    ffi.fill(self.ic2eq, ffi.sizeof(self.ic2eq))
+end
+
+function svf:process(input, output, frameCount, channels)
+    luadio_svf_process(self, ffi.cast('const float*', input), ffi.cast('float*', output), frameCount, channels or 2)
+end
+
+ffi.metatype('luadio_svf', svf)
+
+-- State variable filter, prefer it over a biquad when the cutoff is modulated
+function filters.svf(type, frequency, q, gainDecibels, sampleRate)
+    local filter = ffi.new('luadio_svf')
+    filter:set(type, frequency, q, gainDecibels, sampleRate)
+    return filter
+end
+
+local one_pole = {}
+one_pole.__index = one_pole
+
+-- Only filters.type.lowpass and filters.type.highpass are supported
+function one_pole:set(type, frequency, sampleRate)
+    luadio_one_pole_set(self, type, frequency, sampleRate or luadio.get_sample_rate())
+end
+
+-- Low pass that reaches about 63% of a step after seconds, handy to smooth parameters
+function one_pole:set_time(seconds, sampleRate)
+    luadio_one_pole_set_time(self, seconds, sampleRate or luadio.get_sample_rate())
+end
+
+function one_pole:reset()
+    ffi.fill(self.z, ffi.sizeof(self.z))
+end
+
+function one_pole:process(input, output, frameCount, channels)
+    luadio_one_pole_process(self, ffi.cast('const float*', input), ffi.cast('float*', output), frameCount, channels or 2)
+end
+
+ffi.metatype('luadio_one_pole', one_pole)
+
+function filters.one_pole(type, frequency, sampleRate)
+    local filter = ffi.new('luadio_one_pole')
+    filter:set(type, frequency, sampleRate)
+    return filter
+end
+
+local delay_line = {}
+delay_line.__index = delay_line
+
+function delay_line:reset()
+    luadio_delay_line_reset(self)
+end
+
+-- Writes the delayed signal to output and feeds input plus feedback times the delayed signal back into the line
+function delay_line:process(input, output, frameCount, delayFrames, feedback, interpolation)
+    luadio_delay_line_process(self, ffi.cast('const float*', input), ffi.cast('float*', output), frameCount, delayFrames, feedback or 0, interpolation or filters.interpolation.linear)
+end
+
+-- Same but with one delay time per frame in delayFrames, for chorus, flanger and vibrato
+function delay_line:process_modulated(input, output, delayFrames, frameCount, feedback, interpolation)
+    luadio_delay_line_process_modulated(self, ffi.cast('const float*', input), ffi.cast('float*', output), ffi.cast('const float*', delayFrames), frameCount, feedback or 0, interpolation or filters.interpolation.cubic)
+end
+
+ffi.metatype('luadio_delay_line', delay_line)
+
+-- Interleaved delay line that holds at least maxDelayFrames, delay times are fractional
+function filters.delay_line(maxDelayFrames, channels)
+    local handle = luadio_delay_line_create(maxDelayFrames, channels or 2)
+    if handle == nil then
+        error('Failed to create delay line')
+    end
+    return ffi.gc(handle, luadio_delay_line_destroy)
+end
+
+return filters)";
+
+	void filters_module::load(lua_State *L)
+	{
+		register_external_method(L, "luadio_biquad_set", reinterpret_cast<void*>(luadio_biquad_set));
+		register_external_method(L, "luadio_biquad_process", reinterpret_cast<void*>(luadio_biquad_process));
+		register_external_method(L, "luadio_biquad_process_cascade", reinterpret_cast<void*>(luadio_biquad_process_cascade));
+		register_external_method(L, "luadio_svf_set", reinterpret_cast<void*>(luadio_svf_set));
+		register_external_method(L, "luadio_svf_process", reinterpret_cast<void*>(luadio_svf_process));
+		register_external_method(L, "luadio_one_pole_set", reinterpret_cast<void*>(luadio_one_pole_set));
+		register_external_method(L, "luadio_one_pole_set_time", reinterpret_cast<void*>(luadio_one_pole_set_time));
+		register_external_method(L, "luadio_one_pole_process", reinterpret_cast<void*>(luadio_one_pole_process));
+		register_external_method(L, "luadio_delay_line_create", reinterpret_cast<void*>(luadio_delay_line_create));
+		register_external_method(L, "luadio_delay_line_destroy", reinterpret_cast<void*>(luadio_delay_line_destroy));
+		register_external_method(L, "luadio_delay_line_reset", reinterpret_cast<void*>(luadio_delay_line_reset));
+		register_external_method(L, "luadio_delay_line_process", reinterpret_cast<void*>(luadio_delay_line_process));
+		register_external_method(L, "luadio_delay_line_process_modulated", reinterpret_cast<void*>(luadio_delay_line_process_modulated));
+
+		register_source(L, gSource, "luadio.filters");
+	}
+
+	static filter_type to_filter_type(int32_t type)
+	{
+		if(type < filter_type_lowpass || type > filter_type_highshelf)
+			return filter_type_lowpass;
+		return static_cast<filter_type>(type);
+	}
+
+	void filters_module::luadio_biquad_set(biquad *pFilter, int32_t type, float frequency, float q, float gainDecibels, float sampleRate)
+	{
+		if(pFilter == nullptr || sampleRate <= 0.0f)
+			return;
+		pFilter->set(to_filter_type(type), frequency, q, gainDecibels, sampleRate);
+	}
+
+	void filters_module::luadio_biquad_process(biquad *pFilter, const float *pInput, float *pOutput, uint32_t frameCount, uint32_t channels)
+	{
+		if(pFilter == nullptr || pInput == nullptr || pOutput == nullptr)
+			return;
+		pFilter->process(pInput, pOutput, frameCount, channels);
+	}
+
+	void filters_module::luadio_biquad_process_cascade(biquad *pStages, uint32_t stageCount, const float *pInput, float *pOutput, uint32_t frameCount, uint32_t channels)
+	{
+		if(pStages == nullptr || pInput == nullptr || pOutput == nullptr)
+			return;
+		biquad::process_cascade(pStages, stageCount, pInput, pOutput, frameCount, channels);
+	}
+
+	void filters_module::luadio_svf_set(state_variable_filter *pFilter, int32_t type, float frequency, float q, float gainDecibels, float sampleRate)
+	{
+		if(pFilter == nullptr || sampleRate <= 0.0f)
+			return;
+		pFilter->set(to_filter_type(type), frequency, q, gainDecibels, sampleRate);
+	}
+
+	void filters_module::luadio_svf_process(state_variable_filter *pFilter, const float *pInput, float *pOutput, uint32_t frameCount, uint32_t channels)
+	{
+		if(pFilter == nullptr || pInput == nullptr || pOutput == nullptr)
+			return;
+		pFilter->process(pInput, pOutput, frameCount, channels);
+	}
+
+	void filters_module::luadio_one_pole_set(one_pole *pFilter, int32_t type, float frequency, float sampleRate)
+	{
+		if(pFilter == nullptr || sampleRate <= 0.0f)
+			return;
+		pFilter->set(to_filter_type(type), frequency, sampleRate);
+	}
+
+	void filters_module::luadio_one_pole_set_time(one_pole *pFilter, float seconds, float sampleRate)
+	{
+		if(pFilter == nullptr || sampleRate <= 0.0f)
+			return;
+		pFilter->set_time(seconds, sampleRate);
+	}
+
+	void filters_module::luadio_one_pole_process(one_pole *pFilter, const float *pInput, float *pOutput, uint32_t frameCount, uint32_t channels)
+	{
+		if(pFilter == nullptr || pInput == nullptr || pOutput == nullptr)
+			return;
+		pFilter->process(pInput, pOutput, frameCount, channels);
+	}
+
+	delay_line *filters_module::luadio_delay_line_create(uint32_t maxDelayFrames, uint32_t channels)
+	{
+		if(channels == 0)
+			return nullptr;
+		return new delay_line(maxDelayFrames, channels);
+	}
+
+	void filters_module::luadio_delay_line_destroy(delay_line *pDelay)
+	{
+		delete pDelay;
+	}
+
+	void filters_module::luadio_delay_line_reset(delay_line *pDelay)
+	{
+		if(pDelay == nullptr)
+			return;
+		pDelay->reset();
+	}
+
+	void filters_module::luadio_delay_line_process(delay_line *pDelay, const float *pInput, float *pOutput, uint32_t frameCount, float delayFrames, float feedback, int32_t interpolation)
+	{
+		if(pDelay == nullptr || pInput == nullptr || pOutput == nullptr)
+			return;
+		const interpolation_type type = static_cast<interpolation_type>(std::clamp<int32_t>(interpolation, interpolation_type_none, interpolation_type_cubic));
+		pDelay->process(pInput, pOutput, frameCount, delayFrames, feedback, type);
+	}
+
+	void filters_module::luadio_delay_line_process_modulated(delay_line *pDelay, const float *pInput, float *pOutput, const float *pDelayFrames, uint32_t frameCount, float feedback, int32_t interpolation)
+	{
+		if(pDelay == nullptr || pInput == nullptr || pOutput == nullptr || pDelayFrames == nullptr)
+			return;
+		const interpolation_type type = static_cast<interpolation_type>(std::clamp<int32_t>(interpolation, interpolation_type_none, interpolation_type_cubic));
+		pDelay->process_modulated(pInput, pOutput, pDelayFrames, frameCount, feedback, type);
+	}
+}
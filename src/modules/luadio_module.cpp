@@ -5,6 +5,12 @@ namespace luadio
 {
     luadio_log_func luadio_module::onLog = nullptr;
     luadio_queue_audio_func luadio_module::onQueueAudio = nullptr;
+    luadio_record_func luadio_module::onRecord = nullptr;
+    luadio_record_bus_func luadio_module::onRecordBus = nullptr;
+    luadio_get_frame_position_func luadio_module::onGetFramePosition = nullptr;
+    luadio_get_sample_rate_func luadio_module::onGetSampleRate = nullptr;
+    luadio_set_buffer_layout_func luadio_module::onSetBufferLayout = nullptr;
+    luadio_set_effect_bypass_func luadio_module::onSetEffectBypass = nullptr;
 
 	static std::string gSource = R"(local ffi = require ('ffi')
 local luadio = {}
@@ -21,6 +27,17 @@ end
 local luadio_print = luadio.findMethod('luadio_print', 'void (__cdecl*)(const char*)')
 local luadio_play = luadio.findMethod('luadio_play', 'void (__cdecl*)(void)')
 local luadio_play_from_file = luadio.findMethod('luadio_play_from_file', 'void (__cdecl*)(const char*)')
+local luadio_record = luadio.findMethod('luadio_record', 'void (__cdecl*)(double, double)')
+local luadio_record_bus = luadio.findMethod('luadio_record_bus', 'void (__cdecl*)(const char*, const void*, uint32_t, uint32_t)')
+local luadio_get_frame_position = luadio.findMethod('luadio_get_frame_position', 'double (__cdecl*)(void)')
+local luadio_get_sample_rate = luadio.findMethod('luadio_get_sample_rate', 'double (__cdecl*)(void)')
+local luadio_set_buffer_layout = luadio.findMethod('luadio_set_buffer_layout', 'void (__cdecl*)(int32_t)')
+local luadio_set_effect_bypass = luadio.findMethod('luadio_set_effect_bypass', 'void (__cdecl*)(int32_t)')
+
+-- layout Enum
+luadio.layout = {}
+luadio.layout.interleaved = 0
+luadio.layout.planar = 1
 
 local function c_string(str)
     if type(str) == 'number' then
@@ -51,11 +68,81 @@ function luadio.play(...)
     end
 end
 
+-- Transport frame the output has reached, the clock luadio.record works with
+-- It restarts at 0 with the transport when a script is started, and in sub-block mode
+-- luadio.transport.get_frame() runs ahead of it by the frames waiting to be played
+function luadio.get_frame_position()
+    return luadio_get_frame_position()
+end
+
+-- Rate the engine runs at, modules that take a sampleRate use it when none is given
+function luadio.get_sample_rate()
+    return luadio_get_sample_rate()
+end
+
+-- Records the output from startFrame up to (not including) stopFrame, both in transport frames
+-- Leaving out stopFrame records until the recording is stopped
+function luadio.record(startFrame, stopFrame)
+    luadio_record(startFrame, stopFrame or -1)
+end
+
+-- Records a named bus as its own stem next to the mix while a recording runs
+-- Call it from on_audio_read or on_audio_effect, the frames are placed at the frames of that callback
+-- and writing the same frames of a bus again mixes them, for instance from both callbacks
+-- data is laid out like the callback buffers: interleaved floats, or a 'float**' with one
+-- pointer per channel while the script uses luadio.layout.planar. frameCount is always in frames.
+-- The name is passed as is, so no string is allocated per block
+function luadio.record_bus(name, data, frameCount, channels)
+    luadio_record_bus(name, ffi.cast('const void*', data), frameCount, channels)
+end
+
+-- Chooses how on_audio_read and on_audio_effect receive their buffers, scripts start out interleaved
+-- With luadio.layout.planar data is a 'float**' with one 64 byte aligned buffer per channel and
+-- on_audio_read gets its length in frames instead of samples, so every channel can be processed in one straight loop
+function luadio.set_buffer_layout(layout)
+    luadio_set_buffer_layout(layout)
+end
+
+-- While bypassed on_audio_effect is not called and the output passes through untouched
+-- Whether a script defines on_audio_effect is checked once after on_start
+function luadio.set_effect_bypass(bypass)
+    luadio_set_effect_bypass(bypass and 1 or 0)
+end
+
+-- Runs fn_or_event at an exact frame of the transport, see luadio.transport.schedule
+function luadio.schedule(frame, fn_or_event)
+    return luadio.transport.schedule(frame, fn_or_event)
+end
+
 -- Override print function with our own
 print = luadio.print
 
+-- Submodules that luadio.<name> loads the first time it is used
+local submodules = {
+    fft = 'luadio.fft',
+    convolution = 'luadio.convolution',
+    dsp = 'luadio.dsp',
+    filters = 'luadio.filters',
+    voices = 'luadio.voices',
+    transport = 'luadio.transport',
+    sequencer = 'luadio.sequencer',
+    samples = 'luadio.samples',
+    resampler = 'luadio.resampler',
+    stream = 'luadio.stream',
+}
+
 -- Metatable to prevent overwriting
+-- Any other key is a typo or a missing function, so it raises an error instead of returning nil
 local mt = {
+    __index = function(table, key)
+        local name = submodules[key]
+        if name == nil then
+            error('luadio has no member named ' .. tostring(key), 2)
+        end
+        local module = require(name)
+        rawset(table, key, module)
+        return module
+    end,
     __newindex = function(table, key, value)
         error('Attempt to modify read-only method: ' .. key)
     end,
@@ -72,6 +159,12 @@ return luadio)";
         register_external_method(L, "luadio_print", reinterpret_cast<void*>(luadio_print));
         register_external_method(L, "luadio_play", reinterpret_cast<void*>(luadio_play));
         register_external_method(L, "luadio_play_from_file", reinterpret_cast<void*>(luadio_play_from_file));
+        register_external_method(L, "luadio_record", reinterpret_cast<void*>(luadio_record));
+        register_external_method(L, "luadio_record_bus", reinterpret_cast<void*>(luadio_record_bus));
+        register_external_method(L, "luadio_get_frame_position", reinterpret_cast<void*>(luadio_get_frame_position));
+        register_external_method(L, "luadio_get_sample_rate", reinterpret_cast<void*>(luadio_get_sample_rate));
+        register_external_method(L, "luadio_set_buffer_layout", reinterpret_cast<void*>(luadio_set_buffer_layout));
+        register_external_method(L, "luadio_set_effect_bypass", reinterpret_cast<void*>(luadio_set_effect_bypass));
 		
         register_source(L, gSource, "luadio");
 	}
@@ -127,4 +220,42 @@ return luadio)";
             onQueueAudio(filePath);
         }
     }
+
+    void luadio_module::luadio_record(double startFrame, double stopFrame)
+    {
+        if(onRecord)
+            onRecord(startFrame, stopFrame);
+    }
+
+    void luadio_module::luadio_record_bus(const char *name, const void *pFrames, uint32_t frameCount, uint32_t channels)
+    {
+        if(onRecordBus)
+            onRecordBus(name, pFrames, frameCount, channels);
+    }
+
+    double luadio_module::luadio_get_frame_position()
+    {
+        if(onGetFramePosition)
+            return onGetFramePosition();
+        return 0.0;
+    }
+
+    double luadio_module::luadio_get_sample_rate()
+    {
+        if(onGetSampleRate)
+            return onGetSampleRate();
+        return 44100.0;
+    }
+
+    void luadio_module::luadio_set_buffer_layout(int32_t layout)
+    {
+        if(onSetBufferLayout)
+            onSetBufferLayout(layout);
+    }
+
+    void luadio_module::luadio_set_effect_bypass(int32_t bypass)
+    {
+        if(onSetEffectBypass)
+            onSetEffectBypass(bypass != 0);
+    }
 }
\ No newline at end of file
@@ -0,0 +1,150 @@
+#include "resampler_module.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace luadio
+{
+	static std::string gSource = R"(local ffi = require('ffi')
+local luadio = require('luadio')
+local resampler = {}
+
+local luadio_resampler_create = luadio.findMethod('luadio_resampler_create', 'void* (__cdecl*)(uint32_t, int32_t, double, double)')
+local luadio_resampler_destroy = luadio.findMethod('luadio_resampler_destroy', 'void (__cdecl*)(void*)')
+local luadio_resampler_set_ratio = luadio.findMethod('luadio_resampler_set_ratio', 'void (__cdecl*)(void*, double)')
+local luadio_resampler_reset = luadio.findMethod('luadio_resampler_reset', 'void (__cdecl*)(void*)')
+local luadio_resampler_get_latency = luadio.findMethod('luadio_resampler_get_latency', 'uint32_t (__cdecl*)(void*)')
+local luadio_resampler_process = luadio.findMethod('luadio_resampler_process', 'uint32_t (__cdecl*)(void*, const float*, uint32_t, float*, uint32_t, uint32_t*)')
+local luadio_resampler_process_varying = luadio.findMethod('luadio_resampler_process_varying', 'uint32_t (__cdecl*)(void*, const float*, uint32_t, const float*, float*, uint32_t, uint32_t*)')
+
+-- quality Enum
+resampler.quality = {}
+resampler.quality.low = 0
+resampler.quality.medium = 1
+resampler.quality.high = 2
+
+local stream = {}
+stream.__index = stream
+
+-- ratio is input frames per output frame: sourceRate / targetRate, or the playback speed of a sample
+-- maxRatio is the largest ratio the stream will use, it sets the anti aliasing filter, defaults to ratio
+-- Buffers are interleaved with channels samples per frame, up to 16 channels
+function resampler.new(channels, quality, ratio, maxRatio)
+    ratio = ratio or 1.0
+    local handle = luadio_resampler_create(channels or 2, quality or resampler.quality.medium, ratio, maxRatio or ratio)
+    if handle == nil then
+        error('channels must be between 1 and 16 and ratio greater than 0')
+    end
+    local self = setmetatable({}, stream)
+    self.handle = ffi.gc(handle, luadio_resampler_destroy)
+    self.used = ffi.new('uint32_t[1]')
+    return self
+end
+
+function stream:set_ratio(ratio)
+    luadio_resampler_set_ratio(self.handle, ratio)
+end
+
+function stream:reset()
+    luadio_resampler_reset(self.handle)
+end
+
+-- Input frames the stream holds back, feed this many frames of silence at the end to flush it
+function stream:get_latency()
+    return luadio_resampler_get_latency(self.handle)
+end
+
+-- Consumes up to inputFrames and produces up to outputFrames, returns the frames written and the frames read
+-- Input that could not be used yet stays inside the stream
+function stream:process(input, inputFrames, output, outputFrames)
+    local written = luadio_resampler_process(self.handle, ffi.cast('const float*', input), inputFrames, ffi.cast('float*', output), outputFrames, self.used)
+    return written, self.used[0]
+end
+
+-- Same as process with one ratio per output frame in ratios, for pitch bends and vibrato
+function stream:process_varying(input, inputFrames, ratios, output, outputFrames)
+    local written = luadio_resampler_process_varying(self.handle, ffi.cast('const float*', input), inputFrames, ffi.cast('const float*', ratios), ffi.cast('float*', output), outputFrames, self.used)
+    return written, self.used[0]
+end
+
+return resampler)";
+
+	void resampler_module::load(lua_State *L)
+	{
+		register_external_method(L, "luadio_resampler_create", reinterpret_cast<void*>(luadio_resampler_create));
+		register_external_method(L, "luadio_resampler_destroy", reinterpret_cast<void*>(luadio_resampler_destroy));
+		register_external_method(L, "luadio_resampler_set_ratio", reinterpret_cast<void*>(luadio_resampler_set_ratio));
+		register_external_method(L, "luadio_resampler_reset", reinterpret_cast<void*>(luadio_resampler_reset));
+		register_external_method(L, "luadio_resampler_get_latency", reinterpret_cast<void*>(luadio_resampler_get_latency));
+		register_external_method(L, "luadio_resampler_process", reinterpret_cast<void*>(luadio_resampler_process));
+		register_external_method(L, "luadio_resampler_process_varying", reinterpret_cast<void*>(luadio_resampler_process_varying));
+
+		register_source(L, gSource, "luadio.resampler");
+	}
+
+	void *resampler_module::luadio_resampler_create(uint32_t channels, int32_t quality, double ratio, double maxRatio)
+	{
+		try
+		{
+			const int32_t value = std::clamp<int32_t>(quality, resampler_quality_low, resampler_quality_high);
+			return new polyphase_resampler(channels, static_cast<resampler_quality>(value), ratio, maxRatio);
+		}
+		catch(const std::invalid_argument &)
+		{
+			return nullptr;
+		}
+	}
+
+	void resampler_module::luadio_resampler_destroy(void *pResampler)
+	{
+		delete reinterpret_cast<polyphase_resampler*>(pResampler);
+	}
+
+	void resampler_module::luadio_resampler_set_ratio(void *pResampler, double ratio)
+	{
+		if(pResampler == nullptr)
+			return;
+		reinterpret_cast<polyphase_resampler*>(pResampler)->set_ratio(ratio);
+	}
+
+	void resampler_module::luadio_resampler_reset(void *pResampler)
+	{
+		if(pResampler == nullptr)
+			return;
+		reinterpret_cast<polyphase_resampler*>(pResampler)->reset();
+	}
+
+	uint32_t resampler_module::luadio_resampler_get_latency(void *pResampler)
+	{
+		if(pResampler == nullptr)
+			return 0;
+		return reinterpret_cast<polyphase_resampler*>(pResampler)->get_latency();
+	}
+
+	uint32_t resampler_module::luadio_resampler_process(void *pResampler, const float *pInput, uint32_t inputFrames, float *pOutput, uint32_t outputFrames, uint32_t *pInputUsed)
+	{
+		uint32_t used = 0;
+		uint32_t written = 0;
+
+		if(pResampler != nullptr && pInput != nullptr && pOutput != nullptr)
+			reinterpret_cast<polyphase_resampler*>(pResampler)->process(pInput, inputFrames, pOutput, outputFrames, used, written);
+
+		if(pInputUsed != nullptr)
+			*pInputUsed = used;
+
+		return written;
+	}
+
+	uint32_t resampler_module::luadio_resampler_process_varying(void *pResampler, const float *pInput, uint32_t inputFrames, const float *pRatios, float *pOutput, uint32_t outputFrames, uint32_t *pInputUsed)
+	{
+		uint32_t used = 0;
+		uint32_t written = 0;
+
+		if(pResampler != nullptr && pInput != nullptr && pRatios != nullptr && pOutput != nullptr)
+			reinterpret_cast<polyphase_resampler*>(pResampler)->process_varying(pInput, inputFrames, pRatios, pOutput, outputFrames, used, written);
+
+		if(pInputUsed != nullptr)
+			*pInputUsed = used;
+
+		return written;
+	}
+}
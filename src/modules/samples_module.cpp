@@ -0,0 +1,146 @@
+#include "samples_module.hpp"
+#include <cstddef>
+#include <cmath>
+
+namespace luadio
+{
+	sample_bank *samples_module::pBank = nullptr;
+	sample_player *samples_module::pPlayer = nullptr;
+
+	// The cdef below has to match this layout
+	static_assert(sizeof(std::atomic<int32_t>) == sizeof(int32_t));
+	static_assert(offsetof(sample_data, status) == sizeof(float*) + sizeof(uint64_t) + 2 * sizeof(uint32_t));
+	static_assert(offsetof(sample_data, id) == offsetof(sample_data, status) + sizeof(int32_t));
+
+	static std::string gSource = R"(local ffi = require('ffi')
+local luadio = require('luadio')
+local samples = {}
+
+ffi.cdef[[
+typedef struct { float *pFrames; uint64_t frameCount; uint32_t channels; uint32_t sampleRate; int32_t status; uint32_t id; } luadio_sample;
+]]
+
+local luadio_samples_load = luadio.findMethod('luadio_samples_load', 'luadio_sample* (__cdecl*)(const char*, uint32_t)')
+local luadio_samples_get_status = luadio.findMethod('luadio_samples_get_status', 'int32_t (__cdecl*)(luadio_sample*)')
+local luadio_samples_get_pending_count = luadio.findMethod('luadio_samples_get_pending_count', 'uint32_t (__cdecl*)(void)')
+local luadio_samples_trigger = luadio.findMethod('luadio_samples_trigger', 'int32_t (__cdecl*)(luadio_sample*, float, float, double)')
+local luadio_samples_stop_all = luadio.findMethod('luadio_samples_stop_all', 'void (__cdecl*)(void)')
+local luadio_samples_get_active_count = luadio.findMethod('luadio_samples_get_active_count', 'uint32_t (__cdecl*)(void)')
+
+-- status Enum
+samples.status = {}
+samples.status.loading = 0
+samples.status.ready = 1
+samples.status.failed = 2
+
+local sample = {}
+sample.__index = sample
+
+-- Check is_ready before touching the other fields, after that they never change
+-- pFrames holds frameCount interleaved frames of channels samples, the memory belongs to the bank
+function sample:get_status()
+    return luadio_samples_get_status(self)
+end
+
+function sample:is_ready()
+    return luadio_samples_get_status(self) == samples.status.ready
+end
+
+function sample:failed()
+    return luadio_samples_get_status(self) == samples.status.failed
+end
+
+function sample:get_duration()
+    return tonumber(self.frameCount) / self.sampleRate
+end
+
+ffi.metatype('luadio_sample', sample)
+
+-- Starts loading a file converted to sampleRate, the engine rate if left out, and returns at once
+-- Loading the same path again returns the same sample, safe to call from the audio callbacks
+function samples.load(filePath, sampleRate)
+    local handle = luadio_samples_load(filePath, sampleRate or luadio.get_sample_rate())
+    if handle == nil then
+        error('failed to queue ' .. tostring(filePath))
+    end
+    return handle
+end
+
+function samples.get_pending_count()
+    return luadio_samples_get_pending_count()
+end
+
+-- Plays a sample once on the native voice pool, mixed into the output after on_audio_read
+-- frame is a luadio.transport frame, leave it out to start at the beginning of the next block
+-- Returns false when too many triggers are waiting, a sample that is still loading at its frame is skipped
+function samples.trigger(sample, gain, pan, frame)
+    return luadio_samples_trigger(sample, gain or 1.0, pan or 0.0, frame or 0) ~= 0
+end
+
+-- Stops every sample voice and drops triggers that have not started yet
+function samples.stop_all()
+    luadio_samples_stop_all()
+end
+
+function samples.get_active_count()
+    return luadio_samples_get_active_count()
+end
+
+return samples)";
+
+	void samples_module::load(lua_State *L)
+	{
+		register_external_method(L, "luadio_samples_load", reinterpret_cast<void*>(luadio_samples_load));
+		register_external_method(L, "luadio_samples_get_status", reinterpret_cast<void*>(luadio_samples_get_status));
+		register_external_method(L, "luadio_samples_get_pending_count", reinterpret_cast<void*>(luadio_samples_get_pending_count));
+		register_external_method(L, "luadio_samples_trigger", reinterpret_cast<void*>(luadio_samples_trigger));
+		register_external_method(L, "luadio_samples_stop_all", reinterpret_cast<void*>(luadio_samples_stop_all));
+		register_external_method(L, "luadio_samples_get_active_count", reinterpret_cast<void*>(luadio_samples_get_active_count));
+
+		register_source(L, gSource, "luadio.samples");
+	}
+
+	sample_data *samples_module::luadio_samples_load(const char *filePath, uint32_t sampleRate)
+	{
+		if(pBank == nullptr || filePath == nullptr || sampleRate == 0)
+			return nullptr;
+		return pBank->load(filePath, sampleRate);
+	}
+
+	int32_t samples_module::luadio_samples_get_status(sample_data *pSample)
+	{
+		if(pSample == nullptr)
+			return sample_status_failed;
+		// Acquire pairs with the loader, the fields read after this call are complete
+		return pSample->status.load(std::memory_order_acquire);
+	}
+
+	uint32_t samples_module::luadio_samples_get_pending_count()
+	{
+		if(pBank == nullptr)
+			return 0;
+		return pBank->get_pending_count();
+	}
+
+	int32_t samples_module::luadio_samples_trigger(sample_data *pSample, float gain, float pan, double frame)
+	{
+		if(pPlayer == nullptr || pSample == nullptr)
+			return 0;
+		const uint64_t startFrame = frame > 0.0 ? static_cast<uint64_t>(std::llround(frame)) : 0;
+		return pPlayer->trigger(pSample, startFrame, gain, pan) ? 1 : 0;
+	}
+
+	void samples_module::luadio_samples_stop_all()
+	{
+		if(pPlayer == nullptr)
+			return;
+		pPlayer->stop_all();
+	}
+
+	uint32_t samples_module::luadio_samples_get_active_count()
+	{
+		if(pPlayer == nullptr)
+			return 0;
+		return pPlayer->get_active_count();
+	}
+}
@@ -6,11 +6,12 @@ namespace luadio
 local luadio = require('luadio')
 local wavetable = require('wavetable')
 local oscillator = require('oscillator')
+local dsp = require('luadio.dsp')
 
 local table1 = wavetable.create_with_wave_type(wavetable.wavetype.sine, 1024)
 local table2 = wavetable.create_with_wave_type(wavetable.wavetype.sine, 1024)
-local osc1 = oscillator.new(oscillator.wavetype.sine, 440, 0.5, 44100)
-local osc2 = oscillator.new(oscillator.wavetype.sine, 440, 0.5, 44100)
+local osc1 = nil
+local osc2 = nil
 
 [Checkbox]
 bypass = false
@@ -30,9 +31,12 @@ gain = 0.1
 [KnobFloat(0.0, 1.0, 64)]
 masterGain = 1.0
 
---Runs after compilation
-function on_start()
-
+--Runs after compilation, with the format the engine was started with
+--subBlockSize is 0, or the fixed number of frames every on_audio_read gets. Scheduled events
+--then run before the sub-block that holds their frame and are told that frame.
+function on_start(sampleRate, channels, periodSize, subBlockSize)
+    osc1 = oscillator.new(oscillator.wavetype.sine, 440, 0.5, sampleRate)
+    osc2 = oscillator.new(oscillator.wavetype.sine, 440, 0.5, sampleRate)
 end
 
 --Runs when stop is clicked
@@ -60,9 +64,8 @@ function on_audio_read(data, length, channels)
         local sample = osc1:get_value()
         sample = osc2:get_modulated_value(lfoDepth * sample) * gain
 
-        pData[i] = sample
-        if channels == 2 then
-            pData[i + 1] = sample
+        for c = 0, channels - 1 do
+            pData[i + c] = sample
         end
     end
 end
@@ -78,9 +81,7 @@ function on_audio_effect(framesIn, frameCountIn, framesOut, frameCountOut, chann
     local countOut = pFrameCountOut[0]
     local totalSamples = countIn * channels
 
-    for i = 0, totalSamples-1 do
-        pFramesOut[i] = pFramesIn[i] * masterGain
-    end
+    dsp.gain(pFramesOut, pFramesIn, masterGain, totalSamples)
 
     pFrameCountIn[0] = countIn
     pFrameCountOut[0] = countOut
@@ -0,0 +1,406 @@
+#include "sequencer_module.hpp"
+#include "transport_module.hpp"
+#include <algorithm>
+
+namespace luadio
+{
+	// The cdef below has to match these layouts
+	static_assert(sizeof(note_event) == 4 * sizeof(uint32_t));
+	static_assert(sizeof(sequencer_step) == sizeof(float) * (6 + sequencer_step::maxParameters));
+
+	static std::string gSource = R"(local ffi = require('ffi')
+local luadio = require('luadio')
+local sequencer = {}
+
+ffi.cdef[[
+typedef struct { uint32_t offset; int32_t type; int32_t note; float value; } luadio_note_event;
+typedef struct { int32_t note; float velocity; float gate; float probability; uint32_t ratchets; uint32_t lockMask; float locks[8]; } luadio_sequencer_step;
+]]
+
+local luadio_sequencer_create = luadio.findMethod('luadio_sequencer_create', 'void* (__cdecl*)(uint32_t)')
+local luadio_sequencer_destroy = luadio.findMethod('luadio_sequencer_destroy', 'void (__cdecl*)(void*)')
+local luadio_sequencer_get_steps = luadio.findMethod('luadio_sequencer_get_steps', 'luadio_sequencer_step* (__cdecl*)(void*)')
+local luadio_sequencer_get_parameters = luadio.findMethod('luadio_sequencer_get_parameters', 'float* (__cdecl*)(void*)')
+local luadio_sequencer_get_defaults = luadio.findMethod('luadio_sequencer_get_defaults', 'float* (__cdecl*)(void*)')
+local luadio_sequencer_get_events = luadio.findMethod('luadio_sequencer_get_events', 'const luadio_note_event* (__cdecl*)(void*)')
+local luadio_sequencer_set_length = luadio.findMethod('luadio_sequencer_set_length', 'void (__cdecl*)(void*, uint32_t)')
+local luadio_sequencer_set_rate = luadio.findMethod('luadio_sequencer_set_rate', 'void (__cdecl*)(void*, double)')
+local luadio_sequencer_set_swing = luadio.findMethod('luadio_sequencer_set_swing', 'void (__cdecl*)(void*, double)')
+local luadio_sequencer_set_seed = luadio.findMethod('luadio_sequencer_set_seed', 'void (__cdecl*)(void*, uint32_t)')
+local luadio_sequencer_process = luadio.findMethod('luadio_sequencer_process', 'uint32_t (__cdecl*)(void*, uint32_t)')
+local luadio_sequencer_release_all = luadio.findMethod('luadio_sequencer_release_all', 'void (__cdecl*)(void*)')
+local luadio_arpeggiator_create = luadio.findMethod('luadio_arpeggiator_create', 'void* (__cdecl*)(void)')
+local luadio_arpeggiator_destroy = luadio.findMethod('luadio_arpeggiator_destroy', 'void (__cdecl*)(void*)')
+local luadio_arpeggiator_get_events = luadio.findMethod('luadio_arpeggiator_get_events', 'const luadio_note_event* (__cdecl*)(void*)')
+local luadio_arpeggiator_note_on = luadio.findMethod('luadio_arpeggiator_note_on', 'void (__cdecl*)(void*, int32_t, float)')
+local luadio_arpeggiator_note_off = luadio.findMethod('luadio_arpeggiator_note_off', 'void (__cdecl*)(void*, int32_t)')
+local luadio_arpeggiator_clear = luadio.findMethod('luadio_arpeggiator_clear', 'void (__cdecl*)(void*)')
+local luadio_arpeggiator_set_mode = luadio.findMethod('luadio_arpeggiator_set_mode', 'void (__cdecl*)(void*, int32_t)')
+local luadio_arpeggiator_set_octaves = luadio.findMethod('luadio_arpeggiator_set_octaves', 'void (__cdecl*)(void*, uint32_t)')
+local luadio_arpeggiator_set_gate = luadio.findMethod('luadio_arpeggiator_set_gate', 'void (__cdecl*)(void*, float)')
+local luadio_arpeggiator_set_rate = luadio.findMethod('luadio_arpeggiator_set_rate', 'void (__cdecl*)(void*, double)')
+local luadio_arpeggiator_set_swing = luadio.findMethod('luadio_arpeggiator_set_swing', 'void (__cdecl*)(void*, double)')
+local luadio_arpeggiator_process = luadio.findMethod('luadio_arpeggiator_process', 'uint32_t (__cdecl*)(void*, uint32_t)')
+local luadio_arpeggiator_release_all = luadio.findMethod('luadio_arpeggiator_release_all', 'void (__cdecl*)(void*)')
+
+-- event Enum
+sequencer.event = {}
+sequencer.event.note_off = 0
+sequencer.event.parameter = 1
+sequencer.event.note_on = 2
+
+-- mode Enum
+sequencer.mode = {}
+sequencer.mode.up = 0
+sequencer.mode.down = 1
+sequencer.mode.up_down = 2
+sequencer.mode.played = 3
+sequencer.mode.random = 4
+
+-- Patterns follow luadio.transport, call process once per on_audio_read with its frameCount
+-- process returns the events of the block and their count, sorted by frame offset:
+--   event.type is one of sequencer.event, event.offset the frame within the block
+--   note events carry the note in event.note and the velocity in event.value (0 for note offs)
+--   parameter events carry the parameter index in event.note and the new value in event.value
+-- Pass both results to luadio.voices pool:render_events to play them
+
+local pattern = {}
+pattern.__index = pattern
+
+-- Step sequencer of up to 64 steps, steps and parameters are indexed from 0
+-- self.steps[i] holds note (negative for a rest), velocity, gate, probability, ratchets and the locks
+-- self.parameters holds the current value of the 8 parameters, set by the locks of the playing step
+function sequencer.new(length)
+    local handle = luadio_sequencer_create(length or 16)
+    if handle == nil then
+        error('failed to create sequencer')
+    end
+    local self = setmetatable({}, pattern)
+    self.handle = ffi.gc(handle, luadio_sequencer_destroy)
+    self.steps = luadio_sequencer_get_steps(handle)
+    self.parameters = luadio_sequencer_get_parameters(handle)
+    self.defaults = luadio_sequencer_get_defaults(handle)
+    self.events = luadio_sequencer_get_events(handle)
+    self.eventCount = 0
+    return self
+end
+
+function pattern:set_step(index, note, velocity, gate, ratchets, probability)
+    local step = self.steps[index]
+    step.note = note or -1
+    step.velocity = velocity or 1.0
+    step.gate = gate or 0.5
+    step.ratchets = ratchets or 1
+    step.probability = probability or 1.0
+end
+
+function pattern:clear_step(index)
+    self.steps[index].note = -1
+end
+
+-- Holds parameter at value while the step plays
+function pattern:lock(index, parameter, value)
+    local step = self.steps[index]
+    step.locks[parameter] = value
+    step.lockMask = bit.bor(step.lockMask, bit.lshift(1, parameter))
+end
+
+function pattern:unlock(index, parameter)
+    local step = self.steps[index]
+    step.lockMask = bit.band(step.lockMask, bit.bnot(bit.lshift(1, parameter)))
+end
+
+-- Value of a parameter on steps that do not lock it
+function pattern:set_default(parameter, value)
+    self.defaults[parameter] = value
+end
+
+function pattern:set_length(length)
+    luadio_sequencer_set_length(self.handle, length)
+end
+
+-- Steps per beat, 4 plays sixteenth notes in 4/4
+function pattern:set_rate(stepsPerBeat)
+    luadio_sequencer_set_rate(self.handle, stepsPerBeat)
+end
+
+-- Fraction of a step every second step is delayed by, from 0 to 0.75
+function pattern:set_swing(swing)
+    luadio_sequencer_set_swing(self.handle, swing)
+end
+
+-- Picks a different sequence of random choices for steps with a probability below 1
+function pattern:set_seed(seed)
+    luadio_sequencer_set_seed(self.handle, seed)
+end
+
+function pattern:process(frameCount)
+    self.eventCount = luadio_sequencer_process(self.handle, frameCount)
+    return self.events, self.eventCount
+end
+
+-- Releases every sounding note at the start of the next block
+function pattern:stop()
+    luadio_sequencer_release_all(self.handle)
+end
+
+local arp = {}
+arp.__index = arp
+
+-- Arpeggiator over up to 16 held notes
+function sequencer.arpeggiator()
+    local handle = luadio_arpeggiator_create()
+    if handle == nil then
+        error('failed to create arpeggiator')
+    end
+    local self = setmetatable({}, arp)
+    self.handle = ffi.gc(handle, luadio_arpeggiator_destroy)
+    self.events = luadio_arpeggiator_get_events(handle)
+    self.eventCount = 0
+    return self
+end
+
+function arp:note_on(note, velocity)
+    luadio_arpeggiator_note_on(self.handle, note, velocity or 1.0)
+end
+
+function arp:note_off(note)
+    luadio_arpeggiator_note_off(self.handle, note)
+end
+
+function arp:clear()
+    luadio_arpeggiator_clear(self.handle)
+end
+
+function arp:set_mode(mode)
+    luadio_arpeggiator_set_mode(self.handle, mode)
+end
+
+-- Number of octaves the held notes are repeated over, from 1 to 4
+function arp:set_octaves(octaves)
+    luadio_arpeggiator_set_octaves(self.handle, octaves)
+end
+
+-- Fraction of a step each note is held
+function arp:set_gate(gate)
+    luadio_arpeggiator_set_gate(self.handle, gate)
+end
+
+function arp:set_rate(stepsPerBeat)
+    luadio_arpeggiator_set_rate(self.handle, stepsPerBeat)
+end
+
+function arp:set_swing(swing)
+    luadio_arpeggiator_set_swing(self.handle, swing)
+end
+
+function arp:process(frameCount)
+    self.eventCount = luadio_arpeggiator_process(self.handle, frameCount)
+    return self.events, self.eventCount
+end
+
+function arp:stop()
+    luadio_arpeggiator_release_all(self.handle)
+end
+
+return sequencer)";
+
+	void sequencer_module::load(lua_State *L)
+	{
+		register_external_method(L, "luadio_sequencer_create", reinterpret_cast<void*>(luadio_sequencer_create));
+		register_external_method(L, "luadio_sequencer_destroy", reinterpret_cast<void*>(luadio_sequencer_destroy));
+		register_external_method(L, "luadio_sequencer_get_steps", reinterpret_cast<void*>(luadio_sequencer_get_steps));
+		register_external_method(L, "luadio_sequencer_get_parameters", reinterpret_cast<void*>(luadio_sequencer_get_parameters));
+		register_external_method(L, "luadio_sequencer_get_defaults", reinterpret_cast<void*>(luadio_sequencer_get_defaults));
+		register_external_method(L, "luadio_sequencer_get_events", reinterpret_cast<void*>(luadio_sequencer_get_events));
+		register_external_method(L, "luadio_sequencer_set_length", reinterpret_cast<void*>(luadio_sequencer_set_length));
+		register_external_method(L, "luadio_sequencer_set_rate", reinterpret_cast<void*>(luadio_sequencer_set_rate));
+		register_external_method(L, "luadio_sequencer_set_swing", reinterpret_cast<void*>(luadio_sequencer_set_swing));
+		register_external_method(L, "luadio_sequencer_set_seed", reinterpret_cast<void*>(luadio_sequencer_set_seed));
+		register_external_method(L, "luadio_sequencer_process", reinterpret_cast<void*>(luadio_sequencer_process));
+		register_external_method(L, "luadio_sequencer_release_all", reinterpret_cast<void*>(luadio_sequencer_release_all));
+		register_external_method(L, "luadio_arpeggiator_create", reinterpret_cast<void*>(luadio_arpeggiator_create));
+		register_external_method(L, "luadio_arpeggiator_destroy", reinterpret_cast<void*>(luadio_arpeggiator_destroy));
+		register_external_method(L, "luadio_arpeggiator_get_events", reinterpret_cast<void*>(luadio_arpeggiator_get_events));
+		register_external_method(L, "luadio_arpeggiator_note_on", reinterpret_cast<void*>(luadio_arpeggiator_note_on));
+		register_external_method(L, "luadio_arpeggiator_note_off", reinterpret_cast<void*>(luadio_arpeggiator_note_off));
+		register_external_method(L, "luadio_arpeggiator_clear", reinterpret_cast<void*>(luadio_arpeggiator_clear));
+		register_external_method(L, "luadio_arpeggiator_set_mode", reinterpret_cast<void*>(luadio_arpeggiator_set_mode));
+		register_external_method(L, "luadio_arpeggiator_set_octaves", reinterpret_cast<void*>(luadio_arpeggiator_set_octaves));
+		register_external_method(L, "luadio_arpeggiator_set_gate", reinterpret_cast<void*>(luadio_arpeggiator_set_gate));
+		register_external_method(L, "luadio_arpeggiator_set_rate", reinterpret_cast<void*>(luadio_arpeggiator_set_rate));
+		register_external_method(L, "luadio_arpeggiator_set_swing", reinterpret_cast<void*>(luadio_arpeggiator_set_swing));
+		register_external_method(L, "luadio_arpeggiator_process", reinterpret_cast<void*>(luadio_arpeggiator_process));
+		register_external_method(L, "luadio_arpeggiator_release_all", reinterpret_cast<void*>(luadio_arpeggiator_release_all));
+
+		register_source(L, gSource, "luadio.sequencer");
+	}
+
+	void *sequencer_module::luadio_sequencer_create(uint32_t length)
+	{
+		return new step_sequencer(length);
+	}
+
+	void sequencer_module::luadio_sequencer_destroy(void *pSequencer)
+	{
+		delete reinterpret_cast<step_sequencer*>(pSequencer);
+	}
+
+	sequencer_step *sequencer_module::luadio_sequencer_get_steps(void *pSequencer)
+	{
+		if(pSequencer == nullptr)
+			return nullptr;
+		return reinterpret_cast<step_sequencer*>(pSequencer)->get_steps();
+	}
+
+	float *sequencer_module::luadio_sequencer_get_parameters(void *pSequencer)
+	{
+		if(pSequencer == nullptr)
+			return nullptr;
+		return reinterpret_cast<step_sequencer*>(pSequencer)->get_parameters();
+	}
+
+	float *sequencer_module::luadio_sequencer_get_defaults(void *pSequencer)
+	{
+		if(pSequencer == nullptr)
+			return nullptr;
+		return reinterpret_cast<step_sequencer*>(pSequencer)->get_defaults();
+	}
+
+	const note_event *sequencer_module::luadio_sequencer_get_events(void *pSequencer)
+	{
+		if(pSequencer == nullptr)
+			return nullptr;
+		return reinterpret_cast<step_sequencer*>(pSequencer)->get_events();
+	}
+
+	void sequencer_module::luadio_sequencer_set_length(void *pSequencer, uint32_t length)
+	{
+		if(pSequencer == nullptr)
+			return;
+		reinterpret_cast<step_sequencer*>(pSequencer)->set_length(length);
+	}
+
+	void sequencer_module::luadio_sequencer_set_rate(void *pSequencer, double stepsPerBeat)
+	{
+		if(pSequencer == nullptr)
+			return;
+		reinterpret_cast<step_sequencer*>(pSequencer)->set_rate(stepsPerBeat);
+	}
+
+	void sequencer_module::luadio_sequencer_set_swing(void *pSequencer, double swing)
+	{
+		if(pSequencer == nullptr)
+			return;
+		reinterpret_cast<step_sequencer*>(pSequencer)->set_swing(swing);
+	}
+
+	void sequencer_module::luadio_sequencer_set_seed(void *pSequencer, uint32_t seed)
+	{
+		if(pSequencer == nullptr)
+			return;
+		reinterpret_cast<step_sequencer*>(pSequencer)->set_seed(seed);
+	}
+
+	uint32_t sequencer_module::luadio_sequencer_process(void *pSequencer, uint32_t frameCount)
+	{
+		if(pSequencer == nullptr || transport_module::pTransport == nullptr)
+			return 0;
+		return reinterpret_cast<step_sequencer*>(pSequencer)->process(*transport_module::pTransport->get_state(), frameCount);
+	}
+
+	void sequencer_module::luadio_sequencer_release_all(void *pSequencer)
+	{
+		if(pSequencer == nullptr)
+			return;
+		reinterpret_cast<step_sequencer*>(pSequencer)->release_all();
+	}
+
+	void *sequencer_module::luadio_arpeggiator_create()
+	{
+		return new arpeggiator();
+	}
+
+	void sequencer_module::luadio_arpeggiator_destroy(void *pArpeggiator)
+	{
+		delete reinterpret_cast<arpeggiator*>(pArpeggiator);
+	}
+
+	const note_event *sequencer_module::luadio_arpeggiator_get_events(void *pArpeggiator)
+	{
+		if(pArpeggiator == nullptr)
+			return nullptr;
+		return reinterpret_cast<arpeggiator*>(pArpeggiator)->get_events();
+	}
+
+	void sequencer_module::luadio_arpeggiator_note_on(void *pArpeggiator, int32_t note, float velocity)
+	{
+		if(pArpeggiator == nullptr)
+			return;
+		reinterpret_cast<arpeggiator*>(pArpeggiator)->note_on(note, velocity);
+	}
+
+	void sequencer_module::luadio_arpeggiator_note_off(void *pArpeggiator, int32_t note)
+	{
+		if(pArpeggiator == nullptr)
+			return;
+		reinterpret_cast<arpeggiator*>(pArpeggiator)->note_off(note);
+	}
+
+	void sequencer_module::luadio_arpeggiator_clear(void *pArpeggiator)
+	{
+		if(pArpeggiator == nullptr)
+			return;
+		reinterpret_cast<arpeggiator*>(pArpeggiator)->clear();
+	}
+
+	void sequencer_module::luadio_arpeggiator_set_mode(void *pArpeggiator, int32_t mode)
+	{
+		if(pArpeggiator == nullptr)
+			return;
+		const int32_t value = std::clamp<int32_t>(mode, arp_mode_up, arp_mode_random);
+		reinterpret_cast<arpeggiator*>(pArpeggiator)->set_mode(static_cast<arp_mode>(value));
+	}
+
+	void sequencer_module::luadio_arpeggiator_set_octaves(void *pArpeggiator, uint32_t octaves)
+	{
+		if(pArpeggiator == nullptr)
+			return;
+		reinterpret_cast<arpeggiator*>(pArpeggiator)->set_octaves(octaves);
+	}
+
+	void sequencer_module::luadio_arpeggiator_set_gate(void *pArpeggiator, float gate)
+	{
+		if(pArpeggiator == nullptr)
+			return;
+		reinterpret_cast<arpeggiator*>(pArpeggiator)->set_gate(gate);
+	}
+
+	void sequencer_module::luadio_arpeggiator_set_rate(void *pArpeggiator, double stepsPerBeat)
+	{
+		if(pArpeggiator == nullptr)
+			return;
+		reinterpret_cast<arpeggiator*>(pArpeggiator)->set_rate(stepsPerBeat);
+	}
+
+	void sequencer_module::luadio_arpeggiator_set_swing(void *pArpeggiator, double swing)
+	{
+		if(pArpeggiator == nullptr)
+			return;
+		reinterpret_cast<arpeggiator*>(pArpeggiator)->set_swing(swing);
+	}
+
+	uint32_t sequencer_module::luadio_arpeggiator_process(void *pArpeggiator, uint32_t frameCount)
+	{
+		if(pArpeggiator == nullptr || transport_module::pTransport == nullptr)
+			return 0;
+		return reinterpret_cast<arpeggiator*>(pArpeggiator)->process(*transport_module::pTransport->get_state(), frameCount);
+	}
+
+	void sequencer_module::luadio_arpeggiator_release_all(void *pArpeggiator)
+	{
+		if(pArpeggiator == nullptr)
+			return;
+		reinterpret_cast<arpeggiator*>(pArpeggiator)->release_all();
+	}
+}
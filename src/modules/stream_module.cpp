@@ -0,0 +1,183 @@
+#include "stream_module.hpp"
+#include "../system/object_reaper.hpp"
+#include <cmath>
+
+namespace luadio
+{
+	static std::string gSource = R"(local ffi = require('ffi')
+local luadio = require('luadio')
+local stream = {}
+
+local luadio_stream_open = luadio.findMethod('luadio_stream_open', 'void* (__cdecl*)(const char*, uint32_t)')
+local luadio_stream_close = luadio.findMethod('luadio_stream_close', 'void (__cdecl*)(void*)')
+local luadio_stream_read = luadio.findMethod('luadio_stream_read', 'void (__cdecl*)(void*, float*, uint32_t, uint32_t)')
+local luadio_stream_seek = luadio.findMethod('luadio_stream_seek', 'void (__cdecl*)(void*, double)')
+local luadio_stream_set_loop = luadio.findMethod('luadio_stream_set_loop', 'void (__cdecl*)(void*, int32_t)')
+local luadio_stream_get_status = luadio.findMethod('luadio_stream_get_status', 'int32_t (__cdecl*)(void*)')
+local luadio_stream_get_position = luadio.findMethod('luadio_stream_get_position', 'double (__cdecl*)(void*)')
+local luadio_stream_get_length = luadio.findMethod('luadio_stream_get_length', 'double (__cdecl*)(void*)')
+local luadio_stream_get_channels = luadio.findMethod('luadio_stream_get_channels', 'uint32_t (__cdecl*)(void*)')
+local luadio_stream_get_underruns = luadio.findMethod('luadio_stream_get_underruns', 'double (__cdecl*)(void*)')
+local luadio_stream_get_underrun_frames = luadio.findMethod('luadio_stream_get_underrun_frames', 'double (__cdecl*)(void*)')
+
+-- status Enum
+stream.status = {}
+stream.status.buffering = 0
+stream.status.playing = 1
+stream.status.ended = 2
+stream.status.failed = 3
+
+local player = {}
+player.__index = player
+
+-- Opens a file for streaming at sampleRate, the engine rate if left out, decoding starts on its own thread right away
+-- Memory use is a few chunks of audio no matter how long the file is
+function stream.open(filePath, sampleRate)
+    local handle = luadio_stream_open(filePath, sampleRate or luadio.get_sample_rate())
+    if handle == nil then
+        error('failed to open ' .. tostring(filePath))
+    end
+    local self = setmetatable({}, player)
+    self.handle = ffi.gc(handle, luadio_stream_close)
+    return self
+end
+
+-- Overwrites output with the next frameCount frames, call from on_audio_read
+-- Mono files play on every channel, silence is written while buffering or after the end
+function player:read(output, frameCount, channels)
+    luadio_stream_read(self.handle, ffi.cast('float*', output), frameCount, channels or 2)
+end
+
+-- Playback continues exactly at frame once it has been prefetched, status is buffering until then
+function player:seek(frame)
+    luadio_stream_seek(self.handle, frame)
+end
+
+function player:set_loop(loop)
+    luadio_stream_set_loop(self.handle, loop and 1 or 0)
+end
+
+function player:get_status()
+    return luadio_stream_get_status(self.handle)
+end
+
+function player:is_playing()
+    return luadio_stream_get_status(self.handle) == stream.status.playing
+end
+
+function player:get_position()
+    return luadio_stream_get_position(self.handle)
+end
+
+-- Length in frames, 0 while opening
+function player:get_length()
+    return luadio_stream_get_length(self.handle)
+end
+
+function player:get_channels()
+    return luadio_stream_get_channels(self.handle)
+end
+
+-- Number of reads that found no buffered audio, and the frames of silence they produced
+function player:get_underruns()
+    return luadio_stream_get_underruns(self.handle), luadio_stream_get_underrun_frames(self.handle)
+end
+
+return stream)";
+
+	void stream_module::load(lua_State *L)
+	{
+		// Start the reaper here, the first stream may be closed on the audio thread
+		object_reaper::get();
+
+		register_external_method(L, "luadio_stream_open", reinterpret_cast<void*>(luadio_stream_open));
+		register_external_method(L, "luadio_stream_close", reinterpret_cast<void*>(luadio_stream_close));
+		register_external_method(L, "luadio_stream_read", reinterpret_cast<void*>(luadio_stream_read));
+		register_external_method(L, "luadio_stream_seek", reinterpret_cast<void*>(luadio_stream_seek));
+		register_external_method(L, "luadio_stream_set_loop", reinterpret_cast<void*>(luadio_stream_set_loop));
+		register_external_method(L, "luadio_stream_get_status", reinterpret_cast<void*>(luadio_stream_get_status));
+		register_external_method(L, "luadio_stream_get_position", reinterpret_cast<void*>(luadio_stream_get_position));
+		register_external_method(L, "luadio_stream_get_length", reinterpret_cast<void*>(luadio_stream_get_length));
+		register_external_method(L, "luadio_stream_get_channels", reinterpret_cast<void*>(luadio_stream_get_channels));
+		register_external_method(L, "luadio_stream_get_underruns", reinterpret_cast<void*>(luadio_stream_get_underruns));
+		register_external_method(L, "luadio_stream_get_underrun_frames", reinterpret_cast<void*>(luadio_stream_get_underrun_frames));
+
+		register_source(L, gSource, "luadio.stream");
+	}
+
+	void *stream_module::luadio_stream_open(const char *filePath, uint32_t sampleRate)
+	{
+		if(filePath == nullptr || sampleRate == 0)
+			return nullptr;
+		return new file_stream(filePath, sampleRate);
+	}
+
+	void stream_module::luadio_stream_close(void *pStream)
+	{
+		// The destructor joins the I/O thread, the collector may run on the audio thread
+		object_reaper::get().dispose(reinterpret_cast<file_stream*>(pStream));
+	}
+
+	void stream_module::luadio_stream_read(void *pStream, float *pOutput, uint32_t frameCount, uint32_t channels)
+	{
+		if(pStream == nullptr || pOutput == nullptr || channels == 0)
+			return;
+		reinterpret_cast<file_stream*>(pStream)->read(pOutput, frameCount, channels);
+	}
+
+	void stream_module::luadio_stream_seek(void *pStream, double frame)
+	{
+		if(pStream == nullptr)
+			return;
+		reinterpret_cast<file_stream*>(pStream)->seek(frame > 0.0 ? static_cast<uint64_t>(std::llround(frame)) : 0);
+	}
+
+	void stream_module::luadio_stream_set_loop(void *pStream, int32_t loop)
+	{
+		if(pStream == nullptr)
+			return;
+		reinterpret_cast<file_stream*>(pStream)->set_loop(loop != 0);
+	}
+
+	int32_t stream_module::luadio_stream_get_status(void *pStream)
+	{
+		if(pStream == nullptr)
+			return stream_status_failed;
+		return reinterpret_cast<file_stream*>(pStream)->get_status();
+	}
+
+	double stream_module::luadio_stream_get_position(void *pStream)
+	{
+		if(pStream == nullptr)
+			return 0.0;
+		return static_cast<double>(reinterpret_cast<file_stream*>(pStream)->get_position());
+	}
+
+	double stream_module::luadio_stream_get_length(void *pStream)
+	{
+		if(pStream == nullptr)
+			return 0.0;
+		return static_cast<double>(reinterpret_cast<file_stream*>(pStream)->get_length());
+	}
+
+	uint32_t stream_module::luadio_stream_get_channels(void *pStream)
+	{
+		if(pStream == nullptr)
+			return 0;
+		return reinterpret_cast<file_stream*>(pStream)->get_channels();
+	}
+
+	double stream_module::luadio_stream_get_underruns(void *pStream)
+	{
+		if(pStream == nullptr)
+			return 0.0;
+		return static_cast<double>(reinterpret_cast<file_stream*>(pStream)->get_underruns());
+	}
+
+	double stream_module::luadio_stream_get_underrun_frames(void *pStream)
+	{
+		if(pStream == nullptr)
+			return 0.0;
+		return static_cast<double>(reinterpret_cast<file_stream*>(pStream)->get_underrun_frames());
+	}
+}
@@ -0,0 +1,201 @@
+#include "transport_module.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace luadio
+{
+	transport *transport_module::pTransport = nullptr;
+	event_scheduler *transport_module::pScheduler = nullptr;
+
+	static std::string gSource = R"(local ffi = require('ffi')
+local luadio = require('luadio')
+local transport = {}
+
+ffi.cdef[[
+typedef struct { double frame; double beat; double tempo; double sampleRate; uint32_t beatsPerBar; uint32_t reserved; } luadio_transport_state;
+]]
+
+local luadio_transport_get_state = luadio.findMethod('luadio_transport_get_state', 'const luadio_transport_state* (__cdecl*)(void)')
+local luadio_transport_set_tempo = luadio.findMethod('luadio_transport_set_tempo', 'void (__cdecl*)(double)')
+local luadio_transport_set_beats_per_bar = luadio.findMethod('luadio_transport_set_beats_per_bar', 'void (__cdecl*)(uint32_t)')
+local luadio_transport_get_frame_of_beat = luadio.findMethod('luadio_transport_get_frame_of_beat', 'double (__cdecl*)(double)')
+local luadio_scheduler_schedule = luadio.findMethod('luadio_scheduler_schedule', 'int32_t (__cdecl*)(double, int32_t)')
+local luadio_scheduler_pop_due = luadio.findMethod('luadio_scheduler_pop_due', 'int32_t (__cdecl*)(double, double*)')
+local luadio_scheduler_get_count = luadio.findMethod('luadio_scheduler_get_count', 'uint32_t (__cdecl*)(void)')
+local luadio_scheduler_clear = luadio.findMethod('luadio_scheduler_clear', 'void (__cdecl*)(void)')
+
+-- The clock starts at frame 0 when the script starts and only moves while audio is rendered
+-- on_audio_read is split at scheduled frames, so during a callback state.frame is the frame of its first sample
+local state = luadio_transport_get_state()
+local pending = {}
+local eventFrame = ffi.new('double[1]')
+local nextId = 0
+
+function transport.get_frame()
+    return state.frame
+end
+
+function transport.get_beat()
+    return state.beat
+end
+
+-- Bars and beats within the bar count from 0
+function transport.get_bar()
+    return math.floor(state.beat / state.beatsPerBar)
+end
+
+function transport.get_beat_in_bar()
+    return state.beat % state.beatsPerBar
+end
+
+function transport.get_tempo()
+    return state.tempo
+end
+
+function transport.get_sample_rate()
+    return state.sampleRate
+end
+
+-- The block being rendered keeps its tempo, the new one applies from the next block on
+-- and get_tempo reports it from then, schedule_beat already converts with it
+function transport.set_tempo(beatsPerMinute)
+    luadio_transport_set_tempo(beatsPerMinute)
+end
+
+function transport.set_beats_per_bar(beatsPerBar)
+    luadio_transport_set_beats_per_bar(beatsPerBar)
+end
+
+-- Calls item(frame) when the transport reaches frame, or on_event(item, frame) if item is not a function
+-- Events in the past run before the next block. Returns an id for cancel, or nil when the queue is full
+-- With sub-blocks the events of a sub-block all run before it, frame - transport.get_frame() is then
+-- the offset into the coming on_audio_read at which the event is due
+function transport.schedule(frame, item)
+    nextId = (nextId + 1) % 2147483647
+    if luadio_scheduler_schedule(frame, nextId) == 0 then
+        return nil
+    end
+    pending[nextId] = item
+    return nextId
+end
+
+-- Same as schedule with a position in beats, converted with the current tempo
+function transport.schedule_beat(beat, item)
+    return transport.schedule(luadio_transport_get_frame_of_beat(beat), item)
+end
+
+function transport.cancel(id)
+    pending[id] = nil
+end
+
+function transport.get_pending_count()
+    return luadio_scheduler_get_count()
+end
+
+-- Called by the host with the last frame that is due and the first frame about to be rendered,
+-- not meant to be called by scripts. Events get the frame they were scheduled for, or startFrame if it passed.
+function transport.dispatch(frame, startFrame)
+    while true do
+        local id = luadio_scheduler_pop_due(frame, eventFrame)
+        if id < 0 then
+            break
+        end
+        local item = pending[id]
+        local due = math.max(eventFrame[0], startFrame)
+        pending[id] = nil
+        if type(item) == 'function' then
+            item(due)
+        elseif item ~= nil and type(on_event) == 'function' then
+            on_event(item, due)
+        end
+    end
+end
+
+-- Called by the host before a script starts
+function transport.reset()
+    luadio_scheduler_clear()
+    pending = {}
+end
+
+return transport)";
+
+	void transport_module::load(lua_State *L)
+	{
+		register_external_method(L, "luadio_transport_get_state", reinterpret_cast<void*>(luadio_transport_get_state));
+		register_external_method(L, "luadio_transport_set_tempo", reinterpret_cast<void*>(luadio_transport_set_tempo));
+		register_external_method(L, "luadio_transport_set_beats_per_bar", reinterpret_cast<void*>(luadio_transport_set_beats_per_bar));
+		register_external_method(L, "luadio_transport_get_frame_of_beat", reinterpret_cast<void*>(luadio_transport_get_frame_of_beat));
+		register_external_method(L, "luadio_scheduler_schedule", reinterpret_cast<void*>(luadio_scheduler_schedule));
+		register_external_method(L, "luadio_scheduler_pop_due", reinterpret_cast<void*>(luadio_scheduler_pop_due));
+		register_external_method(L, "luadio_scheduler_get_count", reinterpret_cast<void*>(luadio_scheduler_get_count));
+		register_external_method(L, "luadio_scheduler_clear", reinterpret_cast<void*>(luadio_scheduler_clear));
+
+		register_source(L, gSource, "luadio.transport");
+	}
+
+	static uint64_t to_frame(double frame)
+	{
+		return frame > 0.0 ? static_cast<uint64_t>(std::llround(frame)) : 0;
+	}
+
+	const transport_state *transport_module::luadio_transport_get_state()
+	{
+		if(pTransport == nullptr)
+			return nullptr;
+		return pTransport->get_state();
+	}
+
+	void transport_module::luadio_transport_set_tempo(double beatsPerMinute)
+	{
+		if(pTransport == nullptr)
+			return;
+		pTransport->set_tempo(beatsPerMinute);
+	}
+
+	void transport_module::luadio_transport_set_beats_per_bar(uint32_t beatsPerBar)
+	{
+		if(pTransport == nullptr)
+			return;
+		pTransport->set_beats_per_bar(beatsPerBar);
+	}
+
+	double transport_module::luadio_transport_get_frame_of_beat(double beat)
+	{
+		if(pTransport == nullptr)
+			return 0.0;
+		return pTransport->get_frame_of_beat(beat);
+	}
+
+	int32_t transport_module::luadio_scheduler_schedule(double frame, int32_t id)
+	{
+		if(pScheduler == nullptr || id < 0)
+			return 0;
+		return pScheduler->schedule(to_frame(frame), id) ? 1 : 0;
+	}
+
+	int32_t transport_module::luadio_scheduler_pop_due(double frame, double *pEventFrame)
+	{
+		int32_t id = -1;
+		uint64_t eventFrame = 0;
+
+		if(pScheduler == nullptr || pEventFrame == nullptr || !pScheduler->pop_due(to_frame(frame), id, eventFrame))
+			return -1;
+
+		*pEventFrame = static_cast<double>(eventFrame);
+		return id;
+	}
+
+	uint32_t transport_module::luadio_scheduler_get_count()
+	{
+		if(pScheduler == nullptr)
+			return 0;
+		return pScheduler->get_count();
+	}
+
+	void transport_module::luadio_scheduler_clear()
+	{
+		if(pScheduler == nullptr)
+			return;
+		pScheduler->clear();
+	}
+}
@@ -0,0 +1,216 @@
+#include "voices_module.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace luadio
+{
+	static std::string gSource = R"(local ffi = require('ffi')
+local luadio = require('luadio')
+local voices = {}
+
+ffi.cdef[[
+typedef struct {
+    uint32_t voiceCount;
+    uint32_t activeCount;
+    uint32_t *pActive;
+    int32_t *pNotes;
+    float *pVelocities;
+    float *pFrequencies;
+    float *pGains;
+    float *pPans;
+    int32_t *pWaveforms;
+    float *pLevels;
+} luadio_voice_data;
+]]
+
+local luadio_voices_create = luadio.findMethod('luadio_voices_create', 'void* (__cdecl*)(uint32_t, uint32_t)')
+local luadio_voices_destroy = luadio.findMethod('luadio_voices_destroy', 'void (__cdecl*)(void*)')
+local luadio_voices_get_data = luadio.findMethod('luadio_voices_get_data', 'luadio_voice_data* (__cdecl*)(void*)')
+local luadio_voices_set_envelope = luadio.findMethod('luadio_voices_set_envelope', 'void (__cdecl*)(void*, float, float, float, float)')
+local luadio_voices_set_steal_policy = luadio.findMethod('luadio_voices_set_steal_policy', 'void (__cdecl*)(void*, int32_t)')
+local luadio_voices_note_on = luadio.findMethod('luadio_voices_note_on', 'int32_t (__cdecl*)(void*, int32_t, float)')
+local luadio_voices_note_off = luadio.findMethod('luadio_voices_note_off', 'void (__cdecl*)(void*, int32_t)')
+local luadio_voices_all_notes_off = luadio.findMethod('luadio_voices_all_notes_off', 'void (__cdecl*)(void*)')
+local luadio_voices_reset = luadio.findMethod('luadio_voices_reset', 'void (__cdecl*)(void*)')
+local luadio_voices_render = luadio.findMethod('luadio_voices_render', 'void (__cdecl*)(void*, float*, uint32_t, uint32_t)')
+local luadio_voices_render_events = luadio.findMethod('luadio_voices_render_events', 'void (__cdecl*)(void*, float*, uint32_t, uint32_t, const void*, uint32_t)')
+
+-- steal Enum
+voices.steal = {}
+voices.steal.none = 0
+voices.steal.oldest = 1
+voices.steal.quietest = 2
+
+-- waveform Enum
+voices.waveform = {}
+voices.waveform.sine = 0
+voices.waveform.saw = 1
+voices.waveform.square = 2
+voices.waveform.triangle = 3
+
+local pool = {}
+pool.__index = pool
+
+-- Pool of voiceCount voices, each with an oscillator and an ADSR envelope
+-- Per voice arrays are in self.data and are indexed by voice, starting at 0:
+--   data.activeCount and data.pActive[0 .. activeCount - 1] list the sounding voices
+--   data.pFrequencies, data.pGains, data.pPans and data.pWaveforms may be written at any time
+--   data.pNotes, data.pVelocities and data.pLevels are read only
+-- Call everything from the audio callbacks, sampleRate defaults to the engine rate
+function voices.new(voiceCount, sampleRate)
+    local handle = luadio_voices_create(voiceCount or 16, sampleRate or luadio.get_sample_rate())
+    if handle == nil then
+        error('voiceCount must be between 1 and 128')
+    end
+    local self = setmetatable({}, pool)
+    self.handle = ffi.gc(handle, luadio_voices_destroy)
+    self.data = luadio_voices_get_data(handle)
+    return self
+end
+
+function pool:set_envelope(attackSeconds, decaySeconds, sustainLevel, releaseSeconds)
+    luadio_voices_set_envelope(self.handle, attackSeconds, decaySeconds, sustainLevel, releaseSeconds)
+end
+
+function pool:set_steal_policy(policy)
+    luadio_voices_set_steal_policy(self.handle, policy)
+end
+
+-- Sets the waveform of every voice, set data.pWaveforms[voice] for a single one
+function pool:set_waveform(waveform)
+    for i = 0, self.data.voiceCount - 1 do
+        self.data.pWaveforms[i] = waveform
+    end
+end
+
+-- Returns the voice that plays the note, or -1 when the note was dropped
+-- Per voice gain and pan are reset to 1 and 0, set them after this call
+function pool:note_on(note, velocity)
+    return luadio_voices_note_on(self.handle, note, velocity or 1.0)
+end
+
+function pool:note_off(note)
+    luadio_voices_note_off(self.handle, note)
+end
+
+function pool:all_notes_off()
+    luadio_voices_all_notes_off(self.handle)
+end
+
+-- Silences every voice immediately
+function pool:reset()
+    luadio_voices_reset(self.handle)
+end
+
+-- Overwrites output with frameCount interleaved frames of all sounding voices
+function pool:render(output, frameCount, channels)
+    luadio_voices_render(self.handle, ffi.cast('float*', output), frameCount, channels or 2)
+end
+
+-- Same as render, and plays the note events returned by a luadio.sequencer pattern at their exact frames
+function pool:render_events(output, frameCount, channels, events, eventCount)
+    luadio_voices_render_events(self.handle, ffi.cast('float*', output), frameCount, channels or 2, events, eventCount or 0)
+end
+
+return voices)";
+
+	void voices_module::load(lua_State *L)
+	{
+		register_external_method(L, "luadio_voices_create", reinterpret_cast<void*>(luadio_voices_create));
+		register_external_method(L, "luadio_voices_destroy", reinterpret_cast<void*>(luadio_voices_destroy));
+		register_external_method(L, "luadio_voices_get_data", reinterpret_cast<void*>(luadio_voices_get_data));
+		register_external_method(L, "luadio_voices_set_envelope", reinterpret_cast<void*>(luadio_voices_set_envelope));
+		register_external_method(L, "luadio_voices_set_steal_policy", reinterpret_cast<void*>(luadio_voices_set_steal_policy));
+		register_external_method(L, "luadio_voices_note_on", reinterpret_cast<void*>(luadio_voices_note_on));
+		register_external_method(L, "luadio_voices_note_off", reinterpret_cast<void*>(luadio_voices_note_off));
+		register_external_method(L, "luadio_voices_all_notes_off", reinterpret_cast<void*>(luadio_voices_all_notes_off));
+		register_external_method(L, "luadio_voices_reset", reinterpret_cast<void*>(luadio_voices_reset));
+		register_external_method(L, "luadio_voices_render", reinterpret_cast<void*>(luadio_voices_render));
+		register_external_method(L, "luadio_voices_render_events", reinterpret_cast<void*>(luadio_voices_render_events));
+
+		register_source(L, gSource, "luadio.voices");
+	}
+
+	void *voices_module::luadio_voices_create(uint32_t voiceCount, uint32_t sampleRate)
+	{
+		try
+		{
+			return new voice_allocator(voiceCount, sampleRate);
+		}
+		catch(const std::invalid_argument &)
+		{
+			return nullptr;
+		}
+	}
+
+	void voices_module::luadio_voices_destroy(void *pVoices)
+	{
+		delete reinterpret_cast<voice_allocator*>(pVoices);
+	}
+
+	voice_data *voices_module::luadio_voices_get_data(void *pVoices)
+	{
+		if(pVoices == nullptr)
+			return nullptr;
+		return reinterpret_cast<voice_allocator*>(pVoices)->get_data();
+	}
+
+	void voices_module::luadio_voices_set_envelope(void *pVoices, float attackSeconds, float decaySeconds, float sustainLevel, float releaseSeconds)
+	{
+		if(pVoices == nullptr)
+			return;
+		reinterpret_cast<voice_allocator*>(pVoices)->set_envelope(attackSeconds, decaySeconds, sustainLevel, releaseSeconds);
+	}
+
+	void voices_module::luadio_voices_set_steal_policy(void *pVoices, int32_t policy)
+	{
+		if(pVoices == nullptr)
+			return;
+		const int32_t value = std::clamp<int32_t>(policy, steal_policy_none, steal_policy_quietest);
+		reinterpret_cast<voice_allocator*>(pVoices)->set_steal_policy(static_cast<steal_policy>(value));
+	}
+
+	int32_t voices_module::luadio_voices_note_on(void *pVoices, int32_t note, float velocity)
+	{
+		if(pVoices == nullptr)
+			return -1;
+		return reinterpret_cast<voice_allocator*>(pVoices)->note_on(note, velocity);
+	}
+
+	void voices_module::luadio_voices_note_off(void *pVoices, int32_t note)
+	{
+		if(pVoices == nullptr)
+			return;
+		reinterpret_cast<voice_allocator*>(pVoices)->note_off(note);
+	}
+
+	void voices_module::luadio_voices_all_notes_off(void *pVoices)
+	{
+		if(pVoices == nullptr)
+			return;
+		reinterpret_cast<voice_allocator*>(pVoices)->all_notes_off();
+	}
+
+	void voices_module::luadio_voices_reset(void *pVoices)
+	{
+		if(pVoices == nullptr)
+			return;
+		reinterpret_cast<voice_allocator*>(pVoices)->reset();
+	}
+
+	void voices_module::luadio_voices_render(void *pVoices, float *pOutput, uint32_t frameCount, uint32_t channels)
+	{
+		if(pVoices == nullptr || pOutput == nullptr || channels == 0)
+			return;
+		reinterpret_cast<voice_allocator*>(pVoices)->render(pOutput, frameCount, channels);
+	}
+
+	void voices_module::luadio_voices_render_events(void *pVoices, float *pOutput, uint32_t frameCount, uint32_t channels, const void *pEvents, uint32_t eventCount)
+	{
+		if(pVoices == nullptr || pOutput == nullptr || channels == 0)
+			return;
+		if(pEvents == nullptr)
+			eventCount = 0;
+		reinterpret_cast<voice_allocator*>(pVoices)->render_events(pOutput, frameCount, channels, reinterpret_cast<const note_event*>(pEvents), eventCount);
+	}
+}
@@ -0,0 +1,281 @@
+#include "analysis_worker.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace luadio
+{
+	analysis_worker::analysis_worker()
+	{
+		tap.resize(1 << 16);
+		frames = std::make_unique<triple_buffer<analysis_frame>>();
+		running.store(false);
+		settingsChanged.store(false);
+		scopeSettingsChanged.store(false);
+		waveformSeconds.store(static_cast<float>(scopeFrames) / 44100.0f);
+		sampleRate = 44100;
+		channels = 2;
+		scopePosition = 0;
+		spectrumScale = 1.0f;
+		settings.fftSize = 2048;
+		settings.overlap = 4;
+		settings.window = window_type_hann;
+		settings.minDecibels = -90.0f;
+		triggerSettings.mode = trigger_mode_zero_crossing;
+		triggerSettings.level = 0.0f;
+		triggerSettings.holdoffSeconds = 0.0f;
+		triggerSettings.windowSeconds = 0.02f;
+		triggerSettings.channel = 0;
+	}
+
+	analysis_worker::~analysis_worker()
+	{
+		stop();
+	}
+
+	void analysis_worker::start(uint32_t sampleRate, uint32_t channels)
+	{
+		if(running.load())
+			return;
+
+		this->sampleRate = sampleRate;
+		this->channels = channels;
+		// Blocks left over from a previous start may have another channel count
+		tap.resize(1 << 16);
+		readBuffer.resize(4096 * channels);
+		monoBuffer.resize(4096);
+		scope.assign(scopeFrames * channels, 0.0f);
+		scopePosition = 0;
+		pyramid.initialize(static_cast<uint64_t>(maxWaveformSeconds * sampleRate), analysis_frame::waveformColumns, channels);
+		spectrum.configure(get_spectrogram_settings(), sampleRate);
+		oscilloscope.initialize(sampleRate, channels);
+		oscilloscope.configure(get_scope_settings());
+		loudness.initialize(sampleRate, channels);
+
+		plan = fft_plan::get(scopeFrames);
+		window.resize(scopeFrames);
+		fftInput.resize(scopeFrames);
+		fftOutput.resize(plan->get_bin_count());
+		window_function::generate(window_type_hann, window.data(), scopeFrames);
+		spectrumScale = 2.0f / window_function::get_gain(window.data(), scopeFrames);
+		spectrogram::compute_bands(scopeFrames, sampleRate, bands, analysis_frame::spectrumBands);
+
+		// Start from silence so the UI has something valid to draw before audio flows
+		publish_frame(nullptr, 0);
+
+		running.store(true);
+		thread = std::thread(&analysis_worker::run, this);
+	}
+
+	void analysis_worker::stop()
+	{
+		running.store(false);
+
+		if(thread.joinable())
+			thread.join();
+	}
+
+	void analysis_worker::write(const float *pFrames, uint32_t frameCount, uint32_t channels)
+	{
+		if(!running.load(std::memory_order_relaxed) || channels != this->channels)
+			return;
+
+		const size_t count = static_cast<size_t>(frameCount) * channels;
+
+		// Drop whole blocks when the worker falls behind so frames stay aligned
+		if(tap.get_free_space() < count)
+			return;
+
+		tap.write(pFrames, count);
+	}
+
+	void analysis_worker::set_spectrogram_settings(const spectrogram_settings &settings)
+	{
+		std::lock_guard<std::mutex> lock(settingsMutex);
+		this->settings = settings;
+		settingsChanged.store(true);
+	}
+
+	spectrogram_settings analysis_worker::get_spectrogram_settings() const
+	{
+		std::lock_guard<std::mutex> lock(settingsMutex);
+		return settings;
+	}
+
+	const spectrogram &analysis_worker::get_spectrogram() const
+	{
+		return spectrum;
+	}
+
+	void analysis_worker::set_waveform_seconds(float seconds)
+	{
+		waveformSeconds.store(std::clamp(seconds, 0.001f, maxWaveformSeconds));
+	}
+
+	float analysis_worker::get_waveform_seconds() const
+	{
+		return waveformSeconds.load();
+	}
+
+	void analysis_worker::set_scope_settings(const scope_settings &settings)
+	{
+		std::lock_guard<std::mutex> lock(settingsMutex);
+		triggerSettings = settings;
+		scopeSettingsChanged.store(true);
+	}
+
+	scope_settings analysis_worker::get_scope_settings() const
+	{
+		std::lock_guard<std::mutex> lock(settingsMutex);
+		return triggerSettings;
+	}
+
+	loudness_meter &analysis_worker::get_loudness()
+	{
+		return loudness;
+	}
+
+	const analysis_frame &analysis_worker::get_frame()
+	{
+		frames->update();
+		return frames->get_read_buffer();
+	}
+
+	void analysis_worker::run()
+	{
+		while(running.load())
+		{
+			if(settingsChanged.exchange(false))
+				spectrum.configure(get_spectrogram_settings(), sampleRate);
+
+			if(scopeSettingsChanged.exchange(false))
+				oscilloscope.configure(get_scope_settings());
+
+			const size_t framesRead = tap.read(readBuffer.data(), readBuffer.size()) / channels;
+
+			if(framesRead == 0)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(5));
+				continue;
+			}
+
+			for(size_t i = 0; i < framesRead; i++)
+			{
+				float sum = 0.0f;
+
+				for(uint32_t c = 0; c < channels; c++)
+					sum += readBuffer[i * channels + c];
+
+				monoBuffer[i] = sum / channels;
+			}
+
+			spectrum.process(monoBuffer.data(), framesRead);
+			write_scope(readBuffer.data(), framesRead);
+			pyramid.push(readBuffer.data(), framesRead);
+			oscilloscope.push(readBuffer.data(), framesRead);
+			loudness.process(readBuffer.data(), framesRead);
+			publish_frame(readBuffer.data(), framesRead);
+		}
+	}
+
+	void analysis_worker::write_scope(const float *pFrames, size_t frameCount)
+	{
+		// Only the newest frames matter if more arrived than the scope holds
+		if(frameCount > scopeFrames)
+		{
+			pFrames += (frameCount - scopeFrames) * channels;
+			frameCount = scopeFrames;
+		}
+
+		for(size_t i = 0; i < frameCount; i++)
+		{
+			std::copy(pFrames + i * channels, pFrames + (i + 1) * channels, &scope[scopePosition * channels]);
+			scopePosition = (scopePosition + 1) % scopeFrames;
+		}
+	}
+
+	void analysis_worker::publish_frame(const float *pNewFrames, size_t frameCount)
+	{
+		analysis_frame &frame = frames->get_write_buffer();
+		frame.channels = std::min(channels, analysis_frame::maxChannels);
+
+		compute_waveform(frame);
+		compute_scope(frame);
+		compute_spectrum(frame);
+		compute_levels(frame, pNewFrames, frameCount);
+
+		frames->publish();
+	}
+
+	void analysis_worker::compute_waveform(analysis_frame &frame)
+	{
+		const uint64_t frameCount = static_cast<uint64_t>(waveformSeconds.load() * sampleRate);
+
+		for(uint32_t c = 0; c < frame.channels; c++)
+			pyramid.get_columns(frameCount, analysis_frame::waveformColumns, c, frame.waveformMin[c], frame.waveformMax[c]);
+	}
+
+	void analysis_worker::compute_scope(analysis_frame &frame)
+	{
+		frame.scopeTriggered = oscilloscope.update();
+
+		for(uint32_t c = 0; c < frame.channels; c++)
+			oscilloscope.get_columns(analysis_frame::waveformColumns, c, frame.scopeMin[c], frame.scopeMax[c]);
+	}
+
+	void analysis_worker::compute_spectrum(analysis_frame &frame)
+	{
+		// Windowed mono downmix of the scope, oldest frame first
+		for(size_t i = 0; i < scopeFrames; i++)
+		{
+			const size_t index = (scopePosition + i) % scopeFrames;
+			float sum = 0.0f;
+
+			for(uint32_t c = 0; c < channels; c++)
+				sum += scope[index * channels + c];
+
+			fftInput[i] = window[i] * sum / channels;
+		}
+
+		plan->forward(fftInput.data(), fftOutput.data());
+
+		for(uint32_t b = 0; b < analysis_frame::spectrumBands; b++)
+		{
+			float power = 0.0f;
+
+			for(uint32_t i = bands[b].firstBin; i <= bands[b].lastBin; i++)
+				power = std::max(power, std::norm(fftOutput[i]));
+
+			const float decibels = 10.0f * std::log10(power * spectrumScale * spectrumScale + 1e-20f);
+			frame.spectrum[b] = std::max(decibels, analysis_frame::minDecibels);
+		}
+	}
+
+	void analysis_worker::compute_levels(analysis_frame &frame, const float *pNewFrames, size_t frameCount)
+	{
+		auto toDecibels = [] (float amplitude) -> float {
+			return std::max(20.0f * std::log10(amplitude + 1e-20f), analysis_frame::minDecibels);
+		};
+
+		for(uint32_t c = 0; c < frame.channels; c++)
+		{
+			// Peak covers exactly the frames that arrived since the last frame, so no peak is ever missed
+			float peak = 0.0f;
+
+			for(size_t i = 0; i < frameCount; i++)
+				peak = std::max(peak, std::abs(pNewFrames[i * channels + c]));
+
+			// RMS is taken over the whole scope for a steadier reading
+			double sum = 0.0;
+
+			for(size_t i = 0; i < scopeFrames; i++)
+			{
+				const float sample = scope[i * channels + c];
+				sum += sample * sample;
+			}
+
+			frame.peakDecibels[c] = toDecibels(peak);
+			frame.rmsDecibels[c] = toDecibels(static_cast<float>(std::sqrt(sum / scopeFrames)));
+		}
+	}
+}
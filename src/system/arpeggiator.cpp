@@ -0,0 +1,160 @@
+#include "arpeggiator.hpp"
+#include <algorithm>
+#include <numeric>
+
+namespace luadio
+{
+	arpeggiator::arpeggiator()
+	{
+		heldCount = 0;
+		patternLength = 0;
+		position = 0;
+		mode = arp_mode_up;
+		octaves = 1;
+		gate = 0.5f;
+	}
+
+	void arpeggiator::note_on(int32_t note, float velocity)
+	{
+		for(uint32_t i = 0; i < heldCount; i++)
+		{
+			if(heldNotes[i] == note)
+				return;
+		}
+
+		if(heldCount >= maxNotes)
+			return;
+
+		if(heldCount == 0)
+			position = 0;
+
+		heldNotes[heldCount] = note;
+		heldVelocities[heldCount] = velocity;
+		heldCount++;
+		build_pattern();
+	}
+
+	void arpeggiator::note_off(int32_t note)
+	{
+		for(uint32_t i = 0; i < heldCount; i++)
+		{
+			if(heldNotes[i] != note)
+				continue;
+
+			// Shift instead of swap to keep the played order
+			std::copy(heldNotes + i + 1, heldNotes + heldCount, heldNotes + i);
+			std::copy(heldVelocities + i + 1, heldVelocities + heldCount, heldVelocities + i);
+			heldCount--;
+			build_pattern();
+			return;
+		}
+	}
+
+	void arpeggiator::clear()
+	{
+		heldCount = 0;
+		build_pattern();
+	}
+
+	void arpeggiator::set_mode(arp_mode mode)
+	{
+		this->mode = mode;
+		build_pattern();
+	}
+
+	void arpeggiator::set_octaves(uint32_t octaves)
+	{
+		this->octaves = std::clamp<uint32_t>(octaves, 1, maxOctaves);
+		build_pattern();
+	}
+
+	void arpeggiator::set_gate(float gate)
+	{
+		this->gate = std::clamp(gate, 0.01f, 1.0f);
+	}
+
+	void arpeggiator::set_rate(double stepsPerBeat)
+	{
+		clock.set_rate(stepsPerBeat);
+	}
+
+	void arpeggiator::set_swing(double swing)
+	{
+		clock.set_swing(swing);
+	}
+
+	uint32_t arpeggiator::process(const transport_state &state, uint32_t frameCount)
+	{
+		int64_t firstStep, lastStep;
+		clock.begin(state, frameCount, firstStep, lastStep);
+
+		for(int64_t s = firstStep; s <= lastStep && patternLength > 0; s++)
+		{
+			const double start = clock.get_step_beat(s);
+
+			if(!clock.contains(start))
+				continue;
+
+			uint32_t index;
+
+			if(mode == arp_mode_random)
+				index = static_cast<uint32_t>(pattern_clock::get_random(s, 0) * patternLength);
+			else
+				index = static_cast<uint32_t>(position % patternLength);
+
+			clock.add_note(start, (clock.get_step_beat(s + 1) - start) * gate, pattern[index], patternVelocities[index]);
+			position++;
+		}
+
+		return clock.end();
+	}
+
+	const note_event *arpeggiator::get_events() const
+	{
+		return clock.get_events();
+	}
+
+	void arpeggiator::release_all()
+	{
+		clock.release_all();
+	}
+
+	void arpeggiator::build_pattern()
+	{
+		uint32_t order[maxNotes];
+		std::iota(order, order + heldCount, 0);
+
+		if(mode != arp_mode_played)
+			std::sort(order, order + heldCount, [this] (uint32_t a, uint32_t b) { return heldNotes[a] < heldNotes[b]; });
+
+		patternLength = 0;
+
+		for(uint32_t o = 0; o < octaves; o++)
+		{
+			for(uint32_t i = 0; i < heldCount; i++)
+			{
+				pattern[patternLength] = heldNotes[order[i]] + static_cast<int32_t>(o) * 12;
+				patternVelocities[patternLength] = heldVelocities[order[i]];
+				patternLength++;
+			}
+		}
+
+		if(mode == arp_mode_down)
+		{
+			std::reverse(pattern, pattern + patternLength);
+			std::reverse(patternVelocities, patternVelocities + patternLength);
+		}
+		else if(mode == arp_mode_up_down && patternLength > 2)
+		{
+			// Back down without repeating the top and bottom notes
+			const uint32_t upLength = patternLength;
+
+			for(uint32_t i = upLength - 2; i > 0; i--)
+			{
+				pattern[patternLength] = pattern[i];
+				patternVelocities[patternLength] = patternVelocities[i];
+				patternLength++;
+			}
+		}
+	}
+}
@@ -0,0 +1,40 @@
+#include "audio_file.hpp"
+#include "../../libs/miniaudioex/include/miniaudioex.h"
+
+namespace luadio
+{
+	bool audio_file::read(const std::string &filePath, uint32_t sampleRate, std::vector<float> &frames, uint32_t &channels)
+	{
+		ma_decoder_config config = ma_decoder_config_init(ma_format_f32, 0, sampleRate);
+		ma_decoder decoder;
+
+		if(ma_decoder_init_file(filePath.c_str(), &config, &decoder) != MA_SUCCESS)
+			return false;
+
+		channels = decoder.outputChannels;
+		frames.clear();
+
+		ma_uint64 length = 0;
+
+		if(ma_decoder_get_length_in_pcm_frames(&decoder, &length) == MA_SUCCESS && length > 0)
+			frames.reserve(length * channels);
+
+		// The length is not known up front for every format, so decode in chunks until the end
+		const ma_uint64 chunkFrames = 4096;
+		std::vector<float> chunk(chunkFrames * channels);
+
+		while(true)
+		{
+			ma_uint64 framesRead = 0;
+			ma_result result = ma_decoder_read_pcm_frames(&decoder, chunk.data(), chunkFrames, &framesRead);
+
+			frames.insert(frames.end(), chunk.begin(), chunk.begin() + framesRead * channels);
+
+			if(result != MA_SUCCESS || framesRead < chunkFrames)
+				break;
+		}
+
+		ma_decoder_uninit(&decoder);
+		return channels > 0 && frames.size() > 0;
+	}
+}
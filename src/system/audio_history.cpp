@@ -0,0 +1,140 @@
+#include "audio_history.hpp"
+#include "wav_writer.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace luadio
+{
+	audio_history::audio_history()
+	{
+		capacity = 0;
+		sampleRate = 0;
+		channels = 0;
+		writePosition.store(0);
+		saving.store(false);
+	}
+
+	audio_history::~audio_history()
+	{
+		if(saveThread.joinable())
+			saveThread.join();
+	}
+
+	void audio_history::initialize(uint32_t maxSeconds, uint32_t sampleRate, uint32_t channels)
+	{
+		// Must be called before audio starts flowing, the buffer is never resized afterwards
+		this->sampleRate = sampleRate;
+		this->channels = channels;
+		capacity = static_cast<uint64_t>(maxSeconds) * sampleRate;
+		buffer.resize(capacity * channels);
+		std::fill(buffer.begin(), buffer.end(), 0.0f);
+		writePosition.store(0);
+	}
+
+	void audio_history::write(const float *pFrames, uint32_t frameCount, uint32_t channels)
+	{
+		if(capacity == 0 || channels != this->channels || frameCount == 0)
+			return;
+
+		uint64_t position = writePosition.load(std::memory_order_relaxed);
+
+		// Only the newest frames fit if a block is larger than the ring
+		if(frameCount > capacity)
+		{
+			pFrames += (frameCount - capacity) * channels;
+			position += frameCount - capacity;
+			frameCount = static_cast<uint32_t>(capacity);
+		}
+
+		const uint64_t index = position % capacity;
+		const uint64_t firstPart = std::min<uint64_t>(frameCount, capacity - index);
+
+		std::memcpy(&buffer[index * channels], pFrames, firstPart * channels * sizeof(float));
+
+		if(firstPart < frameCount)
+			std::memcpy(&buffer[0], pFrames + firstPart * channels, (frameCount - firstPart) * channels * sizeof(float));
+
+		writePosition.store(position + frameCount, std::memory_order_release);
+	}
+
+	bool audio_history::save(float seconds, pcm_format format, bool dither)
+	{
+		if(capacity == 0 || seconds <= 0.0f)
+			return false;
+
+		if(saving.exchange(true))
+			return false;
+
+		if(saveThread.joinable())
+			saveThread.join();
+
+		uint64_t frameCount = static_cast<uint64_t>(seconds * sampleRate);
+		frameCount = std::min(frameCount, capacity);
+
+		saveThread = std::thread(&audio_history::save_to_file, this, wav_writer::create_file_name("_history"), frameCount, format, dither);
+		return true;
+	}
+
+	bool audio_history::is_saving() const
+	{
+		return saving.load();
+	}
+
+	float audio_history::get_max_seconds() const
+	{
+		if(sampleRate == 0)
+			return 0.0f;
+		return static_cast<float>(capacity) / sampleRate;
+	}
+
+	float audio_history::get_available_seconds() const
+	{
+		if(sampleRate == 0)
+			return 0.0f;
+		uint64_t available = std::min(writePosition.load(std::memory_order_acquire), capacity);
+		return static_cast<float>(available) / sampleRate;
+	}
+
+	void audio_history::save_to_file(std::string filePath, uint64_t frameCount, pcm_format format, bool dither)
+	{
+		const uint64_t end = writePosition.load(std::memory_order_acquire);
+		const uint64_t count = std::min(frameCount, std::min(end, capacity));
+		const uint64_t start = end - count;
+
+		std::vector<float> frames(count * channels);
+
+		for(uint64_t i = 0; i < count; )
+		{
+			const uint64_t index = (start + i) % capacity;
+			const uint64_t n = std::min(count - i, capacity - index);
+			std::memcpy(&frames[i * channels], &buffer[index * channels], n * channels * sizeof(float));
+			i += n;
+		}
+
+		// The audio thread kept writing while we copied. Frames it may have overwritten in the meantime,
+		// including a block that could be in flight right now, are dropped from the front.
+		const uint64_t margin = sampleRate / 10;
+		const uint64_t now = writePosition.load(std::memory_order_acquire) + margin;
+		uint64_t skip = 0;
+
+		if(now > capacity && now - capacity > start)
+			skip = std::min(count, now - capacity - start);
+
+		wav_writer writer;
+
+		if(writer.open(filePath, sampleRate, channels, format, dither))
+		{
+			const uint64_t chunkFrames = 4096;
+
+			for(uint64_t i = skip; i < count; i += chunkFrames)
+			{
+				const uint64_t n = std::min(chunkFrames, count - i);
+				writer.write(&frames[i * channels], static_cast<uint32_t>(n));
+			}
+
+			writer.close();
+		}
+
+		saving.store(false);
+	}
+}
@@ -1,201 +1,625 @@
 #include "audio_recorder.hpp"
+#include <algorithm>
 #include <chrono>
-#include <filesystem>
+#include <cstring>
+#include <cctype>
 
 namespace luadio
 {
+	static constexpr size_t stagingSize = 1 << 18;
+	// Enough for the longest period plus the frames the read callback runs ahead in sub-block mode
+	static constexpr uint32_t stagingFrames = 1 << 14;
+	static constexpr size_t ringSize = 1 << 17;
+
 	audio_recorder::audio_recorder()
 	{
-		outputBuffer.resize(4096);
-		bytesWritten = 0;
-		state = recorder_state_idle;
+		for(uint32_t i = 0; i < maxStems; i++)
+		{
+			auto s = std::make_unique<stem>();
+			s->name[0] = '\0';
+			s->active.store(false);
+			s->channels = 0;
+			s->inSession = false;
+
+			if(i >= stem_index_first_bus)
+			{
+				s->staging.resize(stagingSize);
+				s->stagedFrames.resize(stagingFrames, endless);
+			}
+
+			s->ring.resize(ringSize);
+			s->framesWritten = 0;
+			stems.push_back(std::move(s));
+		}
+
+		std::strcpy(stems[stem_index_mix]->name, "mix");
+		std::strcpy(stems[stem_index_dry]->name, "dry");
+		stems[stem_index_mix]->active.store(true);
+		stems[stem_index_dry]->active.store(true);
+
+		ioBuffer.resize(ringSize);
+		busBuffer.resize(stagingSize);
+		commands.resize(1024);
+		sessionFormat = pcm_format_s16;
+		sessionDither = false;
+		sessionFrames = 0;
+
+		format.store(pcm_format_s16);
+		dither.store(true);
+		recordDry.store(false);
+		recordBuses.store(true);
+		sampleRate.store(44100);
+		state.store(recorder_state_idle);
+		startFrame.store(0);
+		stopFrame.store(endless);
+		framePosition.store(0);
+		stagingPosition = 0;
+		droppedBlocks.store(0);
+		droppedBusWrites.store(0);
+		releaseRequested.store(false);
+		sessionsOpened.store(0);
+		sessionsClosed.store(0);
+
+		running.store(true);
+		ioThread = std::thread(&audio_recorder::io_loop, this);
 	}
 
 	audio_recorder::~audio_recorder()
 	{
-		close_file();
+		running.store(false);
+
+		if(ioThread.joinable())
+			ioThread.join();
 	}
 
 	bool audio_recorder::is_recording() const
 	{
-		return get_state() != recorder_state_idle;
+		return state.load(std::memory_order_acquire) != recorder_state_idle;
+	}
+
+	uint64_t audio_recorder::get_frame_position() const
+	{
+		return framePosition.load(std::memory_order_acquire);
+	}
+
+	uint64_t audio_recorder::get_dropped_blocks() const
+	{
+		return droppedBlocks.load(std::memory_order_relaxed);
+	}
+
+	uint64_t audio_recorder::get_dropped_bus_writes() const
+	{
+		return droppedBusWrites.load(std::memory_order_relaxed);
 	}
 
 	void audio_recorder::start()
 	{
-		if(get_state() != recorder_state_idle) 
+		// Frame 0 has always passed, so the recording starts with the next block whatever the clock reads
+		start_at(0);
+	}
+
+	void audio_recorder::stop()
+	{
+		stop_at(0);
+	}
+
+	void audio_recorder::start_at(uint64_t frame, uint64_t stopFrame)
+	{
+		if(state.load(std::memory_order_acquire) != recorder_state_idle)
 			return;
 
-		set_state(recorder_state_write_header);
+		startFrame.store(frame, std::memory_order_relaxed);
+		this->stopFrame.store(stopFrame, std::memory_order_relaxed);
+		state.store(recorder_state_armed, std::memory_order_release);
 	}
 
-	void audio_recorder::stop()
+	void audio_recorder::stop_at(uint64_t frame)
 	{
-		close_file();
+		if(state.load(std::memory_order_acquire) == recorder_state_idle)
+			return;
+
+		stopFrame.store(frame, std::memory_order_release);
 	}
 
-	void audio_recorder::on_process(const float* pFrames, uint32_t frameCount, uint32_t channels)
+	void audio_recorder::set_format(pcm_format format)
 	{
-		write_header(channels);
-		write_data(pFrames, frameCount, channels);
+		this->format.store(format);
 	}
 
-	audio_recorder::recorder_state audio_recorder::get_state() const
+	pcm_format audio_recorder::get_format() const
 	{
-		std::lock_guard<std::mutex> lock(mutex);
-		return state;
+		return format.load();
 	}
 
-	void audio_recorder::set_state(audio_recorder::recorder_state newState)
+	void audio_recorder::set_dither(bool enabled)
 	{
-		std::lock_guard<std::mutex> lock(mutex);
-		state = newState;
+		dither.store(enabled);
 	}
 
-	void audio_recorder::write_header(uint32_t channels)
+	bool audio_recorder::get_dither() const
 	{
-		if(get_state() != recorder_state_write_header)
-			return;
+		return dither.load();
+	}
 
-		if(bytesWritten > 0)
-			return;
+	void audio_recorder::set_record_dry(bool enabled)
+	{
+		recordDry.store(enabled);
+	}
 
-		if(stream.is_open())
-			return;
+	bool audio_recorder::get_record_dry() const
+	{
+		return recordDry.load();
+	}
 
-		auto now = std::chrono::high_resolution_clock::now();
-		auto ticks = std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+	void audio_recorder::set_record_buses(bool enabled)
+	{
+		recordBuses.store(enabled);
+	}
 
-		std::filesystem::path dirPath = "recordings";
+	bool audio_recorder::get_record_buses() const
+	{
+		return recordBuses.load();
+	}
 
-		currentFileName = std::to_string(ticks) + ".wav";
-		
-		if(std::filesystem::exists(dirPath))
+	void audio_recorder::set_sample_rate(uint32_t sampleRate)
+	{
+		this->sampleRate.store(sampleRate);
+	}
+
+	uint32_t audio_recorder::get_sample_rate() const
+	{
+		return sampleRate.load();
+	}
+
+	void audio_recorder::on_process(const float *pDry, const float *pMix, uint32_t frameCount, uint32_t channels, uint64_t frame)
+	{
+		const uint64_t blockStart = frame;
+		const uint64_t blockEnd = blockStart + frameCount;
+		const recorder_state currentState = state.load(std::memory_order_acquire);
+
+		sync_staging();
+
+		if(currentState != recorder_state_idle)
 		{
-			currentFileName = "recordings/" + std::to_string(ticks) + ".wav";
+			// Once running every block is taken, the transport restarts at 0 when a script is started again
+			const uint64_t first = currentState == recorder_state_armed ? std::max(startFrame.load(std::memory_order_relaxed), blockStart) : blockStart;
+			const uint64_t last = std::min(stopFrame.load(std::memory_order_acquire), blockEnd);
+
+			if(first < last)
+			{
+				if(currentState == recorder_state_armed)
+				{
+					stems[stem_index_mix]->channels = channels;
+					stems[stem_index_dry]->channels = channels;
+
+					io_command command = { io_command_type_open, 0, 0, format.load(), dither.load() };
+
+					if(commands.try_enqueue(command))
+					{
+						// Buses join the new session when they are first written for one of its frames
+						for(uint32_t i = stem_index_first_bus; i < maxStems; i++)
+							stems[i]->inSession = false;
+
+						sessionsOpened.fetch_add(1, std::memory_order_relaxed);
+						state.store(recorder_state_recording, std::memory_order_release);
+					}
+				}
+
+				if(state.load(std::memory_order_relaxed) == recorder_state_recording)
+				{
+					if(!push_frames(pDry, pMix, static_cast<uint32_t>(first - blockStart), static_cast<uint32_t>(last - first), channels, first))
+						droppedBlocks.fetch_add(1, std::memory_order_relaxed);
+				}
+			}
+
+			check_stop(blockEnd);
 		}
 
-		uint8_t header[44];
-
-		const int32_t bitDepth = 16;
-
-		int32_t chunkId = 1179011410;           //"RIFF
-		int32_t chunkSize = 0;
-		int32_t format = 1163280727;            //"WAVE"
-		int32_t subChunk1Id = 544501094;        //"fmt "
-		int32_t subChunk1Size = 16;
-		int16_t audioFormat = 1;
-		int16_t numChannels = static_cast<int16_t>(channels);
-		int32_t sampleRate = 44100;
-		int32_t byteRate = sampleRate * numChannels * bitDepth / 8;
-		int16_t blockAlign = static_cast<int16_t>(numChannels * bitDepth / 8);
-		int16_t bitsPerSample = bitDepth;
-		int32_t subChunk2Id = 1635017060;       //"data"
-		int32_t subChunk2Size = 0;
-
-		write_int32(chunkId, header, 0);
-		write_int32(chunkSize, header, 4);
-		write_int32(format, header, 8);
-		write_int32(subChunk1Id, header, 12);
-		write_int32(subChunk1Size, header, 16);
-		write_int16(audioFormat, header, 20);
-		write_int16(numChannels, header, 22);
-		write_int32(sampleRate, header, 24);
-		write_int32(byteRate, header, 28);
-		write_int16(blockAlign, header, 32);
-		write_int16(bitsPerSample, header, 34);
-		write_int32(subChunk2Id, header, 36);
-		write_int32(subChunk2Size, header, 40);
-
-		stream = std::ofstream(currentFileName, std::ios::out | std::ios::trunc);
-
-		if(!stream.is_open())
+		stagingPosition = blockEnd;
+		framePosition.store(blockEnd, std::memory_order_release);
+	}
+
+	void audio_recorder::on_idle()
+	{
+		// The transport stands still while nothing is produced, a stop at or before it still lands
+		if(state.load(std::memory_order_acquire) != recorder_state_idle)
+			check_stop(framePosition.load(std::memory_order_relaxed));
+	}
+
+	void audio_recorder::set_frame_position(uint64_t frame)
+	{
+		framePosition.store(frame, std::memory_order_release);
+	}
+
+	void audio_recorder::release_buses()
+	{
+		// Done by the audio thread in sync_staging, it owns the slots
+		releaseRequested.store(true, std::memory_order_release);
+	}
+
+	void audio_recorder::write_bus(const char *name, const float *pFrames, uint32_t frameCount, uint32_t channels, uint64_t frame)
+	{
+		// Called from the script callbacks, which are serialized with on_process by the Lua mutex
+		sync_staging();
+		stem *pStem = pFrames != nullptr ? find_bus(name, channels) : nullptr;
+
+		if(pStem == nullptr)
 			return;
 
-		stream.write(reinterpret_cast<const char*>(header), 44);
+		// Frames the output already passed are late, frames beyond the staging would overwrite pending ones
+		const uint32_t capacityFrames = get_staging_capacity(channels);
+		const uint64_t position = framePosition.load(std::memory_order_relaxed);
+		const uint64_t first = std::max(frame, position);
+		const uint64_t last = std::min(frame + frameCount, position + capacityFrames);
 
-		bytesWritten = 0;
+		for(uint64_t f = first; f < last; f++)
+		{
+			const size_t slot = f % capacityFrames;
+			float *pSlot = pStem->staging.data() + slot * channels;
+			const float *pSource = pFrames + (f - frame) * channels;
 
-		set_state(recorder_state_write_data);
+			// A slot holding this frame was written before and is mixed, anything else in it is stale
+			if(pStem->stagedFrames[slot] == f)
+			{
+				for(uint32_t c = 0; c < channels; c++)
+					pSlot[c] += pSource[c];
+			}
+			else
+			{
+				std::memcpy(pSlot, pSource, channels * sizeof(float));
+				pStem->stagedFrames[slot] = f;
+			}
+		}
 	}
 
-	void audio_recorder::write_data(const float* pFrames, uint32_t frameCount, uint32_t channels)
+	void audio_recorder::write_bus(const char *name, const float *const *ppChannels, uint32_t frameCount, uint32_t channels, uint64_t frame)
 	{
-		if(get_state() != recorder_state_write_data)
-			return;		
+		sync_staging();
+		stem *pStem = ppChannels != nullptr ? find_bus(name, channels) : nullptr;
 
-		if(!stream.is_open())
+		if(pStem == nullptr)
 			return;
 
+		const uint32_t capacityFrames = get_staging_capacity(channels);
+		const uint64_t position = framePosition.load(std::memory_order_relaxed);
+		const uint64_t first = std::max(frame, position);
+		const uint64_t last = std::min(frame + frameCount, position + capacityFrames);
+
+		for(uint64_t f = first; f < last; f++)
+		{
+			const size_t slot = f % capacityFrames;
+			float *pSlot = pStem->staging.data() + slot * channels;
+			const size_t index = f - frame;
+
+			if(pStem->stagedFrames[slot] == f)
+			{
+				for(uint32_t c = 0; c < channels; c++)
+					pSlot[c] += ppChannels[c][index];
+			}
+			else
+			{
+				for(uint32_t c = 0; c < channels; c++)
+					pSlot[c] = ppChannels[c][index];
+
+				pStem->stagedFrames[slot] = f;
+			}
+		}
+	}
+
+	audio_recorder::stem *audio_recorder::find_bus(const char *name, uint32_t channels)
+	{
+		if(name == nullptr || channels == 0)
+			return nullptr;
+
+		for(uint32_t i = stem_index_first_bus; i < maxStems; i++)
+		{
+			stem *s = stems[i].get();
 
-		const uint32_t byteSize = static_cast<uint32_t>(frameCount * channels * sizeof(short));
-		const uint32_t numSamples = frameCount * channels;
+			if(!s->active.load(std::memory_order_relaxed))
+			{
+				// Claim a free slot, buses keep it until release_buses
+				std::strncpy(s->name, name, sizeof(s->name) - 1);
+				s->name[sizeof(s->name) - 1] = '\0';
+				s->channels = channels;
+				s->inSession = false;
+				s->active.store(true, std::memory_order_release);
+				return s;
+			}
 
-		if(byteSize == 0)
+			if(std::strncmp(s->name, name, sizeof(s->name) - 1) == 0)
+			{
+				if(s->channels == channels)
+					return s;
+
+				break;
+			}
+		}
+
+		droppedBusWrites.fetch_add(1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	void audio_recorder::sync_staging()
+	{
+		// The I/O thread reads the name and channels of a bus until the session it records is closed
+		if(releaseRequested.load(std::memory_order_acquire) &&
+		   state.load(std::memory_order_acquire) != recorder_state_recording &&
+		   sessionsClosed.load(std::memory_order_acquire) == sessionsOpened.load(std::memory_order_relaxed))
+		{
+			for(uint32_t i = stem_index_first_bus; i < maxStems; i++)
+			{
+				stem *s = stems[i].get();
+				s->active.store(false, std::memory_order_relaxed);
+				s->name[0] = '\0';
+				s->channels = 0;
+				s->inSession = false;
+				std::fill(s->stagedFrames.begin(), s->stagedFrames.end(), endless);
+			}
+
+			releaseRequested.store(false, std::memory_order_relaxed);
+		}
+
+		// The transport was reset since the last block, staged frames may carry the same numbers again
+		const uint64_t position = framePosition.load(std::memory_order_relaxed);
+
+		if(position == stagingPosition)
 			return;
 
-		if(outputBuffer.size() < byteSize)
-			outputBuffer.resize(byteSize);
+		for(uint32_t i = stem_index_first_bus; i < maxStems; i++)
+			std::fill(stems[i]->stagedFrames.begin(), stems[i]->stagedFrames.end(), endless);
 
-		int32_t index = 0;
+		stagingPosition = position;
+	}
 
-		int16_t *pBuffer = reinterpret_cast<int16_t*>(outputBuffer.data());
+	bool audio_recorder::has_staged_frames(const stem &s, uint64_t frame, uint32_t frameCount) const
+	{
+		const uint32_t capacityFrames = get_staging_capacity(s.channels);
 
-		for(int32_t i = 0; i < numSamples; i++)
+		for(uint64_t f = frame; f < frame + frameCount; f++)
 		{
-			pBuffer[index] = static_cast<int16_t>(pFrames[i] * 32767);
-			index++;
+			if(s.stagedFrames[f % capacityFrames] == f)
+				return true;
 		}
 
-		stream.write(reinterpret_cast<const char*>(outputBuffer.data()), byteSize);
+		return false;
+	}
 
-		bytesWritten += byteSize;
+	uint32_t audio_recorder::get_staging_capacity(uint32_t channels) const
+	{
+		return std::min<uint32_t>(stagingFrames, static_cast<uint32_t>(stagingSize / channels));
 	}
 
-	void audio_recorder::close_file()
+	void audio_recorder::check_stop(uint64_t blockEnd)
 	{
-		if(stream.is_open())
+		if(stopFrame.load(std::memory_order_acquire) > blockEnd)
+			return;
+
+		if(state.load(std::memory_order_relaxed) == recorder_state_recording)
 		{
-			if(bytesWritten > 0)
+			io_command command = { io_command_type_close, 0, 0, pcm_format_s16, false };
+
+			// Try again next block if the queue is full
+			if(!commands.try_enqueue(command))
+				return;
+		}
+
+		state.store(recorder_state_idle, std::memory_order_release);
+	}
+
+	bool audio_recorder::push_frames(const float *pDry, const float *pMix, uint32_t offset, uint32_t frameCount, uint32_t channels, uint64_t frame)
+	{
+		uint32_t stemMask = 1 << stem_index_mix;
+
+		if(pDry != nullptr && recordDry.load(std::memory_order_relaxed))
+			stemMask |= 1 << stem_index_dry;
+
+		if(recordBuses.load(std::memory_order_relaxed))
+		{
+			// A bus claimed earlier but silent in this session gets no file
+			for(uint32_t i = stem_index_first_bus; i < maxStems; i++)
 			{
-				const int32_t headerSize = 44;
-				int32_t chunkSize = headerSize + static_cast<int32_t>(bytesWritten - 8);//file size - 8;
-				int32_t subChunk2Size = static_cast<int32_t>(bytesWritten);
+				const stem *s = stems[i].get();
+
+				if(s->active.load(std::memory_order_relaxed) && (s->inSession || has_staged_frames(*s, frame, frameCount)))
+					stemMask |= 1 << i;
+			}
+		}
 
-				uint8_t buffer[8];
+		// Either every stem gets the block or none does, so the files stay aligned
+		if(commands.get_free_space() == 0)
+			return false;
 
-				write_int32(chunkSize, buffer, 0);
-				stream.seekp(4, std::ios::beg);
-				stream.write(reinterpret_cast<const char*>(buffer), sizeof(int32_t));
-				
-				write_int32(subChunk2Size, buffer, 0);
-				stream.seekp(40, std::ios::beg);
-				stream.write(reinterpret_cast<const char*>(buffer), sizeof(int32_t));
+		for(uint32_t i = 0; i < maxStems; i++)
+		{
+			if((stemMask & (1 << i)) && stems[i]->ring.get_free_space() < static_cast<size_t>(frameCount) * stems[i]->channels)
+				return false;
+		}
+
+		for(uint32_t i = 0; i < maxStems; i++)
+		{
+			if(!(stemMask & (1 << i)))
+				continue;
 
-				bytesWritten = 0;
+			stem *s = stems[i].get();
+			s->inSession = true;
+
+			if(i == stem_index_mix)
+			{
+				s->ring.write(pMix + offset * channels, frameCount * channels);
+			}
+			else if(i == stem_index_dry)
+			{
+				s->ring.write(pDry + offset * channels, frameCount * channels);
+			}
+			else
+			{
+				// Frames the script did not write for are recorded as silence
+				const uint32_t capacityFrames = get_staging_capacity(s->channels);
+				const uint32_t chunkFrames = static_cast<uint32_t>(busBuffer.size() / s->channels);
+
+				for(uint32_t done = 0; done < frameCount; )
+				{
+					const uint32_t count = std::min(frameCount - done, chunkFrames);
+
+					for(uint32_t j = 0; j < count; j++)
+					{
+						const uint64_t f = frame + done + j;
+						const size_t slot = f % capacityFrames;
+						float *pTarget = busBuffer.data() + static_cast<size_t>(j) * s->channels;
+
+						if(s->stagedFrames[slot] == f)
+							std::memcpy(pTarget, s->staging.data() + slot * s->channels, s->channels * sizeof(float));
+						else
+							std::memset(pTarget, 0, s->channels * sizeof(float));
+					}
+
+					s->ring.write(busBuffer.data(), static_cast<size_t>(count) * s->channels);
+					done += count;
+				}
 			}
+		}
+
+		io_command command = { io_command_type_data, stemMask, frameCount, pcm_format_s16, false };
+		commands.try_enqueue(command);
+		return true;
+	}
+
+	void audio_recorder::io_loop()
+	{
+		io_command command;
+		io_command nextCommand;
+		bool hasNextCommand = false;
 
-			stream.close();
+		while(true)
+		{
+			if(hasNextCommand)
+			{
+				command = nextCommand;
+				hasNextCommand = false;
+			}
+			else if(!commands.try_dequeue(command))
+			{
+				if(!running.load())
+					break;
+
+				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+				continue;
+			}
+
+			switch(command.type)
+			{
+				case io_command_type_open:
+				{
+					io_close();
+					sessionName = wav_writer::create_file_name("");
+					sessionFormat = command.format;
+					sessionDither = command.dither;
+					sessionFrames = 0;
+					break;
+				}
+				case io_command_type_data:
+				{
+					// Merge consecutive blocks for the same stems into one write per file
+					while(commands.try_dequeue(nextCommand))
+					{
+						if(nextCommand.type != io_command_type_data || nextCommand.stemMask != command.stemMask)
+						{
+							hasNextCommand = true;
+							break;
+						}
+
+						command.frameCount += nextCommand.frameCount;
+					}
+
+					io_write(command);
+					break;
+				}
+				case io_command_type_close:
+				{
+					io_close();
+					sessionsClosed.fetch_add(1, std::memory_order_release);
+					break;
+				}
+			}
 		}
 
-		set_state(recorder_state_idle);
+		io_close();
 	}
 
-	void audio_recorder::write_int16(int16_t value, uint8_t *buffer, int32_t offset)
+	void audio_recorder::io_write(const io_command &command)
 	{
-		int16_t *pBuffer = reinterpret_cast<int16_t*>(&buffer[offset]);
-		*pBuffer = value;
+		for(uint32_t i = 0; i < maxStems; i++)
+		{
+			if(!(command.stemMask & (1 << i)))
+				continue;
+
+			stem *s = stems[i].get();
+			const uint32_t channels = s->channels;
+			const uint64_t framesPerChunk = ioBuffer.size() / channels;
+
+			if(!s->writer.is_open())
+			{
+				s->framesWritten = 0;
+
+				if(s->writer.open(get_stem_file_name(*s), sampleRate.load(), channels, sessionFormat, sessionDither))
+				{
+					// A bus that shows up halfway the session is padded so all stems start together
+					std::fill(ioBuffer.begin(), ioBuffer.end(), 0.0f);
+
+					while(s->framesWritten < sessionFrames)
+					{
+						const uint64_t n = std::min(framesPerChunk, sessionFrames - s->framesWritten);
+						s->writer.write(ioBuffer.data(), static_cast<uint32_t>(n));
+						s->framesWritten += n;
+					}
+				}
+			}
+
+			uint64_t remaining = command.frameCount;
+
+			while(remaining > 0)
+			{
+				const uint64_t n = std::min(framesPerChunk, remaining);
+				s->ring.read(ioBuffer.data(), n * channels);
+
+				if(s->writer.is_open())
+				{
+					s->writer.write(ioBuffer.data(), static_cast<uint32_t>(n));
+					s->framesWritten += n;
+				}
+
+				remaining -= n;
+			}
+		}
+
+		sessionFrames += command.frameCount;
 	}
 
-	void audio_recorder::write_int32(int32_t value, uint8_t *buffer, int32_t offset)
+	void audio_recorder::io_close()
 	{
-		int32_t *pBuffer = reinterpret_cast<int32_t*>(&buffer[offset]);
-		*pBuffer = value;
+		for(uint32_t i = 0; i < maxStems; i++)
+		{
+			stems[i]->writer.close();
+			stems[i]->framesWritten = 0;
+		}
+
+		sessionFrames = 0;
 	}
 
-	void audio_recorder::write_float(float value, uint8_t *buffer, int32_t offset)
+	std::string audio_recorder::get_stem_file_name(const stem &s) const
 	{
-		float *pBuffer = reinterpret_cast<float*>(&buffer[offset]);
-		*pBuffer = value;
+		if(&s == stems[stem_index_mix].get())
+			return sessionName;
+
+		std::string suffix = "_";
+
+		for(const char *p = s.name; *p != '\0'; p++)
+		{
+			const char c = *p;
+			suffix += (std::isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_') ? c : '_';
+		}
+
+		// sessionName always ends with .wav
+		return sessionName.substr(0, sessionName.size() - 4) + suffix + ".wav";
 	}
-}
\ No newline at end of file
+}
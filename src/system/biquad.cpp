@@ -0,0 +1,158 @@
+#include "biquad.hpp"
+#include "simd.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace luadio
+{
+	void biquad::set(filter_type type, float frequency, float q, float gainDecibels, float sampleRate)
+	{
+		// Coefficients are computed in double, low cutoffs lose a lot of precision in float
+		const double w0 = 2.0 * 3.14159265358979323846 * std::clamp<double>(frequency, 1.0, sampleRate * 0.49) / sampleRate;
+		const double cosW0 = std::cos(w0);
+		const double alpha = std::sin(w0) / (2.0 * std::max<double>(q, 0.01));
+		const double A = std::pow(10.0, gainDecibels / 40.0);
+		const double shelfAlpha = 2.0 * std::sqrt(A) * alpha;
+
+		double nb0, nb1, nb2, na0, na1, na2;
+
+		switch(type)
+		{
+			case filter_type_highpass:
+				nb0 = (1.0 + cosW0) / 2.0;
+				nb1 = -(1.0 + cosW0);
+				nb2 = (1.0 + cosW0) / 2.0;
+				na0 = 1.0 + alpha;
+				na1 = -2.0 * cosW0;
+				na2 = 1.0 - alpha;
+				break;
+			case filter_type_bandpass:
+				nb0 = alpha;
+				nb1 = 0.0;
+				nb2 = -alpha;
+				na0 = 1.0 + alpha;
+				na1 = -2.0 * cosW0;
+				na2 = 1.0 - alpha;
+				break;
+			case filter_type_notch:
+				nb0 = 1.0;
+				nb1 = -2.0 * cosW0;
+				nb2 = 1.0;
+				na0 = 1.0 + alpha;
+				na1 = -2.0 * cosW0;
+				na2 = 1.0 - alpha;
+				break;
+			case filter_type_allpass:
+				nb0 = 1.0 - alpha;
+				nb1 = -2.0 * cosW0;
+				nb2 = 1.0 + alpha;
+				na0 = 1.0 + alpha;
+				na1 = -2.0 * cosW0;
+				na2 = 1.0 - alpha;
+				break;
+			case filter_type_peak:
+				nb0 = 1.0 + alpha * A;
+				nb1 = -2.0 * cosW0;
+				nb2 = 1.0 - alpha * A;
+				na0 = 1.0 + alpha / A;
+				na1 = -2.0 * cosW0;
+				na2 = 1.0 - alpha / A;
+				break;
+			case filter_type_lowshelf:
+				nb0 = A * ((A + 1.0) - (A - 1.0) * cosW0 + shelfAlpha);
+				nb1 = 2.0 * A * ((A - 1.0) - (A + 1.0) * cosW0);
+				nb2 = A * ((A + 1.0) - (A - 1.0) * cosW0 - shelfAlpha);
+				na0 = (A + 1.0) + (A - 1.0) * cosW0 + shelfAlpha;
+				na1 = -2.0 * ((A - 1.0) + (A + 1.0) * cosW0);
+				na2 = (A + 1.0) + (A - 1.0) * cosW0 - shelfAlpha;
+				break;
+			case filter_type_highshelf:
+				nb0 = A * ((A + 1.0) + (A - 1.0) * cosW0 + shelfAlpha);
+				nb1 = -2.0 * A * ((A - 1.0) + (A + 1.0) * cosW0);
+				nb2 = A * ((A + 1.0) + (A - 1.0) * cosW0 - shelfAlpha);
+				na0 = (A + 1.0) - (A - 1.0) * cosW0 + shelfAlpha;
+				na1 = 2.0 * ((A - 1.0) - (A + 1.0) * cosW0);
+				na2 = (A + 1.0) - (A - 1.0) * cosW0 - shelfAlpha;
+				break;
+			default:
+				nb0 = (1.0 - cosW0) / 2.0;
+				nb1 = 1.0 - cosW0;
+				nb2 = (1.0 - cosW0) / 2.0;
+				na0 = 1.0 + alpha;
+				na1 = -2.0 * cosW0;
+				na2 = 1.0 - alpha;
+				break;
+		}
+
+		b0 = static_cast<float>(nb0 / na0);
+		b1 = static_cast<float>(nb1 / na0);
+		b2 = static_cast<float>(nb2 / na0);
+		a1 = static_cast<float>(na1 / na0);
+		a2 = static_cast<float>(na2 / na0);
+	}
+
+	void biquad::reset()
+	{
+		std::fill(z1, z1 + maxChannels, 0.0f);
+		std::fill(z2, z2 + maxChannels, 0.0f);
+	}
+
+	void biquad::process(const float *pInput, float *pOutput, size_t frameCount, uint32_t channels)
+	{
+		const uint32_t stride = channels;
+		channels = std::min(channels, maxChannels);
+		uint32_t c = 0;
+
+#if defined(LUADIO_SIMD_SSE2)
+		// The recursion is serial in time, so the vector runs across channels instead
+		const __m128 vb0 = _mm_set1_ps(b0);
+		const __m128 vb1 = _mm_set1_ps(b1);
+		const __m128 vb2 = _mm_set1_ps(b2);
+		const __m128 va1 = _mm_set1_ps(a1);
+		const __m128 va2 = _mm_set1_ps(a2);
+
+		for( ; c < channels; c += 4)
+		{
+			const uint32_t lanes = std::min<uint32_t>(4, channels - c);
+			__m128 s1 = _mm_loadu_ps(&z1[c]);
+			__m128 s2 = _mm_loadu_ps(&z2[c]);
+
+			for(size_t i = 0; i < frameCount; i++)
+			{
+				const __m128 x = simd_load_lanes(pInput + i * stride + c, lanes);
+				const __m128 y = _mm_add_ps(_mm_mul_ps(vb0, x), s1);
+				s1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(vb1, x), _mm_mul_ps(va1, y)), s2);
+				s2 = _mm_sub_ps(_mm_mul_ps(vb2, x), _mm_mul_ps(va2, y));
+				simd_store_lanes(pOutput + i * stride + c, y, lanes);
+			}
+
+			_mm_storeu_ps(&z1[c], s1);
+			_mm_storeu_ps(&z2[c], s2);
+		}
+#endif
+
+		for( ; c < channels; c++)
+		{
+			float s1 = z1[c];
+			float s2 = z2[c];
+
+			for(size_t i = 0; i < frameCount; i++)
+			{
+				const float x = pInput[i * stride + c];
+				const float y = b0 * x + s1;
+				s1 = b1 * x - a1 * y + s2;
+				s2 = b2 * x - a2 * y;
+				pOutput[i * stride + c] = y;
+			}
+
+			z1[c] = s1;
+			z2[c] = s2;
+		}
+	}
+
+	void biquad::process_cascade(biquad *pStages, uint32_t stageCount, const float *pInput, float *pOutput, size_t frameCount, uint32_t channels)
+	{
+		for(uint32_t i = 0; i < stageCount; i++)
+			pStages[i].process(i == 0 ? pInput : pOutput, pOutput, frameCount, channels);
+	}
+}
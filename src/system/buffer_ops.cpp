@@ -0,0 +1,403 @@
+#include "buffer_ops.hpp"
+#include "simd.hpp"
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+
+namespace luadio
+{
+	void buffer_ops::clear(float *pDst, size_t count)
+	{
+		std::memset(pDst, 0, count * sizeof(float));
+	}
+
+	void buffer_ops::copy(float *pDst, const float *pSrc, size_t count)
+	{
+		if(pDst != pSrc)
+			std::memmove(pDst, pSrc, count * sizeof(float));
+	}
+
+	void buffer_ops::gain(float *pDst, const float *pSrc, float gain, size_t count)
+	{
+		size_t i = 0;
+
+#if defined(LUADIO_SIMD_AVX2)
+		const __m256 g8 = _mm256_set1_ps(gain);
+
+		for( ; i + 8 <= count; i += 8)
+			_mm256_storeu_ps(pDst + i, _mm256_mul_ps(_mm256_loadu_ps(pSrc + i), g8));
+#endif
+#if defined(LUADIO_SIMD_SSE2)
+		const __m128 g4 = _mm_set1_ps(gain);
+
+		for( ; i + 4 <= count; i += 4)
+			_mm_storeu_ps(pDst + i, _mm_mul_ps(_mm_loadu_ps(pSrc + i), g4));
+#endif
+
+		for( ; i < count; i++)
+			pDst[i] = pSrc[i] * gain;
+	}
+
+	void buffer_ops::gain_ramp(float *pDst, const float *pSrc, float startGain, float endGain, size_t count)
+	{
+		if(count == 0)
+			return;
+
+		const float step = (endGain - startGain) / count;
+		size_t i = 0;
+
+#if defined(LUADIO_SIMD_AVX2)
+		__m256 g8 = _mm256_add_ps(_mm256_set1_ps(startGain), _mm256_mul_ps(_mm256_set1_ps(step), _mm256_set_ps(7, 6, 5, 4, 3, 2, 1, 0)));
+		const __m256 step8 = _mm256_set1_ps(step * 8);
+
+		for( ; i + 8 <= count; i += 8)
+		{
+			_mm256_storeu_ps(pDst + i, _mm256_mul_ps(_mm256_loadu_ps(pSrc + i), g8));
+			g8 = _mm256_add_ps(g8, step8);
+		}
+#endif
+#if defined(LUADIO_SIMD_SSE2)
+		// Recomputed from i so the ramp does not drift when the AVX2 loop ran first
+		__m128 g4 = _mm_add_ps(_mm_set1_ps(startGain + step * i), _mm_mul_ps(_mm_set1_ps(step), _mm_set_ps(3, 2, 1, 0)));
+		const __m128 step4 = _mm_set1_ps(step * 4);
+
+		for( ; i + 4 <= count; i += 4)
+		{
+			_mm_storeu_ps(pDst + i, _mm_mul_ps(_mm_loadu_ps(pSrc + i), g4));
+			g4 = _mm_add_ps(g4, step4);
+		}
+#endif
+
+		for( ; i < count; i++)
+			pDst[i] = pSrc[i] * (startGain + step * i);
+	}
+
+	void buffer_ops::accumulate(float *pDst, const float *pSrc, float gain, size_t count)
+	{
+		size_t i = 0;
+
+#if defined(LUADIO_SIMD_AVX2)
+		const __m256 g8 = _mm256_set1_ps(gain);
+
+		for( ; i + 8 <= count; i += 8)
+			_mm256_storeu_ps(pDst + i, _mm256_add_ps(_mm256_loadu_ps(pDst + i), _mm256_mul_ps(_mm256_loadu_ps(pSrc + i), g8)));
+#endif
+#if defined(LUADIO_SIMD_SSE2)
+		const __m128 g4 = _mm_set1_ps(gain);
+
+		for( ; i + 4 <= count; i += 4)
+			_mm_storeu_ps(pDst + i, _mm_add_ps(_mm_loadu_ps(pDst + i), _mm_mul_ps(_mm_loadu_ps(pSrc + i), g4)));
+#endif
+
+		for( ; i < count; i++)
+			pDst[i] += pSrc[i] * gain;
+	}
+
+	void buffer_ops::mix(float *pDst, const float *pA, float gainA, const float *pB, float gainB, size_t count)
+	{
+		size_t i = 0;
+
+#if defined(LUADIO_SIMD_AVX2)
+		const __m256 a8 = _mm256_set1_ps(gainA);
+		const __m256 b8 = _mm256_set1_ps(gainB);
+
+		for( ; i + 8 <= count; i += 8)
+			_mm256_storeu_ps(pDst + i, _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(pA + i), a8), _mm256_mul_ps(_mm256_loadu_ps(pB + i), b8)));
+#endif
+#if defined(LUADIO_SIMD_SSE2)
+		const __m128 a4 = _mm_set1_ps(gainA);
+		const __m128 b4 = _mm_set1_ps(gainB);
+
+		for( ; i + 4 <= count; i += 4)
+			_mm_storeu_ps(pDst + i, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(pA + i), a4), _mm_mul_ps(_mm_loadu_ps(pB + i), b4)));
+#endif
+
+		for( ; i < count; i++)
+			pDst[i] = pA[i] * gainA + pB[i] * gainB;
+	}
+
+	void buffer_ops::clip(float *pDst, const float *pSrc, float minimum, float maximum, size_t count)
+	{
+		size_t i = 0;
+
+#if defined(LUADIO_SIMD_AVX2)
+		const __m256 min8 = _mm256_set1_ps(minimum);
+		const __m256 max8 = _mm256_set1_ps(maximum);
+
+		for( ; i + 8 <= count; i += 8)
+			_mm256_storeu_ps(pDst + i, _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(pSrc + i), min8), max8));
+#endif
+#if defined(LUADIO_SIMD_SSE2)
+		const __m128 min4 = _mm_set1_ps(minimum);
+		const __m128 max4 = _mm_set1_ps(maximum);
+
+		for( ; i + 4 <= count; i += 4)
+			_mm_storeu_ps(pDst + i, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(pSrc + i), min4), max4));
+#endif
+
+		for( ; i < count; i++)
+			pDst[i] = std::min(std::max(pSrc[i], minimum), maximum);
+	}
+
+	void buffer_ops::pan(float *pDst, const float *pSrc, float pan, size_t frameCount)
+	{
+		float left, right;
+		get_pan_gains(pan, left, right);
+		size_t i = 0;
+
+#if defined(LUADIO_SIMD_SSE2)
+		const __m128 gains = _mm_set_ps(right, left, right, left);
+
+		for( ; i + 4 <= frameCount; i += 4)
+		{
+			const __m128 mono = _mm_loadu_ps(pSrc + i);
+			_mm_storeu_ps(pDst + i * 2, _mm_mul_ps(_mm_unpacklo_ps(mono, mono), gains));
+			_mm_storeu_ps(pDst + i * 2 + 4, _mm_mul_ps(_mm_unpackhi_ps(mono, mono), gains));
+		}
+#endif
+
+		for( ; i < frameCount; i++)
+		{
+			pDst[i * 2] = pSrc[i] * left;
+			pDst[i * 2 + 1] = pSrc[i] * right;
+		}
+	}
+
+	void buffer_ops::balance(float *pDst, const float *pSrc, float pan, size_t frameCount)
+	{
+		float left, right;
+		get_pan_gains(pan, left, right);
+
+		// Normalized so the center position leaves the signal untouched
+		left *= std::sqrt(2.0f);
+		right *= std::sqrt(2.0f);
+
+		const size_t count = frameCount * 2;
+		size_t i = 0;
+
+#if defined(LUADIO_SIMD_AVX2)
+		const __m256 g8 = _mm256_set_ps(right, left, right, left, right, left, right, left);
+
+		for( ; i + 8 <= count; i += 8)
+			_mm256_storeu_ps(pDst + i, _mm256_mul_ps(_mm256_loadu_ps(pSrc + i), g8));
+#endif
+#if defined(LUADIO_SIMD_SSE2)
+		const __m128 g4 = _mm_set_ps(right, left, right, left);
+
+		for( ; i + 4 <= count; i += 4)
+			_mm_storeu_ps(pDst + i, _mm_mul_ps(_mm_loadu_ps(pSrc + i), g4));
+#endif
+
+		for( ; i < count; i += 2)
+		{
+			pDst[i] = pSrc[i] * left;
+			pDst[i + 1] = pSrc[i + 1] * right;
+		}
+	}
+
+	void buffer_ops::interleave(float *pDst, const float *pSrc, size_t frameCount, uint32_t channels)
+	{
+		if(channels == 1)
+		{
+			copy(pDst, pSrc, frameCount);
+			return;
+		}
+
+		size_t i = 0;
+
+		if(channels == 2)
+		{
+			const float *pLeft = pSrc;
+			const float *pRight = pSrc + frameCount;
+
+#if defined(LUADIO_SIMD_SSE2)
+			for( ; i + 4 <= frameCount; i += 4)
+			{
+				const __m128 l = _mm_loadu_ps(pLeft + i);
+				const __m128 r = _mm_loadu_ps(pRight + i);
+				_mm_storeu_ps(pDst + i * 2, _mm_unpacklo_ps(l, r));
+				_mm_storeu_ps(pDst + i * 2 + 4, _mm_unpackhi_ps(l, r));
+			}
+#endif
+
+			for( ; i < frameCount; i++)
+			{
+				pDst[i * 2] = pLeft[i];
+				pDst[i * 2 + 1] = pRight[i];
+			}
+
+			return;
+		}
+
+		for(uint32_t c = 0; c < channels; c++)
+		{
+			const float *pChannel = pSrc + c * frameCount;
+
+			for(i = 0; i < frameCount; i++)
+				pDst[i * channels + c] = pChannel[i];
+		}
+	}
+
+	void buffer_ops::deinterleave(float *pDst, const float *pSrc, size_t frameCount, uint32_t channels)
+	{
+		if(channels == 1)
+		{
+			copy(pDst, pSrc, frameCount);
+			return;
+		}
+
+		size_t i = 0;
+
+		if(channels == 2)
+		{
+			float *pLeft = pDst;
+			float *pRight = pDst + frameCount;
+
+#if defined(LUADIO_SIMD_SSE2)
+			for( ; i + 4 <= frameCount; i += 4)
+			{
+				const __m128 a = _mm_loadu_ps(pSrc + i * 2);
+				const __m128 b = _mm_loadu_ps(pSrc + i * 2 + 4);
+				_mm_storeu_ps(pLeft + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+				_mm_storeu_ps(pRight + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+			}
+#endif
+
+			for( ; i < frameCount; i++)
+			{
+				pLeft[i] = pSrc[i * 2];
+				pRight[i] = pSrc[i * 2 + 1];
+			}
+
+			return;
+		}
+
+		for(uint32_t c = 0; c < channels; c++)
+		{
+			float *pChannel = pDst + c * frameCount;
+
+			for(i = 0; i < frameCount; i++)
+				pChannel[i] = pSrc[i * channels + c];
+		}
+	}
+
+	void buffer_ops::interleave(float *pDst, const float *const *ppSrc, size_t frameCount, uint32_t channels)
+	{
+		uint32_t c = 0;
+
+#if defined(LUADIO_SIMD_SSE2)
+		// Four channels at a time, each 4x4 tile of frames is transposed in registers
+		for( ; c + 4 <= channels; c += 4)
+		{
+			size_t i = 0;
+
+			for( ; i + 4 <= frameCount; i += 4)
+			{
+				__m128 a = _mm_loadu_ps(ppSrc[c] + i);
+				__m128 b = _mm_loadu_ps(ppSrc[c + 1] + i);
+				__m128 x = _mm_loadu_ps(ppSrc[c + 2] + i);
+				__m128 y = _mm_loadu_ps(ppSrc[c + 3] + i);
+				_MM_TRANSPOSE4_PS(a, b, x, y);
+				_mm_storeu_ps(pDst + i * channels + c, a);
+				_mm_storeu_ps(pDst + (i + 1) * channels + c, b);
+				_mm_storeu_ps(pDst + (i + 2) * channels + c, x);
+				_mm_storeu_ps(pDst + (i + 3) * channels + c, y);
+			}
+
+			for( ; i < frameCount; i++)
+			{
+				for(uint32_t k = 0; k < 4; k++)
+					pDst[i * channels + c + k] = ppSrc[c + k][i];
+			}
+		}
+#endif
+
+		for( ; c < channels; c++)
+		{
+			const float *pChannel = ppSrc[c];
+
+			for(size_t i = 0; i < frameCount; i++)
+				pDst[i * channels + c] = pChannel[i];
+		}
+	}
+
+	void buffer_ops::deinterleave(float *const *ppDst, const float *pSrc, size_t frameCount, uint32_t channels)
+	{
+		uint32_t c = 0;
+
+#if defined(LUADIO_SIMD_SSE2)
+		for( ; c + 4 <= channels; c += 4)
+		{
+			size_t i = 0;
+
+			for( ; i + 4 <= frameCount; i += 4)
+			{
+				__m128 a = _mm_loadu_ps(pSrc + i * channels + c);
+				__m128 b = _mm_loadu_ps(pSrc + (i + 1) * channels + c);
+				__m128 x = _mm_loadu_ps(pSrc + (i + 2) * channels + c);
+				__m128 y = _mm_loadu_ps(pSrc + (i + 3) * channels + c);
+				_MM_TRANSPOSE4_PS(a, b, x, y);
+				_mm_storeu_ps(ppDst[c] + i, a);
+				_mm_storeu_ps(ppDst[c + 1] + i, b);
+				_mm_storeu_ps(ppDst[c + 2] + i, x);
+				_mm_storeu_ps(ppDst[c + 3] + i, y);
+			}
+
+			for( ; i < frameCount; i++)
+			{
+				for(uint32_t k = 0; k < 4; k++)
+					ppDst[c + k][i] = pSrc[i * channels + c + k];
+			}
+		}
+#endif
+
+		for( ; c < channels; c++)
+		{
+			float *pChannel = ppDst[c];
+
+			for(size_t i = 0; i < frameCount; i++)
+				pChannel[i] = pSrc[i * channels + c];
+		}
+	}
+
+	float buffer_ops::get_peak(const float *pSrc, size_t count)
+	{
+		float peak = 0.0f;
+		size_t i = 0;
+
+#if defined(LUADIO_SIMD_AVX2)
+		const __m256 absMask8 = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+		__m256 peak8 = _mm256_setzero_ps();
+
+		for( ; i + 8 <= count; i += 8)
+			peak8 = _mm256_max_ps(peak8, _mm256_and_ps(_mm256_loadu_ps(pSrc + i), absMask8));
+
+		alignas(32) float peaks8[8];
+		_mm256_store_ps(peaks8, peak8);
+		peak = *std::max_element(peaks8, peaks8 + 8);
+#endif
+#if defined(LUADIO_SIMD_SSE2)
+		const __m128 absMask4 = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+		__m128 peak4 = _mm_set1_ps(peak);
+
+		for( ; i + 4 <= count; i += 4)
+			peak4 = _mm_max_ps(peak4, _mm_and_ps(_mm_loadu_ps(pSrc + i), absMask4));
+
+		alignas(16) float peaks4[4];
+		_mm_store_ps(peaks4, peak4);
+		peak = *std::max_element(peaks4, peaks4 + 4);
+#endif
+
+		for( ; i < count; i++)
+			peak = std::max(peak, std::abs(pSrc[i]));
+
+		return peak;
+	}
+
+	void buffer_ops::get_pan_gains(float pan, float &left, float &right)
+	{
+		const float angle = (std::clamp(pan, -1.0f, 1.0f) + 1.0f) * 0.25f * 3.14159265358979f;
+		left = std::cos(angle);
+		right = std::sin(angle);
+	}
+}
@@ -0,0 +1,317 @@
+#include "convolution_engine.hpp"
+#include "audio_file.hpp"
+#include <algorithm>
+#include <chrono>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+
+namespace luadio
+{
+	// Partitions accumulated per step of an inline segment, about the cost of one transform
+	static constexpr uint32_t partitionsPerStep = 8;
+
+	convolution_engine::convolution_engine(uint32_t channels, uint32_t blockSize)
+	{
+		if(channels == 0)
+			throw std::invalid_argument("channels must be greater than 0");
+
+		this->channels = channels;
+		this->blockSize = std::bit_ceil(std::clamp<uint32_t>(blockSize, 64, 8192));
+		blockPosition = 0;
+		inputBlock.assign(static_cast<size_t>(channels) * this->blockSize, 0.0f);
+		outputBlock.assign(static_cast<size_t>(channels) * this->blockSize, 0.0f);
+		scratch.resize(this->blockSize);
+		status.store(convolution_status_loading);
+		running.store(false);
+		lateBlocks.store(0);
+	}
+
+	convolution_engine::~convolution_engine()
+	{
+		// The loader starts the worker, so it has to be finished first
+		if(loader.joinable())
+			loader.join();
+
+		running.store(false);
+
+		if(worker.joinable())
+			worker.join();
+	}
+
+	void convolution_engine::load(const std::string &filePath, uint32_t sampleRate)
+	{
+		loader = std::thread([this, filePath, sampleRate] () {
+			std::vector<float> impulse;
+			uint32_t irChannels = 0;
+
+			if(!audio_file::read(filePath, sampleRate, impulse, irChannels) || irChannels == 0)
+			{
+				status.store(convolution_status_failed);
+				return;
+			}
+
+			prepare(impulse.data(), impulse.size() / irChannels, irChannels);
+		});
+	}
+
+	void convolution_engine::load(const float *pImpulse, size_t frameCount, uint32_t irChannels)
+	{
+		if(pImpulse == nullptr || irChannels == 0)
+		{
+			status.store(convolution_status_failed);
+			return;
+		}
+
+		prepare(pImpulse, frameCount, irChannels);
+	}
+
+	void convolution_engine::process(const float *pInput, float *pOutput, uint32_t frameCount, uint32_t channels)
+	{
+		if(status.load(std::memory_order_acquire) != convolution_status_ready)
+		{
+			std::memset(pOutput, 0, static_cast<size_t>(frameCount) * channels * sizeof(float));
+			return;
+		}
+
+		for(uint32_t i = 0; i < frameCount; i++)
+		{
+			for(uint32_t c = 0; c < this->channels; c++)
+			{
+				const size_t index = static_cast<size_t>(c) * blockSize + blockPosition;
+				inputBlock[index] = c < channels ? pInput[i * channels + c] : 0.0f;
+
+				if(c < channels)
+					pOutput[i * channels + c] = outputBlock[index];
+			}
+
+			for(uint32_t c = this->channels; c < channels; c++)
+				pOutput[i * channels + c] = 0.0f;
+
+			if(++blockPosition == blockSize)
+			{
+				process_block();
+				blockPosition = 0;
+			}
+		}
+	}
+
+	convolution_status convolution_engine::get_status() const
+	{
+		return status.load();
+	}
+
+	uint32_t convolution_engine::get_latency() const
+	{
+		return blockSize;
+	}
+
+	uint64_t convolution_engine::get_late_blocks() const
+	{
+		return lateBlocks.load();
+	}
+
+	void convolution_engine::prepare(const float *pImpulse, size_t frameCount, uint32_t irChannels)
+	{
+		if(frameCount == 0)
+		{
+			status.store(convolution_status_failed);
+			return;
+		}
+
+		const uint32_t middlePartition = blockSize * 16;
+		const uint32_t middleOffset = middlePartition * 2;
+		const uint32_t tailPartition = std::max<uint32_t>(8192, middleOffset * 2);
+		const uint32_t tailOffset = tailPartition * 2;
+
+		try
+		{
+			add_segment(0, blockSize, std::min<size_t>(frameCount, middleOffset), pImpulse, irChannels, false);
+
+			if(frameCount > middleOffset)
+				add_segment(middleOffset, middlePartition, std::min<size_t>(frameCount, tailOffset) - middleOffset, pImpulse, irChannels, false);
+
+			if(frameCount > tailOffset)
+				add_segment(tailOffset, tailPartition, frameCount - tailOffset, pImpulse, irChannels, true);
+		}
+		catch(const std::exception&)
+		{
+			segments.clear();
+			status.store(convolution_status_failed);
+			return;
+		}
+
+		if(segments.back()->threaded)
+		{
+			running.store(true);
+			worker = std::thread(&convolution_engine::run, this);
+		}
+
+		status.store(convolution_status_ready, std::memory_order_release);
+	}
+
+	void convolution_engine::add_segment(uint32_t offset, uint32_t partitionSize, size_t length, const float *pImpulse, uint32_t irChannels, bool threaded)
+	{
+		auto s = std::make_unique<segment>();
+		s->offset = offset;
+		s->partitionSize = partitionSize;
+		s->threaded = threaded;
+		s->inputPosition = 0;
+		s->blockIndex = 0;
+		s->outputChunk.resize(partitionSize);
+		s->outputDebt.assign(channels, 0);
+
+		// Output is due offset frames after the input, so the queue starts with that much silence
+		const std::vector<float> silence(offset, 0.0f);
+
+		for(uint32_t c = 0; c < channels; c++)
+		{
+			// Output channels beyond the impulse response reuse its last channel
+			const uint32_t irChannel = std::min(c, irChannels - 1);
+			const float *pChannel = pImpulse + static_cast<size_t>(offset) * irChannels + irChannel;
+			s->convolvers.push_back(std::make_unique<uniform_convolver>(partitionSize, pChannel, length, irChannels));
+
+			if(threaded)
+			{
+				s->inputQueues.push_back(std::make_unique<spsc_queue<float>>(std::bit_ceil(static_cast<size_t>(partitionSize) * 4)));
+			}
+			else
+			{
+				s->inputChunks.emplace_back(partitionSize, 0.0f);
+				s->pendingChunks.emplace_back(partitionSize, 0.0f);
+			}
+
+			s->outputQueues.push_back(std::make_unique<spsc_queue<float>>(std::bit_ceil(static_cast<size_t>(offset) + partitionSize * 2 + blockSize)));
+			s->outputQueues.back()->write(silence.data(), silence.size());
+		}
+
+		// One step begins the partition, one step per few filter partitions accumulates, one finishes it
+		s->stepsPerChannel = (s->convolvers[0]->get_partition_count() + partitionsPerStep - 1) / partitionsPerStep + 2;
+		s->stepCount = s->stepsPerChannel * channels;
+		s->step = s->stepCount;
+
+		segments.push_back(std::move(s));
+	}
+
+	void convolution_engine::process_block()
+	{
+		for(auto &s : segments)
+		{
+			if(s->threaded)
+			{
+				for(uint32_t c = 0; c < channels; c++)
+					s->inputQueues[c]->write(&inputBlock[static_cast<size_t>(c) * blockSize], blockSize);
+
+				continue;
+			}
+
+			for(uint32_t c = 0; c < channels; c++)
+				std::copy_n(&inputBlock[static_cast<size_t>(c) * blockSize], blockSize, &s->inputChunks[c][s->inputPosition]);
+
+			s->inputPosition += blockSize;
+
+			if(s->inputPosition == s->partitionSize)
+			{
+				// Every step of the previous partition ran by now
+				std::swap(s->inputChunks, s->pendingChunks);
+				s->inputPosition = 0;
+				s->blockIndex = 0;
+				s->step = 0;
+			}
+
+			if(s->step == s->stepCount)
+				continue;
+
+			// Each block runs its share of the steps, the last block of the partition finishes them.
+			// The output of the head is due right away, its partition is one block so it does all steps at once.
+			const uint32_t blocksPerPartition = s->partitionSize / blockSize;
+			s->blockIndex++;
+			const uint32_t target = (s->stepCount * s->blockIndex + blocksPerPartition - 1) / blocksPerPartition;
+
+			while(s->step < target)
+				run_step(*s, s->step++);
+		}
+
+		std::fill(outputBlock.begin(), outputBlock.end(), 0.0f);
+		bool late = false;
+
+		for(auto &s : segments)
+		{
+			for(uint32_t c = 0; c < channels; c++)
+			{
+				spsc_queue<float> &queue = *s->outputQueues[c];
+
+				// Catch up on samples that were replaced by silence before
+				if(s->outputDebt[c] > 0)
+					s->outputDebt[c] -= queue.skip(s->outputDebt[c]);
+
+				const size_t framesRead = queue.read(scratch.data(), blockSize);
+
+				if(framesRead < blockSize)
+				{
+					s->outputDebt[c] += blockSize - framesRead;
+					late = true;
+				}
+
+				float *pOutput = &outputBlock[static_cast<size_t>(c) * blockSize];
+
+				for(size_t i = 0; i < framesRead; i++)
+					pOutput[i] += scratch[i];
+			}
+		}
+
+		if(late)
+			lateBlocks.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void convolution_engine::run_step(segment &s, uint32_t step)
+	{
+		const uint32_t c = step / s.stepsPerChannel;
+		const uint32_t index = step % s.stepsPerChannel;
+		uniform_convolver &convolver = *s.convolvers[c];
+
+		if(index == 0)
+		{
+			convolver.begin(s.pendingChunks[c].data());
+		}
+		else if(index == s.stepsPerChannel - 1)
+		{
+			convolver.finish(s.outputChunk.data());
+			s.outputQueues[c]->write(s.outputChunk.data(), s.partitionSize);
+		}
+		else
+		{
+			convolver.accumulate((index - 1) * partitionsPerStep, partitionsPerStep);
+		}
+	}
+
+	void convolution_engine::run()
+	{
+		segment &s = *segments.back();
+		std::vector<float> chunk(s.partitionSize);
+
+		while(running.load())
+		{
+			bool available = true;
+
+			for(uint32_t c = 0; c < channels; c++)
+			{
+				if(s.inputQueues[c]->size() < s.partitionSize || s.outputQueues[c]->get_free_space() < s.partitionSize)
+					available = false;
+			}
+
+			if(!available)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				continue;
+			}
+
+			for(uint32_t c = 0; c < channels; c++)
+			{
+				s.inputQueues[c]->read(chunk.data(), s.partitionSize);
+				s.convolvers[c]->process(chunk.data(), s.outputChunk.data());
+				s.outputQueues[c]->write(s.outputChunk.data(), s.partitionSize);
+			}
+		}
+	}
+}
@@ -0,0 +1,105 @@
+#include "delay_line.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace luadio
+{
+	delay_line::delay_line(uint32_t maxDelayFrames, uint32_t channels)
+	{
+		// Room for the interpolation neighbours on both sides of the longest delay
+		length = std::bit_ceil(std::max<uint32_t>(maxDelayFrames, 1) + 4);
+		mask = length - 1;
+		writePosition = 0;
+		this->channels = std::max<uint32_t>(channels, 1);
+		pBuffer = new float[static_cast<size_t>(length) * this->channels]();
+	}
+
+	delay_line::~delay_line()
+	{
+		delete[] pBuffer;
+	}
+
+	void delay_line::reset()
+	{
+		std::fill(pBuffer, pBuffer + static_cast<size_t>(length) * channels, 0.0f);
+		writePosition = 0;
+	}
+
+	uint32_t delay_line::get_max_delay() const
+	{
+		return length - 3;
+	}
+
+	void delay_line::process(const float *pInput, float *pOutput, size_t frameCount, float delayFrames, float feedback, interpolation_type interpolation)
+	{
+		for(size_t i = 0; i < frameCount; i++)
+		{
+			for(uint32_t c = 0; c < channels; c++)
+			{
+				const size_t index = i * channels + c;
+				const float input = pInput[index];
+				const float delayed = read(c, delayFrames, interpolation);
+				pBuffer[writePosition * channels + c] = input + feedback * delayed;
+				pOutput[index] = delayed;
+			}
+
+			writePosition = (writePosition + 1) & mask;
+		}
+	}
+
+	void delay_line::process_modulated(const float *pInput, float *pOutput, const float *pDelayFrames, size_t frameCount, float feedback, interpolation_type interpolation)
+	{
+		for(size_t i = 0; i < frameCount; i++)
+		{
+			for(uint32_t c = 0; c < channels; c++)
+			{
+				const size_t index = i * channels + c;
+				const float input = pInput[index];
+				const float delayed = read(c, pDelayFrames[i], interpolation);
+				pBuffer[writePosition * channels + c] = input + feedback * delayed;
+				pOutput[index] = delayed;
+			}
+
+			writePosition = (writePosition + 1) & mask;
+		}
+	}
+
+	float delay_line::read(uint32_t channel, float delayFrames, interpolation_type interpolation) const
+	{
+		// The current frame is written after reading, so the shortest delay is one frame,
+		// or two for cubic interpolation which also needs the newer neighbour
+		const float minimum = interpolation == interpolation_type_cubic ? 2.0f : 1.0f;
+		delayFrames = std::clamp(delayFrames, minimum, static_cast<float>(get_max_delay()));
+
+		const uint32_t whole = static_cast<uint32_t>(delayFrames);
+		const float t = delayFrames - whole;
+
+		auto at = [this, channel] (uint32_t delay) -> float {
+			return pBuffer[((writePosition - delay) & mask) * channels + channel];
+		};
+
+		switch(interpolation)
+		{
+			case interpolation_type_none:
+				return at(static_cast<uint32_t>(delayFrames + 0.5f));
+			case interpolation_type_linear:
+			{
+				const float y0 = at(whole);
+				return y0 + t * (at(whole + 1) - y0);
+			}
+			default:
+			{
+				// 4 point, 3rd order Hermite
+				const float ym1 = at(whole - 1);
+				const float y0 = at(whole);
+				const float y1 = at(whole + 1);
+				const float y2 = at(whole + 2);
+				const float c1 = 0.5f * (y1 - ym1);
+				const float c2 = ym1 - 2.5f * y0 + 2.0f * y1 - 0.5f * y2;
+				const float c3 = 0.5f * (y2 - ym1) + 1.5f * (y0 - y1);
+				return ((c3 * t + c2) * t + c1) * t + y0;
+			}
+		}
+	}
+}
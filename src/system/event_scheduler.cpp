@@ -0,0 +1,59 @@
+#include "event_scheduler.hpp"
+#include <algorithm>
+#include <limits>
+
+namespace luadio
+{
+	event_scheduler::event_scheduler()
+	{
+		heap.reserve(capacity);
+		sequence = 0;
+	}
+
+	bool event_scheduler::schedule(uint64_t frame, int32_t id)
+	{
+		if(heap.size() >= capacity)
+			return false;
+
+		heap.push_back({ frame, sequence++, id });
+		std::push_heap(heap.begin(), heap.end(), [] (const event &a, const event &b) { return is_before(b, a); });
+		return true;
+	}
+
+	bool event_scheduler::pop_due(uint64_t frame, int32_t &id, uint64_t &eventFrame)
+	{
+		if(heap.empty() || heap.front().frame > frame)
+			return false;
+
+		id = heap.front().id;
+		eventFrame = heap.front().frame;
+		std::pop_heap(heap.begin(), heap.end(), [] (const event &a, const event &b) { return is_before(b, a); });
+		heap.pop_back();
+		return true;
+	}
+
+	uint64_t event_scheduler::get_next_frame() const
+	{
+		if(heap.empty())
+			return std::numeric_limits<uint64_t>::max();
+		return heap.front().frame;
+	}
+
+	uint32_t event_scheduler::get_count() const
+	{
+		return static_cast<uint32_t>(heap.size());
+	}
+
+	void event_scheduler::clear()
+	{
+		heap.clear();
+		sequence = 0;
+	}
+
+	bool event_scheduler::is_before(const event &a, const event &b)
+	{
+		if(a.frame != b.frame)
+			return a.frame < b.frame;
+		return a.sequence < b.sequence;
+	}
+}
@@ -0,0 +1,307 @@
+#include "fft_plan.hpp"
+#include "simd.hpp"
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+
+namespace luadio
+{
+	static std::map<size_t,std::shared_ptr<const fft_plan>> gPlans;
+	static std::mutex gPlansMutex;
+
+#if defined(LUADIO_SIMD_SSE2)
+	// Multiplies two interleaved complex values by two twiddles given as duplicated real and imaginary parts
+	static inline __m128 complex_multiply_sse2(__m128 a, __m128 wr, __m128 wi)
+	{
+		const __m128 sign = _mm_set_ps(0.0f, -0.0f, 0.0f, -0.0f);
+		__m128 swapped = _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1));
+		return _mm_add_ps(_mm_mul_ps(a, wr), _mm_xor_ps(_mm_mul_ps(swapped, wi), sign));
+	}
+
+	static inline __m128 multiply_negative_i_sse2(__m128 a)
+	{
+		const __m128 sign = _mm_set_ps(-0.0f, 0.0f, -0.0f, 0.0f);
+		return _mm_xor_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)), sign);
+	}
+#endif
+
+#if defined(LUADIO_SIMD_AVX2)
+	static inline __m256 complex_multiply_avx2(__m256 a, __m256 wr, __m256 wi)
+	{
+		const __m256 sign = _mm256_set_ps(0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f);
+		__m256 swapped = _mm256_permute_ps(a, _MM_SHUFFLE(2, 3, 0, 1));
+		return _mm256_add_ps(_mm256_mul_ps(a, wr), _mm256_xor_ps(_mm256_mul_ps(swapped, wi), sign));
+	}
+
+	static inline __m256 multiply_negative_i_avx2(__m256 a)
+	{
+		const __m256 sign = _mm256_set_ps(-0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f);
+		return _mm256_xor_ps(_mm256_permute_ps(a, _MM_SHUFFLE(2, 3, 0, 1)), sign);
+	}
+#endif
+
+	fft_plan::fft_plan(size_t size)
+	{
+		if(size < 4 || (size & (size - 1)) != 0)
+			throw std::invalid_argument("size must be a power of two of at least 4");
+
+		this->size = size;
+		complexSize = size / 2;
+
+		size_t log2 = 0;
+		while((static_cast<size_t>(1) << log2) < complexSize)
+			log2++;
+
+		bitReverse.resize(complexSize);
+
+		for(size_t i = 0; i < complexSize; i++)
+		{
+			uint32_t reversed = 0;
+			for(size_t bit = 0; bit < log2; bit++)
+			{
+				if(i & (static_cast<size_t>(1) << bit))
+					reversed |= 1u << (log2 - 1 - bit);
+			}
+			bitReverse[i] = reversed;
+		}
+
+		// An odd number of radix-2 stages leaves one plain radix-2 pass at the start
+		radix2Pass = (log2 & 1) != 0;
+
+		size_t half = radix2Pass ? 2 : 1;
+
+		while(half * 4 <= complexSize)
+		{
+			pass p;
+			p.half = half;
+			p.twiddleOffset = twiddles.size();
+
+			// Layout per pass: W(2h)^j real, W(2h)^j imaginary, W(4h)^j real, W(4h)^j imaginary.
+			// Every value is stored twice so a vector load lines up with interleaved complex data.
+			twiddles.resize(twiddles.size() + half * 8);
+			float *pTwiddles = &twiddles[p.twiddleOffset];
+
+			for(size_t j = 0; j < half; j++)
+			{
+				const double angle1 = -2.0 * M_PI * static_cast<double>(j) / static_cast<double>(2 * half);
+				const double angle2 = -2.0 * M_PI * static_cast<double>(j) / static_cast<double>(4 * half);
+				pTwiddles[0 * half + 2 * j] = pTwiddles[0 * half + 2 * j + 1] = static_cast<float>(std::cos(angle1));
+				pTwiddles[2 * half + 2 * j] = pTwiddles[2 * half + 2 * j + 1] = static_cast<float>(std::sin(angle1));
+				pTwiddles[4 * half + 2 * j] = pTwiddles[4 * half + 2 * j + 1] = static_cast<float>(std::cos(angle2));
+				pTwiddles[6 * half + 2 * j] = pTwiddles[6 * half + 2 * j + 1] = static_cast<float>(std::sin(angle2));
+			}
+
+			passes.push_back(p);
+			half *= 4;
+		}
+
+		splitTwiddles.resize(complexSize / 2 + 1);
+
+		for(size_t k = 0; k < splitTwiddles.size(); k++)
+		{
+			const double angle = -2.0 * M_PI * static_cast<double>(k) / static_cast<double>(size);
+			splitTwiddles[k] = std::complex<float>(static_cast<float>(std::cos(angle)), static_cast<float>(std::sin(angle)));
+		}
+	}
+
+	size_t fft_plan::get_size() const
+	{
+		return size;
+	}
+
+	size_t fft_plan::get_bin_count() const
+	{
+		return complexSize + 1;
+	}
+
+	std::shared_ptr<const fft_plan> fft_plan::get(size_t size)
+	{
+		std::lock_guard<std::mutex> lock(gPlansMutex);
+
+		auto it = gPlans.find(size);
+
+		if(it != gPlans.end())
+			return it->second;
+
+		auto plan = std::make_shared<const fft_plan>(size);
+		gPlans[size] = plan;
+		return plan;
+	}
+
+	void fft_plan::forward(const float *pInput, std::complex<float> *pOutput) const
+	{
+		const size_t M = complexSize;
+
+		// Even samples become the real parts and odd samples the imaginary parts,
+		// stored in bit reversed order so the passes can run in place
+		for(size_t i = 0; i < M; i++)
+			pOutput[bitReverse[i]] = std::complex<float>(pInput[2 * i], pInput[2 * i + 1]);
+
+		transform(pOutput);
+
+		// Split the half size spectrum into the spectrum of the real signal
+		const std::complex<float> z0 = pOutput[0];
+		pOutput[0] = std::complex<float>(z0.real() + z0.imag(), 0.0f);
+		pOutput[M] = std::complex<float>(z0.real() - z0.imag(), 0.0f);
+
+		for(size_t k = 1; k <= M / 2; k++)
+		{
+			const std::complex<float> a = pOutput[k];
+			const std::complex<float> b = std::conj(pOutput[M - k]);
+			const std::complex<float> even = 0.5f * (a + b);
+			const std::complex<float> odd = std::complex<float>(0.0f, -0.5f) * (a - b);
+			const std::complex<float> t = splitTwiddles[k] * odd;
+			pOutput[k] = even + t;
+			pOutput[M - k] = std::conj(even - t);
+		}
+	}
+
+	void fft_plan::inverse(const std::complex<float> *pInput, float *pOutput) const
+	{
+		const size_t M = complexSize;
+		std::complex<float> *pData = reinterpret_cast<std::complex<float>*>(pOutput);
+
+		// Rebuild the half size spectrum. It is conjugated so the forward passes compute the inverse,
+		// and written in bit reversed order so the passes can run in place.
+		const float x0 = pInput[0].real();
+		const float xM = pInput[M].real();
+		pData[bitReverse[0]] = std::conj(std::complex<float>(0.5f * (x0 + xM), 0.5f * (x0 - xM)));
+
+		for(size_t k = 1; k <= M / 2; k++)
+		{
+			const std::complex<float> a = pInput[k];
+			const std::complex<float> b = std::conj(pInput[M - k]);
+			const std::complex<float> even = 0.5f * (a + b);
+			const std::complex<float> odd = 0.5f * (a - b) * std::conj(splitTwiddles[k]);
+			const std::complex<float> i(0.0f, 1.0f);
+			pData[bitReverse[k]] = std::conj(even + i * odd);
+			pData[bitReverse[M - k]] = std::conj(std::conj(even) + i * std::conj(odd));
+		}
+
+		transform(pData);
+
+		// Undo the conjugation and scale
+		const float scale = 1.0f / static_cast<float>(M);
+		size_t i = 0;
+
+#if defined(LUADIO_SIMD_SSE2)
+		const __m128 scale128 = _mm_set_ps(-scale, scale, -scale, scale);
+
+		for(; i + 4 <= size; i += 4)
+			_mm_storeu_ps(pOutput + i, _mm_mul_ps(_mm_loadu_ps(pOutput + i), scale128));
+#endif
+
+		for(; i < size; i += 2)
+		{
+			pOutput[i] *= scale;
+			pOutput[i + 1] *= -scale;
+		}
+	}
+
+	void fft_plan::transform(std::complex<float> *pData) const
+	{
+		if(radix2Pass)
+		{
+			for(size_t i = 0; i < complexSize; i += 2)
+			{
+				const std::complex<float> a = pData[i];
+				const std::complex<float> b = pData[i + 1];
+				pData[i] = a + b;
+				pData[i + 1] = a - b;
+			}
+		}
+
+		for(const pass &p : passes)
+			fused_pass(pData, p);
+	}
+
+	void fft_plan::fused_pass(std::complex<float> *pData, const pass &p) const
+	{
+		// Two radix-2 stages in one sweep over the data: size h sub transforms become size 4h
+		const size_t h = p.half;
+		const float *pW1Re = &twiddles[p.twiddleOffset];
+		const float *pW1Im = pW1Re + 2 * h;
+		const float *pW2Re = pW1Re + 4 * h;
+		const float *pW2Im = pW1Re + 6 * h;
+
+		for(size_t block = 0; block < complexSize; block += 4 * h)
+		{
+			float *x0 = reinterpret_cast<float*>(pData + block);
+			float *x1 = x0 + 2 * h;
+			float *x2 = x0 + 4 * h;
+			float *x3 = x0 + 6 * h;
+			size_t j = 0;
+
+#if defined(LUADIO_SIMD_AVX2)
+			for(; j + 4 <= h; j += 4)
+			{
+				const size_t f = 2 * j;
+				const __m256 w1r = _mm256_loadu_ps(pW1Re + f);
+				const __m256 w1i = _mm256_loadu_ps(pW1Im + f);
+				const __m256 w2r = _mm256_loadu_ps(pW2Re + f);
+				const __m256 w2i = _mm256_loadu_ps(pW2Im + f);
+				const __m256 a0 = _mm256_loadu_ps(x0 + f);
+				const __m256 t1 = complex_multiply_avx2(_mm256_loadu_ps(x1 + f), w1r, w1i);
+				const __m256 a2 = _mm256_loadu_ps(x2 + f);
+				const __m256 t3 = complex_multiply_avx2(_mm256_loadu_ps(x3 + f), w1r, w1i);
+				const __m256 b0 = _mm256_add_ps(a0, t1);
+				const __m256 b1 = _mm256_sub_ps(a0, t1);
+				const __m256 u = complex_multiply_avx2(_mm256_add_ps(a2, t3), w2r, w2i);
+				const __m256 v = multiply_negative_i_avx2(complex_multiply_avx2(_mm256_sub_ps(a2, t3), w2r, w2i));
+				_mm256_storeu_ps(x0 + f, _mm256_add_ps(b0, u));
+				_mm256_storeu_ps(x2 + f, _mm256_sub_ps(b0, u));
+				_mm256_storeu_ps(x1 + f, _mm256_add_ps(b1, v));
+				_mm256_storeu_ps(x3 + f, _mm256_sub_ps(b1, v));
+			}
+#endif
+
+#if defined(LUADIO_SIMD_SSE2)
+			for(; j + 2 <= h; j += 2)
+			{
+				const size_t f = 2 * j;
+				const __m128 w1r = _mm_loadu_ps(pW1Re + f);
+				const __m128 w1i = _mm_loadu_ps(pW1Im + f);
+				const __m128 w2r = _mm_loadu_ps(pW2Re + f);
+				const __m128 w2i = _mm_loadu_ps(pW2Im + f);
+				const __m128 a0 = _mm_loadu_ps(x0 + f);
+				const __m128 t1 = complex_multiply_sse2(_mm_loadu_ps(x1 + f), w1r, w1i);
+				const __m128 a2 = _mm_loadu_ps(x2 + f);
+				const __m128 t3 = complex_multiply_sse2(_mm_loadu_ps(x3 + f), w1r, w1i);
+				const __m128 b0 = _mm_add_ps(a0, t1);
+				const __m128 b1 = _mm_sub_ps(a0, t1);
+				const __m128 u = complex_multiply_sse2(_mm_add_ps(a2, t3), w2r, w2i);
+				const __m128 v = multiply_negative_i_sse2(complex_multiply_sse2(_mm_sub_ps(a2, t3), w2r, w2i));
+				_mm_storeu_ps(x0 + f, _mm_add_ps(b0, u));
+				_mm_storeu_ps(x2 + f, _mm_sub_ps(b0, u));
+				_mm_storeu_ps(x1 + f, _mm_add_ps(b1, v));
+				_mm_storeu_ps(x3 + f, _mm_sub_ps(b1, v));
+			}
+#endif
+
+			for(; j < h; j++)
+			{
+				const size_t f = 2 * j;
+				const std::complex<float> w1(pW1Re[f], pW1Im[f]);
+				const std::complex<float> w2(pW2Re[f], pW2Im[f]);
+				const std::complex<float> a0(x0[f], x0[f + 1]);
+				const std::complex<float> t1 = std::complex<float>(x1[f], x1[f + 1]) * w1;
+				const std::complex<float> a2(x2[f], x2[f + 1]);
+				const std::complex<float> t3 = std::complex<float>(x3[f], x3[f + 1]) * w1;
+				const std::complex<float> b0 = a0 + t1;
+				const std::complex<float> b1 = a0 - t1;
+				const std::complex<float> u = (a2 + t3) * w2;
+				const std::complex<float> d = (a2 - t3) * w2;
+				const std::complex<float> v(d.imag(), -d.real());
+				const std::complex<float> r0 = b0 + u;
+				const std::complex<float> r2 = b0 - u;
+				const std::complex<float> r1 = b1 + v;
+				const std::complex<float> r3 = b1 - v;
+				x0[f] = r0.real(); x0[f + 1] = r0.imag();
+				x1[f] = r1.real(); x1[f + 1] = r1.imag();
+				x2[f] = r2.real(); x2[f + 1] = r2.imag();
+				x3[f] = r3.real(); x3[f + 1] = r3.imag();
+			}
+		}
+	}
+}
@@ -0,0 +1,277 @@
+#include "file_stream.hpp"
+#include "../../libs/miniaudioex/include/miniaudioex.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace luadio
+{
+	file_stream::file_stream(const std::string &filePath, uint32_t sampleRate) : filledChunks(chunkCount), freeChunks(chunkCount)
+	{
+		this->filePath = filePath;
+		this->sampleRate = sampleRate;
+		running.store(true);
+		loop.store(false);
+		status.store(stream_status_buffering);
+		generation.store(0);
+		activeGeneration.store(0);
+		finishedGeneration.store(UINT32_MAX);
+		seekFrame.store(0);
+		position.store(0);
+		length.store(0);
+		channels.store(0);
+		underruns.store(0);
+		underrunFrames.store(0);
+		currentChunk = -1;
+		chunkOffset = 0;
+		readerGeneration = 0;
+
+		for(uint32_t i = 0; i < chunkCount; i++)
+			freeChunks.try_enqueue(i);
+
+		thread = std::thread(&file_stream::run, this);
+	}
+
+	file_stream::~file_stream()
+	{
+		running.store(false);
+
+		if(thread.joinable())
+			thread.join();
+	}
+
+	void file_stream::read(float *pOutput, uint32_t frameCount, uint32_t channels)
+	{
+		const uint32_t currentGeneration = generation.load(std::memory_order_acquire);
+		const stream_status state = get_status();
+		const uint32_t streamChannels = this->channels.load(std::memory_order_relaxed);
+		uint32_t done = 0;
+
+		if(state != stream_status_failed)
+		{
+			// A seek happened, whatever is buffered belongs to the old position
+			if(readerGeneration != currentGeneration)
+			{
+				if(currentChunk >= 0)
+					freeChunks.try_enqueue(static_cast<uint32_t>(currentChunk));
+
+				currentChunk = -1;
+				readerGeneration = currentGeneration;
+			}
+
+			// While prefetching only stale chunks are dropped, the first fresh one waits for playback to start
+			const uint32_t needed = state == stream_status_buffering ? 0 : frameCount;
+
+			while(currentChunk < 0 || done < needed)
+			{
+				if(currentChunk < 0)
+				{
+					uint32_t index;
+
+					if(!filledChunks.try_dequeue(index))
+						break;
+
+					if(chunks[index].generation != readerGeneration)
+					{
+						freeChunks.try_enqueue(index);
+						continue;
+					}
+
+					currentChunk = static_cast<int32_t>(index);
+					chunkOffset = 0;
+				}
+
+				if(done == needed)
+					break;
+
+				const chunk &source = chunks[currentChunk];
+				const uint32_t count = std::min(frameCount - done, source.frameCount - chunkOffset);
+				const float *pSource = source.frames.data() + static_cast<size_t>(chunkOffset) * streamChannels;
+				float *pTarget = pOutput + static_cast<size_t>(done) * channels;
+
+				for(uint32_t i = 0; i < count; i++)
+				{
+					for(uint32_t c = 0; c < channels; c++)
+					{
+						// Mono files play on every channel, channels the file does not have stay silent
+						const uint32_t sourceChannel = streamChannels == 1 ? 0 : c;
+						pTarget[i * channels + c] = sourceChannel < streamChannels ? pSource[i * streamChannels + sourceChannel] : 0.0f;
+					}
+				}
+
+				position.store(source.startFrame + chunkOffset + count, std::memory_order_relaxed);
+				chunkOffset += count;
+				done += count;
+
+				if(chunkOffset == source.frameCount)
+				{
+					freeChunks.try_enqueue(static_cast<uint32_t>(currentChunk));
+					currentChunk = -1;
+				}
+			}
+
+			// Running dry at the end of the file ends the stream, anywhere else while playing it is an underrun
+			if(done < frameCount && currentChunk < 0 && finishedGeneration.load(std::memory_order_acquire) == readerGeneration && filledChunks.size() == 0)
+			{
+				stream_status expected = stream_status_playing;
+				status.compare_exchange_strong(expected, stream_status_ended);
+			}
+			else if(done < frameCount && state == stream_status_playing)
+			{
+				underruns.fetch_add(1, std::memory_order_relaxed);
+				underrunFrames.fetch_add(frameCount - done, std::memory_order_relaxed);
+			}
+		}
+
+		std::memset(pOutput + static_cast<size_t>(done) * channels, 0, static_cast<size_t>(frameCount - done) * channels * sizeof(float));
+	}
+
+	void file_stream::seek(uint64_t frame)
+	{
+		seekFrame.store(frame, std::memory_order_relaxed);
+		position.store(frame, std::memory_order_relaxed);
+		generation.fetch_add(1, std::memory_order_release);
+	}
+
+	void file_stream::set_loop(bool loop)
+	{
+		this->loop.store(loop);
+	}
+
+	stream_status file_stream::get_status() const
+	{
+		// Until the I/O thread picks up a seek the stream counts as buffering
+		const stream_status state = status.load(std::memory_order_acquire);
+
+		if(state != stream_status_failed && activeGeneration.load(std::memory_order_acquire) != generation.load(std::memory_order_acquire))
+			return stream_status_buffering;
+
+		return state;
+	}
+
+	uint64_t file_stream::get_position() const
+	{
+		return position.load(std::memory_order_relaxed);
+	}
+
+	uint64_t file_stream::get_length() const
+	{
+		return length.load();
+	}
+
+	uint32_t file_stream::get_channels() const
+	{
+		return channels.load();
+	}
+
+	uint64_t file_stream::get_underruns() const
+	{
+		return underruns.load(std::memory_order_relaxed);
+	}
+
+	uint64_t file_stream::get_underrun_frames() const
+	{
+		return underrunFrames.load(std::memory_order_relaxed);
+	}
+
+	void file_stream::run()
+	{
+		ma_decoder_config config = ma_decoder_config_init(ma_format_f32, 0, sampleRate);
+		ma_decoder decoder;
+
+		if(ma_decoder_init_file(filePath.c_str(), &config, &decoder) != MA_SUCCESS)
+		{
+			status.store(stream_status_failed);
+			return;
+		}
+
+		const uint32_t streamChannels = decoder.outputChannels;
+		ma_uint64 frames = 0;
+
+		if(ma_decoder_get_length_in_pcm_frames(&decoder, &frames) == MA_SUCCESS)
+			length.store(frames);
+
+		for(uint32_t i = 0; i < chunkCount; i++)
+			chunks[i].frames.resize(static_cast<size_t>(chunkFrames) * streamChannels);
+
+		channels.store(streamChannels);
+
+		uint32_t decodeGeneration = 0;
+		uint64_t decodePosition = 0;
+		uint32_t prefetched = 0;
+		int32_t spareChunk = -1;
+		bool endOfFile = false;
+
+		while(running.load())
+		{
+			const uint32_t requested = generation.load(std::memory_order_acquire);
+
+			if(requested != decodeGeneration)
+			{
+				decodeGeneration = requested;
+				decodePosition = seekFrame.load(std::memory_order_relaxed);
+				endOfFile = ma_decoder_seek_to_pcm_frame(&decoder, decodePosition) != MA_SUCCESS;
+				prefetched = 0;
+
+				if(endOfFile)
+					finishedGeneration.store(decodeGeneration, std::memory_order_release);
+
+				status.store(endOfFile ? stream_status_ended : stream_status_buffering, std::memory_order_release);
+				activeGeneration.store(decodeGeneration, std::memory_order_release);
+			}
+
+			uint32_t index;
+
+			if(spareChunk >= 0 && !endOfFile)
+			{
+				index = static_cast<uint32_t>(spareChunk);
+				spareChunk = -1;
+			}
+			else if(endOfFile || !freeChunks.try_dequeue(index))
+			{
+				// The ring is full, or the rest of the file is queued and only a seek can bring more work
+				std::this_thread::sleep_for(std::chrono::milliseconds(2));
+				continue;
+			}
+
+			chunk &target = chunks[index];
+			ma_uint64 framesRead = 0;
+			ma_decoder_read_pcm_frames(&decoder, target.frames.data(), chunkFrames, &framesRead);
+
+			target.startFrame = decodePosition;
+			target.frameCount = static_cast<uint32_t>(framesRead);
+			target.generation = decodeGeneration;
+			decodePosition += framesRead;
+
+			if(framesRead < chunkFrames)
+			{
+				// An empty file must not loop forever
+				if(loop.load() && decodePosition > 0 && ma_decoder_seek_to_pcm_frame(&decoder, 0) == MA_SUCCESS)
+					decodePosition = 0;
+				else
+					endOfFile = true;
+			}
+
+			if(endOfFile)
+				finishedGeneration.store(decodeGeneration, std::memory_order_release);
+
+			if(framesRead == 0)
+			{
+				// Only the reader returns chunks to the free queue, keep this one for the next read
+				spareChunk = static_cast<int32_t>(index);
+			}
+			else
+			{
+				filledChunks.try_enqueue(index);
+				prefetched++;
+			}
+
+			// Playing once a few chunks are ahead of the reader, or the whole rest of a short file
+			if(status.load(std::memory_order_relaxed) == stream_status_buffering && (prefetched >= chunkCount / 4 || endOfFile))
+				status.store(stream_status_playing, std::memory_order_release);
+
+		}
+
+		ma_decoder_uninit(&decoder);
+	}
+}
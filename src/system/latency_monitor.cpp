@@ -0,0 +1,119 @@
+#include "latency_monitor.hpp"
+#include <algorithm>
+#include <chrono>
+
+namespace luadio
+{
+	// Weight of the newest period in the running averages
+	static constexpr float smoothing = 0.05f;
+
+	latency_monitor::latency_monitor()
+	{
+		sampleRate.store(44100);
+		clear();
+		resetRequested.store(false);
+	}
+
+	void latency_monitor::reset(uint32_t sampleRate)
+	{
+		// The audio thread clears the measurements at the start of its next period
+		this->sampleRate.store(std::max<uint32_t>(sampleRate, 1));
+		resetRequested.store(true);
+	}
+
+	uint64_t latency_monitor::now()
+	{
+		auto time = std::chrono::steady_clock::now().time_since_epoch();
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(time).count());
+	}
+
+	void latency_monitor::add_work(uint64_t start)
+	{
+		work += now() - start;
+	}
+
+	void latency_monitor::end_period(uint64_t start, uint32_t frameCount)
+	{
+		if(resetRequested.exchange(false))
+			clear();
+
+		work += now() - start;
+
+		if(frameCount == 0)
+			return;
+
+		const float duration = 1000.0f * frameCount / sampleRate.load(std::memory_order_relaxed);
+		const float load = static_cast<float>(work) / 1e6f / duration;
+
+		averageLoadState = averageLoadState > 0.0f ? averageLoadState + smoothing * (load - averageLoadState) : load;
+		blockSize.store(frameCount, std::memory_order_relaxed);
+		maxBlockSize.store(std::max(maxBlockSize.load(std::memory_order_relaxed), frameCount), std::memory_order_relaxed);
+		averageLoad.store(averageLoadState, std::memory_order_relaxed);
+		peakLoad.store(std::max(peakLoad.load(std::memory_order_relaxed), load), std::memory_order_relaxed);
+
+		// The first period after a reset has nothing to measure its interval against
+		if(lastStart > 0)
+		{
+			const float interval = static_cast<float>(start - lastStart) / 1e6f;
+			averageIntervalState = averageIntervalState > 0.0f ? averageIntervalState + smoothing * (interval - averageIntervalState) : interval;
+			averageInterval.store(averageIntervalState, std::memory_order_relaxed);
+			maxInterval.store(std::max(maxInterval.load(std::memory_order_relaxed), interval), std::memory_order_relaxed);
+
+			if(interval > 1.5f * duration)
+				latePeriods.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		lastStart = start;
+		work = 0;
+	}
+
+	uint32_t latency_monitor::get_block_size() const
+	{
+		return blockSize.load(std::memory_order_relaxed);
+	}
+
+	uint32_t latency_monitor::get_max_block_size() const
+	{
+		return maxBlockSize.load(std::memory_order_relaxed);
+	}
+
+	float latency_monitor::get_average_interval() const
+	{
+		return averageInterval.load(std::memory_order_relaxed);
+	}
+
+	float latency_monitor::get_max_interval() const
+	{
+		return maxInterval.load(std::memory_order_relaxed);
+	}
+
+	float latency_monitor::get_average_load() const
+	{
+		return averageLoad.load(std::memory_order_relaxed);
+	}
+
+	float latency_monitor::get_peak_load() const
+	{
+		return peakLoad.load(std::memory_order_relaxed);
+	}
+
+	uint64_t latency_monitor::get_late_periods() const
+	{
+		return latePeriods.load(std::memory_order_relaxed);
+	}
+
+	void latency_monitor::clear()
+	{
+		lastStart = 0;
+		work = 0;
+		averageIntervalState = 0.0f;
+		averageLoadState = 0.0f;
+		blockSize.store(0);
+		maxBlockSize.store(0);
+		averageInterval.store(0.0f);
+		maxInterval.store(0.0f);
+		averageLoad.store(0.0f);
+		peakLoad.store(0.0f);
+		latePeriods.store(0);
+	}
+}
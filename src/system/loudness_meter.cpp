@@ -0,0 +1,340 @@
+#include "loudness_meter.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace luadio
+{
+	static float to_decibels(double amplitude)
+	{
+		if(amplitude <= 0.0)
+			return -std::numeric_limits<float>::infinity();
+		return static_cast<float>(20.0 * std::log10(amplitude));
+	}
+
+	static float to_lufs(double meanSquare)
+	{
+		if(meanSquare <= 0.0)
+			return -std::numeric_limits<float>::infinity();
+		return static_cast<float>(-0.691 + 10.0 * std::log10(meanSquare));
+	}
+
+	loudness_meter::loudness_meter()
+	{
+		resetRequested.store(false);
+		histogramCounts.resize(histogramBins);
+		histogramEnergy.resize(histogramBins);
+		initialize(44100, 2);
+	}
+
+	void loudness_meter::initialize(uint32_t sampleRate, uint32_t channels)
+	{
+		this->sampleRate = sampleRate;
+		this->channels = std::min(channels, maxChannels);
+		blockFrames = std::max<uint32_t>(1, sampleRate / 10);
+
+		// K-weighting as a high shelf followed by the RLB high pass, with the
+		// analog prototypes of BS.1770 mapped to the actual sample rate
+		const double rate = static_cast<double>(sampleRate);
+
+		double f0 = 1681.974450955533;
+		double gain = 3.999843853973347;
+		double q = 0.7071752369554196;
+		double k = std::tan(M_PI * f0 / rate);
+		double vh = std::pow(10.0, gain / 20.0);
+		double vb = std::pow(vh, 0.4996667741545416);
+		double a0 = 1.0 + k / q + k * k;
+
+		shelf.b0 = (vh + vb * k / q + k * k) / a0;
+		shelf.b1 = 2.0 * (k * k - vh) / a0;
+		shelf.b2 = (vh - vb * k / q + k * k) / a0;
+		shelf.a1 = 2.0 * (k * k - 1.0) / a0;
+		shelf.a2 = (1.0 - k / q + k * k) / a0;
+
+		f0 = 38.13547087602444;
+		q = 0.5003270373238773;
+		k = std::tan(M_PI * f0 / rate);
+		a0 = 1.0 + k / q + k * k;
+
+		highPass.b0 = 1.0;
+		highPass.b1 = -2.0;
+		highPass.b2 = 1.0;
+		highPass.a1 = 2.0 * (k * k - 1.0) / a0;
+		highPass.a2 = (1.0 - k / q + k * k) / a0;
+
+		// Channel weights for the L, R, C, LFE, Ls, Rs order, anything else counts fully
+		for(uint32_t c = 0; c < maxChannels; c++)
+			channelWeights[c] = 1.0f;
+
+		if(this->channels >= 6)
+		{
+			channelWeights[3] = 0.0f;
+			channelWeights[4] = 1.41f;
+			channelWeights[5] = 1.41f;
+		}
+
+		// Windowed sinc interpolator, split into one filter per oversampled phase
+		const uint32_t taps = oversampling * tapsPerPhase;
+		const double center = (taps - 1) * 0.5;
+		double filter[oversampling * tapsPerPhase];
+		double sum = 0.0;
+
+		for(uint32_t i = 0; i < taps; i++)
+		{
+			const double x = (i - center) / oversampling;
+			const double sinc = x == 0.0 ? 1.0 : std::sin(M_PI * x) / (M_PI * x);
+			const double w = 2.0 * M_PI * (i + 0.5) / taps;
+			const double window = 0.42 - 0.5 * std::cos(w) + 0.08 * std::cos(2.0 * w);
+			filter[i] = sinc * window;
+			sum += filter[i];
+		}
+
+		for(uint32_t p = 0; p < oversampling; p++)
+		{
+			for(uint32_t t = 0; t < tapsPerPhase; t++)
+				truePeakFilter[p][t] = static_cast<float>(filter[p + t * oversampling] * oversampling / sum);
+		}
+
+		clear();
+	}
+
+	void loudness_meter::process(const float *pFrames, size_t frameCount)
+	{
+		if(resetRequested.exchange(false))
+			clear();
+
+		for(size_t i = 0; i < frameCount; i++)
+		{
+			const float *pFrame = pFrames + i * channels;
+
+			for(uint32_t c = 0; c < channels; c++)
+			{
+				channel_state &state = states[c];
+				const double x = pFrame[c];
+
+				// Transposed direct form II, one stage after the other
+				const double shelved = shelf.b0 * x + state.shelfZ1;
+				state.shelfZ1 = shelf.b1 * x - shelf.a1 * shelved + state.shelfZ2;
+				state.shelfZ2 = shelf.b2 * x - shelf.a2 * shelved;
+
+				const double weighted = highPass.b0 * shelved + state.highPassZ1;
+				state.highPassZ1 = highPass.b1 * shelved - highPass.a1 * weighted + state.highPassZ2;
+				state.highPassZ2 = highPass.b2 * shelved - highPass.a2 * weighted;
+
+				state.weightedSum += weighted * weighted;
+				state.squareSum += x * x;
+				state.samplePeak = std::max(state.samplePeak, std::abs(pFrame[c]));
+				state.truePeak = std::max(state.truePeak, measure_true_peak(state, pFrame[c]));
+			}
+
+			if(++framesInBlock == blockFrames)
+				end_block();
+		}
+	}
+
+	void loudness_meter::reset()
+	{
+		resetRequested.store(true);
+	}
+
+	uint32_t loudness_meter::get_channels() const
+	{
+		return channels;
+	}
+
+	float loudness_meter::get_momentary() const
+	{
+		return momentary.load(std::memory_order_relaxed);
+	}
+
+	float loudness_meter::get_short_term() const
+	{
+		return shortTerm.load(std::memory_order_relaxed);
+	}
+
+	float loudness_meter::get_integrated() const
+	{
+		return integrated.load(std::memory_order_relaxed);
+	}
+
+	float loudness_meter::get_true_peak(uint32_t channel) const
+	{
+		if(channel >= maxChannels)
+			return -std::numeric_limits<float>::infinity();
+		return truePeaks[channel].load(std::memory_order_relaxed);
+	}
+
+	float loudness_meter::get_rms(uint32_t channel) const
+	{
+		if(channel >= maxChannels)
+			return -std::numeric_limits<float>::infinity();
+		return rmsLevels[channel].load(std::memory_order_relaxed);
+	}
+
+	float loudness_meter::get_peak_hold(uint32_t channel) const
+	{
+		if(channel >= maxChannels)
+			return -std::numeric_limits<float>::infinity();
+		return peakHolds[channel].load(std::memory_order_relaxed);
+	}
+
+	void loudness_meter::clear()
+	{
+		const float silence = -std::numeric_limits<float>::infinity();
+
+		framesInBlock = 0;
+		blockCount = 0;
+
+		std::fill(std::begin(weightedBlocks), std::end(weightedBlocks), 0.0);
+		std::fill(&squareBlocks[0][0], &squareBlocks[0][0] + rmsBlocks * maxChannels, 0.0);
+		std::fill(histogramCounts.begin(), histogramCounts.end(), 0);
+		std::fill(histogramEnergy.begin(), histogramEnergy.end(), 0.0);
+
+		for(uint32_t c = 0; c < maxChannels; c++)
+		{
+			states[c] = channel_state{};
+			truePeaks[c].store(silence);
+			rmsLevels[c].store(silence);
+			peakHolds[c].store(silence);
+		}
+
+		momentary.store(silence);
+		shortTerm.store(silence);
+		integrated.store(silence);
+	}
+
+	void loudness_meter::end_block()
+	{
+		const uint32_t index = static_cast<uint32_t>(blockCount % shortTermBlocks);
+		double weightedBlock = 0.0;
+
+		for(uint32_t c = 0; c < channels; c++)
+		{
+			channel_state &state = states[c];
+
+			weightedBlock += channelWeights[c] * state.weightedSum;
+			squareBlocks[blockCount % rmsBlocks][c] = state.squareSum;
+
+			// Hold for two seconds, then fall at 20 dB per second
+			if(state.samplePeak >= state.peakHold)
+			{
+				state.peakHold = state.samplePeak;
+				state.holdBlocks = 20;
+			}
+			else if(state.holdBlocks > 0)
+			{
+				state.holdBlocks--;
+			}
+			else
+			{
+				state.peakHold *= 0.7943282f;
+			}
+
+			state.weightedSum = 0.0;
+			state.squareSum = 0.0;
+			state.samplePeak = 0.0f;
+		}
+
+		weightedBlocks[index] = weightedBlock;
+		blockCount++;
+		framesInBlock = 0;
+
+		auto sumBlocks = [this] (uint32_t count) -> double {
+			double sum = 0.0;
+			for(uint32_t i = 0; i < count; i++)
+				sum += weightedBlocks[(blockCount - 1 - i) % shortTermBlocks];
+			return sum / (static_cast<double>(count) * blockFrames);
+		};
+
+		const uint32_t available = static_cast<uint32_t>(std::min<uint64_t>(blockCount, shortTermBlocks));
+		const double momentaryPower = sumBlocks(std::min(available, momentaryBlocks));
+
+		momentary.store(to_lufs(momentaryPower), std::memory_order_relaxed);
+		shortTerm.store(to_lufs(sumBlocks(available)), std::memory_order_relaxed);
+
+		// Every complete 400 ms block overlaps the previous one by 75% and goes into the gating histogram
+		if(blockCount >= momentaryBlocks)
+		{
+			const float loudness = to_lufs(momentaryPower);
+
+			if(loudness >= -70.0f)
+			{
+				const uint32_t bin = std::min(histogramBins - 1, static_cast<uint32_t>((loudness + 70.0f) * 10.0f));
+				histogramCounts[bin]++;
+				histogramEnergy[bin] += momentaryPower;
+				integrated.store(compute_integrated(), std::memory_order_relaxed);
+			}
+		}
+
+		const uint32_t rmsCount = static_cast<uint32_t>(std::min<uint64_t>(blockCount, rmsBlocks));
+
+		for(uint32_t c = 0; c < channels; c++)
+		{
+			double sum = 0.0;
+
+			for(uint32_t i = 0; i < rmsCount; i++)
+				sum += squareBlocks[i][c];
+
+			rmsLevels[c].store(to_decibels(std::sqrt(sum / (static_cast<double>(rmsCount) * blockFrames))), std::memory_order_relaxed);
+			peakHolds[c].store(to_decibels(states[c].peakHold), std::memory_order_relaxed);
+			truePeaks[c].store(to_decibels(states[c].truePeak), std::memory_order_relaxed);
+		}
+	}
+
+	float loudness_meter::measure_true_peak(channel_state &state, float sample) const
+	{
+		// The history holds every sample twice so the newest tapsPerPhase samples are contiguous
+		state.history[state.historyPosition] = sample;
+		state.history[state.historyPosition + tapsPerPhase] = sample;
+
+		const float *pNewest = &state.history[state.historyPosition + tapsPerPhase];
+		float peak = std::abs(sample);
+
+		for(uint32_t p = 0; p < oversampling; p++)
+		{
+			float sum = 0.0f;
+
+			for(uint32_t t = 0; t < tapsPerPhase; t++)
+				sum += truePeakFilter[p][t] * pNewest[-static_cast<int32_t>(t)];
+
+			peak = std::max(peak, std::abs(sum));
+		}
+
+		state.historyPosition = (state.historyPosition + 1) % tapsPerPhase;
+		return peak;
+	}
+
+	float loudness_meter::compute_integrated() const
+	{
+		// Absolute gate at -70 LUFS is applied when blocks enter the histogram
+		uint64_t count = 0;
+		double energy = 0.0;
+
+		for(uint32_t i = 0; i < histogramBins; i++)
+		{
+			count += histogramCounts[i];
+			energy += histogramEnergy[i];
+		}
+
+		if(count == 0)
+			return -std::numeric_limits<float>::infinity();
+
+		// Relative gate 10 LU below the loudness of the blocks that passed the absolute gate
+		const float threshold = to_lufs(energy / count) - 10.0f;
+		const uint32_t firstBin = static_cast<uint32_t>(std::clamp((threshold + 70.0f) * 10.0f, 0.0f, static_cast<float>(histogramBins - 1)));
+
+		count = 0;
+		energy = 0.0;
+
+		for(uint32_t i = firstBin; i < histogramBins; i++)
+		{
+			count += histogramCounts[i];
+			energy += histogramEnergy[i];
+		}
+
+		if(count == 0)
+			return -std::numeric_limits<float>::infinity();
+
+		return to_lufs(energy / count);
+	}
+}
@@ -0,0 +1,131 @@
+#include "memory_mapped_file.hpp"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace luadio
+{
+	memory_mapped_file::memory_mapped_file()
+	{
+		pData = nullptr;
+		size = 0;
+#ifdef _WIN32
+		fileHandle = INVALID_HANDLE_VALUE;
+		mappingHandle = nullptr;
+#else
+		fileDescriptor = -1;
+#endif
+	}
+
+	memory_mapped_file::~memory_mapped_file()
+	{
+		close();
+	}
+
+	bool memory_mapped_file::open(const std::string &filePath)
+	{
+		close();
+
+#ifdef _WIN32
+		fileHandle = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+		if(fileHandle == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER fileSize;
+
+		if(!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0)
+		{
+			close();
+			return false;
+		}
+
+		mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+		if(mappingHandle == nullptr)
+		{
+			close();
+			return false;
+		}
+
+		pData = static_cast<const uint8_t*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+		size = static_cast<size_t>(fileSize.QuadPart);
+#else
+		fileDescriptor = ::open(filePath.c_str(), O_RDONLY);
+
+		if(fileDescriptor < 0)
+			return false;
+
+		struct stat status;
+
+		if(fstat(fileDescriptor, &status) != 0 || status.st_size == 0)
+		{
+			close();
+			return false;
+		}
+
+		void *pMapping = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+
+		if(pMapping == MAP_FAILED)
+		{
+			close();
+			return false;
+		}
+
+		// The file is read front to back once, let the kernel read ahead aggressively
+		madvise(pMapping, static_cast<size_t>(status.st_size), MADV_SEQUENTIAL);
+
+		pData = static_cast<const uint8_t*>(pMapping);
+		size = static_cast<size_t>(status.st_size);
+#endif
+
+		if(pData == nullptr)
+		{
+			close();
+			return false;
+		}
+
+		return true;
+	}
+
+	void memory_mapped_file::close()
+	{
+#ifdef _WIN32
+		if(pData != nullptr)
+			UnmapViewOfFile(pData);
+		if(mappingHandle != nullptr)
+			CloseHandle(mappingHandle);
+		if(fileHandle != INVALID_HANDLE_VALUE)
+			CloseHandle(fileHandle);
+		mappingHandle = nullptr;
+		fileHandle = INVALID_HANDLE_VALUE;
+#else
+		if(pData != nullptr)
+			munmap(const_cast<uint8_t*>(pData), size);
+		if(fileDescriptor >= 0)
+			::close(fileDescriptor);
+		fileDescriptor = -1;
+#endif
+		pData = nullptr;
+		size = 0;
+	}
+
+	const uint8_t *memory_mapped_file::get_data() const
+	{
+		return pData;
+	}
+
+	size_t memory_mapped_file::get_size() const
+	{
+		return size;
+	}
+}
@@ -0,0 +1,55 @@
+#include "object_reaper.hpp"
+#include <chrono>
+
+namespace luadio
+{
+	object_reaper::object_reaper()
+	{
+		items.resize(1024);
+		running.store(true);
+		thread = std::thread(&object_reaper::run, this);
+	}
+
+	object_reaper::~object_reaper()
+	{
+		running.store(false);
+
+		if(thread.joinable())
+			thread.join();
+	}
+
+	object_reaper &object_reaper::get()
+	{
+		static object_reaper reaper;
+		return reaper;
+	}
+
+	void object_reaper::dispose(void *pObject, delete_function pDelete)
+	{
+		if(pObject == nullptr)
+			return;
+
+		if(!items.try_enqueue({ pObject, pDelete }))
+			pDelete(pObject);
+	}
+
+	void object_reaper::run()
+	{
+		item i;
+
+		while(true)
+		{
+			if(items.try_dequeue(i))
+			{
+				i.pDelete(i.pObject);
+				continue;
+			}
+
+			// Objects handed over before shutdown are still deleted
+			if(!running.load())
+				break;
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+	}
+}
@@ -0,0 +1,56 @@
+#include "one_pole.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace luadio
+{
+	void one_pole::set(filter_type type, float frequency, float sampleRate)
+	{
+		const double w = 2.0 * 3.14159265358979323846 * std::clamp<double>(frequency, 0.0, sampleRate * 0.49) / sampleRate;
+		coefficient = static_cast<float>(1.0 - std::exp(-w));
+		highpass = type == filter_type_highpass ? 1 : 0;
+	}
+
+	void one_pole::set_time(float seconds, float sampleRate)
+	{
+		const double frames = std::max<double>(seconds * sampleRate, 1.0);
+		coefficient = static_cast<float>(1.0 - std::exp(-1.0 / frames));
+		highpass = 0;
+	}
+
+	void one_pole::reset()
+	{
+		std::fill(z, z + maxChannels, 0.0f);
+	}
+
+	void one_pole::process(const float *pInput, float *pOutput, size_t frameCount, uint32_t channels)
+	{
+		const uint32_t stride = channels;
+		channels = std::min(channels, maxChannels);
+
+		for(uint32_t c = 0; c < channels; c++)
+		{
+			float y = z[c];
+
+			if(highpass)
+			{
+				for(size_t i = 0; i < frameCount; i++)
+				{
+					const float x = pInput[i * stride + c];
+					y += coefficient * (x - y);
+					pOutput[i * stride + c] = x - y;
+				}
+			}
+			else
+			{
+				for(size_t i = 0; i < frameCount; i++)
+				{
+					y += coefficient * (pInput[i * stride + c] - y);
+					pOutput[i * stride + c] = y;
+				}
+			}
+
+			z[c] = y;
+		}
+	}
+}
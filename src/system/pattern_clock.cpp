@@ -0,0 +1,165 @@
+#include "pattern_clock.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace luadio
+{
+	pattern_clock::pattern_clock()
+	{
+		stepsPerBeat = 4.0;
+		swing = 0.0;
+		blockStart = 0.0;
+		blockEnd = 0.0;
+		framesPerBeat = 22050.0;
+		frameCount = 0;
+		eventCount = 0;
+		noteOffCount = 0;
+		releaseRequested = false;
+	}
+
+	void pattern_clock::set_rate(double stepsPerBeat)
+	{
+		this->stepsPerBeat = std::clamp(stepsPerBeat, 1.0 / 16.0, 64.0);
+	}
+
+	void pattern_clock::set_swing(double swing)
+	{
+		this->swing = std::clamp(swing, 0.0, 0.75);
+	}
+
+	double pattern_clock::get_step_length() const
+	{
+		return 1.0 / stepsPerBeat;
+	}
+
+	double pattern_clock::get_step_beat(int64_t step) const
+	{
+		const double beat = step / stepsPerBeat;
+		return (step & 1) ? beat + swing / stepsPerBeat : beat;
+	}
+
+	void pattern_clock::begin(const transport_state &state, uint32_t frameCount, int64_t &firstStep, int64_t &lastStep)
+	{
+		this->frameCount = frameCount;
+		eventCount = 0;
+		framesPerBeat = 60.0 * state.sampleRate / state.tempo;
+
+		// The transport jumped back, notes waiting for their release would hang forever
+		const bool restarted = state.beat < blockEnd - 1e-6;
+
+		blockStart = state.beat;
+		blockEnd = state.beat + frameCount / framesPerBeat;
+
+		uint32_t kept = 0;
+
+		for(uint32_t i = 0; i < noteOffCount; i++)
+		{
+			if(restarted || releaseRequested)
+				add_event(0, note_event_type_note_off, noteOffs[i].note, 0.0f);
+			else if(contains(noteOffs[i].beat))
+				add_event(to_offset(noteOffs[i].beat), note_event_type_note_off, noteOffs[i].note, 0.0f);
+			else
+				noteOffs[kept++] = noteOffs[i];
+		}
+
+		noteOffCount = kept;
+		releaseRequested = false;
+
+		// One step back because swing can move the start of the previous step into this block
+		firstStep = std::max<int64_t>(0, static_cast<int64_t>(std::floor(blockStart * stepsPerBeat)) - 1);
+		lastStep = static_cast<int64_t>(std::floor(blockEnd * stepsPerBeat));
+	}
+
+	bool pattern_clock::contains(double beat) const
+	{
+		const double frame = to_frame(beat);
+		return frame >= 0.0 && frame < frameCount;
+	}
+
+	void pattern_clock::add_note(double beat, double length, int32_t note, float velocity)
+	{
+		const uint32_t onOffset = to_offset(beat);
+		const double offBeat = beat + length;
+
+		if(eventCount + 2 > maxEvents)
+			return;
+
+		if(contains(offBeat) && to_offset(offBeat) > onOffset)
+		{
+			add_event(onOffset, note_event_type_note_on, note, velocity);
+			add_event(to_offset(offBeat), note_event_type_note_off, note, 0.0f);
+			return;
+		}
+
+		// Without room to remember the release the note is not played at all
+		if(noteOffCount >= maxNoteOffs)
+			return;
+
+		add_event(onOffset, note_event_type_note_on, note, velocity);
+		noteOffs[noteOffCount++] = { std::max(offBeat, blockEnd), note };
+	}
+
+	void pattern_clock::add_parameter(double beat, uint32_t index, float value)
+	{
+		add_event(to_offset(beat), note_event_type_parameter, static_cast<int32_t>(index), value);
+	}
+
+	uint32_t pattern_clock::end()
+	{
+		std::stable_sort(events, events + eventCount, [] (const note_event &a, const note_event &b) {
+			if(a.offset != b.offset)
+				return a.offset < b.offset;
+			return a.type < b.type;
+		});
+
+		return eventCount;
+	}
+
+	void pattern_clock::release_all()
+	{
+		releaseRequested = true;
+	}
+
+	const note_event *pattern_clock::get_events() const
+	{
+		return events;
+	}
+
+	uint32_t pattern_clock::get_event_count() const
+	{
+		return eventCount;
+	}
+
+	double pattern_clock::get_random(int64_t step, uint64_t seed)
+	{
+		// splitmix64
+		uint64_t x = static_cast<uint64_t>(step) + seed * 0x9e3779b97f4a7c15ull;
+		x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+		x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+		x = x ^ (x >> 31);
+		return (x >> 11) * (1.0 / 9007199254740992.0);
+	}
+
+	uint32_t pattern_clock::to_offset(double beat) const
+	{
+		if(frameCount == 0)
+			return 0;
+
+		const double offset = std::floor(to_frame(beat));
+		return static_cast<uint32_t>(std::clamp(offset, 0.0, static_cast<double>(frameCount - 1)));
+	}
+
+	double pattern_clock::to_frame(double beat) const
+	{
+		// The transport beat is a running sum, the tolerance keeps steps on exact frames from slipping one frame early
+		return (beat - blockStart) * framesPerBeat + 1e-6;
+	}
+
+	void pattern_clock::add_event(uint32_t offset, note_event_type type, int32_t note, float value)
+	{
+		if(eventCount >= maxEvents)
+			return;
+
+		events[eventCount++] = { offset, static_cast<int32_t>(type), note, value };
+	}
+}
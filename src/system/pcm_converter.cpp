@@ -0,0 +1,339 @@
+#include "pcm_converter.hpp"
+#include "simd.hpp"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+namespace luadio
+{
+	static constexpr float s16Scale = 32767.0f;
+	static constexpr float s24Scale = 8388607.0f;
+	static constexpr float s32Scale = 2147483648.0f;
+	static constexpr float s32Max = 0.99999994f; // Largest float below 1.0, keeps s32Scale from overflowing
+
+	static inline float saturate(float value, float max)
+	{
+		// Written so that NaN ends up at -1, matching the min/max order of the vector paths
+		if(!(value > -1.0f))
+			value = -1.0f;
+		if(value > max)
+			value = max;
+		return value;
+	}
+
+	static inline uint32_t xorshift32(uint32_t &state)
+	{
+		uint32_t x = state;
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		state = x;
+		return x;
+	}
+
+	static inline float to_unit_float(uint32_t bits)
+	{
+		// Puts the top 23 bits in the mantissa of a float in [1, 2)
+		uint32_t mantissa = (bits >> 9) | 0x3F800000u;
+		float value;
+		std::memcpy(&value, &mantissa, sizeof(float));
+		return value - 1.0f;
+	}
+
+#if defined(LUADIO_SIMD_SSE2)
+	static inline __m128i xorshift32_sse2(__m128i x)
+	{
+		x = _mm_xor_si128(x, _mm_slli_epi32(x, 13));
+		x = _mm_xor_si128(x, _mm_srli_epi32(x, 17));
+		x = _mm_xor_si128(x, _mm_slli_epi32(x, 5));
+		return x;
+	}
+
+	static inline __m128 to_unit_float_sse2(__m128i bits)
+	{
+		__m128i mantissa = _mm_or_si128(_mm_srli_epi32(bits, 9), _mm_set1_epi32(0x3F800000));
+		return _mm_sub_ps(_mm_castsi128_ps(mantissa), _mm_set1_ps(1.0f));
+	}
+
+	static inline __m128i scale_sse2(const float *pSrc, __m128 scale, __m128 max)
+	{
+		__m128 v = _mm_loadu_ps(pSrc);
+		v = _mm_min_ps(_mm_max_ps(v, _mm_set1_ps(-1.0f)), max);
+		return _mm_cvtps_epi32(_mm_mul_ps(v, scale));
+	}
+#endif
+
+#if defined(LUADIO_SIMD_AVX2)
+	static inline __m256i scale_avx2(const float *pSrc, __m256 scale, __m256 max)
+	{
+		__m256 v = _mm256_loadu_ps(pSrc);
+		v = _mm256_min_ps(_mm256_max_ps(v, _mm256_set1_ps(-1.0f)), max);
+		return _mm256_cvtps_epi32(_mm256_mul_ps(v, scale));
+	}
+#endif
+
+	pcm_converter::pcm_converter()
+	{
+		dither = false;
+
+		// Any non zero seed works for xorshift, distinct seeds keep the lanes uncorrelated
+		for(size_t i = 0; i < 8; i++)
+			seeds[i] = 0x9E3779B9u * static_cast<uint32_t>(i + 1);
+	}
+
+	void pcm_converter::set_dither(bool enabled)
+	{
+		dither = enabled;
+	}
+
+	bool pcm_converter::get_dither() const
+	{
+		return dither;
+	}
+
+	uint32_t pcm_converter::get_bits_per_sample(pcm_format format)
+	{
+		return get_bytes_per_sample(format) * 8;
+	}
+
+	uint32_t pcm_converter::get_bytes_per_sample(pcm_format format)
+	{
+		switch(format)
+		{
+			case pcm_format_s16:
+				return 2;
+			case pcm_format_s24:
+				return 3;
+			case pcm_format_s32:
+				return 4;
+			default:
+				return 0;
+		}
+	}
+
+	void pcm_converter::convert(const float *pSrc, void *pDst, size_t count, pcm_format format)
+	{
+		uint8_t *pOutput = reinterpret_cast<uint8_t*>(pDst);
+		const size_t bytesPerSample = get_bytes_per_sample(format);
+
+		if(!dither)
+		{
+			switch(format)
+			{
+				case pcm_format_s16:
+					float_to_s16(pSrc, reinterpret_cast<int16_t*>(pOutput), count);
+					break;
+				case pcm_format_s24:
+					float_to_s24(pSrc, pOutput, count);
+					break;
+				case pcm_format_s32:
+					float_to_s32(pSrc, reinterpret_cast<int32_t*>(pOutput), count);
+					break;
+			}
+			return;
+		}
+
+		float lsb = 1.0f / s16Scale;
+
+		if(format == pcm_format_s24)
+			lsb = 1.0f / s24Scale;
+		else if(format == pcm_format_s32)
+			lsb = 1.0f / s32Scale;
+
+		// Dither into a small stack buffer so the caller's data is never modified and nothing is allocated
+		float dithered[chunkSize];
+
+		for(size_t offset = 0; offset < count; offset += chunkSize)
+		{
+			const size_t n = std::min(chunkSize, count - offset);
+
+			add_dither(pSrc + offset, dithered, n, lsb);
+
+			switch(format)
+			{
+				case pcm_format_s16:
+					float_to_s16(dithered, reinterpret_cast<int16_t*>(pOutput + offset * bytesPerSample), n);
+					break;
+				case pcm_format_s24:
+					float_to_s24(dithered, pOutput + offset * bytesPerSample, n);
+					break;
+				case pcm_format_s32:
+					float_to_s32(dithered, reinterpret_cast<int32_t*>(pOutput + offset * bytesPerSample), n);
+					break;
+			}
+		}
+	}
+
+	void pcm_converter::add_dither(const float *pSrc, float *pDst, size_t count, float lsb)
+	{
+		size_t i = 0;
+
+#if defined(LUADIO_SIMD_SSE2)
+		__m128i stateA = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&seeds[0]));
+		__m128i stateB = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&seeds[4]));
+		const __m128 scale = _mm_set1_ps(lsb);
+
+		for(; i + 4 <= count; i += 4)
+		{
+			stateA = xorshift32_sse2(stateA);
+			stateB = xorshift32_sse2(stateB);
+			__m128 noise = _mm_sub_ps(to_unit_float_sse2(stateA), to_unit_float_sse2(stateB));
+			_mm_storeu_ps(pDst + i, _mm_add_ps(_mm_loadu_ps(pSrc + i), _mm_mul_ps(noise, scale)));
+		}
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&seeds[0]), stateA);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&seeds[4]), stateB);
+#endif
+
+		for(; i < count; i++)
+		{
+			const size_t lane = i & 3;
+			float noise = to_unit_float(xorshift32(seeds[lane])) - to_unit_float(xorshift32(seeds[lane + 4]));
+			pDst[i] = pSrc[i] + noise * lsb;
+		}
+	}
+
+	void pcm_converter::float_to_s16(const float *pSrc, int16_t *pDst, size_t count)
+	{
+		size_t i = 0;
+
+#if defined(LUADIO_SIMD_AVX2)
+		const __m256 scale256 = _mm256_set1_ps(s16Scale);
+		const __m256 max256 = _mm256_set1_ps(1.0f);
+
+		for(; i + 16 <= count; i += 16)
+		{
+			__m256i a = scale_avx2(pSrc + i, scale256, max256);
+			__m256i b = scale_avx2(pSrc + i + 8, scale256, max256);
+			// packs works per 128 bit lane, the permute restores sample order
+			__m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), 0xD8);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(pDst + i), packed);
+		}
+#endif
+
+#if defined(LUADIO_SIMD_SSE2)
+		const __m128 scale128 = _mm_set1_ps(s16Scale);
+		const __m128 max128 = _mm_set1_ps(1.0f);
+
+		for(; i + 8 <= count; i += 8)
+		{
+			__m128i a = scale_sse2(pSrc + i, scale128, max128);
+			__m128i b = scale_sse2(pSrc + i + 4, scale128, max128);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i), _mm_packs_epi32(a, b));
+		}
+#endif
+
+		for(; i < count; i++)
+			pDst[i] = static_cast<int16_t>(std::lrintf(saturate(pSrc[i], 1.0f) * s16Scale));
+	}
+
+	void pcm_converter::float_to_s24(const float *pSrc, uint8_t *pDst, size_t count)
+	{
+		size_t i = 0;
+
+		auto store24 = [] (int32_t value, uint8_t *pOut) {
+			pOut[0] = static_cast<uint8_t>(value & 0xFF);
+			pOut[1] = static_cast<uint8_t>((value >> 8) & 0xFF);
+			pOut[2] = static_cast<uint8_t>((value >> 16) & 0xFF);
+		};
+
+#if defined(LUADIO_SIMD_SSE2)
+		const __m128 scale128 = _mm_set1_ps(s24Scale);
+		const __m128 max128 = _mm_set1_ps(1.0f);
+		alignas(16) int32_t values[4];
+
+		for(; i + 4 <= count; i += 4)
+		{
+			_mm_store_si128(reinterpret_cast<__m128i*>(values), scale_sse2(pSrc + i, scale128, max128));
+
+			for(size_t j = 0; j < 4; j++)
+				store24(values[j], pDst + (i + j) * 3);
+		}
+#endif
+
+		for(; i < count; i++)
+			store24(static_cast<int32_t>(std::lrintf(saturate(pSrc[i], 1.0f) * s24Scale)), pDst + i * 3);
+	}
+
+	void pcm_converter::float_to_s32(const float *pSrc, int32_t *pDst, size_t count)
+	{
+		size_t i = 0;
+
+#if defined(LUADIO_SIMD_AVX2)
+		const __m256 scale256 = _mm256_set1_ps(s32Scale);
+		const __m256 max256 = _mm256_set1_ps(s32Max);
+
+		for(; i + 8 <= count; i += 8)
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(pDst + i), scale_avx2(pSrc + i, scale256, max256));
+#endif
+
+#if defined(LUADIO_SIMD_SSE2)
+		const __m128 scale128 = _mm_set1_ps(s32Scale);
+		const __m128 max128 = _mm_set1_ps(s32Max);
+
+		for(; i + 4 <= count; i += 4)
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i), scale_sse2(pSrc + i, scale128, max128));
+#endif
+
+		for(; i < count; i++)
+			pDst[i] = static_cast<int32_t>(std::lrintf(saturate(pSrc[i], s32Max) * s32Scale));
+	}
+
+	void pcm_converter::s16_to_float(const uint8_t *pSrc, float *pDst, size_t count)
+	{
+		size_t i = 0;
+
+#if defined(LUADIO_SIMD_SSE2)
+		const __m128 scale128 = _mm_set1_ps(1.0f / 32768.0f);
+
+		for(; i + 8 <= count; i += 8)
+		{
+			const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i * 2));
+			// Sign extend by moving each sample into the high half of a 32 bit lane
+			const __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+			const __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+			_mm_storeu_ps(pDst + i, _mm_mul_ps(_mm_cvtepi32_ps(low), scale128));
+			_mm_storeu_ps(pDst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(high), scale128));
+		}
+#endif
+
+		for(; i < count; i++)
+		{
+			const int16_t value = static_cast<int16_t>(pSrc[i * 2] | (pSrc[i * 2 + 1] << 8));
+			pDst[i] = value * (1.0f / 32768.0f);
+		}
+	}
+
+	void pcm_converter::s24_to_float(const uint8_t *pSrc, float *pDst, size_t count)
+	{
+		for(size_t i = 0; i < count; i++)
+		{
+			const uint8_t *pSample = pSrc + i * 3;
+			// Assemble in the top 24 bits so the shift back sign extends
+			const int32_t value = static_cast<int32_t>((static_cast<uint32_t>(pSample[0]) << 8) | (static_cast<uint32_t>(pSample[1]) << 16) | (static_cast<uint32_t>(pSample[2]) << 24)) >> 8;
+			pDst[i] = value * (1.0f / 8388608.0f);
+		}
+	}
+
+	void pcm_converter::s32_to_float(const uint8_t *pSrc, float *pDst, size_t count)
+	{
+		size_t i = 0;
+
+#if defined(LUADIO_SIMD_SSE2)
+		const __m128 scale128 = _mm_set1_ps(1.0f / s32Scale);
+
+		for(; i + 4 <= count; i += 4)
+		{
+			const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i * 4));
+			_mm_storeu_ps(pDst + i, _mm_mul_ps(_mm_cvtepi32_ps(v), scale128));
+		}
+#endif
+
+		for(; i < count; i++)
+		{
+			int32_t value;
+			std::memcpy(&value, pSrc + i * 4, sizeof(int32_t));
+			pDst[i] = value * (1.0f / s32Scale);
+		}
+	}
+}
@@ -0,0 +1,70 @@
+#include "planar_buffer.hpp"
+#include "buffer_ops.hpp"
+#include <cstring>
+
+namespace luadio
+{
+	static constexpr size_t alignment = 64;
+	static constexpr uint32_t alignmentFloats = alignment / sizeof(float);
+
+	planar_buffer::planar_buffer()
+	{
+		channels = 0;
+		capacity = 0;
+		stride = 0;
+	}
+
+	void planar_buffer::resize(uint32_t channels, uint32_t capacity)
+	{
+		this->channels = channels;
+		this->capacity = capacity;
+		stride = (capacity + alignmentFloats - 1) / alignmentFloats * alignmentFloats;
+
+		// Over allocate by one alignment so the first channel can be moved onto the boundary
+		storage.assign(static_cast<size_t>(stride) * channels + alignmentFloats, 0.0f);
+		channelPointers.resize(channels);
+
+		const uintptr_t address = reinterpret_cast<uintptr_t>(storage.data());
+		float *pBase = storage.data() + ((alignment - address % alignment) % alignment) / sizeof(float);
+
+		for(uint32_t c = 0; c < channels; c++)
+			channelPointers[c] = pBase + static_cast<size_t>(c) * stride;
+	}
+
+	void planar_buffer::clear(uint32_t frameCount)
+	{
+		for(uint32_t c = 0; c < channels; c++)
+			buffer_ops::clear(channelPointers[c], frameCount);
+	}
+
+	void planar_buffer::copy(const planar_buffer &source, uint32_t frameCount)
+	{
+		for(uint32_t c = 0; c < channels && c < source.channels; c++)
+			buffer_ops::copy(channelPointers[c], source.channelPointers[c], frameCount);
+	}
+
+	void planar_buffer::read_interleaved(const float *pSrc, uint32_t frameCount)
+	{
+		buffer_ops::deinterleave(channelPointers.data(), pSrc, frameCount, channels);
+	}
+
+	void planar_buffer::write_interleaved(float *pDst, uint32_t frameCount) const
+	{
+		buffer_ops::interleave(pDst, channelPointers.data(), frameCount, channels);
+	}
+
+	float **planar_buffer::get_channels()
+	{
+		return channelPointers.data();
+	}
+
+	uint32_t planar_buffer::get_channel_count() const
+	{
+		return channels;
+	}
+
+	uint32_t planar_buffer::get_capacity() const
+	{
+		return capacity;
+	}
+}
@@ -0,0 +1,107 @@
+#include "polyphase_filter.hpp"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+
+namespace luadio
+{
+	struct filter_design
+	{
+		uint32_t tapCount;
+		double beta;
+		// Fraction of the cutoff where the passband ends, the rest is transition band
+		double passband;
+	};
+
+	static const filter_design gDesigns[] = {
+		{ 16, 6.0, 0.85 },
+		{ 32, 8.0, 0.91 },
+		{ 64, 10.0, 0.95 }
+	};
+
+	static std::map<std::pair<int32_t,int32_t>,std::shared_ptr<const polyphase_filter>> gFilters;
+	static std::mutex gFiltersMutex;
+
+	polyphase_filter::polyphase_filter(resampler_quality quality, double cutoff)
+	{
+		const filter_design &design = gDesigns[std::clamp<int32_t>(quality, resampler_quality_low, resampler_quality_high)];
+		const double frequency = std::clamp(cutoff, 0.01, 1.0) * design.passband;
+		const double center = design.tapCount / 2 - 1;
+		const double halfLength = design.tapCount / 2;
+		const double normalize = 1.0 / bessel_i0(design.beta);
+		const double pi = 3.14159265358979323846;
+
+		tapCount = design.tapCount;
+		coefficients.resize(static_cast<size_t>(phaseCount + 1) * tapCount);
+
+		std::vector<double> row(tapCount);
+
+		for(uint32_t p = 0; p <= phaseCount; p++)
+		{
+			const double fraction = static_cast<double>(p) / phaseCount;
+			double sum = 0.0;
+
+			// Tap k weighs the input frame k - center - fraction away from the output position
+			for(uint32_t k = 0; k < tapCount; k++)
+			{
+				const double x = k - center - fraction;
+				const double t = x / halfLength;
+				const double window = std::abs(t) < 1.0 ? bessel_i0(design.beta * std::sqrt(1.0 - t * t)) * normalize : 0.0;
+				const double sinc = x == 0.0 ? 1.0 : std::sin(pi * frequency * x) / (pi * frequency * x);
+				row[k] = sinc * window;
+				sum += row[k];
+			}
+
+			float *pRow = &coefficients[static_cast<size_t>(p) * tapCount];
+
+			for(uint32_t k = 0; k < tapCount; k++)
+				pRow[k] = static_cast<float>(row[k] / sum);
+		}
+	}
+
+	uint32_t polyphase_filter::get_tap_count() const
+	{
+		return tapCount;
+	}
+
+	const float *polyphase_filter::get_phase(uint32_t phase) const
+	{
+		return &coefficients[static_cast<size_t>(phase) * tapCount];
+	}
+
+	std::shared_ptr<const polyphase_filter> polyphase_filter::get(resampler_quality quality, double cutoff)
+	{
+		const int32_t key = static_cast<int32_t>(std::lround(std::clamp(cutoff, 0.01, 1.0) * 1000.0));
+
+		std::lock_guard<std::mutex> lock(gFiltersMutex);
+
+		auto it = gFilters.find({ quality, key });
+
+		if(it != gFilters.end())
+			return it->second;
+
+		auto filter = std::make_shared<const polyphase_filter>(quality, key / 1000.0);
+		gFilters[{ quality, key }] = filter;
+		return filter;
+	}
+
+	double polyphase_filter::bessel_i0(double x)
+	{
+		// Power series, converges quickly for the beta values used here
+		double sum = 1.0;
+		double term = 1.0;
+		const double y = x * x * 0.25;
+
+		for(uint32_t k = 1; k < 64; k++)
+		{
+			term *= y / (static_cast<double>(k) * k);
+			sum += term;
+
+			if(term < sum * 1e-12)
+				break;
+		}
+
+		return sum;
+	}
+}
@@ -0,0 +1,191 @@
+#include "polyphase_resampler.hpp"
+#include "simd.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+#include <cmath>
+
+namespace luadio
+{
+	polyphase_resampler::polyphase_resampler(uint32_t channels, resampler_quality quality, double ratio, double maxRatio)
+	{
+		if(channels == 0 || channels > maxChannels)
+			throw std::invalid_argument("channels must be between 1 and 16");
+
+		if(!(ratio > 0.0) || !(maxRatio > 0.0))
+			throw std::invalid_argument("ratio must be greater than 0");
+
+		this->channels = channels;
+		this->maxRatio = std::clamp(std::max(maxRatio, ratio), 1.0 / maxRatioLimit, maxRatioLimit);
+		this->ratio = std::min(ratio, this->maxRatio);
+
+		// Reading faster than the input rate lowers the cutoff below the input Nyquist frequency
+		filter = polyphase_filter::get(quality, 1.0 / std::max(1.0, this->maxRatio));
+		tapCount = filter->get_tap_count();
+		capacity = tapCount + chunkFrames + static_cast<uint32_t>(std::ceil(this->maxRatio));
+		history.resize(static_cast<size_t>(capacity) * channels);
+		kernel.resize(tapCount);
+		reset();
+	}
+
+	void polyphase_resampler::set_ratio(double ratio)
+	{
+		this->ratio = std::clamp(ratio, 1.0 / maxRatioLimit, maxRatio);
+	}
+
+	double polyphase_resampler::get_ratio() const
+	{
+		return ratio;
+	}
+
+	void polyphase_resampler::process(const float *pInput, uint32_t inputFrames, float *pOutput, uint32_t outputFrames, uint32_t &inputUsed, uint32_t &outputWritten)
+	{
+		run(pInput, inputFrames, nullptr, pOutput, outputFrames, inputUsed, outputWritten);
+	}
+
+	void polyphase_resampler::process_varying(const float *pInput, uint32_t inputFrames, const float *pRatios, float *pOutput, uint32_t outputFrames, uint32_t &inputUsed, uint32_t &outputWritten)
+	{
+		run(pInput, inputFrames, pRatios, pOutput, outputFrames, inputUsed, outputWritten);
+	}
+
+	void polyphase_resampler::reset()
+	{
+		// Half a filter of silence up front lines the first output frame up with the first input frame
+		std::fill(history.begin(), history.end(), 0.0f);
+		filled = tapCount / 2 - 1;
+		position = 0.0;
+	}
+
+	uint32_t polyphase_resampler::get_latency() const
+	{
+		return tapCount / 2;
+	}
+
+	uint32_t polyphase_resampler::get_channels() const
+	{
+		return channels;
+	}
+
+	uint64_t polyphase_resampler::get_output_frames(uint64_t inputFrames, double ratio)
+	{
+		return static_cast<uint64_t>(std::ceil(inputFrames / ratio));
+	}
+
+	void polyphase_resampler::run(const float *pInput, uint32_t inputFrames, const float *pRatios, float *pOutput, uint32_t outputFrames, uint32_t &inputUsed, uint32_t &outputWritten)
+	{
+		inputUsed = 0;
+		outputWritten = 0;
+
+		while(true)
+		{
+			const uint32_t count = std::min(inputFrames - inputUsed, capacity - filled);
+
+			for(uint32_t c = 0; c < channels; c++)
+			{
+				float *pHistory = &history[static_cast<size_t>(c) * capacity + filled];
+				const float *pSource = pInput + static_cast<size_t>(inputUsed) * channels + c;
+
+				for(uint32_t i = 0; i < count; i++)
+					pHistory[i] = pSource[static_cast<size_t>(i) * channels];
+			}
+
+			filled += count;
+			inputUsed += count;
+
+			while(outputWritten < outputFrames)
+			{
+				const uint32_t index = static_cast<uint32_t>(position);
+
+				if(index + tapCount > filled)
+					break;
+
+				const double phase = (position - index) * polyphase_filter::phaseCount;
+				const uint32_t row = static_cast<uint32_t>(phase);
+				interpolate(filter->get_phase(row), filter->get_phase(row + 1), static_cast<float>(phase - row), kernel.data(), tapCount);
+
+				float *pFrame = pOutput + static_cast<size_t>(outputWritten) * channels;
+
+				for(uint32_t c = 0; c < channels; c++)
+					pFrame[c] = dot(&history[static_cast<size_t>(c) * capacity + index], kernel.data(), tapCount);
+
+				position += pRatios != nullptr ? std::clamp(static_cast<double>(pRatios[outputWritten]), 1.0 / maxRatioLimit, maxRatio) : ratio;
+				outputWritten++;
+			}
+
+			// Drop the frames no future output can reach
+			const uint32_t consumed = std::min(static_cast<uint32_t>(position), filled);
+
+			if(consumed > 0)
+			{
+				for(uint32_t c = 0; c < channels; c++)
+				{
+					float *pHistory = &history[static_cast<size_t>(c) * capacity];
+					std::memmove(pHistory, pHistory + consumed, (filled - consumed) * sizeof(float));
+				}
+
+				filled -= consumed;
+				position -= consumed;
+			}
+
+			if(outputWritten == outputFrames || inputUsed == inputFrames)
+				break;
+		}
+	}
+
+	void polyphase_resampler::interpolate(const float *pA, const float *pB, float t, float *pDst, uint32_t count)
+	{
+		uint32_t i = 0;
+
+#if defined(LUADIO_SIMD_AVX2)
+		const __m256 t8 = _mm256_set1_ps(t);
+
+		for( ; i + 8 <= count; i += 8)
+		{
+			const __m256 a = _mm256_loadu_ps(pA + i);
+			_mm256_storeu_ps(pDst + i, _mm256_add_ps(a, _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(pB + i), a), t8)));
+		}
+#endif
+#if defined(LUADIO_SIMD_SSE2)
+		const __m128 t4 = _mm_set1_ps(t);
+
+		for( ; i + 4 <= count; i += 4)
+		{
+			const __m128 a = _mm_loadu_ps(pA + i);
+			_mm_storeu_ps(pDst + i, _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(pB + i), a), t4)));
+		}
+#endif
+
+		for( ; i < count; i++)
+			pDst[i] = pA[i] + (pB[i] - pA[i]) * t;
+	}
+
+	float polyphase_resampler::dot(const float *pA, const float *pB, uint32_t count)
+	{
+		uint32_t i = 0;
+		float sum = 0.0f;
+
+#if defined(LUADIO_SIMD_AVX2)
+		__m256 sum8 = _mm256_setzero_ps();
+
+		for( ; i + 8 <= count; i += 8)
+			sum8 = _mm256_add_ps(sum8, _mm256_mul_ps(_mm256_loadu_ps(pA + i), _mm256_loadu_ps(pB + i)));
+
+		__m128 sum4 = _mm_add_ps(_mm256_castps256_ps128(sum8), _mm256_extractf128_ps(sum8, 1));
+#elif defined(LUADIO_SIMD_SSE2)
+		__m128 sum4 = _mm_setzero_ps();
+#endif
+#if defined(LUADIO_SIMD_SSE2)
+		for( ; i + 4 <= count; i += 4)
+			sum4 = _mm_add_ps(sum4, _mm_mul_ps(_mm_loadu_ps(pA + i), _mm_loadu_ps(pB + i)));
+
+		sum4 = _mm_add_ps(sum4, _mm_movehl_ps(sum4, sum4));
+		sum4 = _mm_add_ss(sum4, _mm_shuffle_ps(sum4, sum4, 1));
+		sum = _mm_cvtss_f32(sum4);
+#endif
+
+		for( ; i < count; i++)
+			sum += pA[i] * pB[i];
+
+		return sum;
+	}
+}
@@ -0,0 +1,354 @@
+#include "sample_bank.hpp"
+#include "memory_mapped_file.hpp"
+#include "pcm_converter.hpp"
+#include "audio_file.hpp"
+#include "polyphase_resampler.hpp"
+#include <filesystem>
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace luadio
+{
+	struct wav_format
+	{
+		uint32_t audioFormat;
+		uint32_t channels;
+		uint32_t sampleRate;
+		uint32_t bitsPerSample;
+		const uint8_t *pData;
+		size_t dataSize;
+	};
+
+	static uint32_t read_uint16(const uint8_t *pData)
+	{
+		return pData[0] | (pData[1] << 8);
+	}
+
+	static uint32_t read_uint32(const uint8_t *pData)
+	{
+		return pData[0] | (pData[1] << 8) | (pData[2] << 16) | (static_cast<uint32_t>(pData[3]) << 24);
+	}
+
+	static bool parse_wav(const uint8_t *pFile, size_t fileSize, wav_format &format)
+	{
+		if(fileSize < 12 || std::memcmp(pFile, "RIFF", 4) != 0 || std::memcmp(pFile + 8, "WAVE", 4) != 0)
+			return false;
+
+		bool hasFormat = false;
+		size_t position = 12;
+
+		while(position + 8 <= fileSize)
+		{
+			const uint8_t *pChunk = pFile + position;
+			const size_t chunkSize = read_uint32(pChunk + 4);
+			const size_t available = std::min(chunkSize, fileSize - position - 8);
+
+			if(std::memcmp(pChunk, "fmt ", 4) == 0 && available >= 16)
+			{
+				format.audioFormat = read_uint16(pChunk + 8);
+				format.channels = read_uint16(pChunk + 10);
+				format.sampleRate = read_uint32(pChunk + 12);
+				format.bitsPerSample = read_uint16(pChunk + 22);
+
+				// WAVE_FORMAT_EXTENSIBLE keeps the real format in the first two bytes of the sub format GUID
+				if(format.audioFormat == 0xFFFE && available >= 26)
+					format.audioFormat = read_uint16(pChunk + 32);
+
+				hasFormat = true;
+			}
+			else if(std::memcmp(pChunk, "data", 4) == 0)
+			{
+				format.pData = pChunk + 8;
+				// Files cut short while recording often have a data size that runs past the end
+				format.dataSize = available;
+				return hasFormat;
+			}
+
+			// Chunks are padded to an even size
+			position += 8 + chunkSize + (chunkSize & 1);
+		}
+
+		return false;
+	}
+
+	sample_bank::sample_bank()
+	{
+		pendingCount.store(0);
+		running = true;
+		loader = std::thread(&sample_bank::run, this);
+	}
+
+	sample_bank::~sample_bank()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			running = false;
+		}
+
+		condition.notify_one();
+
+		if(loader.joinable())
+			loader.join();
+	}
+
+	sample_data *sample_bank::load(const std::string &filePath, uint32_t sampleRate)
+	{
+		// Lexical only, resolving links would touch the file system on the calling thread
+		const std::string normalPath = std::filesystem::path(filePath).lexically_normal().string();
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		for(auto &sample : entries)
+		{
+			if(sample->filePath == normalPath && sample->data.sampleRate == sampleRate)
+				return &sample->data;
+		}
+
+		auto sample = std::make_unique<entry>();
+		sample->data.pFrames = nullptr;
+		sample->data.frameCount = 0;
+		sample->data.channels = 0;
+		sample->data.sampleRate = sampleRate;
+		sample->data.status.store(sample_status_loading);
+		sample->data.id = static_cast<uint32_t>(entries.size());
+		sample->filePath = normalPath;
+		sample->hash = 0;
+
+		queue.push_back(sample.get());
+		entries.push_back(std::move(sample));
+		pendingCount.fetch_add(1);
+		condition.notify_one();
+
+		return &entries.back()->data;
+	}
+
+	sample_data *sample_bank::get(uint32_t id)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		if(id >= entries.size())
+			return nullptr;
+
+		return &entries[id]->data;
+	}
+
+	uint32_t sample_bank::get_count() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return static_cast<uint32_t>(entries.size());
+	}
+
+	uint32_t sample_bank::get_pending_count() const
+	{
+		return pendingCount.load();
+	}
+
+	void sample_bank::run()
+	{
+		while(true)
+		{
+			entry *pSample = nullptr;
+
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				condition.wait(lock, [this] { return !running || !queue.empty(); });
+
+				if(!running)
+					return;
+
+				pSample = queue.front();
+				queue.pop_front();
+			}
+
+			const bool loaded = read(*pSample);
+
+			if(loaded)
+				share_duplicate(*pSample);
+
+			pSample->data.status.store(loaded ? sample_status_ready : sample_status_failed, std::memory_order_release);
+			pendingCount.fetch_sub(1);
+		}
+	}
+
+	bool sample_bank::read(entry &sample)
+	{
+		if(read_wav(sample))
+			return true;
+
+		std::vector<float> frames;
+		uint32_t channels = 0;
+
+		if(!audio_file::read(sample.filePath, sample.data.sampleRate, frames, channels))
+			return false;
+
+		const uint64_t frameCount = frames.size() / channels;
+		sample.buffer = allocate((frameCount + paddingFrames) * channels);
+		std::copy(frames.begin(), frames.end(), sample.buffer.get());
+		std::fill_n(sample.buffer.get() + frameCount * channels, paddingFrames * channels, 0.0f);
+
+		sample.data.pFrames = sample.buffer.get();
+		sample.data.frameCount = frameCount;
+		sample.data.channels = channels;
+		sample.hash = compute_hash(sample.data.pFrames, frameCount * channels);
+		return true;
+	}
+
+	bool sample_bank::read_wav(entry &sample)
+	{
+		memory_mapped_file file;
+
+		if(!file.open(sample.filePath))
+			return false;
+
+		wav_format format;
+
+		if(!parse_wav(file.get_data(), file.get_size(), format))
+			return false;
+
+		if(format.channels == 0)
+			return false;
+
+		const bool isFloat = format.audioFormat == 3 && format.bitsPerSample == 32;
+		const bool isInteger = format.audioFormat == 1 && (format.bitsPerSample == 16 || format.bitsPerSample == 24 || format.bitsPerSample == 32);
+		const bool resample = format.sampleRate != sample.data.sampleRate;
+
+		// Unusual sample formats and channel counts go through the decoder
+		if((!isFloat && !isInteger) || (resample && format.channels > polyphase_resampler::maxChannels))
+			return false;
+
+		const size_t frameSize = static_cast<size_t>(format.channels) * (format.bitsPerSample / 8);
+		const uint64_t frameCount = format.dataSize / frameSize;
+
+		if(frameCount == 0 || format.sampleRate == 0)
+			return false;
+
+		// Without resampling the file is converted straight into the final buffer
+		const size_t count = frameCount * format.channels;
+		std::vector<float> converted;
+		float *pTarget;
+
+		if(resample)
+		{
+			converted.resize(count);
+			pTarget = converted.data();
+		}
+		else
+		{
+			sample.buffer = allocate(count + paddingFrames * format.channels);
+			pTarget = sample.buffer.get();
+		}
+
+		if(isFloat)
+			std::memcpy(pTarget, format.pData, count * sizeof(float));
+		else if(format.bitsPerSample == 16)
+			pcm_converter::s16_to_float(format.pData, pTarget, count);
+		else if(format.bitsPerSample == 24)
+			pcm_converter::s24_to_float(format.pData, pTarget, count);
+		else
+			pcm_converter::s32_to_float(format.pData, pTarget, count);
+
+		uint64_t outputFrames = frameCount;
+
+		if(resample)
+		{
+			const double ratio = static_cast<double>(format.sampleRate) / sample.data.sampleRate;
+			outputFrames = polyphase_resampler::get_output_frames(frameCount, ratio);
+			sample.buffer = allocate((outputFrames + paddingFrames) * format.channels);
+			resample_frames(converted.data(), frameCount, format.channels, ratio, sample.buffer.get(), outputFrames);
+		}
+
+		float *pFrames = sample.buffer.get();
+		const size_t outputCount = outputFrames * format.channels;
+		std::fill_n(pFrames + outputCount, paddingFrames * format.channels, 0.0f);
+
+		sample.data.pFrames = pFrames;
+		sample.data.frameCount = outputFrames;
+		sample.data.channels = format.channels;
+		sample.hash = compute_hash(pFrames, outputCount);
+		return true;
+	}
+
+	void sample_bank::resample_frames(const float *pInput, uint64_t inputFrames, uint32_t channels, double ratio, float *pOutput, uint64_t outputFrames)
+	{
+		polyphase_resampler resampler(channels, resampler_quality_high, ratio, ratio);
+		std::vector<float> silence(static_cast<size_t>(resampler.get_latency()) * channels, 0.0f);
+		uint64_t inputDone = 0;
+		uint64_t outputDone = 0;
+		bool flushed = false;
+
+		// The input is followed by silence so the last frames make it out of the filter
+		while(outputDone < outputFrames)
+		{
+			const bool atEnd = inputDone == inputFrames;
+			const float *pSource = atEnd ? silence.data() : pInput + inputDone * channels;
+			const uint32_t available = atEnd ? resampler.get_latency() : static_cast<uint32_t>(std::min<uint64_t>(inputFrames - inputDone, 1 << 16));
+			const uint32_t space = static_cast<uint32_t>(std::min<uint64_t>(outputFrames - outputDone, 1 << 16));
+			uint32_t used, written;
+
+			resampler.process(pSource, available, pOutput + outputDone * channels, space, used, written);
+
+			if(!atEnd)
+				inputDone += used;
+
+			outputDone += written;
+
+			if(atEnd)
+			{
+				if(flushed)
+					break;
+				flushed = true;
+			}
+		}
+
+		// Rounding can leave the very last frame without enough input behind it
+		std::fill(pOutput + outputDone * channels, pOutput + outputFrames * channels, 0.0f);
+	}
+
+	void sample_bank::share_duplicate(entry &sample)
+	{
+		const size_t byteSize = sample.data.frameCount * sample.data.channels * sizeof(float);
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		for(auto &other : entries)
+		{
+			if(other.get() == &sample || other->data.status.load(std::memory_order_acquire) != sample_status_ready)
+				continue;
+
+			if(other->hash != sample.hash || other->data.frameCount != sample.data.frameCount || other->data.channels != sample.data.channels)
+				continue;
+
+			if(std::memcmp(other->data.pFrames, sample.data.pFrames, byteSize) != 0)
+				continue;
+
+			sample.buffer = other->buffer;
+			sample.data.pFrames = other->data.pFrames;
+			return;
+		}
+	}
+
+	std::shared_ptr<float> sample_bank::allocate(size_t count)
+	{
+		float *pBuffer = new (std::align_val_t(alignment)) float[count];
+
+		return std::shared_ptr<float>(pBuffer, [] (float *p) {
+			operator delete[](p, std::align_val_t(alignment));
+		});
+	}
+
+	uint64_t sample_bank::compute_hash(const float *pSamples, size_t count)
+	{
+		// FNV-1a over whole samples rather than bytes, only used to find candidates for a full compare
+		uint64_t hash = 14695981039346656037ull;
+
+		for(size_t i = 0; i < count; i++)
+		{
+			uint32_t bits;
+			std::memcpy(&bits, &pSamples[i], sizeof(uint32_t));
+			hash = (hash ^ bits) * 1099511628211ull;
+		}
+
+		return hash;
+	}
+}
@@ -0,0 +1,171 @@
+#include "sample_player.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace luadio
+{
+	sample_player::sample_player() : triggers(maxPending)
+	{
+		pendingCount = 0;
+		voiceCount = 0;
+		activeCount.store(0);
+	}
+
+	bool sample_player::trigger(const sample_data *pSample, uint64_t frame, float gain, float pan)
+	{
+		if(pSample == nullptr)
+			return false;
+		return triggers.try_enqueue({ pSample, frame, gain, pan });
+	}
+
+	bool sample_player::stop_all()
+	{
+		return triggers.try_enqueue({ nullptr, 0, 0.0f, 0.0f });
+	}
+
+	void sample_player::render(float *pOutput, uint32_t frameCount, uint32_t channels, uint64_t frame)
+	{
+		sample_trigger trigger;
+
+		while(triggers.try_dequeue(trigger))
+		{
+			if(trigger.pSample == nullptr)
+			{
+				pendingCount = 0;
+				voiceCount = 0;
+			}
+			else if(pendingCount < maxPending)
+			{
+				pending[pendingCount++] = trigger;
+			}
+		}
+
+		const uint64_t blockEnd = frame + frameCount;
+		uint32_t kept = 0;
+
+		// Triggers start in the order they were sent, so a later one steals before an earlier one
+		for(uint32_t i = 0; i < pendingCount; i++)
+		{
+			if(pending[i].frame >= blockEnd)
+				pending[kept++] = pending[i];
+			else
+				start(pending[i], pending[i].frame > frame ? static_cast<uint32_t>(pending[i].frame - frame) : 0);
+		}
+
+		pendingCount = kept;
+
+		for(uint32_t i = 0; i < voiceCount;)
+		{
+			if(render_voice(voices[i], pOutput, frameCount, channels))
+			{
+				i++;
+				continue;
+			}
+
+			// Finished, keep the list compact without changing the age order
+			std::copy(voices + i + 1, voices + voiceCount, voices + i);
+			voiceCount--;
+		}
+
+		activeCount.store(voiceCount, std::memory_order_relaxed);
+	}
+
+	uint32_t sample_player::get_active_count() const
+	{
+		return activeCount.load(std::memory_order_relaxed);
+	}
+
+	void sample_player::reset()
+	{
+		sample_trigger trigger;
+
+		while(triggers.try_dequeue(trigger)) {}
+
+		pendingCount = 0;
+		voiceCount = 0;
+		activeCount.store(0);
+	}
+
+	void sample_player::start(const sample_trigger &trigger, uint32_t delay)
+	{
+		if(trigger.pSample->status.load(std::memory_order_acquire) != sample_status_ready)
+			return;
+
+		// Voices are kept oldest first, the first one is the one to steal
+		if(voiceCount == maxVoices)
+		{
+			std::copy(voices + 1, voices + voiceCount, voices);
+			voiceCount--;
+		}
+
+		// Equal power pan for mono samples, plain balance for the others so their stereo image stays intact
+		const float pan = std::clamp(trigger.pan, -1.0f, 1.0f);
+		voice &v = voices[voiceCount++];
+		v.pSample = trigger.pSample;
+		v.position = 0;
+		v.delay = delay;
+		v.gain = trigger.gain;
+
+		if(trigger.pSample->channels == 1)
+		{
+			const float angle = (pan + 1.0f) * 0.25f * 3.14159265358979f;
+			v.left = std::cos(angle) * trigger.gain;
+			v.right = std::sin(angle) * trigger.gain;
+		}
+		else
+		{
+			v.left = std::min(1.0f, 1.0f - pan) * trigger.gain;
+			v.right = std::min(1.0f, 1.0f + pan) * trigger.gain;
+		}
+	}
+
+	bool sample_player::render_voice(voice &v, float *pOutput, uint32_t frameCount, uint32_t channels)
+	{
+		if(v.delay >= frameCount)
+		{
+			v.delay -= frameCount;
+			return true;
+		}
+
+		const sample_data &sample = *v.pSample;
+		const uint32_t sampleChannels = sample.channels;
+		const uint64_t remaining = sample.frameCount - v.position;
+		const uint32_t count = static_cast<uint32_t>(std::min<uint64_t>(remaining, frameCount - v.delay));
+		const float *pSource = sample.pFrames + v.position * sampleChannels;
+		float *pTarget = pOutput + static_cast<size_t>(v.delay) * channels;
+
+		if(channels == 1)
+		{
+			for(uint32_t i = 0; i < count; i++)
+				pTarget[i] += pSource[i * sampleChannels] * v.gain;
+		}
+		else if(sampleChannels == 1)
+		{
+			for(uint32_t i = 0; i < count; i++)
+			{
+				pTarget[i * channels] += pSource[i] * v.left;
+				pTarget[i * channels + 1] += pSource[i] * v.right;
+			}
+		}
+		else
+		{
+			// The first two channels are balanced, any further ones map straight across
+			const uint32_t shared = std::min(sampleChannels, channels);
+
+			for(uint32_t i = 0; i < count; i++)
+			{
+				const float *pFrame = pSource + static_cast<size_t>(i) * sampleChannels;
+				float *pOut = pTarget + static_cast<size_t>(i) * channels;
+				pOut[0] += pFrame[0] * v.left;
+				pOut[1] += pFrame[1] * v.right;
+
+				for(uint32_t c = 2; c < shared; c++)
+					pOut[c] += pFrame[c] * v.gain;
+			}
+		}
+
+		v.delay = 0;
+		v.position += count;
+		return v.position < sample.frameCount;
+	}
+}
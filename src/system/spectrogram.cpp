@@ -0,0 +1,124 @@
+#include "spectrogram.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace luadio
+{
+	spectrogram::spectrogram()
+	{
+		columns.resize(capacity * rows);
+		std::fill(columns.begin(), columns.end(), 0);
+		columnCount.store(0);
+		fifoCount = 0;
+		hopSize = 0;
+		scale = 1.0f;
+
+		spectrogram_settings defaultSettings;
+		defaultSettings.fftSize = 2048;
+		defaultSettings.overlap = 4;
+		defaultSettings.window = window_type_hann;
+		defaultSettings.minDecibels = -90.0f;
+		configure(defaultSettings, 44100);
+	}
+
+	void spectrogram::configure(const spectrogram_settings &settings, uint32_t sampleRate)
+	{
+		this->settings = settings;
+
+		const size_t n = settings.fftSize;
+		plan = fft_plan::get(n);
+		window.resize(n);
+		fifo.resize(n);
+		frame.resize(n);
+		bins.resize(n / 2 + 1);
+		fifoCount = 0;
+		hopSize = std::max<size_t>(1, n / std::max<uint32_t>(1, settings.overlap));
+
+		window_function::generate(settings.window, window.data(), n);
+
+		// Full scale sine reads 0 dB regardless of window and size
+		scale = 2.0f / window_function::get_gain(window.data(), n);
+
+		rowBands.resize(rows);
+		compute_bands(settings.fftSize, sampleRate, rowBands.data(), rows);
+	}
+
+	void spectrogram::process(const float *pSamples, size_t count)
+	{
+		const size_t n = fifo.size();
+
+		while(count > 0)
+		{
+			const size_t toCopy = std::min(count, n - fifoCount);
+			std::memcpy(&fifo[fifoCount], pSamples, toCopy * sizeof(float));
+			fifoCount += toCopy;
+			pSamples += toCopy;
+			count -= toCopy;
+
+			if(fifoCount == n)
+			{
+				compute_column();
+				std::memmove(fifo.data(), fifo.data() + hopSize, (n - hopSize) * sizeof(float));
+				fifoCount -= hopSize;
+			}
+		}
+	}
+
+	uint64_t spectrogram::get_column_count() const
+	{
+		return columnCount.load(std::memory_order_acquire);
+	}
+
+	const uint8_t *spectrogram::get_column(uint64_t index) const
+	{
+		return &columns[(index % capacity) * rows];
+	}
+
+	void spectrogram::compute_bands(uint32_t fftSize, uint32_t sampleRate, spectrum_band *pBands, uint32_t count)
+	{
+		const double minFrequency = 20.0;
+		const double maxFrequency = sampleRate * 0.5;
+		const double ratio = maxFrequency / minFrequency;
+		const double binsPerHz = static_cast<double>(fftSize) / sampleRate;
+		const uint32_t lastBin = fftSize / 2;
+
+		for(uint32_t i = 0; i < count; i++)
+		{
+			const double low = minFrequency * std::pow(ratio, (i - 0.5) / (count - 1));
+			const double high = minFrequency * std::pow(ratio, (i + 0.5) / (count - 1));
+			uint32_t first = static_cast<uint32_t>(std::clamp(std::round(low * binsPerHz), 0.0, static_cast<double>(lastBin)));
+			uint32_t last = static_cast<uint32_t>(std::clamp(std::round(high * binsPerHz), 0.0, static_cast<double>(lastBin)));
+			pBands[i].firstBin = first;
+			pBands[i].lastBin = std::max(first, last);
+		}
+	}
+
+	void spectrogram::compute_column()
+	{
+		const size_t n = fifo.size();
+
+		for(size_t i = 0; i < n; i++)
+			frame[i] = fifo[i] * window[i];
+
+		plan->forward(frame.data(), bins.data());
+
+		const uint64_t index = columnCount.load(std::memory_order_relaxed);
+		uint8_t *pColumn = &columns[(index % capacity) * rows];
+		const float range = -settings.minDecibels;
+
+		for(uint32_t r = 0; r < rows; r++)
+		{
+			float power = 0.0f;
+
+			for(uint32_t b = rowBands[r].firstBin; b <= rowBands[r].lastBin; b++)
+				power = std::max(power, std::norm(bins[b]));
+
+			const float decibels = 10.0f * std::log10(power * scale * scale + 1e-20f);
+			const float t = std::clamp((decibels - settings.minDecibels) / range, 0.0f, 1.0f);
+			pColumn[r] = static_cast<uint8_t>(t * 255.0f);
+		}
+
+		columnCount.store(index + 1, std::memory_order_release);
+	}
+}
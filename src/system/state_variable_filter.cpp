@@ -0,0 +1,128 @@
+#include "state_variable_filter.hpp"
+#include "simd.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace luadio
+{
+	void state_variable_filter::set(filter_type type, float frequency, float q, float gainDecibels, float sampleRate)
+	{
+		const double A = std::pow(10.0, gainDecibels / 40.0);
+		double g = std::tan(3.14159265358979323846 * std::clamp<double>(frequency, 1.0, sampleRate * 0.49) / sampleRate);
+		double k = 1.0 / std::max<double>(q, 0.01);
+		double nm0 = 0.0, nm1 = 0.0, nm2 = 0.0;
+
+		switch(type)
+		{
+			case filter_type_highpass:
+				nm0 = 1.0;
+				nm1 = -k;
+				nm2 = -1.0;
+				break;
+			case filter_type_bandpass:
+				// Scaled by k so the peak sits at 0 dB like the biquad band pass
+				nm1 = k;
+				break;
+			case filter_type_notch:
+				nm0 = 1.0;
+				nm1 = -k;
+				break;
+			case filter_type_allpass:
+				nm0 = 1.0;
+				nm1 = -2.0 * k;
+				break;
+			case filter_type_peak:
+				k = 1.0 / (std::max<double>(q, 0.01) * A);
+				nm0 = 1.0;
+				nm1 = k * (A * A - 1.0);
+				break;
+			case filter_type_lowshelf:
+				g /= std::sqrt(A);
+				nm0 = 1.0;
+				nm1 = k * (A - 1.0);
+				nm2 = A * A - 1.0;
+				break;
+			case filter_type_highshelf:
+				g *= std::sqrt(A);
+				nm0 = A * A;
+				nm1 = k * (1.0 - A) * A;
+				nm2 = 1.0 - A * A;
+				break;
+			default:
+				nm2 = 1.0;
+				break;
+		}
+
+		const double na1 = 1.0 / (1.0 + g * (g + k));
+		a1 = static_cast<float>(na1);
+		a2 = static_cast<float>(g * na1);
+		a3 = static_cast<float>(g * g * na1);
+		m0 = static_cast<float>(nm0);
+		m1 = static_cast<float>(nm1);
+		m2 = static_cast<float>(nm2);
+	}
+
+	void state_variable_filter::reset()
+	{
+		std::fill(ic1eq, ic1eq + maxChannels, 0.0f);
+		std::fill(ic2eq, ic2eq + maxChannels, 0.0f);
+	}
+
+	void state_variable_filter::process(const float *pInput, float *pOutput, size_t frameCount, uint32_t channels)
+	{
+		const uint32_t stride = channels;
+		channels = std::min(channels, maxChannels);
+		uint32_t c = 0;
+
+#if defined(LUADIO_SIMD_SSE2)
+		const __m128 va1 = _mm_set1_ps(a1);
+		const __m128 va2 = _mm_set1_ps(a2);
+		const __m128 va3 = _mm_set1_ps(a3);
+		const __m128 vm0 = _mm_set1_ps(m0);
+		const __m128 vm1 = _mm_set1_ps(m1);
+		const __m128 vm2 = _mm_set1_ps(m2);
+
+		for( ; c < channels; c += 4)
+		{
+			const uint32_t lanes = std::min<uint32_t>(4, channels - c);
+			__m128 s1 = _mm_loadu_ps(&ic1eq[c]);
+			__m128 s2 = _mm_loadu_ps(&ic2eq[c]);
+
+			for(size_t i = 0; i < frameCount; i++)
+			{
+				const __m128 v0 = simd_load_lanes(pInput + i * stride + c, lanes);
+				const __m128 v3 = _mm_sub_ps(v0, s2);
+				const __m128 v1 = _mm_add_ps(_mm_mul_ps(va1, s1), _mm_mul_ps(va2, v3));
+				const __m128 v2 = _mm_add_ps(s2, _mm_add_ps(_mm_mul_ps(va2, s1), _mm_mul_ps(va3, v3)));
+				s1 = _mm_sub_ps(_mm_add_ps(v1, v1), s1);
+				s2 = _mm_sub_ps(_mm_add_ps(v2, v2), s2);
+				const __m128 y = _mm_add_ps(_mm_mul_ps(vm0, v0), _mm_add_ps(_mm_mul_ps(vm1, v1), _mm_mul_ps(vm2, v2)));
+				simd_store_lanes(pOutput + i * stride + c, y, lanes);
+			}
+
+			_mm_storeu_ps(&ic1eq[c], s1);
+			_mm_storeu_ps(&ic2eq[c], s2);
+		}
+#endif
+
+		for( ; c < channels; c++)
+		{
+			float s1 = ic1eq[c];
+			float s2 = ic2eq[c];
+
+			for(size_t i = 0; i < frameCount; i++)
+			{
+				const float v0 = pInput[i * stride + c];
+				const float v3 = v0 - s2;
+				const float v1 = a1 * s1 + a2 * v3;
+				const float v2 = s2 + a2 * s1 + a3 * v3;
+				s1 = 2.0f * v1 - s1;
+				s2 = 2.0f * v2 - s2;
+				pOutput[i * stride + c] = m0 * v0 + m1 * v1 + m2 * v2;
+			}
+
+			ic1eq[c] = s1;
+			ic2eq[c] = s2;
+		}
+	}
+}
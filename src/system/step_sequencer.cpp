@@ -0,0 +1,114 @@
+#include "step_sequencer.hpp"
+#include <algorithm>
+
+namespace luadio
+{
+	step_sequencer::step_sequencer(uint32_t length)
+	{
+		for(uint32_t i = 0; i < maxSteps; i++)
+		{
+			steps[i].note = -1;
+			steps[i].velocity = 1.0f;
+			steps[i].gate = 0.5f;
+			steps[i].probability = 1.0f;
+			steps[i].ratchets = 1;
+			steps[i].lockMask = 0;
+			std::fill(steps[i].locks, steps[i].locks + sequencer_step::maxParameters, 0.0f);
+		}
+
+		std::fill(parameters, parameters + sequencer_step::maxParameters, 0.0f);
+		std::fill(defaults, defaults + sequencer_step::maxParameters, 0.0f);
+		seed = 1;
+		set_length(length);
+	}
+
+	void step_sequencer::set_length(uint32_t length)
+	{
+		this->length = std::clamp<uint32_t>(length, 1, maxSteps);
+	}
+
+	void step_sequencer::set_rate(double stepsPerBeat)
+	{
+		clock.set_rate(stepsPerBeat);
+	}
+
+	void step_sequencer::set_swing(double swing)
+	{
+		clock.set_swing(swing);
+	}
+
+	void step_sequencer::set_seed(uint64_t seed)
+	{
+		this->seed = seed;
+	}
+
+	sequencer_step *step_sequencer::get_steps()
+	{
+		return steps;
+	}
+
+	float *step_sequencer::get_parameters()
+	{
+		return parameters;
+	}
+
+	float *step_sequencer::get_defaults()
+	{
+		return defaults;
+	}
+
+	uint32_t step_sequencer::process(const transport_state &state, uint32_t frameCount)
+	{
+		int64_t firstStep, lastStep;
+		clock.begin(state, frameCount, firstStep, lastStep);
+
+		for(int64_t s = firstStep; s <= lastStep; s++)
+		{
+			const sequencer_step &step = steps[s % length];
+			const double start = clock.get_step_beat(s);
+
+			if(clock.contains(start))
+			{
+				for(uint32_t i = 0; i < sequencer_step::maxParameters; i++)
+				{
+					const float value = (step.lockMask >> i) & 1 ? step.locks[i] : defaults[i];
+
+					if(value == parameters[i])
+						continue;
+
+					parameters[i] = value;
+					clock.add_parameter(start, i, value);
+				}
+			}
+
+			if(step.note < 0 || pattern_clock::get_random(s, seed) >= step.probability)
+				continue;
+
+			const uint32_t ratchets = std::clamp<uint32_t>(step.ratchets, 1, maxRatchets);
+			// Swing shortens or stretches the step, ratchets and gate follow its actual length
+			const double ratchetLength = (clock.get_step_beat(s + 1) - start) / ratchets;
+			const double gate = std::clamp(step.gate, 0.01f, 1.0f);
+
+			// Ratchets are checked one by one, a long step can spread them over several blocks
+			for(uint32_t r = 0; r < ratchets; r++)
+			{
+				const double beat = start + r * ratchetLength;
+
+				if(clock.contains(beat))
+					clock.add_note(beat, ratchetLength * gate, step.note, step.velocity);
+			}
+		}
+
+		return clock.end();
+	}
+
+	const note_event *step_sequencer::get_events() const
+	{
+		return clock.get_events();
+	}
+
+	void step_sequencer::release_all()
+	{
+		clock.release_all();
+	}
+}
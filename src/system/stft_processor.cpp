@@ -0,0 +1,112 @@
+#include "stft_processor.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+
+namespace luadio
+{
+	stft_processor::stft_processor(uint32_t size, uint32_t overlap, window_type window)
+	{
+		if(overlap == 0 || overlap > size)
+			throw std::invalid_argument("overlap must be between 1 and size");
+
+		plan = fft_plan::get(size);
+
+		this->size = size;
+		hopSize = size / overlap;
+		hopPosition = 0;
+		ready = false;
+
+		this->window.resize(size);
+		input.assign(size, 0.0f);
+		output.assign(size, 0.0f);
+		frame.resize(size);
+		bins.assign(plan->get_bin_count(), std::complex<float>(0.0f, 0.0f));
+
+		window_function::generate(window, this->window.data(), size);
+
+		// The window is applied before analysis and after synthesis, so the overlapping
+		// squared windows are normalized. This is exact for Hann and Hamming at 75% overlap or more.
+		double sum = 0.0;
+
+		for(uint32_t i = 0; i < size; i++)
+			sum += this->window[i] * this->window[i];
+
+		synthesisScale = sum > 0.0 ? static_cast<float>(hopSize / sum) : 1.0f;
+	}
+
+	uint32_t stft_processor::process(const float *pInput, float *pOutput, uint32_t frameCount, uint32_t stride)
+	{
+		if(ready)
+		{
+			synthesize();
+			ready = false;
+		}
+
+		const uint32_t offset = size - hopSize;
+
+		for(uint32_t i = 0; i < frameCount; i++)
+		{
+			input[offset + hopPosition] = pInput[i * stride];
+			pOutput[i * stride] = output[hopPosition];
+
+			if(++hopPosition == hopSize)
+			{
+				hopPosition = 0;
+
+				// Everything emitted during this hop is done, make room for the next one
+				std::memmove(output.data(), output.data() + hopSize, offset * sizeof(float));
+				std::fill(output.begin() + offset, output.end(), 0.0f);
+
+				analyze();
+				std::memmove(input.data(), input.data() + hopSize, offset * sizeof(float));
+
+				ready = true;
+				return i + 1;
+			}
+		}
+
+		return frameCount;
+	}
+
+	bool stft_processor::is_ready() const
+	{
+		return ready;
+	}
+
+	std::complex<float> *stft_processor::get_bins()
+	{
+		return bins.data();
+	}
+
+	uint32_t stft_processor::get_bin_count() const
+	{
+		return static_cast<uint32_t>(bins.size());
+	}
+
+	uint32_t stft_processor::get_size() const
+	{
+		return size;
+	}
+
+	uint32_t stft_processor::get_hop_size() const
+	{
+		return hopSize;
+	}
+
+	void stft_processor::analyze()
+	{
+		for(uint32_t i = 0; i < size; i++)
+			frame[i] = input[i] * window[i];
+
+		plan->forward(frame.data(), bins.data());
+	}
+
+	void stft_processor::synthesize()
+	{
+		plan->inverse(bins.data(), frame.data());
+
+		for(uint32_t i = 0; i < size; i++)
+			output[i] += frame[i] * window[i] * synthesisScale;
+	}
+}
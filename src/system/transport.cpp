@@ -0,0 +1,58 @@
+#include "transport.hpp"
+#include <algorithm>
+
+namespace luadio
+{
+	transport::transport()
+	{
+		state.tempo = 120.0;
+		pendingTempo = state.tempo;
+		state.beatsPerBar = 4;
+		state.reserved = 0;
+		reset(44100);
+	}
+
+	void transport::reset(uint32_t sampleRate)
+	{
+		framePosition = 0;
+		state.frame = 0.0;
+		state.beat = 0.0;
+		state.tempo = pendingTempo;
+		state.sampleRate = static_cast<double>(std::max<uint32_t>(sampleRate, 1));
+		publishedFrame.store(0);
+	}
+
+	void transport::advance(uint64_t frameCount)
+	{
+		framePosition += frameCount;
+		state.frame = static_cast<double>(framePosition);
+		state.beat += frameCount * state.tempo / (60.0 * state.sampleRate);
+		state.tempo = pendingTempo;
+		publishedFrame.store(framePosition, std::memory_order_relaxed);
+	}
+
+	void transport::set_tempo(double beatsPerMinute)
+	{
+		pendingTempo = std::clamp(beatsPerMinute, 1.0, 1000.0);
+	}
+
+	void transport::set_beats_per_bar(uint32_t beatsPerBar)
+	{
+		state.beatsPerBar = std::max<uint32_t>(beatsPerBar, 1);
+	}
+
+	const transport_state *transport::get_state() const
+	{
+		return &state;
+	}
+
+	uint64_t transport::get_frame_position() const
+	{
+		return publishedFrame.load(std::memory_order_relaxed);
+	}
+
+	double transport::get_frame_of_beat(double beat) const
+	{
+		return state.frame + (beat - state.beat) * 60.0 * state.sampleRate / pendingTempo;
+	}
+}
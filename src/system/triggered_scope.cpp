@@ -0,0 +1,178 @@
+#include "triggered_scope.hpp"
+#include "simd.hpp"
+#include <algorithm>
+#include <bit>
+
+namespace luadio
+{
+	triggered_scope::triggered_scope()
+	{
+		settings.mode = trigger_mode_zero_crossing;
+		settings.level = 0.0f;
+		settings.holdoffSeconds = 0.0f;
+		settings.windowSeconds = 0.02f;
+		settings.channel = 0;
+		sampleRate = 44100;
+		channels = 0;
+		framesWritten = 0;
+		armedFrame = 0;
+		lastTrigger = 0;
+		windowStart = 0;
+		windowFrames = 0;
+		hasTriggered = false;
+	}
+
+	void triggered_scope::initialize(uint32_t sampleRate, uint32_t channels)
+	{
+		this->sampleRate = sampleRate;
+		this->channels = channels;
+
+		// Every channel is stored twice in a row, so frame f is always followed by the frames after it
+		history.assign(static_cast<size_t>(channels) * historyFrames * 2, 0.0f);
+		framesWritten = 0;
+		armedFrame = 0;
+		lastTrigger = 0;
+		windowStart = 0;
+		hasTriggered = false;
+	}
+
+	void triggered_scope::configure(const scope_settings &settings)
+	{
+		this->settings = settings;
+		hasTriggered = false;
+	}
+
+	void triggered_scope::push(const float *pFrames, size_t frameCount)
+	{
+		for(size_t i = 0; i < frameCount; i++)
+		{
+			const size_t index = static_cast<size_t>(framesWritten % historyFrames);
+
+			for(uint32_t c = 0; c < channels; c++)
+			{
+				float *pChannel = &history[static_cast<size_t>(c) * historyFrames * 2];
+				pChannel[index] = pFrames[i * channels + c];
+				pChannel[index + historyFrames] = pFrames[i * channels + c];
+			}
+
+			framesWritten++;
+		}
+	}
+
+	bool triggered_scope::update()
+	{
+		windowFrames = std::clamp<uint64_t>(static_cast<uint64_t>(settings.windowSeconds * sampleRate), 16, maxWindowFrames);
+
+		if(channels == 0 || framesWritten < windowFrames)
+		{
+			windowStart = 0;
+			return false;
+		}
+
+		if(settings.mode != trigger_mode_free)
+		{
+			const float threshold = settings.mode == trigger_mode_level ? settings.level : 0.0f;
+			const uint64_t holdoff = std::max<uint64_t>(1, static_cast<uint64_t>(settings.holdoffSeconds * sampleRate));
+			const uint32_t channel = std::min(settings.channel, channels - 1);
+
+			// A trigger needs a full window after it, and the sample before it to detect the edge
+			const uint64_t searchEnd = framesWritten - windowFrames + 1;
+			const uint64_t oldest = framesWritten > historyFrames ? framesWritten - historyFrames + 1 : 1;
+
+			// Search at most the newest half of the history, older edges would not be shown anyway
+			armedFrame = std::max(armedFrame, oldest);
+
+			if(searchEnd > armedFrame && searchEnd - armedFrame > historyFrames / 2)
+				armedFrame = searchEnd - historyFrames / 2;
+
+			while(armedFrame < searchEnd)
+			{
+				const size_t count = static_cast<size_t>(searchEnd - armedFrame + 1);
+				const size_t index = find_rising_edge(get_channel(channel, armedFrame - 1), count, threshold);
+
+				if(index >= count)
+				{
+					armedFrame = searchEnd;
+					break;
+				}
+
+				lastTrigger = armedFrame - 1 + index;
+				armedFrame = lastTrigger + holdoff;
+				hasTriggered = true;
+			}
+
+			// Keep showing the last triggered view for a moment before running free
+			if(hasTriggered && framesWritten - lastTrigger <= windowFrames + sampleRate / 10)
+			{
+				windowStart = lastTrigger;
+				return true;
+			}
+		}
+
+		windowStart = framesWritten - windowFrames;
+		return false;
+	}
+
+	void triggered_scope::get_columns(uint32_t columns, uint32_t channel, float *pMin, float *pMax) const
+	{
+		if(channel >= channels || columns == 0 || windowFrames == 0)
+			return;
+
+		const float *pWindow = get_channel(channel, windowStart);
+		const double framesPerColumn = static_cast<double>(windowFrames) / columns;
+
+		for(uint32_t column = 0; column < columns; column++)
+		{
+			const size_t first = static_cast<size_t>(column * framesPerColumn);
+			const size_t last = std::max(first + 1, static_cast<size_t>((column + 1) * framesPerColumn));
+			const auto range = std::minmax_element(pWindow + first, pWindow + last);
+			pMin[column] = *range.first;
+			pMax[column] = *range.second;
+		}
+	}
+
+	size_t triggered_scope::find_rising_edge(const float *pSamples, size_t count, float threshold)
+	{
+		size_t i = 1;
+
+#if defined(LUADIO_SIMD_AVX2)
+		const __m256 threshold256 = _mm256_set1_ps(threshold);
+
+		for( ; i + 8 <= count; i += 8)
+		{
+			__m256 below = _mm256_cmp_ps(_mm256_loadu_ps(pSamples + i - 1), threshold256, _CMP_LT_OQ);
+			__m256 above = _mm256_cmp_ps(_mm256_loadu_ps(pSamples + i), threshold256, _CMP_GE_OQ);
+			int mask = _mm256_movemask_ps(_mm256_and_ps(below, above));
+
+			if(mask != 0)
+				return i + std::countr_zero(static_cast<uint32_t>(mask));
+		}
+#endif
+#if defined(LUADIO_SIMD_SSE2)
+		const __m128 threshold128 = _mm_set1_ps(threshold);
+
+		for( ; i + 4 <= count; i += 4)
+		{
+			__m128 below = _mm_cmplt_ps(_mm_loadu_ps(pSamples + i - 1), threshold128);
+			__m128 above = _mm_cmpge_ps(_mm_loadu_ps(pSamples + i), threshold128);
+			int mask = _mm_movemask_ps(_mm_and_ps(below, above));
+
+			if(mask != 0)
+				return i + std::countr_zero(static_cast<uint32_t>(mask));
+		}
+#endif
+
+		for( ; i < count; i++)
+		{
+			if(pSamples[i - 1] < threshold && pSamples[i] >= threshold)
+				return i;
+		}
+
+		return count;
+	}
+
+	const float *triggered_scope::get_channel(uint32_t channel, uint64_t frame) const
+	{
+		return &history[static_cast<size_t>(channel) * historyFrames * 2 + static_cast<size_t>(frame % historyFrames)];
+	}
+}
@@ -0,0 +1,142 @@
+#include "uniform_convolver.hpp"
+#include "simd.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace luadio
+{
+#if defined(LUADIO_SIMD_SSE2)
+	// Multiplies two pairs of interleaved complex values
+	static inline __m128 complex_multiply_sse2(__m128 a, __m128 b)
+	{
+		const __m128 sign = _mm_set_ps(0.0f, -0.0f, 0.0f, -0.0f);
+		__m128 real = _mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 2, 0, 0));
+		__m128 imag = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 3, 1, 1));
+		__m128 swapped = _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1));
+		return _mm_add_ps(_mm_mul_ps(a, real), _mm_xor_ps(_mm_mul_ps(swapped, imag), sign));
+	}
+#endif
+
+#if defined(LUADIO_SIMD_AVX2)
+	static inline __m256 complex_multiply_avx2(__m256 a, __m256 b)
+	{
+		const __m256 sign = _mm256_set_ps(0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f);
+		__m256 real = _mm256_moveldup_ps(b);
+		__m256 imag = _mm256_movehdup_ps(b);
+		__m256 swapped = _mm256_permute_ps(a, _MM_SHUFFLE(2, 3, 0, 1));
+		return _mm256_add_ps(_mm256_mul_ps(a, real), _mm256_xor_ps(_mm256_mul_ps(swapped, imag), sign));
+	}
+#endif
+
+	uniform_convolver::uniform_convolver(uint32_t partitionSize, const float *pImpulse, size_t impulseLength, size_t stride)
+	{
+		// Blocks of partitionSize new samples are transformed together with the previous block
+		plan = fft_plan::get(partitionSize * 2);
+
+		this->partitionSize = partitionSize;
+		binCount = static_cast<uint32_t>(plan->get_bin_count());
+		partitionCount = static_cast<uint32_t>(std::max<size_t>(1, (impulseLength + partitionSize - 1) / partitionSize));
+		delayLinePosition = 0;
+
+		filters.resize(static_cast<size_t>(partitionCount) * binCount);
+		delayLine.assign(static_cast<size_t>(partitionCount) * binCount, std::complex<float>(0.0f, 0.0f));
+		accumulator.resize(binCount);
+		inputBuffer.assign(partitionSize * 2, 0.0f);
+		outputBuffer.resize(partitionSize * 2);
+
+		// Each partition is zero padded to the transform size
+		std::vector<float> padded(partitionSize * 2);
+
+		for(uint32_t p = 0; p < partitionCount; p++)
+		{
+			std::fill(padded.begin(), padded.end(), 0.0f);
+
+			for(uint32_t i = 0; i < partitionSize; i++)
+			{
+				const size_t index = static_cast<size_t>(p) * partitionSize + i;
+
+				if(index >= impulseLength)
+					break;
+
+				padded[i] = pImpulse[index * stride];
+			}
+
+			plan->forward(padded.data(), &filters[static_cast<size_t>(p) * binCount]);
+		}
+	}
+
+	void uniform_convolver::process(const float *pInput, float *pOutput)
+	{
+		begin(pInput);
+		accumulate(0, partitionCount);
+		finish(pOutput);
+	}
+
+	void uniform_convolver::begin(const float *pInput)
+	{
+		std::memmove(inputBuffer.data(), inputBuffer.data() + partitionSize, partitionSize * sizeof(float));
+		std::memcpy(inputBuffer.data() + partitionSize, pInput, partitionSize * sizeof(float));
+
+		plan->forward(inputBuffer.data(), &delayLine[static_cast<size_t>(delayLinePosition) * binCount]);
+
+		std::fill(accumulator.begin(), accumulator.end(), std::complex<float>(0.0f, 0.0f));
+	}
+
+	void uniform_convolver::accumulate(uint32_t first, uint32_t count)
+	{
+		const uint32_t last = std::min(first + count, partitionCount);
+
+		// Partition p of the filter meets the input spectrum from p blocks ago
+		for(uint32_t p = first; p < last; p++)
+		{
+			const uint32_t slot = (delayLinePosition + partitionCount - p) % partitionCount;
+			multiply_accumulate(&delayLine[static_cast<size_t>(slot) * binCount], &filters[static_cast<size_t>(p) * binCount], accumulator.data(), binCount);
+		}
+	}
+
+	void uniform_convolver::finish(float *pOutput)
+	{
+		plan->inverse(accumulator.data(), outputBuffer.data());
+
+		// The first half is circular wrap around, only the second half is valid
+		std::memcpy(pOutput, outputBuffer.data() + partitionSize, partitionSize * sizeof(float));
+
+		delayLinePosition = (delayLinePosition + 1) % partitionCount;
+	}
+
+	uint32_t uniform_convolver::get_partition_size() const
+	{
+		return partitionSize;
+	}
+
+	uint32_t uniform_convolver::get_partition_count() const
+	{
+		return partitionCount;
+	}
+
+	void uniform_convolver::multiply_accumulate(const std::complex<float> *pA, const std::complex<float> *pB, std::complex<float> *pAccumulator, size_t count)
+	{
+		size_t i = 0;
+		const float *a = reinterpret_cast<const float*>(pA);
+		const float *b = reinterpret_cast<const float*>(pB);
+		float *acc = reinterpret_cast<float*>(pAccumulator);
+
+#if defined(LUADIO_SIMD_AVX2)
+		for( ; i + 4 <= count; i += 4)
+		{
+			__m256 product = complex_multiply_avx2(_mm256_loadu_ps(a + i * 2), _mm256_loadu_ps(b + i * 2));
+			_mm256_storeu_ps(acc + i * 2, _mm256_add_ps(_mm256_loadu_ps(acc + i * 2), product));
+		}
+#endif
+#if defined(LUADIO_SIMD_SSE2)
+		for( ; i + 2 <= count; i += 2)
+		{
+			__m128 product = complex_multiply_sse2(_mm_loadu_ps(a + i * 2), _mm_loadu_ps(b + i * 2));
+			_mm_storeu_ps(acc + i * 2, _mm_add_ps(_mm_loadu_ps(acc + i * 2), product));
+		}
+#endif
+
+		for( ; i < count; i++)
+			pAccumulator[i] += pA[i] * pB[i];
+	}
+}
@@ -0,0 +1,351 @@
+#include "voice_allocator.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+#include <cmath>
+
+namespace luadio
+{
+	static constexpr float pi = 3.14159265358979f;
+
+	// Polynomial band limited step, removes most aliasing of the saw and square edges
+	static inline float poly_blep(float t, float dt)
+	{
+		if(t < dt)
+		{
+			t /= dt;
+			return t + t - t * t - 1.0f;
+		}
+		else if(t > 1.0f - dt)
+		{
+			t = (t - 1.0f) / dt;
+			return t * t + t + t + 1.0f;
+		}
+
+		return 0.0f;
+	}
+
+	voice_allocator::voice_allocator(uint32_t voiceCount, uint32_t sampleRate)
+	{
+		if(voiceCount == 0 || voiceCount > maxVoices)
+			throw std::invalid_argument("voiceCount must be between 1 and 128");
+
+		if(sampleRate == 0)
+			throw std::invalid_argument("sampleRate must be greater than 0");
+
+		this->sampleRate = sampleRate;
+		policy = steal_policy_oldest;
+		noteCounter = 0;
+
+		active.resize(voiceCount);
+		notes.assign(voiceCount, -1);
+		velocities.assign(voiceCount, 0.0f);
+		frequencies.assign(voiceCount, 440.0f);
+		gains.assign(voiceCount, 1.0f);
+		pans.assign(voiceCount, 0.0f);
+		waveforms.assign(voiceCount, voice_waveform_saw);
+		levels.assign(voiceCount, 0.0f);
+		phases.assign(voiceCount, 0.0f);
+		releaseSteps.assign(voiceCount, 0.0f);
+		states.assign(voiceCount, voice_state_idle);
+		startOrder.assign(voiceCount, 0);
+		scratch.resize(chunkFrames);
+
+		// The vectors never change size again, so the pointers stay valid
+		data.voiceCount = voiceCount;
+		data.activeCount = 0;
+		data.pActive = active.data();
+		data.pNotes = notes.data();
+		data.pVelocities = velocities.data();
+		data.pFrequencies = frequencies.data();
+		data.pGains = gains.data();
+		data.pPans = pans.data();
+		data.pWaveforms = waveforms.data();
+		data.pLevels = levels.data();
+
+		set_envelope(0.005f, 0.1f, 0.7f, 0.2f);
+	}
+
+	void voice_allocator::set_envelope(float attackSeconds, float decaySeconds, float sustainLevel, float releaseSeconds)
+	{
+		this->sustainLevel = std::clamp(sustainLevel, 0.0f, 1.0f);
+		attackStep = 1.0f / std::max(attackSeconds * sampleRate, 1.0f);
+		decayStep = (1.0f - this->sustainLevel) / std::max(decaySeconds * sampleRate, 1.0f);
+		releaseFrames = std::max(releaseSeconds * sampleRate, 1.0f);
+	}
+
+	void voice_allocator::set_steal_policy(steal_policy policy)
+	{
+		this->policy = policy;
+	}
+
+	int32_t voice_allocator::note_on(int32_t note, float velocity)
+	{
+		const int32_t voice = find_voice(note);
+
+		if(voice < 0)
+			return -1;
+
+		notes[voice] = note;
+		velocities[voice] = std::clamp(velocity, 0.0f, 1.0f);
+		frequencies[voice] = 440.0f * std::exp2((note - 69) / 12.0f);
+		gains[voice] = 1.0f;
+		pans[voice] = 0.0f;
+		states[voice] = voice_state_attack;
+		startOrder[voice] = ++noteCounter;
+
+		update_active();
+		return voice;
+	}
+
+	void voice_allocator::note_off(int32_t note)
+	{
+		for(uint32_t i = 0; i < data.activeCount; i++)
+		{
+			const uint32_t voice = active[i];
+
+			if(notes[voice] != note || states[voice] == voice_state_release)
+				continue;
+
+			states[voice] = voice_state_release;
+			releaseSteps[voice] = levels[voice] / releaseFrames;
+		}
+	}
+
+	void voice_allocator::all_notes_off()
+	{
+		for(uint32_t i = 0; i < data.activeCount; i++)
+		{
+			const uint32_t voice = active[i];
+
+			if(states[voice] == voice_state_release)
+				continue;
+
+			states[voice] = voice_state_release;
+			releaseSteps[voice] = levels[voice] / releaseFrames;
+		}
+	}
+
+	void voice_allocator::reset()
+	{
+		std::fill(states.begin(), states.end(), voice_state_idle);
+		std::fill(levels.begin(), levels.end(), 0.0f);
+		std::fill(phases.begin(), phases.end(), 0.0f);
+		std::fill(notes.begin(), notes.end(), -1);
+		data.activeCount = 0;
+	}
+
+	void voice_allocator::render(float *pOutput, uint32_t frameCount, uint32_t channels)
+	{
+		std::memset(pOutput, 0, static_cast<size_t>(frameCount) * channels * sizeof(float));
+
+		for(uint32_t offset = 0; offset < frameCount; offset += chunkFrames)
+		{
+			const uint32_t count = std::min(chunkFrames, frameCount - offset);
+			float *pChunk = pOutput + static_cast<size_t>(offset) * channels;
+
+			for(uint32_t i = 0; i < data.activeCount; i++)
+			{
+				const uint32_t voice = active[i];
+				render_voice(voice, scratch.data(), count);
+
+				if(channels == 1)
+				{
+					for(uint32_t j = 0; j < count; j++)
+						pChunk[j] += scratch[j];
+
+					continue;
+				}
+
+				// Equal power pan over the first two channels
+				const float angle = (std::clamp(pans[voice], -1.0f, 1.0f) + 1.0f) * 0.25f * pi;
+				const float left = std::cos(angle);
+				const float right = std::sin(angle);
+
+				for(uint32_t j = 0; j < count; j++)
+				{
+					pChunk[j * channels] += scratch[j] * left;
+					pChunk[j * channels + 1] += scratch[j] * right;
+				}
+			}
+
+			// Voices that finished their release drop out of the list here, never while it is iterated
+			update_active();
+		}
+	}
+
+	void voice_allocator::render_events(float *pOutput, uint32_t frameCount, uint32_t channels, const note_event *pEvents, uint32_t eventCount)
+	{
+		uint32_t position = 0;
+
+		for(uint32_t i = 0; i < eventCount; i++)
+		{
+			const uint32_t offset = std::min(pEvents[i].offset, frameCount);
+
+			if(offset > position)
+			{
+				render(pOutput + static_cast<size_t>(position) * channels, offset - position, channels);
+				position = offset;
+			}
+
+			if(pEvents[i].type == note_event_type_note_on)
+				note_on(pEvents[i].note, pEvents[i].value);
+			else if(pEvents[i].type == note_event_type_note_off)
+				note_off(pEvents[i].note);
+		}
+
+		if(frameCount > position)
+			render(pOutput + static_cast<size_t>(position) * channels, frameCount - position, channels);
+	}
+
+	voice_data *voice_allocator::get_data()
+	{
+		return &data;
+	}
+
+	int32_t voice_allocator::find_voice(int32_t note) const
+	{
+		const uint32_t voiceCount = data.voiceCount;
+
+		// Retrigger a voice that already plays the note instead of stacking a second one
+		for(uint32_t i = 0; i < voiceCount; i++)
+		{
+			if(states[i] != voice_state_idle && notes[i] == note)
+				return static_cast<int32_t>(i);
+		}
+
+		for(uint32_t i = 0; i < voiceCount; i++)
+		{
+			if(states[i] == voice_state_idle)
+				return static_cast<int32_t>(i);
+		}
+
+		// Releasing voices are fading out anyway, take the quietest one
+		int32_t best = -1;
+
+		for(uint32_t i = 0; i < voiceCount; i++)
+		{
+			if(states[i] == voice_state_release && (best < 0 || levels[i] < levels[best]))
+				best = static_cast<int32_t>(i);
+		}
+
+		if(best >= 0 || policy == steal_policy_none)
+			return best;
+
+		for(uint32_t i = 0; i < voiceCount; i++)
+		{
+			if(best < 0)
+				best = static_cast<int32_t>(i);
+			else if(policy == steal_policy_oldest && startOrder[i] < startOrder[best])
+				best = static_cast<int32_t>(i);
+			else if(policy == steal_policy_quietest && levels[i] * velocities[i] < levels[best] * velocities[best])
+				best = static_cast<int32_t>(i);
+		}
+
+		return best;
+	}
+
+	void voice_allocator::update_active()
+	{
+		uint32_t count = 0;
+
+		for(uint32_t i = 0; i < data.voiceCount; i++)
+		{
+			if(states[i] != voice_state_idle)
+				active[count++] = i;
+		}
+
+		data.activeCount = count;
+	}
+
+	void voice_allocator::render_voice(uint32_t voice, float *pOutput, uint32_t frameCount)
+	{
+		voice_state state = states[voice];
+		float level = levels[voice];
+		float phase = phases[voice];
+		const float dt = std::clamp(frequencies[voice] / sampleRate, 0.0f, 0.49f);
+		const float amplitude = velocities[voice] * gains[voice];
+		const float releaseStep = releaseSteps[voice];
+		const int32_t waveform = waveforms[voice];
+		uint32_t i = 0;
+
+		for( ; i < frameCount; i++)
+		{
+			switch(state)
+			{
+				case voice_state_attack:
+					level += attackStep;
+					if(level >= 1.0f)
+					{
+						level = 1.0f;
+						state = voice_state_decay;
+					}
+					break;
+				case voice_state_decay:
+					level -= decayStep;
+					if(level <= sustainLevel)
+					{
+						level = sustainLevel;
+						state = voice_state_sustain;
+					}
+					break;
+				case voice_state_sustain:
+					level = sustainLevel;
+					break;
+				case voice_state_release:
+					level -= releaseStep;
+					if(level <= 0.0f)
+					{
+						level = 0.0f;
+						state = voice_state_idle;
+					}
+					break;
+				default:
+					break;
+			}
+
+			if(state == voice_state_idle)
+				break;
+
+			float sample;
+
+			switch(waveform)
+			{
+				case voice_waveform_sine:
+					sample = std::sin(2.0f * pi * phase);
+					break;
+				case voice_waveform_square:
+				{
+					float shifted = phase + 0.5f;
+					if(shifted >= 1.0f)
+						shifted -= 1.0f;
+					sample = (phase < 0.5f ? 1.0f : -1.0f) + poly_blep(phase, dt) - poly_blep(shifted, dt);
+					break;
+				}
+				case voice_waveform_triangle:
+					sample = 1.0f - 4.0f * std::abs(phase - 0.5f);
+					break;
+				default:
+					sample = 2.0f * phase - 1.0f - poly_blep(phase, dt);
+					break;
+			}
+
+			pOutput[i] = sample * level * amplitude;
+
+			phase += dt;
+
+			if(phase >= 1.0f)
+				phase -= 1.0f;
+		}
+
+		for( ; i < frameCount; i++)
+			pOutput[i] = 0.0f;
+
+		states[voice] = state;
+		levels[voice] = level;
+		phases[voice] = phase;
+
+		if(state == voice_state_idle)
+			notes[voice] = -1;
+	}
+}
@@ -0,0 +1,157 @@
+#include "wav_writer.hpp"
+#include <chrono>
+#include <filesystem>
+
+namespace luadio
+{
+	wav_writer::wav_writer()
+	{
+		outputBuffer.resize(4096);
+		format = pcm_format_s16;
+		channels = 0;
+		bytesWritten = 0;
+	}
+
+	wav_writer::~wav_writer()
+	{
+		close();
+	}
+
+	bool wav_writer::open(const std::string &filePath, uint32_t sampleRate, uint32_t channels, pcm_format format, bool dither)
+	{
+		if(stream.is_open())
+			return false;
+
+		this->format = format;
+		this->channels = channels;
+		converter.set_dither(dither);
+
+		uint8_t header[44];
+
+		const int32_t bitDepth = static_cast<int32_t>(pcm_converter::get_bits_per_sample(format));
+
+		int32_t chunkId = 1179011410;           //"RIFF
+		int32_t chunkSize = 0;
+		int32_t waveFormat = 1163280727;        //"WAVE"
+		int32_t subChunk1Id = 544501094;        //"fmt "
+		int32_t subChunk1Size = 16;
+		int16_t audioFormat = 1;
+		int16_t numChannels = static_cast<int16_t>(channels);
+		int32_t rate = static_cast<int32_t>(sampleRate);
+		int32_t byteRate = rate * numChannels * bitDepth / 8;
+		int16_t blockAlign = static_cast<int16_t>(numChannels * bitDepth / 8);
+		int16_t bitsPerSample = static_cast<int16_t>(bitDepth);
+		int32_t subChunk2Id = 1635017060;       //"data"
+		int32_t subChunk2Size = 0;
+
+		write_int32(chunkId, header, 0);
+		write_int32(chunkSize, header, 4);
+		write_int32(waveFormat, header, 8);
+		write_int32(subChunk1Id, header, 12);
+		write_int32(subChunk1Size, header, 16);
+		write_int16(audioFormat, header, 20);
+		write_int16(numChannels, header, 22);
+		write_int32(rate, header, 24);
+		write_int32(byteRate, header, 28);
+		write_int16(blockAlign, header, 32);
+		write_int16(bitsPerSample, header, 34);
+		write_int32(subChunk2Id, header, 36);
+		write_int32(subChunk2Size, header, 40);
+
+		stream = std::ofstream(filePath, std::ios::out | std::ios::binary | std::ios::trunc);
+
+		if(!stream.is_open())
+			return false;
+
+		stream.write(reinterpret_cast<const char*>(header), 44);
+
+		bytesWritten = 0;
+
+		return true;
+	}
+
+	void wav_writer::write(const float *pFrames, uint32_t frameCount)
+	{
+		if(!stream.is_open())
+			return;
+
+		const uint32_t numSamples = frameCount * channels;
+		const uint32_t byteSize = numSamples * pcm_converter::get_bytes_per_sample(format);
+
+		if(byteSize == 0)
+			return;
+
+		if(outputBuffer.size() < byteSize)
+			outputBuffer.resize(byteSize);
+
+		converter.convert(pFrames, outputBuffer.data(), numSamples, format);
+
+		stream.write(reinterpret_cast<const char*>(outputBuffer.data()), byteSize);
+
+		bytesWritten += byteSize;
+	}
+
+	void wav_writer::close()
+	{
+		if(!stream.is_open())
+			return;
+
+		if(bytesWritten > 0)
+		{
+			const int32_t headerSize = 44;
+			int32_t chunkSize = headerSize + static_cast<int32_t>(bytesWritten - 8);//file size - 8;
+			int32_t subChunk2Size = static_cast<int32_t>(bytesWritten);
+
+			uint8_t buffer[8];
+
+			write_int32(chunkSize, buffer, 0);
+			stream.seekp(4, std::ios::beg);
+			stream.write(reinterpret_cast<const char*>(buffer), sizeof(int32_t));
+
+			write_int32(subChunk2Size, buffer, 0);
+			stream.seekp(40, std::ios::beg);
+			stream.write(reinterpret_cast<const char*>(buffer), sizeof(int32_t));
+
+			bytesWritten = 0;
+		}
+
+		stream.close();
+	}
+
+	bool wav_writer::is_open() const
+	{
+		return stream.is_open();
+	}
+
+	uint32_t wav_writer::get_channels() const
+	{
+		return channels;
+	}
+
+	std::string wav_writer::create_file_name(const std::string &suffix)
+	{
+		auto now = std::chrono::high_resolution_clock::now();
+		auto ticks = std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+
+		std::filesystem::path dirPath = "recordings";
+
+		std::string fileName = std::to_string(ticks) + suffix + ".wav";
+
+		if(std::filesystem::exists(dirPath))
+			fileName = "recordings/" + fileName;
+
+		return fileName;
+	}
+
+	void wav_writer::write_int16(int16_t value, uint8_t *buffer, int32_t offset)
+	{
+		int16_t *pBuffer = reinterpret_cast<int16_t*>(&buffer[offset]);
+		*pBuffer = value;
+	}
+
+	void wav_writer::write_int32(int32_t value, uint8_t *buffer, int32_t offset)
+	{
+		int32_t *pBuffer = reinterpret_cast<int32_t*>(&buffer[offset]);
+		*pBuffer = value;
+	}
+}
@@ -0,0 +1,160 @@
+#include "waveform_pyramid.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace luadio
+{
+	waveform_pyramid::waveform_pyramid()
+	{
+		accumulated = 0;
+		maxFrames = 0;
+		channels = 0;
+	}
+
+	void waveform_pyramid::initialize(uint64_t maxFrames, uint32_t maxColumns, uint32_t channels)
+	{
+		this->maxFrames = maxFrames;
+		this->channels = channels;
+
+		// Output may exceed full scale, start empty so the first frame sets both extremes
+		accumulatorMin.assign(channels, std::numeric_limits<float>::infinity());
+		accumulatorMax.assign(channels, -std::numeric_limits<float>::infinity());
+		accumulated = 0;
+
+		levels.clear();
+
+		// Levels are only useful up to the point where the whole history fits in maxColumns entries
+		const uint64_t coarsest = std::max<uint64_t>(baseFrames, maxFrames / std::max<uint32_t>(1, maxColumns));
+
+		for(uint64_t framesPerEntry = baseFrames; ; framesPerEntry *= 2)
+		{
+			level l;
+			l.framesPerEntry = framesPerEntry;
+			// Two spare entries so a view of maxFrames never touches overwritten entries
+			l.capacity = (maxFrames + framesPerEntry - 1) / framesPerEntry + 2;
+			l.count = 0;
+			l.minimums.assign(l.capacity * channels, 0.0f);
+			l.maximums.assign(l.capacity * channels, 0.0f);
+			l.pendingMin.resize(channels);
+			l.pendingMax.resize(channels);
+			levels.push_back(std::move(l));
+
+			if(framesPerEntry >= coarsest)
+				break;
+		}
+	}
+
+	void waveform_pyramid::push(const float *pFrames, size_t frameCount)
+	{
+		if(levels.empty())
+			return;
+
+		for(size_t i = 0; i < frameCount; i++)
+		{
+			const float *pFrame = pFrames + i * channels;
+
+			for(uint32_t c = 0; c < channels; c++)
+			{
+				accumulatorMin[c] = std::min(accumulatorMin[c], pFrame[c]);
+				accumulatorMax[c] = std::max(accumulatorMax[c], pFrame[c]);
+			}
+
+			if(++accumulated == baseFrames)
+			{
+				push_entry(0, accumulatorMin.data(), accumulatorMax.data());
+				std::fill(accumulatorMin.begin(), accumulatorMin.end(), std::numeric_limits<float>::infinity());
+				std::fill(accumulatorMax.begin(), accumulatorMax.end(), -std::numeric_limits<float>::infinity());
+				accumulated = 0;
+			}
+		}
+	}
+
+	void waveform_pyramid::get_columns(uint64_t frameCount, uint32_t columns, uint32_t channel, float *pMin, float *pMax) const
+	{
+		if(levels.empty() || columns == 0 || channel >= channels)
+			return;
+
+		frameCount = std::clamp<uint64_t>(frameCount, 1, maxFrames);
+
+		// Coarsest level whose entries are not wider than a column
+		const double framesPerColumn = static_cast<double>(frameCount) / columns;
+		size_t levelIndex = 0;
+
+		while(levelIndex + 1 < levels.size() && levels[levelIndex + 1].framesPerEntry <= framesPerColumn)
+			levelIndex++;
+
+		const level &l = levels[levelIndex];
+
+		// The view ends at the newest complete entry of the chosen level
+		const int64_t end = static_cast<int64_t>(l.count);
+		const int64_t oldest = std::max<int64_t>(0, end - static_cast<int64_t>(l.capacity));
+		const double entriesPerColumn = framesPerColumn / l.framesPerEntry;
+		const double start = end - entriesPerColumn * columns;
+
+		for(uint32_t column = 0; column < columns; column++)
+		{
+			const int64_t first = static_cast<int64_t>(std::floor(start + column * entriesPerColumn));
+			const int64_t last = std::max(first + 1, static_cast<int64_t>(std::floor(start + (column + 1) * entriesPerColumn)));
+
+			float minimum = 0.0f;
+			float maximum = 0.0f;
+			bool found = false;
+
+			for(int64_t e = std::max(first, oldest); e < std::min(last, end); e++)
+			{
+				const size_t index = static_cast<size_t>(e % l.capacity) * channels + channel;
+
+				if(!found)
+				{
+					minimum = l.minimums[index];
+					maximum = l.maximums[index];
+					found = true;
+				}
+				else
+				{
+					minimum = std::min(minimum, l.minimums[index]);
+					maximum = std::max(maximum, l.maximums[index]);
+				}
+			}
+
+			// Columns before the start of the history read as silence
+			pMin[column] = minimum;
+			pMax[column] = maximum;
+		}
+	}
+
+	uint64_t waveform_pyramid::get_max_frames() const
+	{
+		return maxFrames;
+	}
+
+	uint32_t waveform_pyramid::get_channels() const
+	{
+		return channels;
+	}
+
+	void waveform_pyramid::push_entry(size_t levelIndex, const float *pMin, const float *pMax)
+	{
+		level &l = levels[levelIndex];
+		const size_t slot = static_cast<size_t>(l.count % l.capacity) * channels;
+
+		std::copy(pMin, pMin + channels, &l.minimums[slot]);
+		std::copy(pMax, pMax + channels, &l.maximums[slot]);
+		l.count++;
+
+		// Every second entry completes one entry of the next level
+		if((l.count & 1) != 0 || levelIndex + 1 >= levels.size())
+			return;
+
+		const size_t previous = static_cast<size_t>((l.count - 2) % l.capacity) * channels;
+
+		for(uint32_t c = 0; c < channels; c++)
+		{
+			l.pendingMin[c] = std::min(l.minimums[previous + c], l.minimums[slot + c]);
+			l.pendingMax[c] = std::max(l.maximums[previous + c], l.maximums[slot + c]);
+		}
+
+		push_entry(levelIndex + 1, l.pendingMin.data(), l.pendingMax.data());
+	}
+}
@@ -0,0 +1,47 @@
+#include "window_function.hpp"
+#include <cmath>
+
+namespace luadio
+{
+	void window_function::generate(window_type type, float *pDst, size_t n)
+	{
+		if(pDst == nullptr || n == 0)
+			return;
+
+		const double step = 2.0 * M_PI / static_cast<double>(n);
+
+		for(size_t i = 0; i < n; i++)
+		{
+			const double x = step * static_cast<double>(i);
+			double value = 1.0;
+
+			switch(type)
+			{
+				case window_type_rectangular:
+					value = 1.0;
+					break;
+				case window_type_hann:
+					value = 0.5 - 0.5 * std::cos(x);
+					break;
+				case window_type_hamming:
+					value = 0.54 - 0.46 * std::cos(x);
+					break;
+				case window_type_blackman_harris:
+					value = 0.35875 - 0.48829 * std::cos(x) + 0.14128 * std::cos(2.0 * x) - 0.01168 * std::cos(3.0 * x);
+					break;
+			}
+
+			pDst[i] = static_cast<float>(value);
+		}
+	}
+
+	float window_function::get_gain(const float *pWindow, size_t n)
+	{
+		double sum = 0.0;
+
+		for(size_t i = 0; i < n; i++)
+			sum += pWindow[i];
+
+		return static_cast<float>(sum);
+	}
+}